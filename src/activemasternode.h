@@ -62,6 +62,9 @@ private:
 
 public:
     virtual void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload);
+    std::string GetSubscriberName() const override { return "activemasternode"; }
+    // Shares state with the masternode maintenance tasks on the scheduler thread
+    bool UseSchedulerThread() const override { return true; }
 
     void Init();
 
@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <wallet/crypter.h>
 
 #include <vector>
@@ -84,4 +85,70 @@ static void CCoinsCaching(benchmark::State& state)
     }
 }
 
+static const size_t NUM_CACHED_COINS = 10000;
+
+static std::vector<COutPoint> RandomOutPoints(size_t nCount)
+{
+    FastRandomContext rng(true);
+    std::vector<COutPoint> vOutPoints;
+    vOutPoints.reserve(nCount);
+    for (size_t i = 0; i < nCount; i++) {
+        vOutPoints.emplace_back(rng.rand256(), rng.randrange(10));
+    }
+    return vOutPoints;
+}
+
+// Fill a map of coins and free it again, once with nodes allocated one by one
+// and once with nodes allocated from a pool, to compare the allocators used by
+// CCoinsMap.
+template <typename Map>
+static void FillCoinsMap(Map& map, const std::vector<COutPoint>& vOutPoints, const Coin& coin)
+{
+    for (const COutPoint& outpoint : vOutPoints) {
+        CCoinsCacheEntry& entry = map[outpoint];
+        entry.coin = coin;
+        entry.flags = CCoinsCacheEntry::DIRTY;
+    }
+}
+
+static void CoinsMapStdAllocator(benchmark::State& state)
+{
+    const std::vector<COutPoint> vOutPoints = RandomOutPoints(NUM_CACHED_COINS);
+    const Coin coin(CTxOut(50 * CENT, CScript() << OP_TRUE), 1, false);
+    while (state.KeepRunning()) {
+        std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> map;
+        FillCoinsMap(map, vOutPoints, coin);
+    }
+}
+
+static void CoinsMapPoolAllocator(benchmark::State& state)
+{
+    const std::vector<COutPoint> vOutPoints = RandomOutPoints(NUM_CACHED_COINS);
+    const Coin coin(CTxOut(50 * CENT, CScript() << OP_TRUE), 1, false);
+    while (state.KeepRunning()) {
+        CCoinsMapMemoryResource resource;
+        CCoinsMap map(0, SaltedOutpointHasher(), std::equal_to<COutPoint>(), CCoinsMapAllocator(&resource));
+        FillCoinsMap(map, vOutPoints, coin);
+    }
+}
+
+// Add coins to a CCoinsViewCache and flush it, which frees the memory of all
+// entries at once.
+static void CCoinsCachingFlush(benchmark::State& state)
+{
+    const std::vector<COutPoint> vOutPoints = RandomOutPoints(NUM_CACHED_COINS);
+    const Coin coin(CTxOut(50 * CENT, CScript() << OP_TRUE), 1, false);
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+    while (state.KeepRunning()) {
+        for (const COutPoint& outpoint : vOutPoints) {
+            coins.AddCoin(outpoint, Coin(coin), false);
+        }
+        coins.Flush();
+    }
+}
+
 BENCHMARK(CCoinsCaching, 170 * 1000);
+BENCHMARK(CoinsMapStdAllocator, 100);
+BENCHMARK(CoinsMapPoolAllocator, 100);
+BENCHMARK(CCoinsCachingFlush, 100);
@@ -0,0 +1,60 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <pow.h>
+#include <primitives/block.h>
+
+#include <vector>
+
+/**
+ * Check the difficulty of every header of a chain like header sync does. With
+ * fMinDifficultyRuns, all blocks but the first of each difficulty adjustment
+ * interval use the testnet special-min-difficulty rule.
+ */
+static void HeaderChainNextWork(benchmark::State& state, const std::string& chain, int nBlocks, bool fMinDifficultyRuns)
+{
+    const auto chainParams = CreateChainParams(chain);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    const unsigned int nProofOfWorkLimit = UintToArith256(params.powLimit).GetCompact();
+    const unsigned int nBitsStart = 0x1c0fffff;
+
+    std::vector<uint256> hashes(nBlocks);
+    std::vector<CBlockIndex> blocks(nBlocks);
+    for (int i = 0; i < nBlocks; i++) {
+        hashes[i] = ArithToUint256(arith_uint256(i + 1));
+        blocks[i].phashBlock = &hashes[i];
+        blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+        blocks[i].nHeight = i;
+        blocks[i].nTime = 1389306217 + i * params.nPowTargetSpacing;
+        blocks[i].nBits = fMinDifficultyRuns && i % params.DifficultyAdjustmentInterval() != 0 ? nProofOfWorkLimit : nBitsStart;
+        blocks[i].BuildSkip();
+    }
+
+    while (state.KeepRunning()) {
+        for (int i = 1; i < nBlocks; i++) {
+            CBlockHeader header;
+            header.nTime = blocks[i].nTime;
+            header.nBits = blocks[i].nBits;
+            GetNextWorkRequired(&blocks[i - 1], &header, params);
+        }
+    }
+}
+
+static void HeaderChainNextWorkMain(benchmark::State& state)
+{
+    // Covers every retargeting algorithm
+    HeaderChainNextWork(state, CBaseChainParams::MAIN, 480000, false);
+}
+
+static void HeaderChainNextWorkTestnet(benchmark::State& state)
+{
+    HeaderChainNextWork(state, CBaseChainParams::TESTNET, 76000, true);
+}
+
+BENCHMARK(HeaderChainNextWorkMain, 2);
+BENCHMARK(HeaderChainNextWorkTestnet, 10);
@@ -0,0 +1,132 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <index/txindex.h>
+#include <miner.h>
+#include <pow.h>
+#include <scheduler.h>
+#include <txdb.h>
+#include <txmempool.h>
+#include <utiltime.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/thread.hpp>
+
+#include <vector>
+
+static CTxIn MineIndexSyncBlock(const CScript& coinbase_scriptPubKey)
+{
+    auto block = std::make_shared<CBlock>(
+        BlockAssembler{Params()}
+            .CreateNewBlock(coinbase_scriptPubKey, /* fMineWitnessTx */ true)
+            ->block);
+
+    block->nTime = ::chainActive.Tip()->GetMedianTimePast() + 1;
+    block->hashMerkleRoot = BlockMerkleRoot(*block);
+
+    while (!CheckProofOfWork(block->GetHash(), block->nBits, Params().GetConsensus())) {
+        assert(++block->nNonce);
+    }
+
+    bool processed{ProcessNewBlock(Params(), block, true, nullptr)};
+    assert(processed);
+
+    return CTxIn{block->vtx[0]->GetHash(), 0};
+}
+
+/**
+ * Extend the chain to at least NUM_BLOCKS blocks. Once coinbases are mature, every block also
+ * holds a transaction spending the coinbase mined COINBASE_MATURITY blocks before it, so the
+ * index has more than the coinbases to write.
+ */
+static void PrepareIndexSyncChain()
+{
+    constexpr int NUM_BLOCKS{2000};
+    constexpr int NUM_OUTPUTS{50};
+
+    const std::vector<unsigned char> op_true{OP_TRUE};
+    CScriptWitness witness;
+    witness.stack.push_back(op_true);
+
+    uint256 witness_program;
+    CSHA256().Write(&op_true[0], op_true.size()).Finalize(witness_program.begin());
+
+    const CScript SCRIPT_PUB{CScript(OP_0) << std::vector<unsigned char>{witness_program.begin(), witness_program.end()}};
+
+    // Another benchmark may have set up a chain already, keep building on it
+    if (::chainActive.Tip() == nullptr) {
+        SelectParams(CBaseChainParams::REGTEST);
+        InitScriptExecutionCache();
+
+        ::pblocktree.reset(new CBlockTreeDB(1 << 20, true));
+        ::pcoinsdbview.reset(new CCoinsViewDB(1 << 23, true));
+        ::pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
+
+        LoadGenesisBlock(Params());
+        CValidationState state;
+        ActivateBestChain(state, Params());
+        assert(::chainActive.Tip() != nullptr);
+    }
+
+    std::vector<CTxIn> coinbases;
+    while (::chainActive.Height() + 1 < NUM_BLOCKS) {
+        if (coinbases.size() >= COINBASE_MATURITY) {
+            CMutableTransaction tx;
+            tx.vin.push_back(coinbases[coinbases.size() - COINBASE_MATURITY]);
+            tx.vin.back().scriptWitness = witness;
+            for (int i = 0; i < NUM_OUTPUTS; ++i) {
+                tx.vout.emplace_back(100000, SCRIPT_PUB);
+            }
+
+            LOCK(::cs_main); // Required for ::AcceptToMemoryPool.
+            CValidationState state;
+            bool ret{::AcceptToMemoryPool(::mempool, state, MakeTransactionRef(tx), nullptr /* pfMissingInputs */, nullptr /* plTxnReplaced */, false /* bypass_limits */, /* nAbsurdFee */ 0)};
+            assert(ret);
+        }
+        coinbases.push_back(MineIndexSyncBlock(SCRIPT_PUB));
+    }
+}
+
+static void IndexSync(benchmark::State& state, int sync_threads)
+{
+    boost::thread_group thread_group;
+    CScheduler scheduler;
+    thread_group.create_thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+
+    PrepareIndexSyncChain();
+
+    while (state.KeepRunning()) {
+        TxIndex txindex(1 << 20, true, true);
+        txindex.Start(sync_threads);
+        while (!txindex.BlockUntilSyncedToCurrentChain()) {
+            MilliSleep(1);
+        }
+        txindex.Stop();
+    }
+
+    thread_group.interrupt_all();
+    thread_group.join_all();
+    GetMainSignals().FlushBackgroundCallbacks();
+    GetMainSignals().UnregisterBackgroundSignalScheduler();
+}
+
+static void IndexSyncSequential(benchmark::State& state)
+{
+    IndexSync(state, 1);
+}
+
+static void IndexSyncParallel(benchmark::State& state)
+{
+    IndexSync(state, DEFAULT_INDEX_SYNC_THREADS);
+}
+
+BENCHMARK(IndexSyncSequential, 5);
+BENCHMARK(IndexSyncParallel, 5);
@@ -0,0 +1,102 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <fs.h>
+#include <miner.h>
+#include <pow.h>
+#include <scheduler.h>
+#include <streams.h>
+#include <txdb.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/thread.hpp>
+
+static void MineImportBlock(const CScript& coinbase_scriptPubKey)
+{
+    auto block = std::make_shared<CBlock>(
+        BlockAssembler{Params()}
+            .CreateNewBlock(coinbase_scriptPubKey, /* fMineWitnessTx */ true)
+            ->block);
+
+    block->nTime = ::chainActive.Tip()->GetMedianTimePast() + 1;
+    block->hashMerkleRoot = BlockMerkleRoot(*block);
+
+    while (!CheckProofOfWork(block->GetHash(), block->nBits, Params().GetConsensus())) {
+        assert(++block->nNonce);
+    }
+
+    bool processed{ProcessNewBlock(Params(), block, true, nullptr)};
+    assert(processed);
+}
+
+/**
+ * Import a block file like -reindex does, with the blocks decoded and checked by the block
+ * decode threads while the import thread accepts the previous batch. The blocks are known
+ * already, so this measures reading, decoding and checking them.
+ */
+static void LoadExternalBlockFilePipelined(benchmark::State& state)
+{
+    constexpr int NUM_BLOCKS{1000};
+    constexpr int NUM_DECODE_THREADS{3};
+
+    boost::thread_group thread_group;
+    CScheduler scheduler;
+    thread_group.create_thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+    for (int i = 0; i < NUM_DECODE_THREADS; i++) {
+        thread_group.create_thread(&ThreadBlockDecode);
+    }
+
+    // Another benchmark may have set up a chain already, keep building on it
+    if (::chainActive.Tip() == nullptr) {
+        SelectParams(CBaseChainParams::REGTEST);
+        InitScriptExecutionCache();
+
+        ::pblocktree.reset(new CBlockTreeDB(1 << 20, true));
+        ::pcoinsdbview.reset(new CCoinsViewDB(1 << 23, true));
+        ::pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
+
+        LoadGenesisBlock(Params());
+        CValidationState state;
+        ActivateBestChain(state, Params());
+        assert(::chainActive.Tip() != nullptr);
+    }
+    const CScript SCRIPT_PUB{CScript() << OP_TRUE};
+    while (::chainActive.Height() + 1 < NUM_BLOCKS) {
+        MineImportBlock(SCRIPT_PUB);
+    }
+
+    // Write the chain to a file in the format of the blk?????.dat files
+    const fs::path path = fs::temp_directory_path() / fs::unique_path();
+    {
+        LOCK(cs_main);
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        assert(!file.IsNull());
+        for (int i = 0; i <= ::chainActive.Height(); i++) {
+            CBlock block;
+            bool read{ReadBlockFromDisk(block, ::chainActive[i], Params().GetConsensus())};
+            assert(read);
+            file << Params().MessageStart() << (unsigned int)GetSerializeSize(file, block) << block;
+        }
+    }
+
+    while (state.KeepRunning()) {
+        CDiskBlockPos pos(0, 0);
+        LoadExternalBlockFile(Params(), fsbridge::fopen(path, "rb"), &pos);
+    }
+    fs::remove(path);
+
+    thread_group.interrupt_all();
+    thread_group.join_all();
+    GetMainSignals().FlushBackgroundCallbacks();
+    GetMainSignals().UnregisterBackgroundSignalScheduler();
+}
+
+BENCHMARK(LoadExternalBlockFilePipelined, 2);
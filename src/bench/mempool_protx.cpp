@@ -0,0 +1,145 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bls/bls.h>
+#include <evo/deterministicmns.h>
+#include <evo/evodb.h>
+#include <evo/providertx.h>
+#include <evo/specialtx.h>
+#include <netbase.h>
+#include <random.h>
+#include <txmempool.h>
+
+#include <vector>
+
+static void AddTx(const CTransactionRef& tx, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    LockPoints lp;
+    pool.addUnchecked(tx->GetHash(), CTxMemPoolEntry(tx, 1000, 0, 1, false, 4, lp));
+}
+
+static CMutableTransaction MakeTx(const COutPoint& prevout)
+{
+    CMutableTransaction tx;
+    tx.vin.emplace_back(prevout);
+    tx.vout.emplace_back(1000 * COIN, CScript() << OP_TRUE);
+    return tx;
+}
+
+static CMutableTransaction MakeProRegTx(FastRandomContext& rng, int i, const CBLSPublicKey& pubKeyOperator)
+{
+    CMutableTransaction tx = MakeTx(COutPoint(rng.rand256(), 0));
+    tx.nVersion = 3;
+    tx.nType = TRANSACTION_PROVIDER_REGISTER;
+
+    CProRegTx proTx;
+    proTx.collateralOutpoint = COutPoint(rng.rand256(), 1);
+    proTx.addr = LookupNumeric(strprintf("10.0.%d.%d", i / 256, i % 256).c_str(), 40333);
+    proTx.keyIDOwner = CKeyID(uint160(rng.randbytes(20)));
+    proTx.pubKeyOperator = pubKeyOperator;
+    proTx.keyIDVoting = proTx.keyIDOwner;
+    proTx.scriptPayout = CScript() << OP_TRUE;
+    SetTxPayload(tx, proTx);
+    return tx;
+}
+
+// Many pending ProRegTxs besides regular transactions, and a block that mines some of the
+// ProRegTxs, spends the collaterals of others and registers masternodes on the addresses of
+// others, while most of its transactions are unrelated.
+static void MakeProTxMempoolAndBlock(std::vector<CTransactionRef>& mempoolTxs, std::vector<CTransactionRef>& block)
+{
+    constexpr int NUM_PROTXS = 1000;
+    constexpr int NUM_REGULAR_TXS = 2000;
+    constexpr int NUM_BLOCK_TXS = 2000;
+
+    FastRandomContext rng(true);
+    for (int i = 0; i < NUM_PROTXS; i++) {
+        CBLSSecretKey sk;
+        sk.MakeNewKey();
+        CMutableTransaction proRegTx = MakeProRegTx(rng, i, sk.GetPublicKey());
+        mempoolTxs.push_back(MakeTransactionRef(proRegTx));
+
+        CProRegTx proTx;
+        GetTxPayload(proRegTx, proTx);
+        switch (i % 4) {
+        case 0:
+            block.push_back(mempoolTxs.back());
+            break;
+        case 1:
+            block.push_back(MakeTransactionRef(MakeTx(proTx.collateralOutpoint)));
+            break;
+        case 2: {
+            CBLSSecretKey sk2;
+            sk2.MakeNewKey();
+            CMutableTransaction conflict = MakeProRegTx(rng, i, sk2.GetPublicKey());
+            block.push_back(MakeTransactionRef(conflict));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    for (int i = 0; i < NUM_REGULAR_TXS; i++) {
+        mempoolTxs.push_back(MakeTransactionRef(MakeTx(COutPoint(rng.rand256(), 0))));
+    }
+    while (block.size() < NUM_BLOCK_TXS) {
+        block.push_back(MakeTransactionRef(MakeTx(COutPoint(rng.rand256(), 0))));
+    }
+}
+
+// Each iteration has to refill the mempool, which the framework can't exclude from the timing.
+// fRemoveForBlock is false for the baseline that only refills and clears it, the cost of
+// removeForBlock is the difference between both benchmarks.
+static void MempoolProTx(benchmark::State& state, bool fRemoveForBlock)
+{
+    // Removing ProTx conflicts needs the masternode list at the tip, which is empty here
+    bool fOwnEvo = deterministicMNManager == nullptr;
+    if (fOwnEvo) {
+        evoDb = new CEvoDB(1 << 20, true, true);
+        deterministicMNManager = new CDeterministicMNManager(*evoDb);
+    }
+
+    std::vector<CTransactionRef> mempoolTxs;
+    std::vector<CTransactionRef> block;
+    MakeProTxMempoolAndBlock(mempoolTxs, block);
+
+    CTxMemPool pool;
+    while (state.KeepRunning()) {
+        {
+            LOCK(pool.cs);
+            for (const auto& tx : mempoolTxs) {
+                AddTx(tx, pool);
+            }
+        }
+        if (fRemoveForBlock) {
+            pool.removeForBlock(block, 1);
+        }
+        pool.clear();
+    }
+
+    if (fOwnEvo) {
+        delete deterministicMNManager;
+        deterministicMNManager = nullptr;
+        delete evoDb;
+        evoDb = nullptr;
+    }
+}
+
+// Fill a mempool holding many pending ProRegTxs and clear it again, the baseline of
+// MempoolRemoveForBlockProTx.
+static void MempoolAddProTx(benchmark::State& state)
+{
+    MempoolProTx(state, false);
+}
+
+// Connect a block to a mempool holding many pending ProRegTxs, see MakeProTxMempoolAndBlock.
+// Subtract MempoolAddProTx for the time spent in removeForBlock.
+static void MempoolRemoveForBlockProTx(benchmark::State& state)
+{
+    MempoolProTx(state, true);
+}
+
+BENCHMARK(MempoolAddProTx, 20);
+BENCHMARK(MempoolRemoveForBlockProTx, 20);
@@ -0,0 +1,157 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <compat.h>
+#include <net.h>
+#include <netbase.h>
+#include <random.h>
+
+#include <set>
+#include <vector>
+
+#ifndef WIN32
+
+// Number of simulated peers, kept below FD_SETSIZE so select() can be compared
+static const int NUM_PEERS = 400;
+// Number of peers that have data waiting on each iteration
+static const int ACTIVE_PEERS = 8;
+
+/** A set of connected loopback TCP socket pairs standing in for peers */
+class LoopbackPeers
+{
+public:
+    std::vector<SOCKET> vClient;
+    std::vector<SOCKET> vServer;
+
+    explicit LoopbackPeers(int nPeers)
+    {
+        SOCKET hListen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+        if (hListen == INVALID_SOCKET || bind(hListen, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+            getsockname(hListen, (struct sockaddr*)&addr, &len) != 0 || listen(hListen, SOMAXCONN) != 0) {
+            throw std::runtime_error("cannot set up loopback listener");
+        }
+        for (int i = 0; i < nPeers; i++) {
+            SOCKET hClient = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (hClient == INVALID_SOCKET || connect(hClient, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+                throw std::runtime_error("cannot connect to loopback listener");
+            }
+            SOCKET hServer = accept(hListen, nullptr, nullptr);
+            if (hServer == INVALID_SOCKET) {
+                throw std::runtime_error("cannot accept loopback connection");
+            }
+            SetSocketNoDelay(hClient);
+            vClient.push_back(hClient);
+            vServer.push_back(hServer);
+        }
+        CloseSocket(hListen);
+    }
+
+    ~LoopbackPeers()
+    {
+        for (SOCKET& hSocket : vClient) CloseSocket(hSocket);
+        for (SOCKET& hSocket : vServer) CloseSocket(hSocket);
+    }
+
+    /** Make a few random peers readable */
+    void Send(FastRandomContext& rand)
+    {
+        char c = 0;
+        for (int i = 0; i < ACTIVE_PEERS; i++) {
+            if (send(vClient[rand.randrange(vClient.size())], &c, 1, MSG_NOSIGNAL) != 1) {
+                throw std::runtime_error("send failed");
+            }
+        }
+    }
+
+    /** Drain the sockets reported as readable, returns the number of bytes read */
+    size_t Receive(const std::set<SOCKET>& recv_set)
+    {
+        char buf[64];
+        size_t nBytes = 0;
+        for (SOCKET hSocket : recv_set) {
+            ssize_t n = recv(hSocket, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n > 0) nBytes += n;
+        }
+        return nBytes;
+    }
+};
+
+// Wait for readable peers the way the select() backend of ThreadSocketHandler does,
+// rebuilding the fd_set over every peer on each wakeup.
+static void SocketEventsSelect(benchmark::State& state)
+{
+    LoopbackPeers peers(NUM_PEERS);
+    FastRandomContext rand(true);
+    while (state.KeepRunning()) {
+        peers.Send(rand);
+        size_t nReceived = 0;
+        while (nReceived < ACTIVE_PEERS) {
+            fd_set fdsetRecv;
+            fd_set fdsetError;
+            FD_ZERO(&fdsetRecv);
+            FD_ZERO(&fdsetError);
+            SOCKET hSocketMax = 0;
+            for (SOCKET hSocket : peers.vServer) {
+                FD_SET(hSocket, &fdsetRecv);
+                FD_SET(hSocket, &fdsetError);
+                hSocketMax = std::max(hSocketMax, hSocket);
+            }
+            struct timeval timeout;
+            timeout.tv_sec = 1;
+            timeout.tv_usec = 0;
+            if (select(hSocketMax + 1, &fdsetRecv, nullptr, &fdsetError, &timeout) == SOCKET_ERROR) {
+                throw std::runtime_error("select failed");
+            }
+            std::set<SOCKET> recv_set;
+            for (SOCKET hSocket : peers.vServer) {
+                if (FD_ISSET(hSocket, &fdsetRecv)) recv_set.insert(hSocket);
+            }
+            nReceived += peers.Receive(recv_set);
+        }
+    }
+}
+
+BENCHMARK(SocketEventsSelect, 2000);
+
+#ifdef USE_EPOLL
+// Same workload with the persistent epoll interest set used by -socketevents=epoll.
+static void SocketEventsEpoll(benchmark::State& state)
+{
+    LoopbackPeers peers(NUM_PEERS);
+    CSocketEventsEpoll events;
+    for (size_t i = 0; i < peers.vServer.size(); i++) {
+        if (!events.Add(peers.vServer[i], CSocketEventsEpoll::EVENT_RECV, i)) {
+            throw std::runtime_error("epoll registration failed");
+        }
+    }
+    FastRandomContext rand(true);
+    while (state.KeepRunning()) {
+        peers.Send(rand);
+        size_t nReceived = 0;
+        while (nReceived < ACTIVE_PEERS) {
+            std::vector<CSocketEventsEpoll::Event> ready;
+            if (!events.Wait(1000, ready)) {
+                throw std::runtime_error("epoll_wait failed");
+            }
+            // The events name the peers directly, no pass over all of them is needed
+            std::set<SOCKET> recv_set;
+            for (const CSocketEventsEpoll::Event& event : ready) {
+                if (event.nEvents & CSocketEventsEpoll::EVENT_RECV) recv_set.insert(peers.vServer[event.nData]);
+            }
+            nReceived += peers.Receive(recv_set);
+        }
+    }
+}
+
+BENCHMARK(SocketEventsEpoll, 2000);
+#endif // USE_EPOLL
+
+#endif // WIN32
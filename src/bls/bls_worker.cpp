@@ -885,6 +885,23 @@ std::future<bool> CBLSWorker::AsyncVerifySig(const CBLSSignature& sig, const CBL
     return std::move(p.second);
 }
 
+void CBLSWorker::AsyncVerifySecureAggregatedSig(const CBLSSignature& sig, const BLSPublicKeyVector& pubKeys, const uint256& msgHash,
+                                                CBLSWorker::SigVerifyDoneCallback doneCallback, CancelCond cancelCond)
+{
+    if (!sig.IsValid() || pubKeys.empty()) {
+        doneCallback(false);
+        return;
+    }
+
+    auto f = [sig, pubKeys, msgHash, doneCallback, cancelCond](int threadId) {
+        if (cancelCond()) {
+            return;
+        }
+        doneCallback(sig.VerifySecureAggregated(pubKeys, msgHash));
+    };
+    workerPool.push(f);
+}
+
 bool CBLSWorker::IsAsyncVerifyInProgress()
 {
     std::unique_lock<std::mutex> l(sigVerifyMutex);
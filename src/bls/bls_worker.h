@@ -139,6 +139,11 @@ public:
     std::future<bool> AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, CancelCond cancelCond = [] { return false; });
     bool IsAsyncVerifyInProgress();
 
+    // Verification of a securely aggregated signature of multiple public keys over the same message. This can't be
+    // combined with other signatures into a single aggregated verification, so each call results in its own job.
+    // doneCallback is not called if cancelCond returns true before the job starts
+    void AsyncVerifySecureAggregatedSig(const CBLSSignature& sig, const BLSPublicKeyVector& pubKeys, const uint256& msgHash, SigVerifyDoneCallback doneCallback, CancelCond cancelCond = [] { return false; });
+
 private:
     void PushSigVerifyBatch();
 };
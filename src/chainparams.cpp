@@ -59,6 +59,11 @@ void CChainParams::UpdateVersionBitsParameters(Consensus::DeploymentPos d, int64
     consensus.vDeployments[d].nTimeout = nTimeout;
 }
 
+void CChainParams::UpdateSnapshotHash(int nHeight, const uint256& hash)
+{
+    snapshotHashes[nHeight] = hash;
+}
+
 // this one is for testing only
 static Consensus::LLMQParams llmq10_60 = {
         .type = Consensus::LLMQ_10_60,
@@ -252,6 +257,10 @@ public:
             }
         };
 
+        // No UTXO snapshot has been pinned yet, loadtxoutset only accepts the hashes listed here. A hash
+        // is added once independent nodes running dumptxoutset at the same block agree on it.
+        snapshotHashes = {};
+
         chainTxData = ChainTxData{
             // Data as of block 0x1ddf5a63bf1ecc82c62156dd64d2c71fb93beca86295321144d42e0a41ad324d (height 915598).
             1591809615, // * UNIX timestamp of last known number of transactions
@@ -355,6 +364,10 @@ public:
             }
         };
 
+        // No UTXO snapshot has been pinned yet, loadtxoutset only accepts the hashes listed here. A hash
+        // is added once independent nodes running dumptxoutset at the same block agree on it.
+        snapshotHashes = {};
+
         chainTxData = ChainTxData{
             // Data as of block 3c63f32416111dca75775eb0361b110be82f4603a83bb3f2e8d88326a5ccf2f3 (height 209).
             0, // * UNIX timestamp of last known number of transactions
@@ -451,6 +464,9 @@ public:
             }
         };
 
+        // UTXO snapshots are pinned with -snapshothash
+        snapshotHashes = {};
+
         chainTxData = ChainTxData{
             0,
             0,
@@ -508,3 +524,8 @@ void UpdateVersionBitsParameters(Consensus::DeploymentPos d, int64_t nStartTime,
 {
     globalChainParams->UpdateVersionBitsParameters(d, nStartTime, nTimeout);
 }
+
+void UpdateSnapshotHash(int nHeight, const uint256& hash)
+{
+    globalChainParams->UpdateSnapshotHash(nHeight, hash);
+}
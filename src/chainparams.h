@@ -25,6 +25,9 @@ struct CCheckpointData {
     MapCheckpoints mapCheckpoints;
 };
 
+/** Hashes of the UTXO snapshots which may be loaded, by the height of their base block */
+typedef std::map<int, uint256> MapSnapshotHashes;
+
 /**
  * Holds various statistics on transactions within a chain. Used to estimate
  * verification progress during chain sync.
@@ -81,7 +84,9 @@ public:
     const std::vector<SeedSpec6>& FixedSeeds() const { return vFixedSeeds; }
     const CCheckpointData& Checkpoints() const { return checkpointData; }
     const ChainTxData& TxData() const { return chainTxData; }
+    const MapSnapshotHashes& SnapshotHashes() const { return snapshotHashes; }
     void UpdateVersionBitsParameters(Consensus::DeploymentPos d, int64_t nStartTime, int64_t nTimeout);
+    void UpdateSnapshotHash(int nHeight, const uint256& hash);
 	int FulfilledRequestExpireTime() const { return nFulfilledRequestExpireTime; }
 protected:
     CChainParams() {}
@@ -101,6 +106,7 @@ protected:
     bool fMineBlocksOnDemand;
     CCheckpointData checkpointData;
     ChainTxData chainTxData;
+    MapSnapshotHashes snapshotHashes;
 	int nFulfilledRequestExpireTime;
     bool m_fallback_fee_enabled;
 };
@@ -129,4 +135,9 @@ void SelectParams(const std::string& chain);
  */
 void UpdateVersionBitsParameters(Consensus::DeploymentPos d, int64_t nStartTime, int64_t nTimeout);
 
+/**
+ * Allows pinning the hash of a UTXO snapshot on regtest.
+ */
+void UpdateSnapshotHash(int nHeight, const uint256& hash);
+
 #endif // MACHINECOIN_CHAINPARAMS_H
@@ -0,0 +1,229 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/muhash.h>
+
+#include <crypto/chacha20.h>
+#include <crypto/sha256.h>
+
+#include <limits>
+
+namespace {
+
+typedef Num3072::limb_t limb_t;
+typedef Num3072::double_limb_t double_limb_t;
+constexpr int LIMBS = Num3072::LIMBS;
+constexpr int LIMB_SIZE = Num3072::LIMB_SIZE;
+/** 2^3072 - 1103717 is the largest 3072-bit safe prime number, so 2^3072 = MAX_PRIME_DIFF (mod p) */
+constexpr limb_t MAX_PRIME_DIFF = 1103717;
+
+/** Whether a reduced number is at least the modulus, which is only the case for the numbers p to 2^3072 - 1 */
+bool IsOverflow(const limb_t (&a)[LIMBS])
+{
+    if (a[0] <= std::numeric_limits<limb_t>::max() - MAX_PRIME_DIFF) return false;
+    for (int i = 1; i < LIMBS; i++) {
+        if (a[i] != std::numeric_limits<limb_t>::max()) return false;
+    }
+    return true;
+}
+
+/** Add c * 2^3072 = c * MAX_PRIME_DIFF (mod p) to a, until no multiple of 2^3072 is left, and reduce */
+void Reduce(limb_t (&a)[LIMBS], limb_t c)
+{
+    while (c != 0) {
+        double_limb_t cur = (double_limb_t)c * MAX_PRIME_DIFF;
+        for (int i = 0; i < LIMBS && cur != 0; i++) {
+            cur += a[i];
+            a[i] = (limb_t)cur;
+            cur >>= LIMB_SIZE;
+        }
+        c = (limb_t)cur;
+    }
+    if (IsOverflow(a)) {
+        // a - p = a + MAX_PRIME_DIFF - 2^3072, which doesn't overflow into another limb
+        double_limb_t cur = MAX_PRIME_DIFF;
+        for (int i = 0; i < LIMBS; i++) {
+            cur += a[i];
+            a[i] = (limb_t)cur;
+            cur >>= LIMB_SIZE;
+        }
+    }
+}
+
+/** Set a to the low half of tmp plus its high half times 2^3072 (mod p) */
+void ReduceProduct(limb_t (&a)[LIMBS], const limb_t (&tmp)[2 * LIMBS])
+{
+    double_limb_t cur = 0;
+    for (int i = 0; i < LIMBS; i++) {
+        cur += (double_limb_t)tmp[LIMBS + i] * MAX_PRIME_DIFF + tmp[i];
+        a[i] = (limb_t)cur;
+        cur >>= LIMB_SIZE;
+    }
+    Reduce(a, (limb_t)cur);
+}
+
+} // namespace
+
+Num3072::Num3072(const unsigned char (&data)[BYTE_SIZE])
+{
+    for (int i = 0; i < LIMBS; i++) {
+        limb_t limb = 0;
+        for (int j = LIMB_SIZE / 8 - 1; j >= 0; j--) {
+            limb = (limb << 8) | data[i * (LIMB_SIZE / 8) + j];
+        }
+        limbs[i] = limb;
+    }
+}
+
+void Num3072::ToBytes(unsigned char (&out)[BYTE_SIZE]) const
+{
+    for (int i = 0; i < LIMBS; i++) {
+        for (int j = 0; j < LIMB_SIZE / 8; j++) {
+            out[i * (LIMB_SIZE / 8) + j] = (unsigned char)(limbs[i] >> (8 * j));
+        }
+    }
+}
+
+void Num3072::SetToOne()
+{
+    limbs[0] = 1;
+    for (int i = 1; i < LIMBS; i++) {
+        limbs[i] = 0;
+    }
+}
+
+void Num3072::Multiply(const Num3072& a)
+{
+    limb_t tmp[2 * LIMBS] = {};
+    for (int i = 0; i < LIMBS; i++) {
+        double_limb_t cur = 0;
+        for (int j = 0; j < LIMBS; j++) {
+            cur += (double_limb_t)limbs[i] * a.limbs[j] + tmp[i + j];
+            tmp[i + j] = (limb_t)cur;
+            cur >>= LIMB_SIZE;
+        }
+        tmp[i + LIMBS] = (limb_t)cur;
+    }
+    ReduceProduct(limbs, tmp);
+}
+
+void Num3072::Square()
+{
+    // Sum up the products of distinct limbs once, double them and add the squares of the limbs
+    limb_t tmp[2 * LIMBS] = {};
+    for (int i = 0; i < LIMBS; i++) {
+        double_limb_t cur = 0;
+        for (int j = i + 1; j < LIMBS; j++) {
+            cur += (double_limb_t)limbs[i] * limbs[j] + tmp[i + j];
+            tmp[i + j] = (limb_t)cur;
+            cur >>= LIMB_SIZE;
+        }
+        tmp[i + LIMBS] = (limb_t)cur;
+    }
+    limb_t carry = 0;
+    for (int i = 0; i < 2 * LIMBS; i++) {
+        limb_t next_carry = tmp[i] >> (LIMB_SIZE - 1);
+        tmp[i] = (tmp[i] << 1) | carry;
+        carry = next_carry;
+    }
+    double_limb_t cur = 0;
+    for (int i = 0; i < LIMBS; i++) {
+        cur += (double_limb_t)limbs[i] * limbs[i] + tmp[2 * i];
+        tmp[2 * i] = (limb_t)cur;
+        cur >>= LIMB_SIZE;
+        cur += tmp[2 * i + 1];
+        tmp[2 * i + 1] = (limb_t)cur;
+        cur >>= LIMB_SIZE;
+    }
+    ReduceProduct(limbs, tmp);
+}
+
+/** Compute a^(2^n - 1) with n - 1 squarings and about 2 * log2(n) multiplications */
+static Num3072 PowerOfOnes(const Num3072& a, int n)
+{
+    if (n == 1) return a;
+    if (n % 2 == 1) {
+        Num3072 r = PowerOfOnes(a, n - 1);
+        r.Square();
+        r.Multiply(a);
+        return r;
+    }
+    Num3072 half = PowerOfOnes(a, n / 2);
+    Num3072 r = half;
+    for (int i = 0; i < n / 2; i++) {
+        r.Square();
+    }
+    r.Multiply(half);
+    return r;
+}
+
+Num3072 Num3072::GetInverse() const
+{
+    // Fermat's little theorem: a^-1 = a^(p - 2) (mod p). The exponent
+    // p - 2 = 2^3072 - 1103719 consists of 3051 one bits followed by the
+    // 21 bits of 2^21 - 1103719.
+    constexpr int LOW_BITS = 21;
+    constexpr uint32_t LOW_VALUE = (1 << LOW_BITS) - (MAX_PRIME_DIFF + 2);
+    Num3072 r = PowerOfOnes(*this, 3072 - LOW_BITS);
+    for (int i = LOW_BITS - 1; i >= 0; i--) {
+        r.Square();
+        if ((LOW_VALUE >> i) & 1) {
+            r.Multiply(*this);
+        }
+    }
+    return r;
+}
+
+void Num3072::Divide(const Num3072& a)
+{
+    Multiply(a.GetInverse());
+}
+
+Num3072 MuHash3072::ToNum3072(const unsigned char* data, size_t len)
+{
+    unsigned char hashed[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(data, len).Finalize(hashed);
+    unsigned char tmp[Num3072::BYTE_SIZE];
+    ChaCha20(hashed, sizeof(hashed)).Output(tmp, sizeof(tmp));
+    Num3072 num(tmp);
+    // Numbers of at least the modulus only occur with negligible probability, map them into range anyway
+    Reduce(num.limbs, 0);
+    return num;
+}
+
+MuHash3072& MuHash3072::Insert(const unsigned char* data, size_t len)
+{
+    m_numerator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::Remove(const unsigned char* data, size_t len)
+{
+    m_denominator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator*=(const MuHash3072& mul)
+{
+    m_numerator.Multiply(mul.m_numerator);
+    m_denominator.Multiply(mul.m_denominator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator/=(const MuHash3072& div)
+{
+    m_numerator.Multiply(div.m_denominator);
+    m_denominator.Multiply(div.m_numerator);
+    return *this;
+}
+
+void MuHash3072::Finalize(uint256& out)
+{
+    m_numerator.Divide(m_denominator);
+    m_denominator.SetToOne();
+
+    unsigned char data[Num3072::BYTE_SIZE];
+    m_numerator.ToBytes(data);
+    CSHA256().Write(data, sizeof(data)).Finalize(out.begin());
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_CRYPTO_MUHASH_H
+#define MACHINECOIN_CRYPTO_MUHASH_H
+
+#include <serialize.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** An element of the multiplicative group of integers modulo 2^3072 - 1103717. */
+class Num3072
+{
+public:
+    static constexpr size_t BYTE_SIZE = 384;
+
+#ifdef __SIZEOF_INT128__
+    typedef unsigned __int128 double_limb_t;
+    typedef uint64_t limb_t;
+    static constexpr int LIMBS = 48;
+    static constexpr int LIMB_SIZE = 64;
+#else
+    typedef uint64_t double_limb_t;
+    typedef uint32_t limb_t;
+    static constexpr int LIMBS = 96;
+    static constexpr int LIMB_SIZE = 32;
+#endif
+    limb_t limbs[LIMBS];
+
+    /** Constructs the number one. */
+    Num3072() { SetToOne(); }
+    /** Constructs a number from its little endian encoding, which must be smaller than the modulus. */
+    explicit Num3072(const unsigned char (&data)[BYTE_SIZE]);
+
+    void SetToOne();
+    void Multiply(const Num3072& a);
+    void Square();
+    void Divide(const Num3072& a);
+    Num3072 GetInverse() const;
+    void ToBytes(unsigned char (&out)[BYTE_SIZE]) const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        for (int i = 0; i < LIMBS; i++) {
+            READWRITE(limbs[i]);
+        }
+    }
+};
+
+/**
+ * A multiplicative hash of a set of byte strings (MuHash3072). Every element
+ * is mapped to a number modulo a 3072-bit prime and the hash of the set is the
+ * product of these numbers, so elements can be added and removed in any order
+ * and the hash of a set can be updated without knowing the rest of the set.
+ *
+ * To make removals cheap, the numbers of added and removed elements are
+ * multiplied into separate accumulators and only divided in Finalize.
+ */
+class MuHash3072
+{
+private:
+    Num3072 m_numerator;
+    Num3072 m_denominator;
+
+    static Num3072 ToNum3072(const unsigned char* data, size_t len);
+
+public:
+    /** Constructs the hash of the empty set. */
+    MuHash3072() {}
+
+    /** Add an element to the set. */
+    MuHash3072& Insert(const unsigned char* data, size_t len);
+
+    /** Remove an element from the set. It is not checked whether the element was in the set. */
+    MuHash3072& Remove(const unsigned char* data, size_t len);
+
+    /** Add all elements of another set. */
+    MuHash3072& operator*=(const MuHash3072& mul);
+
+    /** Remove all elements of another set. */
+    MuHash3072& operator/=(const MuHash3072& div);
+
+    /** Compute the hash of the set. This is relatively expensive as it involves a modular inversion. */
+    void Finalize(uint256& out);
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(m_numerator);
+        READWRITE(m_denominator);
+    }
+};
+
+#endif // MACHINECOIN_CRYPTO_MUHASH_H
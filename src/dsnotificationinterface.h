@@ -21,6 +21,9 @@ protected:
     void AcceptedBlockHeader(const CBlockIndex *pindexNew) override;
     void NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDownload) override;
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+    std::string GetSubscriberName() const override { return "dsnotification"; }
+    // Shares state with the masternode maintenance tasks on the scheduler thread
+    bool UseSchedulerThread() const override { return true; }
 
 private:
     CConnman& connman;
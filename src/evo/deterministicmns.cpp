@@ -345,6 +345,31 @@ CDeterministicMNListDiff CDeterministicMNList::BuildDiff(const CDeterministicMNL
     return diffRet;
 }
 
+CDeterministicMNListDiff CDeterministicMNList::BuildDiffFromChanges(const CDeterministicMNList& to) const
+{
+    CDeterministicMNListDiff diffRet;
+    diffRet.prevBlockHash = blockHash;
+    diffRet.blockHash = to.blockHash;
+    diffRet.nHeight = to.nHeight;
+
+    for (const auto& proTxHash : to.changedMNs) {
+        auto fromPtr = GetMN(proTxHash);
+        auto toPtr = to.GetMN(proTxHash);
+        if (toPtr == nullptr) {
+            // an MN which was added and removed again in the same block is neither in the old nor in the new list
+            if (fromPtr != nullptr) {
+                diffRet.removedMns.insert(proTxHash);
+            }
+        } else if (fromPtr == nullptr) {
+            diffRet.addedMNs.emplace(proTxHash, toPtr);
+        } else if (*toPtr->pdmnState != *fromPtr->pdmnState) {
+            diffRet.updatedMNs.emplace(proTxHash, toPtr->pdmnState);
+        }
+    }
+
+    return diffRet;
+}
+
 CSimplifiedMNListDiff CDeterministicMNList::BuildSimplifiedDiff(const CDeterministicMNList& to) const
 {
     CSimplifiedMNListDiff diffRet;
@@ -390,6 +415,7 @@ CDeterministicMNList CDeterministicMNList::ApplyDiff(const CDeterministicMNListD
     for (const auto& p : diff.updatedMNs) {
         result.UpdateMN(p.first, p.second);
     }
+    result.ClearChangedMNs();
 
     return result;
 }
@@ -406,6 +432,7 @@ void CDeterministicMNList::AddMN(const CDeterministicMNCPtr& dmn)
     if (dmn->pdmnState->pubKeyOperator.IsValid()) {
         AddUniqueProperty(dmn, dmn->pdmnState->pubKeyOperator);
     }
+    UpdateIndexes(dmn->proTxHash, nullptr, dmn->pdmnState);
 }
 
 void CDeterministicMNList::UpdateMN(const uint256& proTxHash, const CDeterministicMNStateCPtr& pdmnState)
@@ -420,6 +447,7 @@ void CDeterministicMNList::UpdateMN(const uint256& proTxHash, const CDeterminist
     UpdateUniqueProperty(dmn, oldState->addr, pdmnState->addr);
     UpdateUniqueProperty(dmn, oldState->keyIDOwner, pdmnState->keyIDOwner);
     UpdateUniqueProperty(dmn, oldState->pubKeyOperator, pdmnState->pubKeyOperator);
+    UpdateIndexes(proTxHash, oldState, pdmnState);
 }
 
 void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
@@ -435,6 +463,38 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
         DeleteUniqueProperty(dmn, dmn->pdmnState->pubKeyOperator);
     }
     mnMap = mnMap.erase(proTxHash);
+    UpdateIndexes(proTxHash, dmn->pdmnState, nullptr);
+}
+
+static bool IsUnconfirmed(const CDeterministicMNStateCPtr& state)
+{
+    return state && state->confirmedHash.IsNull();
+}
+
+static bool IsPenalized(const CDeterministicMNStateCPtr& state)
+{
+    return state && state->nPoSePenalty > 0 && state->nPoSeBanHeight == -1;
+}
+
+void CDeterministicMNList::RebuildIndexes()
+{
+    unconfirmedMNs = MnSet();
+    penalizedMNs = MnSet();
+    for (const auto& p : mnMap) {
+        UpdateIndexes(p.first, nullptr, p.second->pdmnState);
+    }
+    changedMNs.clear();
+}
+
+void CDeterministicMNList::UpdateIndexes(const uint256& proTxHash, const CDeterministicMNStateCPtr& oldState, const CDeterministicMNStateCPtr& newState)
+{
+    if (IsUnconfirmed(oldState) != IsUnconfirmed(newState)) {
+        unconfirmedMNs = IsUnconfirmed(newState) ? unconfirmedMNs.insert(proTxHash) : unconfirmedMNs.erase(proTxHash);
+    }
+    if (IsPenalized(oldState) != IsPenalized(newState)) {
+        penalizedMNs = IsPenalized(newState) ? penalizedMNs.insert(proTxHash) : penalizedMNs.erase(proTxHash);
+    }
+    changedMNs.emplace(proTxHash);
 }
 
 CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
@@ -467,7 +527,7 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
     newList.SetBlockHash(block.GetHash());
 
     CDeterministicMNList oldList = GetListForBlock(pindex->pprev->GetBlockHash());
-    CDeterministicMNListDiff diff = oldList.BuildDiff(newList);
+    CDeterministicMNListDiff diff = oldList.BuildDiffFromChanges(newList);
 
     evoDb.Write(std::make_pair(DB_LIST_DIFF, diff.blockHash), diff);
     if ((nHeight % SNAPSHOT_LIST_PERIOD) == 0 || oldList.GetHeight() == -1) {
@@ -521,17 +581,15 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
     CDeterministicMNList newList = oldList;
     newList.SetBlockHash(uint256()); // we can't know the final block hash, so better not return a (invalid) block hash
     newList.SetHeight(nHeight);
+    // from here on, newList records all changes so that ProcessBlock can build the diff from them
+    newList.ClearChangedMNs();
 
     auto payee = oldList.GetMNPayee();
 
     // we iterate the oldList here and update the newList
     // this is only valid as long these have not diverged at this point, which is the case as long as we don't add
     // code above this loop that modifies newList
-    oldList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
-        if (!dmn->pdmnState->confirmedHash.IsNull()) {
-            // already confirmed
-            return;
-        }
+    oldList.ForEachUnconfirmedMN([&](const CDeterministicMNCPtr& dmn) {
         // this works on the previous block, so confirmation will happen one block after nMasternodeMinimumConfirmations
         // has been reached, but the block hash will then point to the block at nMasternodeMinimumConfirmations
         int nConfirmations = pindexPrev->nHeight - dmn->pdmnState->nRegisteredHeight;
@@ -763,13 +821,10 @@ void CDeterministicMNManager::HandleQuorumCommitment(llmq::CFinalCommitment& qc,
 void CDeterministicMNManager::DecreasePoSePenalties(CDeterministicMNList& mnList)
 {
     std::vector<uint256> toDecrease;
-    toDecrease.reserve(mnList.GetValidMNsCount() / 10);
     // only iterate and decrease for valid ones (not PoSe banned yet)
     // if a MN ever reaches the maximum, it stays in PoSe banned state until revived
-    mnList.ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
-        if (dmn->pdmnState->nPoSePenalty > 0 && dmn->pdmnState->nPoSeBanHeight == -1) {
-            toDecrease.emplace_back(dmn->proTxHash);
-        }
+    mnList.ForEachPenalizedMN([&](const CDeterministicMNCPtr& dmn) {
+        toDecrease.emplace_back(dmn->proTxHash);
     });
 
     for (const auto& proTxHash : toDecrease) {
@@ -825,6 +880,16 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const uint256& blo
     return snapshot;
 }
 
+void CDeterministicMNManager::WriteListToBatch(CDBBatch& batch, const CDeterministicMNList& list)
+{
+    batch.Write(std::make_pair(DB_LIST_SNAPSHOT, list.GetBlockHash()), list);
+}
+
+void CDeterministicMNManager::WriteListDiffToBatch(CDBBatch& batch, const CDeterministicMNListDiff& diff)
+{
+    batch.Write(std::make_pair(DB_LIST_DIFF, diff.blockHash), diff);
+}
+
 CDeterministicMNList CDeterministicMNManager::GetListAtChainTip()
 {
     LOCK(cs);
@@ -15,8 +15,10 @@
 
 #include <immer/map.hpp>
 #include <immer/map_transient.hpp>
+#include <immer/set.hpp>
 
 #include <map>
+#include <set>
 
 class CBlock;
 class CBlockIndex;
@@ -200,6 +202,7 @@ class CDeterministicMNList
 public:
     typedef immer::map<uint256, CDeterministicMNCPtr> MnMap;
     typedef immer::map<uint256, std::pair<uint256, uint32_t> > MnUniquePropertyMap;
+    typedef immer::set<uint256> MnSet;
 
 private:
     uint256 blockHash;
@@ -211,6 +214,15 @@ private:
     // the entries in the map are ref counted as some properties might appear multiple times per MN (e.g. operator/owner keys)
     MnUniquePropertyMap mnUniquePropertyMap;
 
+    // side indexes of MNs which are not confirmed yet and of MNs which have a PoSe penalty to decrease
+    // they are not serialized but rebuilt on load, so that per-block processing doesn't have to scan the whole list
+    MnSet unconfirmedMNs;
+    MnSet penalizedMNs;
+
+    // proTxHashes of all MNs which were added, updated or removed since the last call to ClearChangedMNs
+    // this is not serialized and only used to build diffs without comparing the full lists
+    std::set<uint256> changedMNs;
+
 public:
     CDeterministicMNList() {}
     explicit CDeterministicMNList(const uint256& _blockHash, int _height) :
@@ -229,6 +241,7 @@ public:
         if (ser_action.ForRead()) {
             UnserializeImmerMap(s, mnMap);
             UnserializeImmerMap(s, mnUniquePropertyMap);
+            RebuildIndexes();
         } else {
             SerializeImmerMap(s, mnMap);
             SerializeImmerMap(s, mnUniquePropertyMap);
@@ -262,6 +275,33 @@ public:
         }
     }
 
+    // Calls cb for all MNs which have no confirmedHash yet, including PoSe banned ones
+    template <typename Callback>
+    void ForEachUnconfirmedMN(Callback&& cb) const
+    {
+        for (const auto& proTxHash : unconfirmedMNs) {
+            cb(GetMN(proTxHash));
+        }
+    }
+
+    // Calls cb for all valid MNs with a PoSe penalty above 0
+    template <typename Callback>
+    void ForEachPenalizedMN(Callback&& cb) const
+    {
+        for (const auto& proTxHash : penalizedMNs) {
+            cb(GetMN(proTxHash));
+        }
+    }
+
+    const std::set<uint256>& GetChangedMNs() const
+    {
+        return changedMNs;
+    }
+    void ClearChangedMNs()
+    {
+        changedMNs.clear();
+    }
+
 public:
     const uint256& GetBlockHash() const
     {
@@ -346,6 +386,13 @@ public:
     void PoSeDecrease(const uint256& proTxHash);
 
     CDeterministicMNListDiff BuildDiff(const CDeterministicMNList& to) const;
+    /**
+     * Same as BuildDiff, but only looks at the MNs recorded as changed in "to". Only valid if "to" was copied from
+     * this list and ClearChangedMNs was called on it (or it had no changes recorded) before modifying it.
+     * @param to
+     * @return
+     */
+    CDeterministicMNListDiff BuildDiffFromChanges(const CDeterministicMNList& to) const;
     CSimplifiedMNListDiff BuildSimplifiedDiff(const CDeterministicMNList& to) const;
     CDeterministicMNList ApplyDiff(const CDeterministicMNListDiff& diff) const;
 
@@ -369,6 +416,9 @@ public:
     }
 
 private:
+    void RebuildIndexes();
+    void UpdateIndexes(const uint256& proTxHash, const CDeterministicMNStateCPtr& oldState, const CDeterministicMNStateCPtr& newState);
+
     template <typename T>
     void AddUniqueProperty(const CDeterministicMNCPtr& dmn, const T& v)
     {
@@ -479,6 +529,11 @@ public:
     CDeterministicMNList GetListForBlock(const uint256& blockHash);
     CDeterministicMNList GetListAtChainTip();
 
+    // UTXO snapshots carry the lists of the last blocks before their base block, these write them to the database
+    // while a snapshot is loaded
+    void WriteListToBatch(CDBBatch& batch, const CDeterministicMNList& list);
+    void WriteListDiffToBatch(CDBBatch& batch, const CDeterministicMNListDiff& diff);
+
     // TODO remove after removal of old non-deterministic lists
     bool HasValidMNCollateralAtChainTip(const COutPoint& outpoint);
     bool HasMNCollateralAtChainTip(const COutPoint& outpoint);
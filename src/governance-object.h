@@ -344,7 +344,8 @@ private:
     bool ProcessVote(CNode* pfrom,
         const CGovernanceVote& vote,
         CGovernanceException& exception,
-        CConnman& connman);
+        CConnman& connman,
+        const vote_sig_check_t& sigCheck = vote_sig_check_t());
 
     /// Called when MN's which have voted on this object have been removed
     void ClearMasternodeVotes();
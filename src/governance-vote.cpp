@@ -237,7 +237,7 @@ bool CGovernanceVote::CheckSignature(const CBLSPublicKey& pubKey) const
     return true;
 }
 
-bool CGovernanceVote::IsValid(bool useVotingKey) const
+bool CGovernanceVote::IsValid(bool useVotingKey, const vote_sig_check_t& sigCheck) const
 {
     if (nTime > GetAdjustedTime() + (60 * 60)) {
         LogPrint(MCLog::GOV, "CGovernanceVote::IsValid -- vote is too far ahead of current time - %s - nTime %lli - Max Time %lli\n", GetHash().ToString(), nTime, GetAdjustedTime() + (60 * 60));
@@ -262,13 +262,23 @@ bool CGovernanceVote::IsValid(bool useVotingKey) const
         return false;
     }
 
+    // The masternode list may have changed since the signature was checked, only rely on that check
+    // if it was done with the key the masternode has now
+    auto checkedResult = [&]() {
+        if (sigCheck.eStatus == VOTE_SIG_INVALID) {
+            LogPrint(MCLog::GOV, "CGovernanceVote::IsValid -- Invalid signature - %s\n", GetHash().ToString());
+            return false;
+        }
+        return true;
+    };
+
     if (useVotingKey) {
-        return CheckSignature(infoMn.keyIDVoting);
+        return sigCheck.IsCheckedWith(infoMn.keyIDVoting) ? checkedResult() : CheckSignature(infoMn.keyIDVoting);
     } else {
         if (deterministicMNManager->AreDeterministicMNsActive()) {
-            return CheckSignature(infoMn.blsPubKeyOperator);
+            return sigCheck.IsCheckedWith(infoMn.blsPubKeyOperator) ? checkedResult() : CheckSignature(infoMn.blsPubKeyOperator);
         } else {
-            return CheckSignature(infoMn.legacyKeyIDOperator);
+            return sigCheck.IsCheckedWith(infoMn.legacyKeyIDOperator) ? checkedResult() : CheckSignature(infoMn.legacyKeyIDOperator);
         }
     }
 }
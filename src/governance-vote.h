@@ -32,6 +32,32 @@ enum vote_signal_enum_t {
 
 static const int MAX_SUPPORTED_VOTE_SIGNAL = VOTE_SIGNAL_ENDORSED;
 
+// RESULT OF A SIGNATURE CHECK DONE BEFORE THE VOTE IS PROCESSED
+enum vote_sig_status_enum_t {
+    VOTE_SIG_UNCHECKED     = 0, //   -- signature still needs to be checked
+    VOTE_SIG_VALID         = 1,
+    VOTE_SIG_INVALID       = 2
+};
+
+/**
+ * Signature check of a vote done before it is processed, together with the key it was checked
+ * against. The result only applies while the masternode still has that key.
+ */
+struct vote_sig_check_t {
+    vote_sig_status_enum_t eStatus{VOTE_SIG_UNCHECKED};
+    CKeyID keyID;
+    CBLSPublicKey blsPubKey;
+
+    vote_sig_check_t() = default;
+    vote_sig_check_t(bool fValid, const CKeyID& keyIDIn) :
+        eStatus(fValid ? VOTE_SIG_VALID : VOTE_SIG_INVALID), keyID(keyIDIn) {}
+    vote_sig_check_t(bool fValid, const CBLSPublicKey& blsPubKeyIn) :
+        eStatus(fValid ? VOTE_SIG_VALID : VOTE_SIG_INVALID), blsPubKey(blsPubKeyIn) {}
+
+    bool IsCheckedWith(const CKeyID& keyIDIn) const { return eStatus != VOTE_SIG_UNCHECKED && !keyID.IsNull() && keyID == keyIDIn; }
+    bool IsCheckedWith(const CBLSPublicKey& blsPubKeyIn) const { return eStatus != VOTE_SIG_UNCHECKED && blsPubKey.IsValid() && blsPubKey == blsPubKeyIn; }
+};
+
 /**
 * Governance Voting
 *
@@ -95,11 +121,14 @@ public:
 
     void SetSignature(const std::vector<unsigned char>& vchSigIn) { vchSig = vchSigIn; }
 
+    const std::vector<unsigned char>& GetSignature() const { return vchSig; }
+
     bool Sign(const CKey& key, const CKeyID& keyID);
     bool CheckSignature(const CKeyID& keyID) const;
     bool Sign(const CBLSSecretKey& key);
     bool CheckSignature(const CBLSPublicKey& pubKey) const;
-    bool IsValid(bool useVotingKey) const;
+    /// sigCheck allows to skip the signature check if the caller already did it with the masternode's current key
+    bool IsValid(bool useVotingKey, const vote_sig_check_t& sigCheck = vote_sig_check_t()) const;
     void Relay(CConnman& connman) const;
 
     const COutPoint& GetMasternodeOutpoint() const { return masternodeOutpoint; }
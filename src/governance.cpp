@@ -19,6 +19,8 @@
 #include <validationinterface.h>
 #include "shutdown.h"
 
+#include <ctpl.h>
+
 CGovernanceManager governance;
 
 int nSubmittedFinalBudget;
@@ -39,10 +41,15 @@ CGovernanceManager::CGovernanceManager() :
     mapLastMasternodeObject(),
     setRequestedObjects(),
     fRateChecksEnabled(true),
+    fVoteVerificationStarted(false),
     cs()
 {
 }
 
+CGovernanceManager::~CGovernanceManager()
+{
+}
+
 // Accessors for thread-safe access to maps
 bool CGovernanceManager::HaveObjectForHash(const uint256& nHash) const
 {
@@ -256,22 +263,214 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
             return;
         }
 
-        CGovernanceException exception;
-        if (ProcessVote(pfrom, vote, exception, connman)) {
-            LogPrint(MCLog::GOV, "MNGOVERNANCEOBJECTVOTE -- %s new\n", strHash);
-            masternodeSync.BumpAssetLastTime("MNGOVERNANCEOBJECTVOTE");
-            vote.Relay(connman);
-        } else {
-            LogPrint(MCLog::GOV, "MNGOVERNANCEOBJECTVOTE -- Rejected vote, error = %s\n", exception.what());
-            if ((exception.GetNodePenalty() != 0) && masternodeSync.IsSynced()) {
-                LOCK(cs_main);
-                Misbehaving(pfrom->GetId(), exception.GetNodePenalty());
+        // Queue the vote so that its signature is verified together with others, outside of cs
+        size_t nPending = 0;
+        {
+            LOCK(cs_pendingVotes);
+            if (fVoteVerificationStarted) {
+                pfrom->AddRef();
+                vecPendingVotes.emplace_back(pfrom, vote);
+                nPending = vecPendingVotes.size();
+            }
+        }
+        if (nPending == 0) {
+            ProcessVoteMessage(pfrom, vote, VerifyVoteSignatures({vote})[0], connman);
+        } else if (nPending >= GOVERNANCE_VOTE_VERIFY_QUEUE_SIZE) {
+            ProcessPendingVotes(connman);
+        }
+    }
+}
+
+void CGovernanceManager::ProcessVoteMessage(CNode* pfrom, const CGovernanceVote& vote, const vote_sig_check_t& sigCheck, CConnman& connman)
+{
+    std::string strHash = vote.GetHash().ToString();
+
+    CGovernanceException exception;
+    if (ProcessVote(pfrom, vote, exception, connman, sigCheck)) {
+        LogPrint(MCLog::GOV, "MNGOVERNANCEOBJECTVOTE -- %s new\n", strHash);
+        masternodeSync.BumpAssetLastTime("MNGOVERNANCEOBJECTVOTE");
+        vote.Relay(connman);
+    } else {
+        LogPrint(MCLog::GOV, "MNGOVERNANCEOBJECTVOTE -- Rejected vote, error = %s\n", exception.what());
+        if ((exception.GetNodePenalty() != 0) && masternodeSync.IsSynced()) {
+            LOCK(cs_main);
+            Misbehaving(pfrom->GetId(), exception.GetNodePenalty());
+        }
+        return;
+    }
+    // SEND NOTIFICATION TO SCRIPT/ZMQ
+    GetMainSignals().NotifyGovernanceVote(vote);
+}
+
+void CGovernanceManager::StartVoteVerification(int nThreads)
+{
+    LOCK(cs_pendingVotes);
+    if (fVoteVerificationStarted) {
+        return;
+    }
+    if (nThreads > 1) {
+        voteVerificationPool.reset(new ctpl::thread_pool(nThreads));
+    }
+    fVoteVerificationStarted = true;
+}
+
+void CGovernanceManager::StopVoteVerification()
+{
+    std::vector<node_vote_pair_t> vecDropped;
+    {
+        LOCK(cs_pendingVotes);
+        fVoteVerificationStarted = false;
+        vecDropped.swap(vecPendingVotes);
+    }
+    for (auto& pair : vecDropped) {
+        pair.first->Release();
+    }
+
+    // wait for a batch which is currently processed and still references nodes
+    LOCK(cs_processPendingVotes);
+    if (voteVerificationPool) {
+        voteVerificationPool->stop(true);
+        voteVerificationPool.reset();
+    }
+}
+
+void CGovernanceManager::ProcessPendingVotes(CConnman& connman)
+{
+    LOCK(cs_processPendingVotes);
+
+    std::vector<node_vote_pair_t> vecBatch;
+    {
+        LOCK(cs_pendingVotes);
+        vecBatch.swap(vecPendingVotes);
+    }
+    if (vecBatch.empty()) {
+        return;
+    }
+
+    std::vector<CGovernanceVote> vecVotes;
+    vecVotes.reserve(vecBatch.size());
+    for (const auto& pair : vecBatch) {
+        vecVotes.emplace_back(pair.second);
+    }
+
+    int64_t nTimeStart = GetTimeMicros();
+    std::vector<vote_sig_check_t> vecSigChecks = VerifyVoteSignatures(vecVotes);
+    LogPrint(MCLog::GOV, "CGovernanceManager::ProcessPendingVotes -- verified %d votes in %.2fms\n", vecVotes.size(), 0.001 * (GetTimeMicros() - nTimeStart));
+
+    for (size_t i = 0; i < vecBatch.size(); i++) {
+        ProcessVoteMessage(vecBatch[i].first, vecBatch[i].second, vecSigChecks[i], connman);
+        vecBatch[i].first->Release();
+    }
+}
+
+std::vector<vote_sig_check_t> CGovernanceManager::VerifyVoteSignatures(const std::vector<CGovernanceVote>& vecVotes)
+{
+    std::vector<vote_sig_check_t> vecSigChecks(vecVotes.size());
+
+    // indexes of the votes to verify and whether they must be signed with the voting key
+    std::vector<size_t> vecToCheck;
+    std::vector<CGovernanceVote> vecVotesToCheck;
+    std::vector<bool> vecUseVotingKey;
+    {
+        LOCK(cs);
+        std::set<uint256> setSeen;
+        for (size_t i = 0; i < vecVotes.size(); i++) {
+            const CGovernanceVote& vote = vecVotes[i];
+            uint256 nHashVote = vote.GetHash();
+            if (!setSeen.insert(nHashVote).second || cmapVoteToObject.HasKey(nHashVote) || cmapInvalidVotes.HasKey(nHashVote)) {
+                continue;
+            }
+            object_m_cit it = mapObjects.find(vote.GetParentHash());
+            if (it == mapObjects.end() || it->second.IsSetCachedDelete() || it->second.IsSetExpired()) {
+                continue;
+            }
+            bool onlyVotingKeyAllowed = it->second.GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
+            vecToCheck.emplace_back(i);
+            vecVotesToCheck.emplace_back(vote);
+            vecUseVotingKey.emplace_back(onlyVotingKeyAllowed);
+        }
+    }
+    if (vecToCheck.empty()) {
+        return vecSigChecks;
+    }
+
+    // only ProcessPendingVotes passes more than one batch, and it holds cs_processPendingVotes which protects the pool
+    std::vector<vote_sig_check_t> vecResults = CheckVoteSignatures(vecVotesToCheck, vecUseVotingKey,
+        vecToCheck.size() > GOVERNANCE_VOTE_VERIFY_BATCH_SIZE ? voteVerificationPool.get() : nullptr);
+    for (size_t j = 0; j < vecToCheck.size(); j++) {
+        vecSigChecks[vecToCheck[j]] = vecResults[j];
+    }
+    return vecSigChecks;
+}
+
+std::vector<vote_sig_check_t> CGovernanceManager::CheckVoteSignatures(const std::vector<CGovernanceVote>& vecVotes, const std::vector<bool>& vecUseVotingKey, ctpl::thread_pool* pool)
+{
+    assert(vecVotes.size() == vecUseVotingKey.size());
+    std::vector<vote_sig_check_t> vecSigChecks(vecVotes.size());
+
+    bool fDIP3Active = deterministicMNManager->AreDeterministicMNsActive();
+
+    // each entry of vecSigChecks is written by exactly one batch
+    auto verifyBatch = [&](size_t nStart, size_t nCount) {
+        std::vector<size_t> vecBLS;
+        std::vector<CBLSSignature> vecSigs;
+        std::vector<CBLSPublicKey> vecPubKeys;
+        std::vector<uint256> vecHashes;
+
+        for (size_t i = nStart; i < nStart + nCount; i++) {
+            const CGovernanceVote& vote = vecVotes[i];
+            masternode_info_t infoMn;
+            if (!mnodeman.GetMasternodeInfo(vote.GetMasternodeOutpoint(), infoMn)) {
+                continue;
+            }
+            if (vecUseVotingKey[i]) {
+                vecSigChecks[i] = vote_sig_check_t(vote.CheckSignature(infoMn.keyIDVoting), infoMn.keyIDVoting);
+            } else if (!fDIP3Active) {
+                vecSigChecks[i] = vote_sig_check_t(vote.CheckSignature(infoMn.legacyKeyIDOperator), infoMn.legacyKeyIDOperator);
+            } else {
+                CBLSSignature sig;
+                sig.SetBuf(vote.GetSignature());
+                if (!sig.IsValid() || !infoMn.blsPubKeyOperator.IsValid()) {
+                    vecSigChecks[i] = vote_sig_check_t(false, infoMn.blsPubKeyOperator);
+                    continue;
+                }
+                vecBLS.emplace_back(i);
+                vecSigs.emplace_back(sig);
+                vecPubKeys.emplace_back(infoMn.blsPubKeyOperator);
+                vecHashes.emplace_back(vote.GetSignatureHash());
+            }
+        }
+
+        if (vecBLS.empty()) {
+            return;
+        }
+        // All votes sign different messages, so the aggregated signature can be verified against all of them at once.
+        // Only if that fails the signatures are checked one by one to find the invalid ones.
+        if (vecBLS.size() > 1 && CBLSSignature::AggregateInsecure(vecSigs).VerifyInsecureAggregated(vecPubKeys, vecHashes)) {
+            for (size_t k = 0; k < vecBLS.size(); k++) {
+                vecSigChecks[vecBLS[k]] = vote_sig_check_t(true, vecPubKeys[k]);
             }
             return;
         }
-        // SEND NOTIFICATION TO SCRIPT/ZMQ
-        GetMainSignals().NotifyGovernanceVote(vote);
+        for (size_t k = 0; k < vecBLS.size(); k++) {
+            vecSigChecks[vecBLS[k]] = vote_sig_check_t(vecSigs[k].VerifyInsecure(vecPubKeys[k], vecHashes[k]), vecPubKeys[k]);
+        }
+    };
+
+    std::vector<std::future<void> > vecFutures;
+    for (size_t nStart = 0; nStart < vecVotes.size(); nStart += GOVERNANCE_VOTE_VERIFY_BATCH_SIZE) {
+        size_t nCount = std::min(GOVERNANCE_VOTE_VERIFY_BATCH_SIZE, vecVotes.size() - nStart);
+        if (pool) {
+            vecFutures.emplace_back(pool->push([&verifyBatch, nStart, nCount](int) { verifyBatch(nStart, nCount); }));
+        } else {
+            verifyBatch(nStart, nCount);
+        }
     }
+    for (auto& f : vecFutures) {
+        f.get();
+    }
+
+    return vecSigChecks;
 }
 
 void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CGovernanceException& exception, CConnman& connman)
@@ -831,7 +1030,7 @@ bool CGovernanceManager::MasternodeRateCheck(const CGovernanceObject& govobj, bo
     return false;
 }
 
-bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman)
+bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman, const vote_sig_check_t& sigCheck)
 {
     ENTER_CRITICAL_SECTION(cs);
     uint256 nHashVote = vote.GetHash();
@@ -880,7 +1079,7 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
         return false;
     }
 
-    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman) && cmapVoteToObject.Insert(nHashVote, &govobj);
+    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman, sigCheck) && cmapVoteToObject.Insert(nHashVote, &govobj);
     LEAVE_CRITICAL_SECTION(cs);
     return fOk;
 }
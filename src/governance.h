@@ -28,6 +28,10 @@ class CGovernanceTriggerManager;
 class CGovernanceObject;
 class CGovernanceVote;
 
+namespace ctpl {
+class thread_pool;
+}
+
 extern CGovernanceManager governance;
 
 struct ExpirationInfo {
@@ -42,6 +46,12 @@ typedef std::pair<CGovernanceObject, ExpirationInfo> object_info_pair_t;
 
 static const int RATE_BUFFER_SIZE = 5;
 
+// Number of network votes collected before their signatures are verified as one batch
+static const size_t GOVERNANCE_VOTE_VERIFY_QUEUE_SIZE = 256;
+// Number of vote signatures verified by one task of the verification threads
+static const size_t GOVERNANCE_VOTE_VERIFY_BATCH_SIZE = 32;
+static const int MAX_GOVERNANCE_VOTE_VERIFY_THREADS = 4;
+
 class CRateCheckBuffer
 {
 private:
@@ -222,6 +232,8 @@ public: // Types
 
     typedef hash_time_m_t::const_iterator hash_time_m_cit;
 
+    typedef std::pair<CNode*, CGovernanceVote> node_vote_pair_t;
+
 private:
     static const int MAX_CACHE_SIZE = 1000000;
 
@@ -266,6 +278,16 @@ private:
     // used to check for changed voting keys
     CDeterministicMNList lastMNListForVotingKeys;
 
+    // votes received from the network whose signatures were not verified yet, the nodes are referenced
+    CCriticalSection cs_pendingVotes;
+    std::vector<node_vote_pair_t> vecPendingVotes;
+    bool fVoteVerificationStarted;
+
+    // held while a batch of pending votes is processed, so that StopVoteVerification can wait for it
+    CCriticalSection cs_processPendingVotes;
+
+    std::unique_ptr<ctpl::thread_pool> voteVerificationPool;
+
     class ScopedLockBool
     {
         bool& ref;
@@ -292,7 +314,7 @@ public:
 
     CGovernanceManager();
 
-    virtual ~CGovernanceManager() {}
+    virtual ~CGovernanceManager();
 
     /**
      * This is called by AlreadyHave in net_processing.cpp as part of the inventory
@@ -308,6 +330,22 @@ public:
 
     void DoMaintenance(CConnman& connman);
 
+    /// Start the threads which verify signatures of network votes before they are processed
+    void StartVoteVerification(int nThreads);
+    /// Stop verification threads and drop pending votes, must be called before nodes are deleted
+    void StopVoteVerification();
+    /// Verify the signatures of all pending network votes in parallel and process them
+    void ProcessPendingVotes(CConnman& connman);
+
+    /**
+     * Check the signatures of votes against the keys their masternodes have in mnodeman now. vecUseVotingKey
+     * tells for each vote whether it must be signed with the voting key. Votes of unknown masternodes are left
+     * VOTE_SIG_UNCHECKED. Batches are checked on pool if given, and BLS signatures of a batch are checked
+     * together as one aggregated signature. The results record the keys used, so that
+     * CGovernanceVote::IsValid checks the signature again if the masternode's key changed meanwhile.
+     */
+    static std::vector<vote_sig_check_t> CheckVoteSignatures(const std::vector<CGovernanceVote>& vecVotes, const std::vector<bool>& vecUseVotingKey, ctpl::thread_pool* pool = nullptr);
+
     CGovernanceObject* FindGovernanceObject(const uint256& nHash);
 
     // These commands are only used in RPC
@@ -398,7 +436,7 @@ public:
 
     bool ProcessVoteAndRelay(const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman)
     {
-        bool fOK = ProcessVote(nullptr, vote, exception, connman);
+        bool fOK = ProcessVote(nullptr, vote, exception, connman, VerifyVoteSignatures({vote})[0]);
         if (fOK) {
             vote.Relay(connman);
         }
@@ -435,7 +473,18 @@ private:
         cmmapOrphanVotes.Insert(vote.GetHash(), vote_time_pair_t(vote, GetAdjustedTime() + GOVERNANCE_ORPHAN_EXPIRATION_TIME));
     }
 
-    bool ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman);
+    bool ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman, const vote_sig_check_t& sigCheck = vote_sig_check_t());
+
+    /// Process a vote received from pfrom, relay it if it is new and punish pfrom if it is invalid
+    void ProcessVoteMessage(CNode* pfrom, const CGovernanceVote& vote, const vote_sig_check_t& sigCheck, CConnman& connman);
+
+    /**
+     * Verify the signatures of votes without holding cs. cs is only taken briefly to skip votes which are
+     * already known and to find out which key must have signed each vote. Votes which can't be checked
+     * upfront, e.g. because their parent object or masternode is unknown, are left VOTE_SIG_UNCHECKED and
+     * are verified by ProcessVote as before. See CheckVoteSignatures.
+     */
+    std::vector<vote_sig_check_t> VerifyVoteSignatures(const std::vector<CGovernanceVote>& vecVotes);
 
     /// Called to indicate a requested object has been received
     bool AcceptObjectMessage(const uint256& nHash);
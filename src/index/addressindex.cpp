@@ -0,0 +1,284 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+#include <chainparams.h>
+#include <crypto/sha256.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+
+constexpr char DB_ADDRESS = 'a';
+constexpr char DB_BALANCE = 'b';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+uint256 GetIndexScriptHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+namespace {
+
+/**
+ * Key of an address index entry. Heights and indexes are serialized big endian, so the entries
+ * of a script are ordered by height in the database.
+ */
+struct CAddressIndexKey
+{
+    uint256 scriptHash;
+    int32_t nHeight;
+    uint256 txid;
+    uint32_t nIndex;
+    bool fSpending;
+
+    CAddressIndexKey() : nHeight(0), nIndex(0), fSpending(false) {}
+
+    CAddressIndexKey(const uint256& scriptHashIn, int32_t nHeightIn, const uint256& txidIn = uint256(),
+                     uint32_t nIndexIn = 0, bool fSpendingIn = false) :
+        scriptHash(scriptHashIn), nHeight(nHeightIn), txid(txidIn), nIndex(nIndexIn), fSpending(fSpendingIn) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << scriptHash;
+        ser_writedata32be(s, nHeight);
+        s << txid;
+        ser_writedata32be(s, nIndex);
+        s << fSpending;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        s >> scriptHash;
+        nHeight = ser_readdata32be(s);
+        s >> txid;
+        nIndex = ser_readdata32be(s);
+        s >> fSpending;
+    }
+};
+
+/**
+ * Sum of the balance changes of a script up to a height, so GetAddressBalance only reads the
+ * entries after it. Erased with the entries of a disconnected block paying to or spending from
+ * the script.
+ */
+struct CAddressBalance
+{
+    int32_t nHeight = -1;
+    CAmount balance = 0;
+    CAmount received = 0;
+    uint64_t tx_count = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nHeight);
+        READWRITE(balance);
+        READWRITE(received);
+        READWRITE(tx_count);
+    }
+};
+
+typedef std::vector<std::pair<CAddressIndexKey, CAmount>> AddressIndexEntries;
+
+/** Collect the address index entries of a block at a height */
+void GetAddressIndexEntries(const CBlock& block, const CBlockUndo& block_undo, int height, AddressIndexEntries& entries)
+{
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+        // The undo data of a block has an entry for every transaction but the coinbase
+        if (i > 0) {
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                const CTxOut& prevout = tx_undo.vprevout[j].out;
+                entries.emplace_back(CAddressIndexKey(GetIndexScriptHash(prevout.scriptPubKey), height, txid, j, true),
+                                     -prevout.nValue);
+            }
+        }
+        for (size_t j = 0; j < tx.vout.size(); j++) {
+            const CTxOut& out = tx.vout[j];
+            if (out.scriptPubKey.IsUnspendable()) continue;
+            entries.emplace_back(CAddressIndexKey(GetIndexScriptHash(out.scriptPubKey), height, txid, j, false),
+                                 out.nValue);
+        }
+    }
+}
+
+/** Read a block and its undo data and collect its address index entries */
+bool ReadAddressIndexEntries(const CBlockIndex* pindex, const CBlock* pblock, AddressIndexEntries& entries)
+{
+    CBlock block;
+    if (!pblock) {
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            return false;
+        }
+        pblock = &block;
+    }
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+    if (block_undo.vtxundo.size() + 1 != pblock->vtx.size()) {
+        return error("%s: undo data of block %s doesn't match the block", __func__, pindex->GetBlockHash().ToString());
+    }
+    GetAddressIndexEntries(*pblock, block_undo, pindex->nHeight, entries);
+    return true;
+}
+
+} // namespace
+
+/**
+ * Access to the address index database (indexes/addressindex/)
+ *
+ * Besides the block locator of BaseIndex::DB, the database maps address index keys to the
+ * amount the balance of the script changes by.
+ */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Add writing or erasing entries to a batch. Erasing entries erases the balance sums of
+    /// their scripts too.
+    void WriteEntries(CDBBatch& batch, const AddressIndexEntries& entries, bool f_erase) const;
+
+    /// Write or erase a batch of entries.
+    bool WriteEntries(const AddressIndexEntries& entries, bool f_erase);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+void AddressIndex::DB::WriteEntries(CDBBatch& batch, const AddressIndexEntries& entries, bool f_erase) const
+{
+    for (const auto& entry : entries) {
+        if (f_erase) {
+            batch.Erase(std::make_pair(DB_ADDRESS, entry.first));
+            batch.Erase(std::make_pair(DB_BALANCE, entry.first.scriptHash));
+        } else {
+            batch.Write(std::make_pair(DB_ADDRESS, entry.first), entry.second);
+        }
+    }
+}
+
+bool AddressIndex::DB::WriteEntries(const AddressIndexEntries& entries, bool f_erase)
+{
+    CDBBatch batch(*this);
+    WriteEntries(batch, entries, f_erase);
+    return WriteBatch(batch);
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+bool AddressIndex::WriteBlockToBatch(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex)
+{
+    // The outputs of the genesis block can't be spent
+    if (pindex->nHeight == 0) {
+        return true;
+    }
+    AddressIndexEntries entries;
+    if (!ReadAddressIndexEntries(pindex, &block, entries)) {
+        return false;
+    }
+    m_db->WriteEntries(batch, entries, false);
+    return true;
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    LOCK(m_cs_balance);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip && pindex->nHeight > 0; pindex = pindex->pprev) {
+        AddressIndexEntries entries;
+        if (!ReadAddressIndexEntries(pindex, nullptr, entries) || !m_db->WriteEntries(entries, true)) {
+            return error("%s: Failed to remove the entries of block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+    }
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::FindAddressDeltas(const uint256& script_hash, int start_height, int end_height,
+                                     size_t skip, size_t count, std::vector<CAddressDelta>& deltas) const
+{
+    std::unique_ptr<CDBIterator> it(m_db->NewIterator());
+    for (it->Seek(std::make_pair(DB_ADDRESS, CAddressIndexKey(script_hash, std::max(start_height, 0))));
+         it->Valid() && deltas.size() < count; it->Next()) {
+        std::pair<char, CAddressIndexKey> key;
+        if (!it->GetKey(key) || key.first != DB_ADDRESS || key.second.scriptHash != script_hash ||
+            key.second.nHeight > end_height) {
+            break;
+        }
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        CAmount amount;
+        if (!it->GetValue(amount)) {
+            return error("%s: cannot parse address index record", __func__);
+        }
+        deltas.push_back({key.second.nHeight, key.second.txid, key.second.nIndex, key.second.fSpending, amount});
+    }
+    return true;
+}
+
+bool AddressIndex::GetAddressBalance(const uint256& script_hash, CAmount& balance, CAmount& received, uint64_t& tx_count)
+{
+    // Entries up to the best block are complete, and Rewind can't erase them meanwhile
+    LOCK(m_cs_balance);
+    const CBlockIndex* best_block_index = CurrentIndex();
+    const int best_height = best_block_index ? best_block_index->nHeight : -1;
+
+    CAddressBalance sum;
+    if (!m_db->Read(std::make_pair(DB_BALANCE, script_hash), sum) || sum.nHeight > best_height) {
+        sum = CAddressBalance();
+    }
+
+    // The entries of a transaction are next to each other, they are ordered by height and txid.
+    // The stored sum ends at a height, so it doesn't count any transaction partly.
+    bool f_updated = false;
+    std::pair<int32_t, uint256> last_tx(-1, uint256());
+    std::unique_ptr<CDBIterator> it(m_db->NewIterator());
+    for (it->Seek(std::make_pair(DB_ADDRESS, CAddressIndexKey(script_hash, sum.nHeight + 1))); it->Valid(); it->Next()) {
+        std::pair<char, CAddressIndexKey> key;
+        if (!it->GetKey(key) || key.first != DB_ADDRESS || key.second.scriptHash != script_hash ||
+            key.second.nHeight > best_height) {
+            break;
+        }
+        CAmount amount;
+        if (!it->GetValue(amount)) {
+            return error("%s: cannot parse address index record", __func__);
+        }
+        sum.balance += amount;
+        if (!key.second.fSpending) {
+            sum.received += amount;
+        }
+        if (key.second.nHeight != last_tx.first || key.second.txid != last_tx.second) {
+            last_tx = std::make_pair(key.second.nHeight, key.second.txid);
+            sum.tx_count++;
+        }
+        f_updated = true;
+    }
+
+    if (f_updated) {
+        sum.nHeight = best_height;
+        m_db->Write(std::make_pair(DB_BALANCE, script_hash), sum);
+    }
+    balance = sum.balance;
+    received = sum.received;
+    tx_count = sum.tx_count;
+    return true;
+}
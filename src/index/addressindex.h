@@ -0,0 +1,91 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_INDEX_ADDRESSINDEX_H
+#define MACHINECOIN_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <chain.h>
+#include <index/base.h>
+#include <script/script.h>
+#include <sync.h>
+
+/** Hash identifying a scriptPubKey in the address and spent indexes, the SHA256 of the script */
+uint256 GetIndexScriptHash(const CScript& script);
+
+/** A change of the balance of a scriptPubKey, by an output paying to it or an input spending from it */
+struct CAddressDelta
+{
+    int nHeight;
+    uint256 txid;
+    //! Index of the output, or of the input if fSpending
+    uint32_t nIndex;
+    bool fSpending;
+    //! Negative for inputs
+    CAmount nAmount;
+};
+
+/**
+ * AddressIndex is used to look up the history of scriptPubKeys, for
+ * explorers and payment backends. The index is written to a LevelDB database
+ * (indexes/addressindex/) and records, per script hash, every output paying
+ * to the script and every input spending such an output, ordered by height.
+ * Outputs which can never be spent (OP_RETURN) aren't indexed.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    /// Held while balance sums are written, so that Rewind erases the sums it invalidates after them
+    CCriticalSection m_cs_balance;
+
+protected:
+    bool WriteBlockToBatch(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool AllowParallelSync() const override { return true; }
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Look up the balance changes of a script in a range of heights, in order of height.
+    ///
+    /// @param[in]   script_hash  The hash of the scriptPubKey, see GetIndexScriptHash.
+    /// @param[in]   start_height  The first height to return changes of.
+    /// @param[in]   end_height  The last height to return changes of.
+    /// @param[in]   skip  The number of changes in the range to skip, for paging.
+    /// @param[in]   count  The maximum number of changes to return.
+    /// @param[out]  deltas  The changes.
+    /// @return  true if the index could be read, false otherwise
+    bool FindAddressDeltas(const uint256& script_hash, int start_height, int end_height,
+                           size_t skip, size_t count, std::vector<CAddressDelta>& deltas) const;
+
+    /// Sum up all balance changes of a script up to the best block. The sum is written to the
+    /// index, so later calls only read the changes after it.
+    ///
+    /// @param[in]   script_hash  The hash of the scriptPubKey, see GetIndexScriptHash.
+    /// @param[out]  balance  The amount of the unspent outputs paying to the script.
+    /// @param[out]  received  The amount of all outputs paying to the script.
+    /// @param[out]  tx_count  The number of transactions paying to or spending from the script.
+    /// @return  true if the index could be read, false otherwise
+    bool GetAddressBalance(const uint256& script_hash, CAmount& balance, CAmount& received, uint64_t& tx_count);
+};
+
+/// The global address index, used by the address RPCs. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // MACHINECOIN_INDEX_ADDRESSINDEX_H
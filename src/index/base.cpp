@@ -11,11 +11,23 @@
 #include <validation.h>
 #include <warnings.h>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
 constexpr char DB_BEST_BLOCK = 'B';
+constexpr char DB_SYNC_TARGET = 'P';
 
 constexpr int64_t SYNC_LOG_INTERVAL = 30; // seconds
 constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
 
+/// Number of blocks a ParallelSync thread claims at once
+constexpr int PARALLEL_SYNC_RANGE_SIZE = 256;
+/// Size of the batches of index entries written while syncing
+constexpr size_t SYNC_BATCH_SIZE = 16 << 20;
+/// Fewer blocks than this to catch up with are indexed sequentially
+constexpr int PARALLEL_SYNC_MIN_BLOCKS = 4 * PARALLEL_SYNC_RANGE_SIZE;
+
 template<typename... Args>
 static void FatalError(const char* fmt, const Args&... args)
 {
@@ -46,6 +58,26 @@ bool BaseIndex::DB::WriteBestBlock(const CBlockLocator& locator)
     return Write(DB_BEST_BLOCK, locator);
 }
 
+void BaseIndex::DB::WriteBestBlock(CDBBatch& batch, const CBlockLocator& locator) const
+{
+    batch.Write(DB_BEST_BLOCK, locator);
+}
+
+bool BaseIndex::DB::ReadSyncTarget(uint256& hash) const
+{
+    return Read(DB_SYNC_TARGET, hash);
+}
+
+bool BaseIndex::DB::WriteSyncTarget(const uint256& hash)
+{
+    return Write(DB_SYNC_TARGET, hash);
+}
+
+void BaseIndex::DB::EraseSyncTarget(CDBBatch& batch) const
+{
+    batch.Erase(DB_SYNC_TARGET);
+}
+
 BaseIndex::~BaseIndex()
 {
     Interrupt();
@@ -59,8 +91,41 @@ bool BaseIndex::Init()
         locator.SetNull();
     }
 
+    uint256 sync_target_hash;
+    const bool f_sync_target = GetDB().ReadSyncTarget(sync_target_hash);
+
+    const CBlockIndex* locator_tip_index = nullptr;
+    const CBlockIndex* sync_target_index = nullptr;
+    {
+        LOCK(cs_main);
+        if (!locator.IsNull()) {
+            locator_tip_index = LookupBlockIndex(locator.vHave.front());
+        }
+        if (f_sync_target) {
+            sync_target_index = LookupBlockIndex(sync_target_hash);
+        }
+        m_best_block_index = FindForkInGlobalIndex(chainActive, locator);
+    }
+
+    // The chain may have been reorganized while the index was offline. An interrupted
+    // ParallelSync may also have left entries of blocks up to its target beyond the locator.
+    const CBlockIndex* rewind_tip_index = sync_target_index ? sync_target_index : locator_tip_index;
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (rewind_tip_index && best_block_index && rewind_tip_index != best_block_index &&
+        rewind_tip_index->GetAncestor(best_block_index->nHeight) == best_block_index) {
+        if (!Rewind(rewind_tip_index, best_block_index)) {
+            return error("%s: Failed to rewind %s to the active chain", __func__, GetName());
+        }
+    }
+    if (f_sync_target) {
+        CDBBatch batch(GetDB());
+        GetDB().EraseSyncTarget(batch);
+        if (!GetDB().WriteBatch(batch)) {
+            return error("%s: Failed to erase the sync target of %s", __func__, GetName());
+        }
+    }
+
     LOCK(cs_main);
-    m_best_block_index = FindForkInGlobalIndex(chainActive, locator);
     m_synced = m_best_block_index.load() == chainActive.Tip();
     return true;
 }
@@ -81,30 +146,267 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev)
     return chainActive.Next(chainActive.FindFork(pindex_prev));
 }
 
+bool BaseIndex::ParallelSync(const CBlockIndex*& pindex)
+{
+    const CBlockIndex* pindex_target;
+    const CBlockIndex* pindex_fork;
+    {
+        LOCK(cs_main);
+        pindex_target = chainActive.Tip();
+        if (!pindex_target) {
+            return true;
+        }
+        pindex_fork = pindex ? chainActive.FindFork(pindex) : nullptr;
+    }
+    if (pindex_target->nHeight - (pindex_fork ? pindex_fork->nHeight : -1) < PARALLEL_SYNC_MIN_BLOCKS) {
+        return true;
+    }
+    if (pindex_fork != pindex) {
+        if (!pindex_fork || !Rewind(pindex, pindex_fork)) {
+            FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                       __func__, GetName());
+            return false;
+        }
+        pindex = pindex_fork;
+    }
+
+    // The genesis block is indexed first, so that there is always a block to rewind to
+    if (!pindex) {
+        const CBlockIndex* pindex_genesis = pindex_target->GetAncestor(0);
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex_genesis, Params().GetConsensus())) {
+            FatalError("%s: Failed to read block %s from disk",
+                       __func__, pindex_genesis->GetBlockHash().ToString());
+            return false;
+        }
+        if (!WriteBlock(block, pindex_genesis)) {
+            FatalError("%s: Failed to write block %s to index database",
+                       __func__, pindex_genesis->GetBlockHash().ToString());
+            return false;
+        }
+        pindex = pindex_genesis;
+    }
+
+    // Entries of blocks past the locator are written out of order. Persist the target, so that
+    // Init can remove them if the sync doesn't finish.
+    if (!GetDB().WriteSyncTarget(pindex_target->GetBlockHash())) {
+        FatalError("%s: Failed to write to index database", __func__);
+        return false;
+    }
+
+    const int start_height = pindex->nHeight + 1;
+    const int end_height = pindex_target->nHeight;
+    const int num_ranges = (end_height - start_height) / PARALLEL_SYNC_RANGE_SIZE + 1;
+    LogPrintf("Syncing %s with block chain from height %d to %d using %d threads\n",
+              GetName(), start_height, end_height, m_sync_threads);
+
+    const auto& consensus_params = Params().GetConsensus();
+    std::atomic<int> next_range{0};
+    std::atomic<bool> failed{false};
+
+    // Progress of the sync, guarded by mutex_progress
+    std::mutex mutex_progress;
+    std::vector<bool> ranges_done(num_ranges, false);
+    int contiguous_ranges = 0;
+    int64_t last_log_time = GetTime();
+    int64_t last_locator_write_time = last_log_time;
+
+    // The last block of the contiguous completed ranges, or the block the sync started at
+    auto synced_tip = [&]() -> const CBlockIndex* {
+        if (contiguous_ranges == 0) return pindex;
+        const int height = std::min(start_height + contiguous_ranges * PARALLEL_SYNC_RANGE_SIZE - 1, end_height);
+        return pindex_target->GetAncestor(height);
+    };
+
+    auto sync_ranges_unchecked = [&]() {
+        CDBBatch batch(GetDB());
+        while (!m_interrupt && !failed) {
+            const int range = next_range++;
+            if (range >= num_ranges) break;
+            const int range_start = start_height + range * PARALLEL_SYNC_RANGE_SIZE;
+            const int range_end = std::min(range_start + PARALLEL_SYNC_RANGE_SIZE - 1, end_height);
+
+            bool complete = true;
+            for (int height = range_start; height <= range_end; ++height) {
+                if (m_interrupt || failed) {
+                    complete = false;
+                    break;
+                }
+                const CBlockIndex* block_index = pindex_target->GetAncestor(height);
+                CBlock block;
+                if (!ReadBlockFromDisk(block, block_index, consensus_params)) {
+                    FatalError("%s: Failed to read block %s from disk",
+                               __func__, block_index->GetBlockHash().ToString());
+                    failed = true;
+                    break;
+                }
+                if (!WriteBlockToBatch(batch, block, block_index)) {
+                    FatalError("%s: Failed to write block %s to index database",
+                               __func__, block_index->GetBlockHash().ToString());
+                    failed = true;
+                    break;
+                }
+                if (batch.SizeEstimate() > SYNC_BATCH_SIZE) {
+                    if (!GetDB().WriteBatch(batch)) {
+                        FatalError("%s: Failed to write to index database", __func__);
+                        failed = true;
+                        break;
+                    }
+                    batch.Clear();
+                }
+            }
+            // Entries of an incomplete range are written too, they are written again once the
+            // sync resumes at the range
+            if (!GetDB().WriteBatch(batch)) {
+                FatalError("%s: Failed to write to index database", __func__);
+                failed = true;
+            }
+            batch.Clear();
+            if (!complete || failed) break;
+
+            const CBlockIndex* locator_tip = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex_progress);
+                ranges_done[range] = true;
+                while (contiguous_ranges < num_ranges && ranges_done[contiguous_ranges]) {
+                    ++contiguous_ranges;
+                }
+
+                int64_t current_time = GetTime();
+                if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
+                    const CBlockIndex* tip = synced_tip();
+                    LogPrintf("Syncing %s with block chain from height %d\n",
+                              GetName(), tip ? tip->nHeight : -1);
+                    last_log_time = current_time;
+                }
+                if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
+                    locator_tip = synced_tip();
+                    last_locator_write_time = current_time;
+                }
+            }
+            if (locator_tip) WriteBestBlock(locator_tip);
+        }
+    };
+
+    // An error in one thread stops the others, rather than terminating the process
+    auto sync_ranges = [&]() {
+        try {
+            sync_ranges_unchecked();
+        } catch (const std::exception& e) {
+            FatalError("%s: Failed to sync %s: %s", __func__, GetName(), e.what());
+            failed = true;
+        } catch (...) {
+            FatalError("%s: Failed to sync %s: unknown exception", __func__, GetName());
+            failed = true;
+        }
+    };
+
+    // This thread syncs ranges as well
+    std::vector<std::thread> threads;
+    for (int i = 1; i < m_sync_threads; ++i) {
+        threads.emplace_back([&, i]() {
+            RenameThread(strprintf("machinecoin-%s.%d", GetName(), i).c_str());
+            sync_ranges();
+        });
+    }
+    sync_ranges();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // Remove the entries of the claimed ranges after the contiguous completed ones, highest
+    // first, which leaves the index at the last block of those
+    const int claimed_ranges = std::min<int>(next_range, num_ranges);
+    for (int range = claimed_ranges - 1; range >= contiguous_ranges; --range) {
+        const int range_start = start_height + range * PARALLEL_SYNC_RANGE_SIZE;
+        const int range_end = std::min(range_start + PARALLEL_SYNC_RANGE_SIZE - 1, end_height);
+        if (!Rewind(pindex_target->GetAncestor(range_end), pindex_target->GetAncestor(range_start - 1))) {
+            FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                       __func__, GetName());
+            return false;
+        }
+    }
+
+    pindex = synced_tip();
+    CDBBatch batch(GetDB());
+    {
+        LOCK(cs_main);
+        GetDB().WriteBestBlock(batch, chainActive.GetLocator(pindex));
+    }
+    GetDB().EraseSyncTarget(batch);
+    if (!GetDB().WriteBatch(batch)) {
+        FatalError("%s: Failed to write to index database", __func__);
+        return false;
+    }
+    return !m_interrupt && !failed;
+}
+
 void BaseIndex::ThreadSync()
 {
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
+        if (AllowParallelSync() && m_sync_threads > 1 && !ParallelSync(pindex)) {
+            return;
+        }
+
         auto& consensus_params = Params().GetConsensus();
 
+        // The entries of indexes allowing ParallelSync are only added by WriteBlockToBatch. They
+        // are written for many blocks at once, together with the locator of the last one.
+        const bool f_batch = AllowParallelSync();
+        CDBBatch batch(GetDB());
+        bool f_batch_pending = false;
+        auto write_locator = [&]() {
+            if (!f_batch_pending) {
+                return WriteBestBlock(pindex);
+            }
+            {
+                LOCK(cs_main);
+                GetDB().WriteBestBlock(batch, chainActive.GetLocator(pindex));
+            }
+            f_batch_pending = false;
+            bool ret = GetDB().WriteBatch(batch);
+            batch.Clear();
+            return ret;
+        };
+
         int64_t last_log_time = 0;
         int64_t last_locator_write_time = 0;
         while (true) {
             if (m_interrupt) {
-                WriteBestBlock(pindex);
+                write_locator();
                 return;
             }
 
+            const CBlockIndex* pindex_fork = nullptr;
             {
                 LOCK(cs_main);
                 const CBlockIndex* pindex_next = NextSyncBlock(pindex);
                 if (!pindex_next) {
-                    WriteBestBlock(pindex);
+                    if (!write_locator()) {
+                        FatalError("%s: Failed to write to index database", __func__);
+                        return;
+                    }
                     m_best_block_index = pindex;
                     m_synced = true;
                     break;
                 }
-                pindex = pindex_next;
+                if (pindex_next->pprev != pindex) {
+                    pindex_fork = pindex_next->pprev;
+                } else {
+                    pindex = pindex_next;
+                }
+            }
+
+            // Rewind may read the disconnected blocks, it is called without cs_main
+            if (pindex_fork) {
+                if (!write_locator() || !Rewind(pindex, pindex_fork)) {
+                    FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                               __func__, GetName());
+                    return;
+                }
+                pindex = pindex_fork;
+                continue;
             }
 
             int64_t current_time = GetTime();
@@ -114,22 +416,27 @@ void BaseIndex::ThreadSync()
                 last_log_time = current_time;
             }
 
-            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
-                WriteBestBlock(pindex);
-                last_locator_write_time = current_time;
-            }
-
             CBlock block;
             if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
                 FatalError("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             }
-            if (!WriteBlock(block, pindex)) {
+            if (f_batch ? !WriteBlockToBatch(batch, block, pindex) : !WriteBlock(block, pindex)) {
                 FatalError("%s: Failed to write block %s to index database",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             }
+            f_batch_pending = f_batch;
+
+            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time ||
+                batch.SizeEstimate() > SYNC_BATCH_SIZE) {
+                if (!write_locator()) {
+                    FatalError("%s: Failed to write to index database", __func__);
+                    return;
+                }
+                last_locator_write_time = current_time;
+            }
         }
     }
 
@@ -140,6 +447,28 @@ void BaseIndex::ThreadSync()
     }
 }
 
+bool BaseIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip == m_best_block_index || current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // In the case of a reorg, ensure persisted block locator is not stale.
+    m_best_block_index = new_tip;
+    return WriteBestBlock(new_tip);
+}
+
+bool BaseIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CDBBatch batch(GetDB());
+    if (!WriteBlockToBatch(batch, block, pindex)) {
+        return false;
+    }
+    {
+        LOCK(cs_main);
+        GetDB().WriteBestBlock(batch, chainActive.GetLocator(pindex));
+    }
+    return GetDB().WriteBatch(batch);
+}
+
 bool BaseIndex::WriteBestBlock(const CBlockIndex* block_index)
 {
     LOCK(cs_main);
@@ -176,6 +505,11 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const
                       best_block_index->GetBlockHash().ToString());
             return;
         }
+        if (best_block_index != pindex->pprev && !Rewind(best_block_index, pindex->pprev)) {
+            FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                       __func__, GetName());
+            return;
+        }
     }
 
     if (WriteBlock(*block, pindex)) {
@@ -254,8 +588,10 @@ void BaseIndex::Interrupt()
     m_interrupt();
 }
 
-void BaseIndex::Start()
+void BaseIndex::Start(int sync_threads)
 {
+    m_sync_threads = std::max(1, std::min(sync_threads, MAX_INDEX_SYNC_THREADS));
+
     // Need to register this ValidationInterface before running Init(), so that
     // callbacks are not missed if Init sets m_synced to true.
     RegisterValidationInterface(this);
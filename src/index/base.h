@@ -14,6 +14,11 @@
 
 class CBlockIndex;
 
+/// Default number of threads catching up indexes built out of order with the chain
+static const int DEFAULT_INDEX_SYNC_THREADS = 4;
+/// Maximum number of threads catching up indexes with the chain
+static const int MAX_INDEX_SYNC_THREADS = 16;
+
 /**
  * Base class for indices of blockchain data. This implements
  * CValidationInterface and ensures blocks are indexed sequentially according
@@ -33,6 +38,18 @@ protected:
 
         /// Write block locator of the chain that the txindex is in sync with.
         bool WriteBestBlock(const CBlockLocator& locator);
+
+        /// Add writing the block locator to a batch.
+        void WriteBestBlock(CDBBatch& batch, const CBlockLocator& locator) const;
+
+        /// Read the hash of the chain tip an unfinished ParallelSync was syncing to.
+        bool ReadSyncTarget(uint256& hash) const;
+
+        /// Write the hash of the chain tip ParallelSync is syncing to.
+        bool WriteSyncTarget(const uint256& hash);
+
+        /// Add erasing the ParallelSync target to a batch.
+        void EraseSyncTarget(CDBBatch& batch) const;
     };
 
 private:
@@ -47,6 +64,9 @@ private:
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
+    /// Number of threads used by ParallelSync.
+    int m_sync_threads{1};
+
     /// Sync the index with the block index starting from the current best block.
     /// Intended to be run in its own thread, m_thread_sync, and can be
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
@@ -54,6 +74,15 @@ private:
     /// over and the sync thread exits.
     void ThreadSync();
 
+    /// Catch up with the active chain tip using m_sync_threads threads, starting at pindex. The
+    /// threads claim ranges of blocks, so blocks are read and indexed out of order, and write the
+    /// index entries in large batches. The best block locator only advances over contiguous
+    /// completed ranges. Entries of the ranges after those are removed again if the sync is
+    /// interrupted or fails, or by Init if it didn't get to that. Blocks connected meanwhile are
+    /// indexed sequentially by ThreadSync afterwards. Returns false if the sync was interrupted
+    /// or failed, and sets pindex to the last block indexed.
+    bool ParallelSync(const CBlockIndex*& pindex);
+
     /// Write the current chain block locator to the DB.
     bool WriteBestBlock(const CBlockIndex* block_index);
 
@@ -63,14 +92,36 @@ protected:
 
     void ChainStateFlushed(const CBlockLocator& locator) override;
 
+    std::string GetSubscriberName() const override { return GetName(); }
+
     /// Initialize internal state from the database and block index.
     virtual bool Init();
 
-    /// Write update index entries for a newly connected block.
-    virtual bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
+    /// Write update index entries for a newly connected block. Unless overridden, writes the
+    /// entries added by WriteBlockToBatch in one batch with the block locator, so that entries
+    /// of blocks after the locator, which Rewind wouldn't find, never outlive a crash. Not
+    /// called by ThreadSync if AllowParallelSync is true, it batches the entries of many blocks.
+    virtual bool WriteBlock(const CBlock& block, const CBlockIndex* pindex);
+
+    /// Add the index entries of a block to a batch. Entries must not depend on other blocks being
+    /// indexed first if AllowParallelSync is true.
+    virtual bool WriteBlockToBatch(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex) { return true; }
+
+    /// Whether blocks can be indexed in any order while catching up with the chain, see
+    /// ParallelSync.
+    virtual bool AllowParallelSync() const { return false; }
+
+    /// Rewind index to an earlier chain tip during a chain reorg. The tip must
+    /// be an ancestor of the current best block. Indexes whose entries depend on
+    /// the active chain override this to remove the entries of the disconnected
+    /// blocks, and call the base class implementation afterwards.
+    virtual bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip);
 
     virtual DB& GetDB() const = 0;
 
+    /// The last block in the chain that the index is in sync with.
+    const CBlockIndex* CurrentIndex() const { return m_best_block_index.load(); }
+
     /// Get the name of the index for display in logs.
     virtual const char* GetName() const = 0;
 
@@ -89,10 +140,14 @@ public:
 
     /// Start initializes the sync state and registers the instance as a
     /// ValidationInterface so that it stays in sync with blockchain updates.
-    void Start();
+    /// Indexes allowing it catch up with the chain using sync_threads threads.
+    void Start(int sync_threads = 1);
 
     /// Stops the instance from staying in sync with blockchain updates.
     void Stop();
+
+    /// Get the last block in the chain that the index is in sync with. Null if none is indexed.
+    const CBlockIndex* GetBestBlockIndex() const { return CurrentIndex(); }
 };
 
 #endif // MACHINECOIN_INDEX_BASE_H
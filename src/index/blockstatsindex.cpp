@@ -0,0 +1,66 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockstatsindex.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+
+constexpr char DB_BLOCK_STATS = 's';
+
+std::unique_ptr<BlockStatsIndex> g_blockstatsindex;
+
+/**
+ * Access to the block stats index database (indexes/blockstats/)
+ *
+ * Besides the block locator of BaseIndex::DB, the database maps block hashes
+ * to the statistics of the block.
+ */
+class BlockStatsIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the statistics of a block. Returns false if the block is not indexed.
+    bool ReadStats(const uint256& block_hash, CBlockStats& stats) const;
+};
+
+BlockStatsIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "blockstats", n_cache_size, f_memory, f_wipe)
+{}
+
+bool BlockStatsIndex::DB::ReadStats(const uint256& block_hash, CBlockStats& stats) const
+{
+    return Read(std::make_pair(DB_BLOCK_STATS, block_hash), stats);
+}
+
+BlockStatsIndex::BlockStatsIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BlockStatsIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+BlockStatsIndex::~BlockStatsIndex() {}
+
+bool BlockStatsIndex::WriteBlockToBatch(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block has no undo data
+    CBlockUndo block_undo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+        return error("%s: Failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: undo data of block %s doesn't match the block", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    CBlockStats stats;
+    ComputeBlockStats(block, block_undo, stats);
+    batch.Write(std::make_pair(DB_BLOCK_STATS, pindex->GetBlockHash()), stats);
+    return true;
+}
+
+BaseIndex::DB& BlockStatsIndex::GetDB() const { return *m_db; }
+
+bool BlockStatsIndex::LookupStats(const CBlockIndex* block_index, CBlockStats& stats) const
+{
+    return m_db->ReadStats(block_index->GetBlockHash(), stats);
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_INDEX_BLOCKSTATSINDEX_H
+#define MACHINECOIN_INDEX_BLOCKSTATSINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <node/blockstats.h>
+
+/**
+ * BlockStatsIndex persists the statistics getblockstats computes for every
+ * block, so that they can be looked up without reading the block and its undo
+ * data. The index is written to a LevelDB database and records the statistics
+ * by block hash. They don't depend on the active chain, so entries of blocks
+ * which were disconnected are kept.
+ */
+class BlockStatsIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlockToBatch(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool AllowParallelSync() const override { return true; }
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "blockstatsindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit BlockStatsIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~BlockStatsIndex() override;
+
+    /// Look up the statistics of a block. Returns false if the block is not indexed.
+    bool LookupStats(const CBlockIndex* block_index, CBlockStats& stats) const;
+};
+
+/// The global block stats index, used by getblockstats. May be null.
+extern std::unique_ptr<BlockStatsIndex> g_blockstatsindex;
+
+#endif // MACHINECOIN_INDEX_BLOCKSTATSINDEX_H
@@ -0,0 +1,274 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/coinstatsindex.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <crypto/muhash.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+
+constexpr char DB_BLOCK_STATS = 's';
+constexpr char DB_TX_OUTPUTS = 'o';
+constexpr char DB_STATE = 'm';
+
+std::unique_ptr<CoinStatsIndex> g_coinstatsindex;
+
+struct CoinStatsIndex::State
+{
+    //! The last block applied, null if none
+    uint256 hashBlock;
+    MuHash3072 muhash;
+    CIndexedCoinsStats stats;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(muhash);
+        READWRITE(stats);
+    }
+};
+
+namespace {
+
+/** Changes of the number of unspent outputs of transactions */
+typedef std::map<uint256, int64_t> TxOutputDeltas;
+
+/** Add an unspent output to the statistics, or remove it */
+void ApplyCoin(MuHash3072& muhash, CIndexedCoinsStats& stats, TxOutputDeltas& deltas,
+               const COutPoint& outpoint, const Coin& coin, bool add)
+{
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << outpoint;
+    ss << (uint32_t)(coin.nHeight * 2 + coin.fCoinBase);
+    ss << coin.out;
+    const uint64_t bogo_size = 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
+                               2 /* scriptPubKey len */ + coin.out.scriptPubKey.size() /* scriptPubKey */;
+
+    if (add) {
+        muhash.Insert((const unsigned char*)ss.data(), ss.size());
+        stats.nTransactionOutputs++;
+        stats.nBogoSize += bogo_size;
+        stats.nTotalAmount += coin.out.nValue;
+        deltas[outpoint.hash]++;
+    } else {
+        muhash.Remove((const unsigned char*)ss.data(), ss.size());
+        stats.nTransactionOutputs--;
+        stats.nBogoSize -= bogo_size;
+        stats.nTotalAmount -= coin.out.nValue;
+        deltas[outpoint.hash]--;
+    }
+}
+
+/**
+ * Apply the outputs a block creates and spends to the statistics, or undo them. The outputs of
+ * a block can be applied in any order, as the set hash and the counters are commutative.
+ */
+void ApplyBlock(MuHash3072& muhash, CIndexedCoinsStats& stats, TxOutputDeltas& deltas,
+                const CBlock& block, const CBlockUndo& block_undo, int height, bool undo)
+{
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        for (size_t j = 0; j < tx.vout.size(); j++) {
+            // Unspendable outputs are never added to the UTXO set
+            if (tx.vout[j].scriptPubKey.IsUnspendable()) continue;
+            ApplyCoin(muhash, stats, deltas, COutPoint(tx.GetHash(), j), Coin(tx.vout[j], height, tx.IsCoinBase()), !undo);
+        }
+        // The undo data of a block has an entry for every transaction but the coinbase
+        if (i > 0) {
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                ApplyCoin(muhash, stats, deltas, tx.vin[j].prevout, tx_undo.vprevout[j], undo);
+            }
+        }
+    }
+}
+
+bool ReadBlockUndo(const CBlockIndex* pindex, const CBlock& block, CBlockUndo& block_undo)
+{
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: undo data of block %s doesn't match the block", __func__, pindex->GetBlockHash().ToString());
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * Access to the coin stats index database (indexes/coinstats/)
+ *
+ * Besides the block locator of BaseIndex::DB, the database maps block hashes
+ * to the UTXO set statistics after the block, transaction ids to the number of
+ * unspent outputs of the transaction, and holds the state of the index as of
+ * the last block applied.
+ */
+class CoinStatsIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the statistics after a block. Returns false if the block is not indexed.
+    bool ReadStats(const uint256& block_hash, CIndexedCoinsStats& stats) const;
+
+    /// Read the state of the index. Returns false if there is none.
+    bool ReadState(State& state) const;
+
+    /// Add the changes of the unspent output counts of transactions to a batch, and update the
+    /// number of transactions with unspent outputs.
+    bool WriteTxOutputDeltas(CDBBatch& batch, const TxOutputDeltas& deltas, uint64_t& tx_count) const;
+};
+
+CoinStatsIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "coinstats", n_cache_size, f_memory, f_wipe)
+{}
+
+bool CoinStatsIndex::DB::ReadStats(const uint256& block_hash, CIndexedCoinsStats& stats) const
+{
+    return Read(std::make_pair(DB_BLOCK_STATS, block_hash), stats);
+}
+
+bool CoinStatsIndex::DB::ReadState(State& state) const
+{
+    return Read(DB_STATE, state);
+}
+
+bool CoinStatsIndex::DB::WriteTxOutputDeltas(CDBBatch& batch, const TxOutputDeltas& deltas, uint64_t& tx_count) const
+{
+    for (const auto& delta : deltas) {
+        // A transaction whose outputs were created and spent by the same block never had unspent outputs
+        if (delta.second == 0) continue;
+
+        const auto key = std::make_pair(DB_TX_OUTPUTS, delta.first);
+        // There is no record if the transaction has no unspent outputs
+        uint64_t count;
+        if (!Read(key, count)) {
+            count = 0;
+        }
+        if (delta.second < 0 && count < (uint64_t)-delta.second) {
+            return error("%s: transaction %s has fewer unspent outputs than spent", __func__, delta.first.ToString());
+        }
+        const uint64_t new_count = count + delta.second;
+        if (count == 0) {
+            tx_count++;
+        } else if (new_count == 0) {
+            tx_count--;
+        }
+        if (new_count == 0) {
+            batch.Erase(key);
+        } else {
+            batch.Write(key, new_count);
+        }
+    }
+    return true;
+}
+
+CoinStatsIndex::CoinStatsIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<CoinStatsIndex::DB>(n_cache_size, f_memory, f_wipe)), m_state(MakeUnique<State>())
+{}
+
+CoinStatsIndex::~CoinStatsIndex() {}
+
+bool CoinStatsIndex::Init()
+{
+    if (!m_db->ReadState(*m_state)) {
+        *m_state = State();
+    }
+    if (!BaseIndex::Init()) {
+        return false;
+    }
+
+    // The best block locator is only written when the chain state is flushed, so blocks may have
+    // been applied after it before a crash. Undo them, they are applied again while syncing.
+    if (!ReverseBlocks(CurrentIndex())) {
+        return error("%s: Failed to undo the blocks applied after the best block of %s", __func__, GetName());
+    }
+    return true;
+}
+
+bool CoinStatsIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    const uint256 prev_hash = pindex->pprev ? pindex->pprev->GetBlockHash() : uint256();
+    if (m_state->hashBlock != prev_hash) {
+        return error("%s: block %s doesn't build on the last block applied %s", __func__,
+                     pindex->GetBlockHash().ToString(), m_state->hashBlock.ToString());
+    }
+
+    TxOutputDeltas deltas;
+    // The outputs of the genesis block aren't part of the UTXO set
+    if (pindex->nHeight > 0) {
+        CBlockUndo block_undo;
+        if (!ReadBlockUndo(pindex, block, block_undo)) {
+            return false;
+        }
+        ApplyBlock(m_state->muhash, m_state->stats, deltas, block, block_undo, pindex->nHeight, false);
+    }
+
+    CDBBatch batch(*m_db);
+    if (!m_db->WriteTxOutputDeltas(batch, deltas, m_state->stats.nTransactions)) {
+        return false;
+    }
+    m_state->muhash.Finalize(m_state->stats.hashMuHash);
+    m_state->hashBlock = pindex->GetBlockHash();
+    batch.Write(std::make_pair(DB_BLOCK_STATS, m_state->hashBlock), m_state->stats);
+    batch.Write(DB_STATE, *m_state);
+    return m_db->WriteBatch(batch);
+}
+
+bool CoinStatsIndex::ReverseBlocks(const CBlockIndex* new_tip)
+{
+    const uint256 new_hash = new_tip ? new_tip->GetBlockHash() : uint256();
+    while (m_state->hashBlock != new_hash) {
+        const CBlockIndex* pindex;
+        {
+            LOCK(cs_main);
+            pindex = LookupBlockIndex(m_state->hashBlock);
+        }
+        if (!pindex || (new_tip && pindex->nHeight <= new_tip->nHeight)) {
+            return error("%s: block %s is not an ancestor of the last block applied %s", __func__,
+                         new_hash.ToString(), m_state->hashBlock.ToString());
+        }
+
+        TxOutputDeltas deltas;
+        if (pindex->nHeight > 0) {
+            CBlock block;
+            CBlockUndo block_undo;
+            if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()) || !ReadBlockUndo(pindex, block, block_undo)) {
+                return error("%s: Failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+            }
+            ApplyBlock(m_state->muhash, m_state->stats, deltas, block, block_undo, pindex->nHeight, true);
+        }
+
+        CDBBatch batch(*m_db);
+        if (!m_db->WriteTxOutputDeltas(batch, deltas, m_state->stats.nTransactions)) {
+            return false;
+        }
+        m_state->hashBlock = pindex->pprev ? pindex->pprev->GetBlockHash() : uint256();
+        batch.Write(DB_STATE, *m_state);
+        if (!m_db->WriteBatch(batch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CoinStatsIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    if (!ReverseBlocks(new_tip)) {
+        return error("%s: Failed to undo the blocks after %s", __func__, new_tip->GetBlockHash().ToString());
+    }
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& CoinStatsIndex::GetDB() const { return *m_db; }
+
+bool CoinStatsIndex::LookupStats(const CBlockIndex* block_index, CIndexedCoinsStats& stats) const
+{
+    return m_db->ReadStats(block_index->GetBlockHash(), stats);
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_INDEX_COINSTATSINDEX_H
+#define MACHINECOIN_INDEX_COINSTATSINDEX_H
+
+#include <amount.h>
+#include <chain.h>
+#include <index/base.h>
+#include <serialize.h>
+
+/** Statistics about the UTXO set after a block, as kept by the coin stats index */
+struct CIndexedCoinsStats
+{
+    //! MuHash3072 of the serialized unspent outputs
+    uint256 hashMuHash;
+    //! Number of transactions with unspent outputs
+    uint64_t nTransactions{0};
+    uint64_t nTransactionOutputs{0};
+    uint64_t nBogoSize{0};
+    CAmount nTotalAmount{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashMuHash);
+        READWRITE(VARINT(nTransactions));
+        READWRITE(VARINT(nTransactionOutputs));
+        READWRITE(VARINT(nBogoSize));
+        READWRITE(VARINT(nTotalAmount, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
+/**
+ * CoinStatsIndex maintains the statistics reported by gettxoutsetinfo
+ * incrementally, from the outputs created and spent by every block, so that
+ * they can be looked up in constant time instead of scanning the UTXO set.
+ * The index is written to a LevelDB database (indexes/coinstats/), which holds
+ * the statistics after every block connected since the index was enabled,
+ * including blocks which were later disconnected, as their statistics don't
+ * change. To count transactions with unspent outputs, it also keeps the number
+ * of unspent outputs of every such transaction as of the best block.
+ */
+class CoinStatsIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    struct State;
+
+    const std::unique_ptr<DB> m_db;
+    /// The UTXO set hash and statistics as of the last block applied. Only accessed by the thread
+    /// writing the index.
+    std::unique_ptr<State> m_state;
+
+    /// Undo the changes of the blocks from the last block applied back to new_tip.
+    bool ReverseBlocks(const CBlockIndex* new_tip);
+
+protected:
+    bool Init() override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "coinstatsindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit CoinStatsIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~CoinStatsIndex() override;
+
+    /// Get the statistics of the UTXO set after a block. Returns false if the block is not indexed.
+    bool LookupStats(const CBlockIndex* block_index, CIndexedCoinsStats& stats) const;
+};
+
+/// The global coin stats index, used by gettxoutsetinfo. May be null.
+extern std::unique_ptr<CoinStatsIndex> g_coinstatsindex;
+
+#endif // MACHINECOIN_INDEX_COINSTATSINDEX_H
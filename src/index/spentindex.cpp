@@ -0,0 +1,131 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/spentindex.h>
+#include <chainparams.h>
+#include <index/addressindex.h>
+#include <undo.h>
+#include <util.h>
+#include <validation.h>
+
+constexpr char DB_SPENT = 'p';
+
+std::unique_ptr<SpentIndex> g_spentindex;
+
+typedef std::vector<std::pair<COutPoint, CSpentIndexValue>> SpentIndexEntries;
+
+/** Read the undo data of a block and collect its spent index entries */
+static bool ReadSpentIndexEntries(const CBlockIndex* pindex, const CBlock& block, SpentIndexEntries& entries)
+{
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: undo data of block %s doesn't match the block", __func__, pindex->GetBlockHash().ToString());
+    }
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+        for (size_t j = 0; j < tx.vin.size(); j++) {
+            const CTxOut& prevout = tx_undo.vprevout[j].out;
+            CSpentIndexValue value;
+            value.txid = tx.GetHash();
+            value.nInputIndex = j;
+            value.nHeight = pindex->nHeight;
+            value.nValue = prevout.nValue;
+            value.scriptHash = GetIndexScriptHash(prevout.scriptPubKey);
+            entries.emplace_back(tx.vin[j].prevout, value);
+        }
+    }
+    return true;
+}
+
+/**
+ * Access to the spent index database (indexes/spentindex/)
+ *
+ * Besides the block locator of BaseIndex::DB, the database maps spent outpoints to their
+ * spenders.
+ */
+class SpentIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the spender of an outpoint. Returns false if the outpoint isn't indexed.
+    bool ReadSpender(const COutPoint& outpoint, CSpentIndexValue& value) const;
+
+    /// Add writing or erasing entries to a batch.
+    void WriteEntries(CDBBatch& batch, const SpentIndexEntries& entries, bool f_erase) const;
+
+    /// Write or erase a batch of entries.
+    bool WriteEntries(const SpentIndexEntries& entries, bool f_erase);
+};
+
+SpentIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "spentindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool SpentIndex::DB::ReadSpender(const COutPoint& outpoint, CSpentIndexValue& value) const
+{
+    return Read(std::make_pair(DB_SPENT, outpoint), value);
+}
+
+void SpentIndex::DB::WriteEntries(CDBBatch& batch, const SpentIndexEntries& entries, bool f_erase) const
+{
+    for (const auto& entry : entries) {
+        if (f_erase) {
+            batch.Erase(std::make_pair(DB_SPENT, entry.first));
+        } else {
+            batch.Write(std::make_pair(DB_SPENT, entry.first), entry.second);
+        }
+    }
+}
+
+bool SpentIndex::DB::WriteEntries(const SpentIndexEntries& entries, bool f_erase)
+{
+    CDBBatch batch(*this);
+    WriteEntries(batch, entries, f_erase);
+    return WriteBatch(batch);
+}
+
+SpentIndex::SpentIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<SpentIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+SpentIndex::~SpentIndex() {}
+
+bool SpentIndex::WriteBlockToBatch(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex)
+{
+    // Only the coinbase transaction, which spends nothing, is in the genesis block
+    if (pindex->nHeight == 0) {
+        return true;
+    }
+    SpentIndexEntries entries;
+    if (!ReadSpentIndexEntries(pindex, block, entries)) {
+        return false;
+    }
+    m_db->WriteEntries(batch, entries, false);
+    return true;
+}
+
+bool SpentIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip && pindex->nHeight > 0; pindex = pindex->pprev) {
+        CBlock block;
+        SpentIndexEntries entries;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()) ||
+            !ReadSpentIndexEntries(pindex, block, entries) || !m_db->WriteEntries(entries, true)) {
+            return error("%s: Failed to remove the entries of block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+    }
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& SpentIndex::GetDB() const { return *m_db; }
+
+bool SpentIndex::FindSpender(const COutPoint& outpoint, CSpentIndexValue& value) const
+{
+    return m_db->ReadSpender(outpoint, value);
+}
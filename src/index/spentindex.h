@@ -0,0 +1,75 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_INDEX_SPENTINDEX_H
+#define MACHINECOIN_INDEX_SPENTINDEX_H
+
+#include <amount.h>
+#include <chain.h>
+#include <index/base.h>
+#include <serialize.h>
+
+/** The input spending an output, and the spent output */
+struct CSpentIndexValue
+{
+    uint256 txid;
+    uint32_t nInputIndex;
+    int32_t nHeight;
+    //! Value of the spent output
+    CAmount nValue;
+    //! Hash of the scriptPubKey of the spent output, see GetIndexScriptHash
+    uint256 scriptHash;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(VARINT(nInputIndex));
+        READWRITE(VARINT(nHeight, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(nValue, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(scriptHash);
+    }
+};
+
+/**
+ * SpentIndex is used to look up the transaction input spending an output.
+ * The index is written to a LevelDB database (indexes/spentindex/) and maps
+ * every output spent in the active chain to its spender.
+ */
+class SpentIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlockToBatch(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool AllowParallelSync() const override { return true; }
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "spentindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit SpentIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~SpentIndex() override;
+
+    /// Look up the input spending an output. Returns false if the output isn't spent in the
+    /// active chain as far as the index is synced.
+    bool FindSpender(const COutPoint& outpoint, CSpentIndexValue& value) const;
+};
+
+/// The global spent index, used by getspentinfo. May be null.
+extern std::unique_ptr<SpentIndex> g_spentindex;
+
+#endif // MACHINECOIN_INDEX_SPENTINDEX_H
@@ -26,7 +26,9 @@ protected:
     /// Override base class init to migrate from old database.
     bool Init() override;
 
-    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+    bool WriteBlockToBatch(CDBBatch& batch, const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool AllowParallelSync() const override { return true; }
 
     BaseIndex::DB& GetDB() const override;
 
@@ -19,7 +19,12 @@
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
+#include <index/addressindex.h>
+#include <index/blockfilterindex.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
+#include <index/blockstatsindex.h>
+#include <index/coinstatsindex.h>
 #include <key.h>
 #include <validation.h>
 #include <miner.h>
@@ -70,6 +75,7 @@
 #include <stdio.h>
 
 #include <bls/bls.h>
+#include <bls/bls_worker.h>
 #ifndef WIN32
 #include <signal.h>
 #endif
@@ -191,9 +197,13 @@ public:
 
 static std::unique_ptr<CCoinsViewErrorCatcher> pcoinscatcher;
 static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
+// Verifies the signatures of LLMQ commitments for the quorum block processor
+static std::unique_ptr<CBLSWorker> blsWorker;
 
 static boost::thread_group threadGroup;
 static CScheduler scheduler;
+//! Delivers validation interface callbacks, separate from scheduler which stays single threaded
+static CScheduler validationCallbackPool;
 
 void Interrupt()
 {
@@ -208,6 +218,21 @@ void Interrupt()
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_blockfilterindex) {
+        g_blockfilterindex->Interrupt();
+    }
+    if (g_addressindex) {
+        g_addressindex->Interrupt();
+    }
+    if (g_spentindex) {
+        g_spentindex->Interrupt();
+    }
+    if (g_coinstatsindex) {
+        g_coinstatsindex->Interrupt();
+    }
+    if (g_blockstatsindex) {
+        g_blockstatsindex->Interrupt();
+    }
 }
 
 void Shutdown()
@@ -235,8 +260,16 @@ void Shutdown()
     // Because these depend on each-other, we make sure that neither can be
     // using the other before destroying them.
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
+    // The masternode message workers hold references to nodes, which CConnman::Stop deletes
+    if (peerLogic) peerLogic->StopMasternodeMessageWorkers();
+    governance.StopVoteVerification();
     if (g_connman) g_connman->Stop();
     if (g_txindex) g_txindex->Stop();
+    if (g_blockfilterindex) g_blockfilterindex->Stop();
+    if (g_addressindex) g_addressindex->Stop();
+    if (g_spentindex) g_spentindex->Stop();
+    if (g_coinstatsindex) g_coinstatsindex->Stop();
+    if (g_blockstatsindex) g_blockstatsindex->Stop();
   
     // STORE DATA CACHES INTO SERIALIZED DAT FILES
     if (!fLiteMode) {
@@ -262,6 +295,11 @@ void Shutdown()
     peerLogic.reset();
     g_connman.reset();
     g_txindex.reset();
+    g_blockfilterindex.reset();
+    g_addressindex.reset();
+    g_spentindex.reset();
+    g_coinstatsindex.reset();
+    g_blockstatsindex.reset();
 
     if (g_is_mempool_loaded && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
         DumpMempool();
@@ -303,7 +341,12 @@ void Shutdown()
         pcoinscatcher.reset();
         pcoinsdbview.reset();
         pblocktree.reset();
+        // wait for running verifications, which reference the quorum block processor
+        if (blsWorker) {
+            blsWorker->Stop();
+        }
         llmq::DestroyLLMQSystem();
+        blsWorker.reset();
         // Use .reset() function
         delete deterministicMNManager;
         deterministicMNManager = NULL;
@@ -347,6 +390,7 @@ void Shutdown()
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    g_logger->StopAsync();
 }
 
 /**
@@ -434,6 +478,8 @@ void SetupServerArgs()
     gArgs.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex()), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-prefetchthreads=<n>", strprintf("Set the number of threads reading the inputs of a block from the coins database before it is connected (0 to %d, 0 = disabled, default: %d)",
+        MAX_COINS_PREFETCH_THREADS, DEFAULT_COINS_PREFETCH_THREADS), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), false, OptionsCategory::OPTIONS);
 #ifndef WIN32
     gArgs.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", MACHINECOIN_PID_FILENAME), false, OptionsCategory::OPTIONS);
@@ -445,12 +491,20 @@ void SetupServerArgs()
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >=%u = automatically prune block files to stay under the specified target size in MiB)", MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-schedulerthreads=<n>", strprintf("Set the number of threads delivering validation notifications to the wallets, indexes and other subscribers in parallel (1 to %d, default: %d)",
+        MAX_SCHEDULER_THREADS, DEFAULT_SCHEDULER_THREADS), false, OptionsCategory::OPTIONS);
 #ifndef WIN32
     gArgs.AddArg("-sysperms", "Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)", false, OptionsCategory::OPTIONS);
 #else
     hidden_args.emplace_back("-sysperms");
 #endif
     gArgs.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-blockfilterindex", strprintf("Maintain an index of compact block filters (BIP 158), used to skip blocks in wallet rescans and by the getblockfilter rpc call (default: %u)", DEFAULT_BLOCKFILTERINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-addressindex", strprintf("Maintain an index of the outputs and inputs of every scriptPubKey, used by the getaddressdeltas and getaddressbalance rpc calls (default: %u)", DEFAULT_ADDRESSINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-spentindex", strprintf("Maintain an index of the inputs spending every output, used by the getspentinfo rpc call (default: %u)", DEFAULT_SPENTINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-coinstatsindex", strprintf("Maintain the statistics of the UTXO set after every block, used by the gettxoutsetinfo rpc call to answer without scanning the UTXO set (default: %u)", DEFAULT_COINSTATSINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-blockstatsindex", strprintf("Maintain the statistics of every block, used by the getblockstats rpc call to answer without reading blocks (default: %u)", DEFAULT_BLOCKSTATSINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-indexsyncthreads=<n>", strprintf("Number of threads catching up -txindex, -addressindex, -spentindex and -blockstatsindex with the block chain (1 to %d, default: %d)", MAX_INDEX_SYNC_THREADS, DEFAULT_INDEX_SYNC_THREADS), false, OptionsCategory::OPTIONS);
 
     gArgs.AddArg("-addnode=<ip>", "Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info). This option can be specified multiple times to add multiple nodes.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-banscore=<n>", strprintf("Threshold for disconnecting misbehaving peers (default: %u)", DEFAULT_BANSCORE_THRESHOLD), false, OptionsCategory::CONNECTION);
@@ -478,6 +532,7 @@ void SetupServerArgs()
     gArgs.AddArg("-proxy=<ip:port>", "Connect through SOCKS5 proxy, set -noproxy to disable (default: disabled)", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-proxyrandomize", strprintf("Randomize credentials for every proxy connection. This enables Tor stream isolation (default: %u)", DEFAULT_PROXYRANDOMIZE), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-seednode=<ip>", "Connect to a node to retrieve peer addresses, and disconnect. This option can be specified multiple times to connect to multiple nodes.", false, OptionsCategory::CONNECTION);
+    gArgs.AddArg("-socketevents=<mode>", strprintf("Socket events mode, which must be one of: %s (default: %s)", GetSupportedSocketEventsModes(), DEFAULT_SOCKETEVENTS), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-timeout=<n>", strprintf("Specify connection timeout in milliseconds (minimum: 1, default: %d)", DEFAULT_CONNECT_TIMEOUT), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-torcontrol=<ip>:<port>", strprintf("Tor control port to use if onion listening enabled (default: %s)", DEFAULT_TOR_CONTROL), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-torpassword=<pass>", "Tor control port password (default: empty)", false, OptionsCategory::CONNECTION);
@@ -526,15 +581,19 @@ void SetupServerArgs()
     gArgs.AddArg("-limitdescendantcount=<n>", strprintf("Do not accept transactions if any ancestor would have <n> or more in-mempool descendants (default: %u)", DEFAULT_DESCENDANT_LIMIT), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-limitdescendantsize=<n>", strprintf("Do not accept transactions if any ancestor would have more than <n> kilobytes of in-mempool descendants (default: %u).", DEFAULT_DESCENDANT_SIZE_LIMIT), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-vbparams=deployment:start:end", "Use given start/end times for specified version bits deployment (regtest-only)", true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-snapshothash=height:hash", "Accept the UTXO snapshot with the given hash, based on the block at the given height, in loadtxoutset (regtest-only)", true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-addrmantest", "Allows to test address relay on localhost", true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-debug=<category>", "Output debugging information (default: -nodebug, supplying <category> is optional). "
         "If <category> is not supplied or if <category> = 1, output all debugging information. <category> can be: " + ListLogCategories() + ".", false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-debugexclude=<category>", strprintf("Exclude debugging information for a category. Can be used in conjunction with -debug=1 to output debug logs for all categories except one or more specified categories."), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-help-debug", "Show all debugging options (usage: --help -help-debug)", false, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-logasync", strprintf("Write debug.log from a background thread, dropping lines when more than -logasyncbuffer are pending. Pending lines are written out on a crash on a best effort basis only (default: %u)", DEFAULT_LOGASYNC), false, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-logasyncbuffer=<n>", strprintf("Maximum size of log lines waiting for the -logasync writer in MiB (default: %u)", DEFAULT_LOGASYNC_BUFFER), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logips", strprintf("Include IP addresses in debug output (default: %u)", DEFAULT_LOGIPS), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logtimestamps", strprintf("Prepend debug output with timestamp (default: %u)", DEFAULT_LOGTIMESTAMPS), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)", true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-maxmsgsigcachesize=<n>", strprintf("Limit size of the cache of verified masternode and governance message signatures to <n> MiB (default: %u)", DEFAULT_MAX_MSG_SIG_CACHE_SIZE), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-maxtxfee=<amt>", strprintf("Maximum total fees (in %s) to use in a single wallet transaction or raw transaction; setting this too low may abort large transactions (default: %s)",
@@ -580,6 +639,7 @@ void SetupServerArgs()
     gArgs.AddArg("-litemode=<n>", strprintf("Disable all Machinecoin specific functionality (Masternodes, Governance) (0-1, default: %u)", 0), false, OptionsCategory::MN);
     gArgs.AddArg("-masternode=<n>", strprintf("Enable the client to act as a masternode (0-1, default: %u)", 0), false, OptionsCategory::MN);
     gArgs.AddArg("-mnconf=<file>", strprintf("Specify masternode configuration file (default: %s)", "masternode.conf"), false, OptionsCategory::MN);
+    gArgs.AddArg("-mnmsgthreads=<n>", strprintf("Number of threads processing masternode, governance and quorum messages, 0 to process them on the message handler thread (0-%d, default: %d)", MAX_MASTERNODE_MESSAGE_THREADS, DEFAULT_MASTERNODE_MESSAGE_THREADS), false, OptionsCategory::MN);
     gArgs.AddArg("-mnconflock=<n>", strprintf("Lock masternodes from masternode configuration file (default: %u)", 1), false, OptionsCategory::MN);
     gArgs.AddArg("-masternodeprivkey=<n>", "Set the masternode private key", false, OptionsCategory::MN);
     gArgs.AddArg("-masternodeblsprivkey=<hex>", "Set the masternode BLS private key", false, OptionsCategory::MN);
@@ -719,6 +779,15 @@ static void ThreadImport(std::vector<fs::path> vImportFiles)
             if (!file)
                 break; // This error is logged in OpenBlockFile
             LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
+            // Let the OS read the next file in the background while this one is imported
+            CDiskBlockPos posNext(nFile + 1, 0);
+            if (fs::exists(GetBlockPosFilename(posNext, "blk"))) {
+                FILE *fileNext = OpenBlockFile(posNext, true);
+                if (fileNext) {
+                    ReadAheadFile(fileNext);
+                    fclose(fileNext);
+                }
+            }
             LoadExternalBlockFile(chainparams, file, &pos);
             nFile++;
         }
@@ -970,6 +1039,7 @@ ServiceFlags nLocalServices = ServiceFlags(NODE_NETWORK | NODE_NETWORK_LIMITED);
     // to terminate first.
     std::set_new_handler(std::terminate);
     LogPrintf("Error: Out of memory. Terminating.\n");
+    g_logger->Flush();
 
     // The log was successful, terminate now.
     std::terminate();
@@ -1040,6 +1110,16 @@ bool AppInitParameterInteraction()
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (gArgs.GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX))
+            return InitError(_("Prune mode is incompatible with -blockfilterindex."));
+        if (gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX))
+            return InitError(_("Prune mode is incompatible with -addressindex."));
+        if (gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX))
+            return InitError(_("Prune mode is incompatible with -spentindex."));
+        if (gArgs.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX))
+            return InitError(_("Prune mode is incompatible with -coinstatsindex."));
+        if (gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX))
+            return InitError(_("Prune mode is incompatible with -blockstatsindex."));
     }
 
     // -bind and -whitebind can't be set when not listening
@@ -1278,6 +1358,24 @@ bool AppInitParameterInteraction()
             }
         }
     }
+
+    if (gArgs.IsArgSet("-snapshothash")) {
+        // Allow pinning UTXO snapshots for testing
+        if (!chainparams.MineBlocksOnDemand()) {
+            return InitError("UTXO snapshot hashes may only be pinned on regtest.");
+        }
+        for (const std::string& strSnapshot : gArgs.GetArgs("-snapshothash")) {
+            std::vector<std::string> vSnapshotParams;
+            boost::split(vSnapshotParams, strSnapshot, boost::is_any_of(":"));
+            int nHeight;
+            if (vSnapshotParams.size() != 2 || !ParseInt32(vSnapshotParams[0], &nHeight) || nHeight < 0 ||
+                vSnapshotParams[1].size() != 64 || !IsHex(vSnapshotParams[1])) {
+                return InitError("UTXO snapshot hash malformed, expecting height:hash");
+            }
+            UpdateSnapshotHash(nHeight, uint256S(vSnapshotParams[1]));
+            LogPrintf("Accepting UTXO snapshot %s at height %d\n", vSnapshotParams[1], nHeight);
+        }
+    }
     return true;
 }
 
@@ -1344,6 +1442,9 @@ bool AppInitMain()
             return InitError(strprintf("Could not open debug log file %s",
                                        g_logger->m_file_path.string()));
         }
+        if (gArgs.GetBoolArg("-logasync", DEFAULT_LOGASYNC)) {
+            g_logger->StartAsync((size_t)std::max<int64_t>(gArgs.GetArg("-logasyncbuffer", DEFAULT_LOGASYNC_BUFFER), 1) << 20);
+        }
     }
 
     if (!g_logger->m_log_timestamps)
@@ -1363,19 +1464,37 @@ bool AppInitMain()
     }
 
     InitSignatureCache();
+    InitMessageSignatureCache();
     InitScriptExecutionCache();
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        // Blocks are imported while scripts aren't verified yet, so use the same number of threads
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadBlockDecode);
+    }
+
+    int nCoinsPrefetchThreads = std::max(0, std::min((int)gArgs.GetArg("-prefetchthreads", DEFAULT_COINS_PREFETCH_THREADS), MAX_COINS_PREFETCH_THREADS));
+    LogPrintf("Using %u threads for prefetching block inputs\n", nCoinsPrefetchThreads);
+    for (int i = 0; i < nCoinsPrefetchThreads; i++) {
+        threadGroup.create_thread(&ThreadCoinsPrefetch);
     }
 
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
 
-    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+    // Every validation interface subscriber has its own callback queue, so the callback pool
+    // threads can deliver callbacks to several of them at once
+    int nSchedulerThreads = std::max(1, std::min(MAX_SCHEDULER_THREADS, (int)gArgs.GetArg("-schedulerthreads", DEFAULT_SCHEDULER_THREADS)));
+    CScheduler::Function callbackLoop = boost::bind(&CScheduler::serviceQueue, &validationCallbackPool);
+    for (int i = 0; i < nSchedulerThreads; i++) {
+        threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "valcallback", callbackLoop));
+    }
+
+    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler, &validationCallbackPool);
     GetMainSignals().RegisterWithMempoolSignals(mempool);
 
     /* Register RPC commands regardless of -server setting so they will be
@@ -1417,7 +1536,8 @@ bool AppInitMain()
     g_connman = std::unique_ptr<CConnman>(new CConnman(GetRand(std::numeric_limits<uint64_t>::max()), GetRand(std::numeric_limits<uint64_t>::max())));
     CConnman& connman = *g_connman;
 
-    peerLogic.reset(new PeerLogicValidation(&connman, scheduler, gArgs.GetBoolArg("-enablebip61", DEFAULT_ENABLE_BIP61)));
+    int nMasternodeMessageThreads = std::max(0, std::min(MAX_MASTERNODE_MESSAGE_THREADS, (int)gArgs.GetArg("-mnmsgthreads", DEFAULT_MASTERNODE_MESSAGE_THREADS)));
+    peerLogic.reset(new PeerLogicValidation(&connman, scheduler, gArgs.GetBoolArg("-enablebip61", DEFAULT_ENABLE_BIP61), nMasternodeMessageThreads));
     RegisterValidationInterface(peerLogic.get());
 
     // sanitize comments per BIP-0014, format user agent and check total size
@@ -1552,6 +1672,16 @@ bool AppInitMain()
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    int64_t nFilterIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX) ? nMaxBlockFilterIndexCache << 20 : 0);
+    nTotalCache -= nFilterIndexCache;
+    int64_t nAddressIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ? nMaxAddressIndexCache << 20 : 0);
+    nTotalCache -= nAddressIndexCache;
+    int64_t nSpentIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ? nMaxSpentIndexCache << 20 : 0);
+    nTotalCache -= nSpentIndexCache;
+    int64_t nCoinStatsIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX) ? nMaxCoinStatsIndexCache << 20 : 0);
+    nTotalCache -= nCoinStatsIndexCache;
+    int64_t nBlockStatsIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX) ? nMaxBlockStatsIndexCache << 20 : 0);
+    nTotalCache -= nBlockStatsIndexCache;
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1563,9 +1693,27 @@ bool AppInitMain()
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1fMiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (gArgs.GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX)) {
+        LogPrintf("* Using %.1fMiB for block filter index database\n", nFilterIndexCache * (1.0 / 1024 / 1024));
+    }
+    if (gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        LogPrintf("* Using %.1fMiB for address index database\n", nAddressIndexCache * (1.0 / 1024 / 1024));
+    }
+    if (gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
+        LogPrintf("* Using %.1fMiB for spent index database\n", nSpentIndexCache * (1.0 / 1024 / 1024));
+    }
+    if (gArgs.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
+        LogPrintf("* Using %.1fMiB for coin stats index database\n", nCoinStatsIndexCache * (1.0 / 1024 / 1024));
+    }
+    if (gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)) {
+        LogPrintf("* Using %.1fMiB for block stats index database\n", nBlockStatsIndexCache * (1.0 / 1024 / 1024));
+    }
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
+    blsWorker.reset(new CBLSWorker());
+    blsWorker->Start();
+
     bool fLoaded = false;
     while (!fLoaded && !ShutdownRequested()) {
         bool fReset = fReindex;
@@ -1592,7 +1740,7 @@ bool AppInitMain()
 
                 evoDb = new CEvoDB(nEvoDbCache, false, fReindex || fReindexChainState);
                 deterministicMNManager = new CDeterministicMNManager(*evoDb);
-                llmq::InitLLMQSystem(*evoDb);
+                llmq::InitLLMQSystem(*evoDb, *blsWorker);
 
                 if (fReset) {
                     pblocktree->WriteReindexing(true);
@@ -1745,9 +1893,30 @@ bool AppInitMain()
     fFeeEstimatesInitialized = true;
 
     // ********************************************************* Step 8: start indexers
+    const int nIndexSyncThreads = gArgs.GetArg("-indexsyncthreads", DEFAULT_INDEX_SYNC_THREADS);
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, fReindex);
-        g_txindex->Start();
+        g_txindex->Start(nIndexSyncThreads);
+    }
+    if (gArgs.GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX)) {
+        g_blockfilterindex = MakeUnique<BlockFilterIndex>(BlockFilterType::BASIC, nFilterIndexCache, false, fReindex);
+        g_blockfilterindex->Start();
+    }
+    if (gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        g_addressindex = MakeUnique<AddressIndex>(nAddressIndexCache, false, fReindex);
+        g_addressindex->Start(nIndexSyncThreads);
+    }
+    if (gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
+        g_spentindex = MakeUnique<SpentIndex>(nSpentIndexCache, false, fReindex);
+        g_spentindex->Start(nIndexSyncThreads);
+    }
+    if (gArgs.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
+        g_coinstatsindex = MakeUnique<CoinStatsIndex>(nCoinStatsIndexCache, false, fReindex);
+        g_coinstatsindex->Start();
+    }
+    if (gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)) {
+        g_blockstatsindex = MakeUnique<BlockStatsIndex>(nBlockStatsIndexCache, false, fReindex);
+        g_blockstatsindex->Start(nIndexSyncThreads);
     }
 
     // ********************************************************* Step 9: load wallet
@@ -1951,6 +2120,9 @@ bool AppInitMain()
 
         scheduler.scheduleEvery(boost::bind(&CMasternodePayments::DoMaintenance, boost::ref(mnpayments)), 60);
         scheduler.scheduleEvery(boost::bind(&CGovernanceManager::DoMaintenance, boost::ref(governance), boost::ref(*g_connman)), 60 * 5);
+
+        governance.StartVoteVerification(std::max(1, std::min(GetNumCores() - 1, MAX_GOVERNANCE_VOTE_VERIFY_THREADS)));
+        scheduler.scheduleEvery(boost::bind(&CGovernanceManager::ProcessPendingVotes, boost::ref(governance), boost::ref(*g_connman)), 100);
     }
 
     // ********************************************************* Step 12: start node
@@ -1988,6 +2160,11 @@ bool AppInitMain()
     connOptions.nReceiveFloodSize = 1000*gArgs.GetArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
     connOptions.m_added_nodes = gArgs.GetArgs("-addnode");
 
+    std::string strSocketEventsMode = gArgs.GetArg("-socketevents", DEFAULT_SOCKETEVENTS);
+    if (!ParseSocketEventsMode(strSocketEventsMode, connOptions.socketEventsMode)) {
+        return InitError(strprintf(_("Invalid -socketevents ('%s') specified. Only these modes are supported: %s"), strSocketEventsMode, GetSupportedSocketEventsModes()));
+    }
+
     connOptions.nMaxOutboundTimeframe = nMaxOutboundTimeframe;
     connOptions.nMaxOutboundLimit = nMaxOutboundLimit;
 
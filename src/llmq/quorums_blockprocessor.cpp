@@ -8,6 +8,7 @@
 
 #include "evo/specialtx.h"
 
+#include "bls/bls_worker.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "consensus/validation.h"
@@ -23,8 +24,14 @@ CQuorumBlockProcessor* quorumBlockProcessor;
 
 static const std::string DB_MINED_COMMITMENT = "q_mc";
 
+// Blocks are connected shortly after they are received, so only few pre-verifications are pending at a time. More
+// are only left behind by blocks which were never connected, the finished ones are dropped to make room
+static const size_t MAX_BLOCK_COMMITMENT_SIGS = 32;
+
 void CQuorumBlockProcessor::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
 {
+    PunishInvalidCommitmentPeers();
+
     if (strCommand == NetMsgType::QFCOMMITMENT) {
         CFinalCommitment qc;
         vRecv >> qc;
@@ -90,7 +97,8 @@ void CQuorumBlockProcessor::ProcessMessage(CNode* pfrom, const std::string& strC
 
         auto members = CLLMQUtils::GetAllQuorumMembers(type, qc.quorumHash);
 
-        if (!qc.Verify(members, true)) {
+        // Signatures are verified asynchronously below
+        if (!qc.Verify(members, false)) {
             LOCK(cs_main);
             LogPrintf("CQuorumBlockProcessor::%s -- commitment for quorum %s:%d is not valid, peer=%d\n", __func__,
                       qc.quorumHash.ToString(), qc.llmqType, pfrom->GetId());
@@ -98,13 +106,182 @@ void CQuorumBlockProcessor::ProcessMessage(CNode* pfrom, const std::string& strC
             return;
         }
 
-        LogPrintf("CQuorumBlockProcessor::%s -- received commitment for quorum %s:%d, validMembers=%d, signers=%d, peer=%d\n", __func__,
-                  qc.quorumHash.ToString(), qc.llmqType, qc.CountValidMembers(), qc.CountSigners(), pfrom->GetId());
+        auto pending = AddPendingCommitment(qc, pfrom->GetId());
+        if (!pending) {
+            // an at least as good commitment is already being verified
+            return;
+        }
+        VerifyPendingCommitment(pending, members);
+    }
+}
+
+// Returns nullptr if an at least as good commitment for the same quorum is pending, cancels a worse one
+std::shared_ptr<CQuorumBlockProcessor::PendingCommitment> CQuorumBlockProcessor::AddPendingCommitment(const CFinalCommitment& qc, NodeId nodeId)
+{
+    auto pending = std::make_shared<PendingCommitment>();
+    pending->qc = qc;
+    pending->nodeId = nodeId;
+
+    LOCK(pendingCommitmentsCs);
+    auto& pendingRef = pendingCommitments[std::make_pair((Consensus::LLMQType)qc.llmqType, qc.quorumHash)];
+    if (pendingRef) {
+        if (pendingRef->qc.CountSigners() >= qc.CountSigners()) {
+            return nullptr;
+        }
+        pendingRef->cancelled = true;
+    }
+    pendingRef = pending;
+    return pending;
+}
+
+void CQuorumBlockProcessor::VerifyPendingCommitment(const std::shared_ptr<PendingCommitment>& pending, const std::vector<CDeterministicMNCPtr>& members)
+{
+    pending->qc.AsyncVerifySigs(blsWorker, members, [this, pending](bool valid) {
+        CommitmentVerified(pending, valid);
+    }, [pending]() {
+        return pending->cancelled.load();
+    });
+}
+
+// Called by the BLS worker, must not lock cs_main
+void CQuorumBlockProcessor::CommitmentVerified(const std::shared_ptr<PendingCommitment>& pending, bool valid)
+{
+    const auto& qc = pending->qc;
+    {
+        LOCK(pendingCommitmentsCs);
+        auto it = pendingCommitments.find(std::make_pair((Consensus::LLMQType)qc.llmqType, qc.quorumHash));
+        if (it != pendingCommitments.end() && it->second == pending) {
+            pendingCommitments.erase(it);
+        }
+        if (!valid) {
+            pendingPunishments.emplace_back(pending->nodeId);
+        }
+    }
+
+    if (!valid) {
+        LogPrintf("CQuorumBlockProcessor::%s -- commitment for quorum %s:%d is not valid, peer=%d\n", __func__,
+                  qc.quorumHash.ToString(), qc.llmqType, pending->nodeId);
+        return;
+    }
+
+    LogPrintf("CQuorumBlockProcessor::%s -- received commitment for quorum %s:%d, validMembers=%d, signers=%d, peer=%d\n", __func__,
+              qc.quorumHash.ToString(), qc.llmqType, qc.CountValidMembers(), qc.CountSigners(), pending->nodeId);
+
+    AddMinableCommitment(qc);
+}
+
+void CQuorumBlockProcessor::PunishInvalidCommitmentPeers()
+{
+    std::vector<NodeId> nodeIds;
+    {
+        LOCK(pendingCommitmentsCs);
+        if (pendingPunishments.empty()) {
+            return;
+        }
+        nodeIds.swap(pendingPunishments);
+    }
 
-        AddMinableCommitment(qc);
+    LOCK(cs_main);
+    for (NodeId nodeId : nodeIds) {
+        Misbehaving(nodeId, 100);
     }
 }
 
+void CQuorumBlockProcessor::PreVerifyBlockCommitments(const CBlock& block)
+{
+    AssertLockNotHeld(cs_main);
+
+    std::map<Consensus::LLMQType, CFinalCommitment> qcs;
+    std::map<Consensus::LLMQType, uint256> quorumHashes;
+    {
+        LOCK(cs_main);
+        auto it = mapBlockIndex.find(block.hashPrevBlock);
+        if (it == mapBlockIndex.end()) {
+            return;
+        }
+        const CBlockIndex* pindexPrev = it->second;
+
+        // invalid commitments are rejected by ProcessBlock, they are not verified here
+        CValidationState dummy;
+        if (!GetCommitmentsFromBlock(block, pindexPrev, qcs, dummy)) {
+            return;
+        }
+        int nHeight = pindexPrev->nHeight + 1;
+        for (const auto& p : qcs) {
+            auto jt = Params().GetConsensus().llmqs.find(p.first);
+            if (jt == Params().GetConsensus().llmqs.end()) {
+                continue;
+            }
+            const CBlockIndex* pquorumIndex = pindexPrev->GetAncestor(nHeight - (nHeight % jt->second.dkgInterval));
+            if (pquorumIndex) {
+                quorumHashes.emplace(p.first, pquorumIndex->GetBlockHash());
+            }
+        }
+    }
+
+    for (const auto& p : qcs) {
+        const auto& qc = p.second;
+        auto it = quorumHashes.find(p.first);
+        if (qc.IsNull() || it == quorumHashes.end() || it->second != qc.quorumHash) {
+            continue;
+        }
+
+        auto members = CLLMQUtils::GetAllQuorumMembers(p.first, qc.quorumHash);
+        if (!qc.Verify(members, false)) {
+            continue;
+        }
+        PreVerifyCommitmentSigs(block.GetHash(), qc, members);
+    }
+}
+
+void CQuorumBlockProcessor::PreVerifyCommitmentSigs(const uint256& blockHash, const CFinalCommitment& qc, const std::vector<CDeterministicMNCPtr>& members)
+{
+    // the commitment hash covers the quorum, and so the members the signatures are verified against
+    uint256 commitmentHash = ::SerializeHash(qc);
+
+    LOCK(blockCommitmentSigsCs);
+    if (blockCommitmentSigs.count(blockHash) && blockCommitmentSigs.at(blockHash).count(commitmentHash)) {
+        return;
+    }
+
+    size_t nCount = 0;
+    for (const auto& p : blockCommitmentSigs) {
+        nCount += p.second.size();
+    }
+    if (nCount >= MAX_BLOCK_COMMITMENT_SIGS) {
+        // the block of a running verification may be connected any moment, only finished ones are dropped
+        for (auto it = blockCommitmentSigs.begin(); it != blockCommitmentSigs.end(); ) {
+            auto& sigs = it->second;
+            for (auto jt = sigs.begin(); jt != sigs.end(); ) {
+                if (jt->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    jt = sigs.erase(jt);
+                    nCount--;
+                } else {
+                    ++jt;
+                }
+            }
+            it = sigs.empty() ? blockCommitmentSigs.erase(it) : std::next(it);
+        }
+        if (nCount >= MAX_BLOCK_COMMITMENT_SIGS) {
+            // ProcessBlock verifies the signatures itself
+            return;
+        }
+    }
+    blockCommitmentSigs[blockHash].emplace(commitmentHash, StartVerifyCommitmentSigs(qc, members));
+}
+
+std::map<uint256, std::shared_future<bool> > CQuorumBlockProcessor::TakeBlockCommitmentSigs(const uint256& blockHash)
+{
+    std::map<uint256, std::shared_future<bool> > ret;
+    LOCK(blockCommitmentSigsCs);
+    auto it = blockCommitmentSigs.find(blockHash);
+    if (it != blockCommitmentSigs.end()) {
+        ret.swap(it->second);
+        blockCommitmentSigs.erase(it);
+    }
+    return ret;
+}
+
 bool CQuorumBlockProcessor::ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state)
 {
     AssertLockHeld(cs_main);
@@ -141,6 +318,10 @@ bool CQuorumBlockProcessor::ProcessBlock(const CBlock& block, const CBlockIndex*
         }
     }
 
+    if (!VerifyCommitmentSigs(pindex, qcs, state)) {
+        return false;
+    }
+
     for (auto& p : qcs) {
         auto& qc = p.second;
         if (!ProcessCommitment(pindex, qc, state)) {
@@ -150,6 +331,64 @@ bool CQuorumBlockProcessor::ProcessBlock(const CBlock& block, const CBlockIndex*
     return true;
 }
 
+// The callback only sets the result and must not reference this, as pre-verifications of blocks which are never
+// connected are still running when the block processor is destroyed
+std::shared_future<bool> CQuorumBlockProcessor::StartVerifyCommitmentSigs(const CFinalCommitment& qc, const std::vector<CDeterministicMNCPtr>& members)
+{
+    auto promise = std::make_shared<std::promise<bool> >();
+    std::shared_future<bool> future = promise->get_future().share();
+    qc.AsyncVerifySigs(blsWorker, members, [promise](bool valid) {
+        promise->set_value(valid);
+    }, []() {
+        return false;
+    });
+    return future;
+}
+
+// Verifies the signatures of all non-null commitments of a block at once on the BLS worker, so that the quorum
+// signatures are batch verified and the member signatures are verified in parallel. Verifications started by
+// PreVerifyBlockCommitments when the block was received are usually done by now
+bool CQuorumBlockProcessor::VerifyCommitmentSigs(const CBlockIndex* pindex, const std::map<Consensus::LLMQType, CFinalCommitment>& qcs, CValidationState& state)
+{
+    auto preVerified = TakeBlockCommitmentSigs(pindex->GetBlockHash());
+
+    std::vector<std::shared_future<bool> > futures;
+    for (const auto& p : qcs) {
+        const auto& qc = p.second;
+        if (qc.IsNull()) {
+            continue;
+        }
+        // don't spend verification work on commitments which ProcessCommitment rejects anyway
+        if (qc.quorumHash != GetQuorumBlockHash(p.first, pindex->nHeight)) {
+            return state.DoS(100, false, REJECT_INVALID, "bad-qc-block");
+        }
+
+        auto members = CLLMQUtils::GetAllQuorumMembers(p.first, qc.quorumHash);
+        if (!qc.Verify(members, false)) {
+            return state.DoS(100, false, REJECT_INVALID, "bad-qc-invalid");
+        }
+
+        std::shared_future<bool> future;
+        auto it = preVerified.find(::SerializeHash(qc));
+        if (it != preVerified.end()) {
+            future = it->second;
+        }
+        if (!future.valid()) {
+            future = StartVerifyCommitmentSigs(qc, members);
+        }
+        futures.emplace_back(std::move(future));
+    }
+
+    bool valid = true;
+    for (auto& f : futures) {
+        valid &= f.get();
+    }
+    if (!valid) {
+        return state.DoS(100, false, REJECT_INVALID, "bad-qc-invalid");
+    }
+    return true;
+}
+
 bool CQuorumBlockProcessor::ProcessCommitment(const CBlockIndex* pindex, const CFinalCommitment& qc, CValidationState& state)
 {
     auto& params = Params().GetConsensus().llmqs.at((Consensus::LLMQType)qc.llmqType);
@@ -181,7 +420,8 @@ bool CQuorumBlockProcessor::ProcessCommitment(const CBlockIndex* pindex, const C
 
     auto members = CLLMQUtils::GetAllQuorumMembers(params.type, quorumHash);
 
-    if (!qc.Verify(members, true)) {
+    // signatures were verified by VerifyCommitmentSigs
+    if (!qc.Verify(members, false)) {
         return state.DoS(100, false, REJECT_INVALID, "bad-qc-invalid");
     }
 
@@ -305,6 +545,11 @@ bool CQuorumBlockProcessor::GetMinedCommitment(Consensus::LLMQType llmqType, con
     return evoDb.Read(key, ret);
 }
 
+void CQuorumBlockProcessor::WriteMinedCommitmentToBatch(CDBBatch& batch, const CFinalCommitment& qc)
+{
+    batch.Write(std::make_pair(DB_MINED_COMMITMENT, std::make_pair(qc.llmqType, qc.quorumHash)), qc);
+}
+
 bool CQuorumBlockProcessor::HasMinableCommitment(const uint256& hash)
 {
     LOCK(minableCommitmentsCs);
@@ -338,6 +583,7 @@ void CQuorumBlockProcessor::AddMinableCommitment(const CFinalCommitment& fqc)
 
     // We only relay the new commitment if it's new or better then the old one
     if (relay) {
+        nMinableCommitmentsUpdated++;
         CInv inv(MSG_QUORUM_FINAL_COMMITMENT, commitmentHash);
         g_connman->RelayInv(inv, DMN_PROTO_VERSION);
     }
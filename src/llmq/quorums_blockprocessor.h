@@ -8,13 +8,18 @@
 #include "llmq/quorums_commitment.h"
 
 #include "consensus/params.h"
+#include "net.h"
 #include "primitives/transaction.h"
 #include "sync.h"
 
+#include <atomic>
+#include <future>
 #include <map>
+#include <memory>
 
 class CNode;
 class CConnman;
+class CBLSWorker;
 
 namespace llmq
 {
@@ -23,17 +28,43 @@ class CQuorumBlockProcessor
 {
 private:
     CEvoDB& evoDb;
+    CBLSWorker& blsWorker;
 
     // TODO cleanup
     CCriticalSection minableCommitmentsCs;
     std::map<std::pair<Consensus::LLMQType, uint256>, uint256> minableCommitmentsByQuorum;
     std::map<uint256, CFinalCommitment> minableCommitments;
+    // Incremented whenever a minable commitment is added or replaced, so that cached block templates can tell
+    // that they are stale
+    std::atomic<unsigned int> nMinableCommitmentsUpdated{0};
+
+    // Commitments received from the network while their signatures are verified by the BLS worker. Only one commitment
+    // is verified per quorum, a commitment with more signers cancels the verification of the pending one
+    struct PendingCommitment {
+        CFinalCommitment qc;
+        NodeId nodeId;
+        std::atomic<bool> cancelled{false};
+    };
+    CCriticalSection pendingCommitmentsCs;
+    std::map<std::pair<Consensus::LLMQType, uint256>, std::shared_ptr<PendingCommitment> > pendingCommitments;
+    // Peers which sent invalid commitments. The BLS worker must not take cs_main (ProcessBlock waits for it while
+    // holding cs_main), so they are punished by the next call to ProcessMessage
+    std::vector<NodeId> pendingPunishments;
+
+    // Signature verifications of the commitments of blocks which were received but not connected yet, by block hash
+    // and commitment hash. ProcessBlock takes the results of its block from here instead of starting the verification
+    // while holding cs_main. Verifications of other blocks may still be running at that time, they are left alone
+    CCriticalSection blockCommitmentSigsCs;
+    std::map<uint256, std::map<uint256, std::shared_future<bool> > > blockCommitmentSigs;
 
 public:
-    CQuorumBlockProcessor(CEvoDB& _evoDb) : evoDb(_evoDb) {}
+    CQuorumBlockProcessor(CEvoDB& _evoDb, CBLSWorker& _blsWorker) : evoDb(_evoDb), blsWorker(_blsWorker) {}
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
 
+    // Starts verifying the signatures of the commitments of a block before it is connected. Must be called without
+    // cs_main, ProcessBlock waits for the result when connecting the block
+    void PreVerifyBlockCommitments(const CBlock& block);
     bool ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state);
     bool UndoBlock(const CBlock& block, const CBlockIndex* pindex);
 
@@ -42,16 +73,29 @@ public:
     bool GetMinableCommitmentByHash(const uint256& commitmentHash, CFinalCommitment& ret);
     bool GetMinableCommitment(Consensus::LLMQType llmqType, int nHeight, CFinalCommitment& ret);
     bool GetMinableCommitmentTx(Consensus::LLMQType llmqType, int nHeight, CTransactionRef& ret);
+    unsigned int GetMinableCommitmentsUpdated() const { return nMinableCommitmentsUpdated; }
 
     bool HasMinedCommitment(Consensus::LLMQType llmqType, const uint256& quorumHash);
     bool GetMinedCommitment(Consensus::LLMQType llmqType, const uint256& quorumHash, CFinalCommitment& ret);
+    // Writes a mined commitment carried by a UTXO snapshot to the database while the snapshot is loaded
+    void WriteMinedCommitmentToBatch(CDBBatch& batch, const CFinalCommitment& qc);
 
 private:
     bool GetCommitmentsFromBlock(const CBlock& block, const CBlockIndex* pindexPrev, std::map<Consensus::LLMQType, CFinalCommitment>& ret, CValidationState& state);
+    std::shared_ptr<PendingCommitment> AddPendingCommitment(const CFinalCommitment& qc, NodeId nodeId);
+    void VerifyPendingCommitment(const std::shared_ptr<PendingCommitment>& pending, const std::vector<CDeterministicMNCPtr>& members);
+    void CommitmentVerified(const std::shared_ptr<PendingCommitment>& pending, bool valid);
+    void PunishInvalidCommitmentPeers();
+    void PreVerifyCommitmentSigs(const uint256& blockHash, const CFinalCommitment& qc, const std::vector<CDeterministicMNCPtr>& members);
+    std::map<uint256, std::shared_future<bool> > TakeBlockCommitmentSigs(const uint256& blockHash);
+    std::shared_future<bool> StartVerifyCommitmentSigs(const CFinalCommitment& qc, const std::vector<CDeterministicMNCPtr>& members);
+    bool VerifyCommitmentSigs(const CBlockIndex* pindex, const std::map<Consensus::LLMQType, CFinalCommitment>& qcs, CValidationState& state);
     bool ProcessCommitment(const CBlockIndex* pindex, const CFinalCommitment& qc, CValidationState& state);
     bool IsMiningPhase(Consensus::LLMQType llmqType, int nHeight);
     bool IsCommitmentRequired(Consensus::LLMQType llmqType, int nHeight);
     uint256 GetQuorumBlockHash(Consensus::LLMQType llmqType, int nHeight);
+
+    friend struct CQuorumBlockProcessorTest;
 };
 
 extern CQuorumBlockProcessor* quorumBlockProcessor;
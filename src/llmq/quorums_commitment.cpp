@@ -5,6 +5,7 @@
 #include <llmq/quorums_commitment.h>
 #include <llmq/quorums_utils.h>
 
+#include <bls/bls_worker.h>
 #include <chainparams.h>
 #include <validation.h>
 
@@ -81,15 +82,8 @@ bool CFinalCommitment::Verify(const std::vector<CDeterministicMNCPtr>& members,
 
     // sigs are only checked when the block is processed
     if (checkSigs) {
-        uint256 commitmentHash = CLLMQUtils::BuildCommitmentHash((uint8_t)params.type, quorumHash, validMembers, quorumPublicKey, quorumVvecHash);
-
-        std::vector<CBLSPublicKey> memberPubKeys;
-        for (size_t i = 0; i < members.size(); i++) {
-            if (!signers[i]) {
-                continue;
-            }
-            memberPubKeys.emplace_back(members[i]->pdmnState->pubKeyOperator);
-        }
+        uint256 commitmentHash = BuildCommitmentHash();
+        std::vector<CBLSPublicKey> memberPubKeys = GetSignerPubKeys(members);
 
         if (!membersSig.VerifySecureAggregated(memberPubKeys, commitmentHash)) {
             LogPrintfFinalCommitment("invalid aggregated members signature\n");
@@ -105,6 +99,52 @@ bool CFinalCommitment::Verify(const std::vector<CDeterministicMNCPtr>& members,
     return true;
 }
 
+void CFinalCommitment::AsyncVerifySigs(CBLSWorker& blsWorker, const std::vector<CDeterministicMNCPtr>& members,
+                                       std::function<void(bool)> doneCallback, std::function<bool()> cancelCond) const
+{
+    struct State {
+        std::atomic<int> pending{2};
+        std::atomic<bool> valid{true};
+        std::function<void(bool)> doneCallback;
+    };
+    auto state = std::make_shared<State>();
+    state->doneCallback = std::move(doneCallback);
+
+    // whichever verification finishes last reports the combined result
+    auto makeCallback = [state](const char* strSig) {
+        return [state, strSig](bool valid) {
+            if (!valid) {
+                LogPrintf("CFinalCommitment::AsyncVerifySigs -- invalid %s\n", strSig);
+                state->valid = false;
+            }
+            if (--state->pending == 0) {
+                state->doneCallback(state->valid);
+            }
+        };
+    };
+
+    uint256 commitmentHash = BuildCommitmentHash();
+    blsWorker.AsyncVerifySecureAggregatedSig(membersSig, GetSignerPubKeys(members), commitmentHash, makeCallback("aggregated members signature"), cancelCond);
+    blsWorker.AsyncVerifySig(quorumSig, quorumPublicKey, commitmentHash, makeCallback("quorum signature"), cancelCond);
+}
+
+uint256 CFinalCommitment::BuildCommitmentHash() const
+{
+    return CLLMQUtils::BuildCommitmentHash(llmqType, quorumHash, validMembers, quorumPublicKey, quorumVvecHash);
+}
+
+std::vector<CBLSPublicKey> CFinalCommitment::GetSignerPubKeys(const std::vector<CDeterministicMNCPtr>& members) const
+{
+    std::vector<CBLSPublicKey> memberPubKeys;
+    for (size_t i = 0; i < members.size(); i++) {
+        if (!signers[i]) {
+            continue;
+        }
+        memberPubKeys.emplace_back(members[i]->pdmnState->pubKeyOperator);
+    }
+    return memberPubKeys;
+}
+
 bool CFinalCommitment::VerifyNull() const
 {
     if (!Params().GetConsensus().llmqs.count((Consensus::LLMQType)llmqType)) {
@@ -11,6 +11,10 @@
 
 #include "bls/bls.h"
 
+#include <functional>
+
+class CBLSWorker;
+
 namespace llmq
 {
 
@@ -49,6 +53,11 @@ public:
     }
 
     bool Verify(const std::vector<CDeterministicMNCPtr>& members, bool checkSigs) const;
+    // Verifies membersSig and quorumSig on the BLS worker, in parallel to each other. quorumSig is batched with other
+    // signatures verified at the same time. doneCallback is called once with the result, unless cancelCond returned
+    // true before verification finished. Verify(members, false) must have succeeded before
+    void AsyncVerifySigs(CBLSWorker& blsWorker, const std::vector<CDeterministicMNCPtr>& members,
+                         std::function<void(bool)> doneCallback, std::function<bool()> cancelCond) const;
     bool VerifyNull() const;
     bool VerifySizes(const Consensus::LLMQParams& params) const;
 
@@ -86,6 +95,10 @@ public:
         }
         return true;
     }
+
+private:
+    uint256 BuildCommitmentHash() const;
+    std::vector<CBLSPublicKey> GetSignerPubKeys(const std::vector<CDeterministicMNCPtr>& members) const;
 };
 
 class CFinalCommitmentTxPayload
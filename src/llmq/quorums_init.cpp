@@ -11,9 +11,9 @@
 namespace llmq
 {
 
-void InitLLMQSystem(CEvoDB& evoDb)
+void InitLLMQSystem(CEvoDB& evoDb, CBLSWorker& blsWorker)
 {
-    quorumBlockProcessor = new CQuorumBlockProcessor(evoDb);
+    quorumBlockProcessor = new CQuorumBlockProcessor(evoDb, blsWorker);
     quorumDummyDKG = new CDummyDKG();
 }
 
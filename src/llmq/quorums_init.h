@@ -5,12 +5,15 @@
 #ifndef DASH_QUORUMS_INIT_H
 #define DASH_QUORUMS_INIT_H
 
+class CBLSWorker;
 class CEvoDB;
 
 namespace llmq
 {
 
-void InitLLMQSystem(CEvoDB& evoDb);
+// The BLS worker verifies commitment signatures. It is owned by the caller and must be stopped before
+// DestroyLLMQSystem, as running verifications reference the quorum block processor
+void InitLLMQSystem(CEvoDB& evoDb, CBLSWorker& blsWorker);
 void DestroyLLMQSystem();
 
 }
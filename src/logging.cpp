@@ -6,8 +6,109 @@
 #include <logging.h>
 #include <utiltime.h>
 
+#include <chrono>
+#include <csignal>
+#include <exception>
+#include <thread>
+
 const char * const DEFAULT_DEBUGLOGFILE = "debug.log";
 
+/** Number of lines the async log queue can hold, must be a power of two */
+static const size_t ASYNC_LOG_QUEUE_SLOTS = 1 << 16;
+/** Up to this many bytes of queued lines are combined into a single write */
+static const size_t ASYNC_LOG_BATCH_SIZE = 1 << 16;
+
+namespace MCLog {
+
+/**
+ * Bounded multi-producer single-consumer queue of log lines. Producers claim a
+ * slot with a CAS on the enqueue position and publish it through the slot's
+ * sequence number, so logging threads never wait for the writer. Pop must not
+ * be called by more than one thread at a time.
+ */
+class AsyncLogQueue
+{
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        std::string msg;
+    };
+
+    const uint64_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<uint64_t> m_enqueue_pos{0};
+    std::atomic<uint64_t> m_dequeue_pos{0};
+    std::atomic<size_t> m_bytes{0};
+
+public:
+    std::atomic<size_t> m_max_bytes{0};
+
+    explicit AsyncLogQueue(size_t slots) : m_mask(slots - 1), m_slots(new Slot[slots])
+    {
+        assert(slots > 0 && (slots & m_mask) == 0);
+        for (size_t i = 0; i < slots; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /** Returns false without taking msg if the queue is full */
+    bool Push(std::string&& msg)
+    {
+        // account for the memory before claiming a slot so that concurrent producers can't exceed the cap
+        const size_t size = msg.size();
+        if (m_bytes.fetch_add(size, std::memory_order_relaxed) + size > m_max_bytes.load(std::memory_order_relaxed)) {
+            m_bytes.fetch_sub(size, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint64_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &m_slots[pos & m_mask];
+            int64_t diff = (int64_t)slot->sequence.load(std::memory_order_acquire) - (int64_t)pos;
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // the writer didn't get to this slot yet
+                m_bytes.fetch_sub(size, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->msg = std::move(msg);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(std::string& msg)
+    {
+        const uint64_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[pos & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        msg = std::move(slot.msg);
+        slot.msg.clear();
+        slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+        m_dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+        m_bytes.fetch_sub(msg.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    bool Empty() const
+    {
+        const uint64_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        return m_slots[pos & m_mask].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+};
+
+} // namespace MCLog
+
 /**
  * NOTE: the logger instances is leaked on exit. This is ugly, but will be
  * cleaned up by the OS/libc. Defining a logger as a global object doesn't work
@@ -30,6 +131,16 @@ static int FileWriteStr(const std::string &str, FILE *fp)
     return fwrite(str.data(), 1, str.size(), fp);
 }
 
+MCLog::Logger::Logger() {}
+
+MCLog::Logger::~Logger()
+{
+    StopAsync();
+    if (m_fileout) {
+        fclose(m_fileout);
+    }
+}
+
 bool MCLog::Logger::OpenDebugLog()
 {
     std::lock_guard<std::mutex> scoped_lock(m_file_mutex);
@@ -200,6 +311,24 @@ std::string MCLog::Logger::LogTimestampStr(const std::string &str)
     return strStamped;
 }
 
+bool MCLog::Logger::PrepareFileOutput()
+{
+    if (m_fileout == nullptr) {
+        return false;
+    }
+
+    // reopen the log file, if requested
+    if (m_reopen_file) {
+        m_reopen_file = false;
+        m_fileout = fsbridge::freopen(m_file_path, "a", m_fileout);
+        if (!m_fileout) {
+            return false;
+        }
+        setbuf(m_fileout, nullptr); // unbuffered
+    }
+    return true;
+}
+
 void MCLog::Logger::LogPrintStr(const std::string &str)
 {
     std::string strTimestamped = LogTimestampStr(str);
@@ -210,6 +339,15 @@ void MCLog::Logger::LogPrintStr(const std::string &str)
         fflush(stdout);
     }
     if (m_print_to_file) {
+        if (m_async.load(std::memory_order_acquire)) {
+            if (!m_async_queue->Push(std::move(strTimestamped))) {
+                m_async_dropped++;
+            } else if (m_async_writer_idle.load(std::memory_order_relaxed) && m_async_writer_idle.exchange(false)) {
+                m_async_cond.notify_one();
+            }
+            return;
+        }
+
         std::lock_guard<std::mutex> scoped_lock(m_file_mutex);
 
         // buffer if we haven't opened the log yet
@@ -218,18 +356,171 @@ void MCLog::Logger::LogPrintStr(const std::string &str)
         }
         else
         {
-            // reopen the log file, if requested
-            if (m_reopen_file) {
-                m_reopen_file = false;
-                m_fileout = fsbridge::freopen(m_file_path, "a", m_fileout);
-                if (!m_fileout) {
-                    return;
-                }
-                setbuf(m_fileout, nullptr); // unbuffered
+            // lines might have been queued while async mode was being stopped, keep them in order
+            DrainAsyncQueue();
+
+            if (PrepareFileOutput()) {
+                FileWriteStr(strTimestamped, m_fileout);
+            }
+        }
+    }
+}
+
+bool MCLog::Logger::DrainAsyncQueue()
+{
+    if (!m_async_queue) {
+        return false;
+    }
+
+    const bool fOutput = PrepareFileOutput();
+    bool fAny = false;
+
+    const uint64_t nDropped = m_async_dropped.load();
+    if (nDropped != m_async_dropped_logged) {
+        m_async_batch += strprintf("%d log messages dropped because the async log buffer was full\n", nDropped - m_async_dropped_logged);
+        m_async_dropped_logged = nDropped;
+        fAny = true;
+    }
+
+    std::string msg;
+    while (m_async_queue->Pop(msg)) {
+        fAny = true;
+        if (m_async_batch.size() + msg.size() > ASYNC_LOG_BATCH_SIZE) {
+            if (fOutput) {
+                FileWriteStr(m_async_batch, m_fileout);
+            }
+            m_async_batch.clear();
+        }
+        if (msg.size() > ASYNC_LOG_BATCH_SIZE) {
+            if (fOutput) {
+                FileWriteStr(msg, m_fileout);
             }
+        } else {
+            m_async_batch += msg;
+        }
+    }
+    if (!m_async_batch.empty()) {
+        if (fOutput) {
+            FileWriteStr(m_async_batch, m_fileout);
+        }
+        m_async_batch.clear();
+    }
+    return fAny;
+}
+
+void MCLog::Logger::AsyncWriterThread()
+{
+    while (true) {
+        {
+            std::lock_guard<std::mutex> scoped_lock(m_file_mutex);
+            DrainAsyncQueue();
+        }
+
+        std::unique_lock<std::mutex> lock(m_async_mutex);
+        if (m_async_stop) {
+            break;
+        }
+        m_async_writer_idle = true;
+        if (m_async_queue->Empty()) {
+            // producers only notify when they see the writer idle, the timeout covers a wakeup missed in between
+            m_async_cond.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        m_async_writer_idle = false;
+    }
+}
+
+/** std::terminate handler in place before the async writer was started */
+static std::terminate_handler g_prev_terminate_handler = nullptr;
+
+static void AsyncLogTerminateHandler()
+{
+    g_logger->FlushOnCrash();
+    if (g_prev_terminate_handler) {
+        g_prev_terminate_handler();
+    }
+    std::abort();
+}
+
+static void AsyncLogFatalSignalHandler(int signal)
+{
+    g_logger->FlushOnCrash();
+    // continue with the default action, which terminates the process
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
 
-            FileWriteStr(strTimestamped, m_fileout);
+/** Flush queued lines before the process dies of an uncaught exception, a failed assert, abort or a fatal signal */
+static void InstallAsyncLogCrashHandlers()
+{
+    g_prev_terminate_handler = std::set_terminate(AsyncLogTerminateHandler);
+    for (int signal : {SIGABRT, SIGSEGV, SIGFPE, SIGILL}) {
+        std::signal(signal, AsyncLogFatalSignalHandler);
+    }
+#ifdef SIGBUS
+    std::signal(SIGBUS, AsyncLogFatalSignalHandler);
+#endif
+}
+
+void MCLog::Logger::StartAsync(size_t max_buffered_bytes)
+{
+    if (m_async) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> scoped_lock(m_file_mutex);
+        // the queue is never freed, a thread which saw async mode enabled might still push to it after StopAsync
+        if (!m_async_queue) {
+            m_async_queue.reset(new AsyncLogQueue(ASYNC_LOG_QUEUE_SLOTS));
+        }
+        m_async_queue->m_max_bytes = max_buffered_bytes;
+        m_async_batch.reserve(ASYNC_LOG_BATCH_SIZE);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        m_async_stop = false;
+    }
+    static std::once_flag crash_handlers_installed;
+    std::call_once(crash_handlers_installed, InstallAsyncLogCrashHandlers);
+
+    m_async_thread = std::thread(&MCLog::Logger::AsyncWriterThread, this);
+    m_async = true;
+}
+
+void MCLog::Logger::StopAsync()
+{
+    if (!m_async.exchange(false)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        m_async_stop = true;
+    }
+    m_async_cond.notify_one();
+    m_async_thread.join();
+    Flush();
+}
+
+void MCLog::Logger::Flush()
+{
+    std::lock_guard<std::mutex> scoped_lock(m_file_mutex);
+    DrainAsyncQueue();
+}
+
+void MCLog::Logger::FlushOnCrash()
+{
+    // The crashing thread might hold m_file_mutex itself, so only wait a bounded time for it
+    for (int i = 0; i < 100; ++i) {
+        std::unique_lock<std::mutex> scoped_lock(m_file_mutex, std::try_to_lock);
+        if (scoped_lock.owns_lock()) {
+            DrainAsyncQueue();
+            if (m_fileout) {
+                fflush(m_fileout);
+            }
+            return;
         }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 }
 
@@ -10,15 +10,21 @@
 #include <tinyformat.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
+static const bool DEFAULT_LOGASYNC      = false;
+/** Default for -logasyncbuffer, the maximum number of bytes waiting for the async debug.log writer, in MiB */
+static const unsigned int DEFAULT_LOGASYNC_BUFFER = 16;
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogIPs;
@@ -58,6 +64,8 @@ namespace MCLog {
         ALL         = ~(uint32_t)0,
     };
 
+    class AsyncLogQueue;
+
     class Logger
     {
     private:
@@ -77,7 +85,35 @@ namespace MCLog {
 
         std::string LogTimestampStr(const std::string& str);
 
+        /**
+         * Async mode. Logging threads push their lines into a lock-free queue
+         * and return without touching the file; m_async_thread drains it and
+         * writes the lines in batches. Lines which don't fit into the queue
+         * are dropped and counted.
+         */
+        std::unique_ptr<AsyncLogQueue> m_async_queue;
+        std::atomic<bool> m_async{false};
+        std::atomic<bool> m_async_writer_idle{false};
+        std::atomic<uint64_t> m_async_dropped{0};
+        /** Dropped lines already reported in debug.log, guarded by m_file_mutex */
+        uint64_t m_async_dropped_logged = 0;
+        /** Buffer to batch writes in, guarded by m_file_mutex */
+        std::string m_async_batch;
+        std::thread m_async_thread;
+        std::mutex m_async_mutex;
+        std::condition_variable m_async_cond;
+        bool m_async_stop = false;
+
+        /** Reopen the log file if requested, returns false if it is not open. Requires m_file_mutex */
+        bool PrepareFileOutput();
+        /** Write out all queued lines, returns whether there were any. Requires m_file_mutex */
+        bool DrainAsyncQueue();
+        void AsyncWriterThread();
+
     public:
+        Logger();
+        ~Logger();
+
         bool m_print_to_console = false;
         bool m_print_to_file = false;
 
@@ -96,6 +132,26 @@ namespace MCLog {
         bool OpenDebugLog();
         void ShrinkDebugFile();
 
+        /**
+         * Write debug.log from a background thread from now on. At most
+         * max_buffered_bytes of lines are held in memory, lines beyond that
+         * are dropped. Call after OpenDebugLog.
+         */
+        void StartAsync(size_t max_buffered_bytes);
+        /** Write out all queued lines and stop the async writer thread */
+        void StopAsync();
+        /** Write out all queued lines. Can be called from any thread, e.g. before terminating */
+        void Flush();
+        /**
+         * Write out queued lines when the process is about to die. StartAsync
+         * installs std::terminate and fatal signal (SIGABRT, SIGSEGV, ...)
+         * handlers calling this. It is best effort: it is not async-signal-safe,
+         * and gives up if m_file_mutex stays locked, e.g. by the crashing thread.
+         */
+        void FlushOnCrash();
+        /** Number of lines dropped since StartAsync because the queue was full */
+        uint64_t GetAsyncDroppedCount() const { return m_async_dropped.load(); }
+
         uint32_t GetCategoryMask() const { return m_categories.load(); }
 
         void EnableCategory(LogFlags flag);
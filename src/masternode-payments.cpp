@@ -258,7 +258,8 @@ void CMasternodePayments::Clear()
 {
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
     mapMasternodeBlocks.clear();
-    mapMasternodePaymentVotes.clear();
+    mapVoteBuckets.clear();
+    mapVoteHeights.clear();
 }
 
 bool CMasternodePayments::UpdateLastVote(const CMasternodePaymentVote& vote)
@@ -385,10 +386,9 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
 
         {
             LOCK(cs_mapMasternodePaymentVotes);
-            auto res = mapMasternodePaymentVotes.emplace(nHash, vote);
 
             // Avoid processing same vote multiple times if it was already verified earlier
-            if(!res.second && res.first->second.IsVerified()) {
+            if(HasVerifiedPaymentVote(nHash)) {
                 LogPrint(MCLog::MN, "MASTERNODEPAYMENTVOTE -- hash=%s, nBlockHeight=%d/%d seen\n",
                             nHash.ToString(), vote.nBlockHeight, nCachedBlockHeight);
                 return;
@@ -396,7 +396,9 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
 
             // Mark vote as non-verified when it's seen for the first time,
             // AddOrUpdatePaymentVote() below should take care of it if vote is actually ok
-            res.first->second.MarkAsNotVerified();
+            CMasternodePaymentVote voteNotVerified(vote);
+            voteNotVerified.MarkAsNotVerified();
+            StoreVote(nHash, voteNotVerified);
         }
 
         int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
@@ -564,8 +566,6 @@ bool CMasternodePayments::GetBlockTxOuts(int nBlockHeight, CAmount blockReward,
 // -- Only look ahead up to 8 blocks to allow for propagation of the latest 2 blocks of votes
 bool CMasternodePayments::IsScheduled(const masternode_info_t& mnInfo, int nNotBlockHeight) const
 {
-    LOCK(cs_mapMasternodeBlocks);
-
     if (deterministicMNManager->AreDeterministicMNsActive()) {
         auto projectedPayees = deterministicMNManager->GetListAtChainTip().GetProjectedMNPayees(8);
         for (const auto &dmn : projectedPayees) {
@@ -581,14 +581,14 @@ bool CMasternodePayments::IsScheduled(const masternode_info_t& mnInfo, int nNotB
     CScript mnpayee;
     mnpayee = GetScriptForDestination(CScriptID(GetScriptForDestination(WitnessV0KeyHash(mnInfo.keyIDCollateralAddress))));
 
-    for(int64_t h = nCachedBlockHeight; h <= nCachedBlockHeight + 8; h++){
-        if(h == nNotBlockHeight) continue;
-        std::vector<CTxOut> voutMasternodePayments;
-        if(GetBlockTxOuts(h, 0, voutMasternodePayments)) {
-            for (const auto& txout : voutMasternodePayments) {
-                if (txout.scriptPubKey == mnpayee)
-                    return true;
-            }
+    // Walk the payment blocks of the heights looked at once, instead of looking up every height
+    LOCK(cs_mapMasternodeBlocks);
+    for (auto it = mapMasternodeBlocks.lower_bound(nCachedBlockHeight);
+         it != mapMasternodeBlocks.end() && it->first <= nCachedBlockHeight + 8; ++it) {
+        if(it->first == nNotBlockHeight) continue;
+        CScript payee;
+        if(it->second.GetBestPayee(payee) && payee == mnpayee) {
+            return true;
         }
     }
 
@@ -606,7 +606,7 @@ bool CMasternodePayments::AddOrUpdatePaymentVote(const CMasternodePaymentVote& v
 
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
 
-    mapMasternodePaymentVotes[nVoteHash] = vote;
+    StoreVote(nVoteHash, vote);
 
     auto it = mapMasternodeBlocks.emplace(vote.nBlockHeight, CMasternodeBlockPayees(vote.nBlockHeight)).first;
     it->second.AddPayee(vote);
@@ -616,11 +616,65 @@ bool CMasternodePayments::AddOrUpdatePaymentVote(const CMasternodePaymentVote& v
     return true;
 }
 
+bool CMasternodePayments::StoreVote(const uint256& nHash, const CMasternodePaymentVote& vote)
+{
+    AssertLockHeld(cs_mapMasternodePaymentVotes);
+
+    auto itHeight = mapVoteHeights.emplace(nHash, vote.nBlockHeight).first;
+    if (itHeight->second != vote.nBlockHeight) {
+        // The height is part of the hash, so this can't happen unless the vote is not the one hashed
+        mapVoteBuckets[itHeight->second].erase(nHash);
+        itHeight->second = vote.nBlockHeight;
+    }
+    auto res = mapVoteBuckets[vote.nBlockHeight].emplace(nHash, vote);
+    if (!res.second) {
+        res.first->second = vote;
+    }
+    return res.second;
+}
+
+bool CMasternodePayments::HasPaymentVote(const uint256& hashIn) const
+{
+    LOCK(cs_mapMasternodePaymentVotes);
+    return mapVoteHeights.count(hashIn);
+}
+
 bool CMasternodePayments::HasVerifiedPaymentVote(const uint256& hashIn) const
+{
+    CMasternodePaymentVote vote;
+    return GetVerifiedPaymentVote(hashIn, vote);
+}
+
+bool CMasternodePayments::GetVerifiedPaymentVote(const uint256& hashIn, CMasternodePaymentVote& voteRet) const
 {
     LOCK(cs_mapMasternodePaymentVotes);
-    const auto it = mapMasternodePaymentVotes.find(hashIn);
-    return it != mapMasternodePaymentVotes.end() && it->second.IsVerified();
+    const auto itHeight = mapVoteHeights.find(hashIn);
+    if (itHeight == mapVoteHeights.end()) return false;
+    const auto& bucket = mapVoteBuckets.at(itHeight->second);
+    const auto it = bucket.find(hashIn);
+    if (it == bucket.end() || !it->second.IsVerified()) return false;
+    voteRet = it->second;
+    return true;
+}
+
+bool CMasternodePayments::GetVerifiedPaymentVotes(int nBlockHeight, std::vector<CMasternodePaymentVote>& vecVotesRet) const
+{
+    vecVotesRet.clear();
+    LOCK(cs_mapMasternodePaymentVotes);
+    const auto itBucket = mapVoteBuckets.find(nBlockHeight);
+    if (itBucket == mapVoteBuckets.end()) return false;
+    for (const auto& pair : itBucket->second) {
+        if (pair.second.IsVerified()) {
+            vecVotesRet.push_back(pair.second);
+        }
+    }
+    return !vecVotesRet.empty();
+}
+
+bool CMasternodePayments::HasPaymentBlock(int nBlockHeight) const
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return mapMasternodeBlocks.count(nBlockHeight);
 }
 
 void CMasternodeBlockPayees::AddPayee(const CMasternodePaymentVote& vote)
@@ -790,20 +844,18 @@ void CMasternodePayments::CheckAndRemove()
 
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
 
-    int nLimit = GetStorageLimit();
-
-    std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.begin();
-    while(it != mapMasternodePaymentVotes.end()) {
-        CMasternodePaymentVote vote = (*it).second;
+    // Votes for heights more than the storage limit below the tip expire, drop their buckets
+    int nFirstBlock = nCachedBlockHeight - GetStorageLimit();
 
-        if(nCachedBlockHeight - vote.nBlockHeight > nLimit) {
-            LogPrint(MCLog::MN, "CMasternodePayments::%s -- Removing old Masternode payment: nBlockHeight=%d\n", __func__, vote.nBlockHeight);
-            mapMasternodePaymentVotes.erase(it++);
-            mapMasternodeBlocks.erase(vote.nBlockHeight);
-        } else {
-            ++it;
+    auto itBucket = mapVoteBuckets.begin();
+    while (itBucket != mapVoteBuckets.end() && itBucket->first < nFirstBlock) {
+        LogPrint(MCLog::MN, "CMasternodePayments::%s -- Removing %d old Masternode payment votes: nBlockHeight=%d\n", __func__, itBucket->second.size(), itBucket->first);
+        for (const auto& pair : itBucket->second) {
+            mapVoteHeights.erase(pair.first);
         }
+        itBucket = mapVoteBuckets.erase(itBucket);
     }
+    mapMasternodeBlocks.erase(mapMasternodeBlocks.begin(), mapMasternodeBlocks.lower_bound(nFirstBlock));
     LogPrint(MCLog::MN, "CMasternodePayments::%s -- %s\n", __func__, ToString());
 }
 
@@ -950,10 +1002,13 @@ void CMasternodePayments::CheckBlockVotes(int nBlockHeight)
 
         const auto it = mapMasternodeBlocks.find(nBlockHeight);
         if (it != mapMasternodeBlocks.end()) {
+            const auto itBucket = mapVoteBuckets.find(nBlockHeight);
+            static const vote_bucket_t emptyBucket;
+            const vote_bucket_t& bucket = itBucket == mapVoteBuckets.end() ? emptyBucket : itBucket->second;
             for (const auto& p : it->second.vecPayees) {
                 for (const auto& voteHash : p.GetVoteHashes()) {
-                    const auto itVote = mapMasternodePaymentVotes.find(voteHash);
-                    if (itVote == mapMasternodePaymentVotes.end()) {
+                    const auto itVote = bucket.find(voteHash);
+                    if (itVote == bucket.end()) {
                         debugStr += strprintf("    - could not find vote %s\n",
                                               voteHash.ToString());
                         continue;
@@ -1169,8 +1224,8 @@ std::string CMasternodePayments::ToString() const
 {
     std::ostringstream info;
 
-    info << "Votes: " << (int)mapMasternodePaymentVotes.size() <<
-            ", Blocks: " << (int)mapMasternodeBlocks.size();
+    info << "Votes: " << GetVoteCount() <<
+            ", Blocks: " << GetBlockCount();
 
     return info.str();
 }
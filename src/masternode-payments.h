@@ -11,7 +11,11 @@
 #include <key.h>
 #include <masternode.h>
 #include <net_processing.h>
+#include <txmempool.h>
 #include <utilstrencodings.h>
+#include <validation.h>
+
+#include <unordered_map>
 
 class CMasternodePayments;
 class CMasternodePaymentVote;
@@ -28,6 +32,7 @@ static const int MIN_MASTERNODE_PAYMENT_PROTO_VERSION = 70022;
 
 extern CCriticalSection cs_vecPayees;
 extern CCriticalSection cs_mapMasternodeBlocks;
+extern CCriticalSection cs_mapMasternodePaymentVotes;
 
 extern CMasternodePayments mnpayments;
 
@@ -171,26 +176,65 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    // The payment votes for one block height by hash, including votes which are not verified yet.
+    // Vote hashes are chosen by peers, so they are hashed with a salt.
+    typedef std::unordered_map<uint256, CMasternodePaymentVote, SaltedTxidHasher> vote_bucket_t;
+
+    // Payment votes bucketed by block height, so expiring a height drops a single bucket
+    std::map<int, vote_bucket_t> mapVoteBuckets;
+    // Height of the bucket of every vote, to look votes up by hash
+    std::unordered_map<uint256, int, SaltedTxidHasher> mapVoteHeights;
+
+    // Add a vote to the bucket of its height, replacing a vote with the same hash.
+    // Returns false if there was one. Requires cs_mapMasternodePaymentVotes.
+    bool StoreVote(const uint256& nHash, const CMasternodePaymentVote& vote);
+
 public:
-    std::map<uint256, CMasternodePaymentVote> mapMasternodePaymentVotes;
     std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks;
     std::map<COutPoint, int> mapMasternodesLastVote;
     std::map<COutPoint, int> mapMasternodesDidNotVote;
 
     CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(6000) {}
 
-    ADD_SERIALIZE_METHODS;
+    // The votes are serialized ordered by hash, as they were kept before being bucketed by height
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        std::map<uint256, CMasternodePaymentVote> mapVotes;
+        {
+            LOCK(cs_mapMasternodePaymentVotes);
+            for (const auto& bucket : mapVoteBuckets) {
+                mapVotes.insert(bucket.second.begin(), bucket.second.end());
+            }
+        }
+        LOCK(cs_mapMasternodeBlocks);
+        s << mapVotes;
+        s << mapMasternodeBlocks;
+    }
 
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(mapMasternodePaymentVotes);
-        READWRITE(mapMasternodeBlocks);
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        std::map<uint256, CMasternodePaymentVote> mapVotes;
+        s >> mapVotes;
+        {
+            LOCK(cs_mapMasternodePaymentVotes);
+            mapVoteBuckets.clear();
+            mapVoteHeights.clear();
+            for (const auto& pair : mapVotes) {
+                StoreVote(pair.first, pair.second);
+            }
+        }
+        LOCK(cs_mapMasternodeBlocks);
+        s >> mapMasternodeBlocks;
     }
 
     void Clear();
 
     bool AddOrUpdatePaymentVote(const CMasternodePaymentVote& vote);
+    bool HasPaymentVote(const uint256& hashIn) const;
     bool HasVerifiedPaymentVote(const uint256& hashIn) const;
+    bool GetVerifiedPaymentVote(const uint256& hashIn, CMasternodePaymentVote& voteRet) const;
+    bool GetVerifiedPaymentVotes(int nBlockHeight, std::vector<CMasternodePaymentVote>& vecVotesRet) const;
+    bool HasPaymentBlock(int nBlockHeight) const;
     bool ProcessBlock(int nBlockHeight, CConnman& connman);
     void CheckBlockVotes(int nBlockHeight);
 
@@ -210,8 +254,8 @@ public:
     bool GetMasternodeTxOuts(int nBlockHeight, CAmount blockReward, std::vector<CTxOut>& voutMasternodePaymentsRet) const;
     std::string ToString() const;
 
-    int GetBlockCount() const { return mapMasternodeBlocks.size(); }
-    int GetVoteCount() const { return mapMasternodePaymentVotes.size(); }
+    int GetBlockCount() const { LOCK(cs_mapMasternodeBlocks); return mapMasternodeBlocks.size(); }
+    int GetVoteCount() const { LOCK(cs_mapMasternodePaymentVotes); return mapVoteHeights.size(); }
 
     bool IsEnoughData() const;
     int GetStorageLimit() const;
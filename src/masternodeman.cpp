@@ -86,6 +86,7 @@ bool CMasternodeMan::Add(CMasternode &mn)
 
     LogPrint(MCLog::MN, "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.outpoint] = mn;
+    ScheduleCheck(mn.outpoint, GetTime());
     fMasternodesAdded = true;
     return true;
 }
@@ -119,7 +120,9 @@ void CMasternodeMan::AskForMN(CNode* pnode, const COutPoint& outpoint, CConnman&
         // we never asked any node for this outpoint
         LogPrintf("CMasternodeMan::AskForMN -- Asking peer %s for missing masternode entry for the first time: %s\n", addrSquashed.ToString(), outpoint.ToStringShort());
     }
-    mWeAskedForMasternodeListEntry[outpoint][addrSquashed] = GetTime() + DSEG_UPDATE_SECONDS;
+    int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
+    mWeAskedForMasternodeListEntry[outpoint][addrSquashed] = askAgain;
+    queueWeAskedForMasternodeListEntry.Push(askAgain, std::make_pair(outpoint, addrSquashed));
 
     connman.PushMessage(pnode, msgMaker.Make(NetMsgType::DSEG, outpoint));
 }
@@ -147,11 +150,30 @@ void CMasternodeMan::Check()
     if (deterministicMNManager->AreDeterministicMNsActive())
         return;
 
-    for (auto& mnpair : mapMasternodes) {
-        // NOTE: internally it checks only every MASTERNODE_CHECK_SECONDS seconds
-        // since the last time, so expect some MNs to skip this
-        mnpair.second.Check();
-    }
+    // Masternodes check themselves at most every MASTERNODE_CHECK_SECONDS seconds,
+    // so only visit the ones which are due instead of all of them on every tick
+    int64_t nNow = GetTime();
+    queueMasternodeChecks.PopExpired(nNow + 1, [&](const COutPoint& outpoint, int64_t nDeadline) {
+        auto itNext = mapMasternodeNextCheck.find(outpoint);
+        if (itNext == mapMasternodeNextCheck.end() || itNext->second != nDeadline) {
+            // rescheduled or removed since
+            return;
+        }
+        auto it = mapMasternodes.find(outpoint);
+        if (it == mapMasternodes.end()) {
+            mapMasternodeNextCheck.erase(itNext);
+            return;
+        }
+        it->second.Check();
+        ScheduleCheck(outpoint, std::max(it->second.nTimeLastChecked, nNow) + MASTERNODE_CHECK_SECONDS);
+    });
+}
+
+void CMasternodeMan::ScheduleCheck(const COutPoint& outpoint, int64_t nTime)
+{
+    AssertLockHeld(cs);
+    mapMasternodeNextCheck[outpoint] = nTime;
+    queueMasternodeChecks.Push(nTime, outpoint);
 }
 
 void CMasternodeMan::CheckAndRemove(CConnman& connman)
@@ -221,7 +243,9 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
                         nAskForMnbRecovery--;
                     }
                     // wait for mnb recovery replies for MNB_RECOVERY_WAIT_SECONDS seconds
-                    mMnbRecoveryRequests[hash] = std::make_pair(GetTime() + MNB_RECOVERY_WAIT_SECONDS, setRequested);
+                    int64_t nWaitUntil = GetTime() + MNB_RECOVERY_WAIT_SECONDS;
+                    mMnbRecoveryRequests[hash] = std::make_pair(nWaitUntil, setRequested);
+                    queueMnbRecoveryRequests.Push(nWaitUntil + MNB_RECOVERY_RETRY_SECONDS, hash);
                 }
                 ++it;
             }
@@ -231,7 +255,8 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
         LogPrint(MCLog::MN, "CMasternodeMan::CheckAndRemove -- mMnbRecoveryGoodReplies size=%d\n", (int)mMnbRecoveryGoodReplies.size());
         std::map<uint256, std::vector<CMasternodeBroadcast> >::iterator itMnbReplies = mMnbRecoveryGoodReplies.begin();
         while(itMnbReplies != mMnbRecoveryGoodReplies.end()){
-            if(mMnbRecoveryRequests[itMnbReplies->first].first < GetTime()) {
+            auto itMnbRequest = mMnbRecoveryRequests.find(itMnbReplies->first);
+            if(itMnbRequest == mMnbRecoveryRequests.end() || itMnbRequest->second.first < GetTime()) {
                 // all nodes we asked should have replied now
                 if(itMnbReplies->second.size() >= MNB_RECOVERY_QUORUM_REQUIRED) {
                     // majority of nodes we asked agrees that this mn doesn't require new mnb, reprocess one of new mnbs
@@ -252,93 +277,128 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
         // no need for cm_main below
         LOCK(cs);
 
-        auto itMnbRequest = mMnbRecoveryRequests.begin();
-        while(itMnbRequest != mMnbRecoveryRequests.end()){
-            // Allow this mnb to be re-verified again after MNB_RECOVERY_RETRY_SECONDS seconds
-            // if mn is still in MASTERNODE_NEW_START_REQUIRED state.
-            if(GetTime() - itMnbRequest->second.first > MNB_RECOVERY_RETRY_SECONDS) {
-                mMnbRecoveryRequests.erase(itMnbRequest++);
-            } else {
-                ++itMnbRequest;
-            }
+        RemoveExpiredEntries();
+
+        LogPrint(MCLog::MN, "CMasternodeMan::CheckAndRemove -- %s\n", ToString());
+    }
+
+    if(fMasternodesRemoved) {
+        NotifyMasternodeUpdates(connman);
+    }
+}
+
+void CMasternodeMan::RemoveExpiredEntries()
+{
+    AssertLockHeld(cs);
+
+    int64_t nNow = GetTime();
+
+    queueMnbRecoveryRequests.PopExpired(nNow, [&](const uint256& hash, int64_t) {
+        // Allow this mnb to be re-verified again after MNB_RECOVERY_RETRY_SECONDS seconds
+        // if mn is still in MASTERNODE_NEW_START_REQUIRED state.
+        auto it = mMnbRecoveryRequests.find(hash);
+        if (it != mMnbRecoveryRequests.end() && nNow - it->second.first > MNB_RECOVERY_RETRY_SECONDS) {
+            mMnbRecoveryRequests.erase(it);
         }
+    });
 
-        // check who's asked for the Masternode list
-        auto it1 = mAskedUsForMasternodeList.begin();
-        while(it1 != mAskedUsForMasternodeList.end()){
-            if((*it1).second < GetTime()) {
-                mAskedUsForMasternodeList.erase(it1++);
-            } else {
-                ++it1;
-            }
+    // check who's asked for the Masternode list
+    queueAskedUsForMasternodeList.PopExpired(nNow, [&](const CService& addr, int64_t) {
+        auto it = mAskedUsForMasternodeList.find(addr);
+        if (it != mAskedUsForMasternodeList.end() && it->second < nNow) {
+            mAskedUsForMasternodeList.erase(it);
         }
+    });
 
-        // check who we asked for the Masternode list
-        it1 = mWeAskedForMasternodeList.begin();
-        while(it1 != mWeAskedForMasternodeList.end()){
-            if((*it1).second < GetTime()){
-                mWeAskedForMasternodeList.erase(it1++);
-            } else {
-                ++it1;
-            }
+    // check who we asked for the Masternode list
+    queueWeAskedForMasternodeList.PopExpired(nNow, [&](const CService& addr, int64_t) {
+        auto it = mWeAskedForMasternodeList.find(addr);
+        if (it != mWeAskedForMasternodeList.end() && it->second < nNow) {
+            mWeAskedForMasternodeList.erase(it);
         }
+    });
 
-        // check which Masternodes we've asked for
-        auto it2 = mWeAskedForMasternodeListEntry.begin();
-        while(it2 != mWeAskedForMasternodeListEntry.end()){
-            auto it3 = it2->second.begin();
-            while(it3 != it2->second.end()){
-                if(it3->second < GetTime()){
-                    it2->second.erase(it3++);
-                } else {
-                    ++it3;
-                }
-            }
-            if(it2->second.empty()) {
-                mWeAskedForMasternodeListEntry.erase(it2++);
-            } else {
-                ++it2;
-            }
+    // check which Masternodes we've asked for
+    queueWeAskedForMasternodeListEntry.PopExpired(nNow, [&](const std::pair<COutPoint, CService>& entry, int64_t) {
+        auto it1 = mWeAskedForMasternodeListEntry.find(entry.first);
+        if (it1 == mWeAskedForMasternodeListEntry.end()) return;
+        auto it2 = it1->second.find(entry.second);
+        if (it2 != it1->second.end() && it2->second < nNow) {
+            it1->second.erase(it2);
+        }
+        if (it1->second.empty()) {
+            mWeAskedForMasternodeListEntry.erase(it1);
         }
+    });
 
-        auto it3 = mWeAskedForVerification.begin();
-        while(it3 != mWeAskedForVerification.end()){
-            if(it3->second.nBlockHeight < nCachedBlockHeight - MAX_POSE_BLOCKS) {
-                mWeAskedForVerification.erase(it3++);
-            } else {
-                ++it3;
-            }
+    queueWeAskedForVerification.PopExpired(nCachedBlockHeight, [&](const CService& addr, int64_t) {
+        auto it = mWeAskedForVerification.find(addr);
+        if (it != mWeAskedForVerification.end() && it->second.nBlockHeight < nCachedBlockHeight - MAX_POSE_BLOCKS) {
+            mWeAskedForVerification.erase(it);
         }
+    });
 
-        // NOTE: do not expire mapSeenMasternodeBroadcast entries here, clean them on mnb updates!
+    // NOTE: do not expire mapSeenMasternodeBroadcast entries here, clean them on mnb updates!
 
-        // remove expired mapSeenMasternodePing
-        std::map<uint256, CMasternodePing>::iterator it4 = mapSeenMasternodePing.begin();
-        while(it4 != mapSeenMasternodePing.end()){
-            if((*it4).second.IsExpired()) {
-                LogPrint(MCLog::MN, "CMasternodeMan::CheckAndRemove -- Removing expired Masternode ping: hash=%s\n", (*it4).second.GetHash().ToString());
-                mapSeenMasternodePing.erase(it4++);
-            } else {
-                ++it4;
-            }
+    // remove expired mapSeenMasternodePing
+    queueSeenMasternodePing.PopExpired(GetAdjustedTime(), [&](const uint256& hash, int64_t) {
+        auto it = mapSeenMasternodePing.find(hash);
+        if (it != mapSeenMasternodePing.end() && it->second.IsExpired()) {
+            LogPrint(MCLog::MN, "CMasternodeMan::CheckAndRemove -- Removing expired Masternode ping: hash=%s\n", hash.ToString());
+            mapSeenMasternodePing.erase(it);
         }
+    });
 
-        // remove expired mapSeenMasternodeVerification
-        std::map<uint256, CMasternodeVerification>::iterator itv2 = mapSeenMasternodeVerification.begin();
-        while(itv2 != mapSeenMasternodeVerification.end()){
-            if((*itv2).second.nBlockHeight < nCachedBlockHeight - MAX_POSE_BLOCKS){
-                LogPrint(MCLog::MN, "CMasternodeMan::CheckAndRemove -- Removing expired Masternode verification: hash=%s\n", (*itv2).first.ToString());
-                mapSeenMasternodeVerification.erase(itv2++);
-            } else {
-                ++itv2;
-            }
+    // remove expired mapSeenMasternodeVerification
+    queueSeenMasternodeVerification.PopExpired(nCachedBlockHeight, [&](const uint256& hash, int64_t) {
+        auto it = mapSeenMasternodeVerification.find(hash);
+        if (it != mapSeenMasternodeVerification.end() && it->second.nBlockHeight < nCachedBlockHeight - MAX_POSE_BLOCKS) {
+            LogPrint(MCLog::MN, "CMasternodeMan::CheckAndRemove -- Removing expired Masternode verification: hash=%s\n", hash.ToString());
+            mapSeenMasternodeVerification.erase(it);
         }
+    });
+}
 
-        LogPrint(MCLog::MN, "CMasternodeMan::CheckAndRemove -- %s\n", ToString());
+void CMasternodeMan::RebuildExpiryQueues()
+{
+    LOCK(cs);
+
+    queueAskedUsForMasternodeList.Clear();
+    for (const auto& pair : mAskedUsForMasternodeList) {
+        queueAskedUsForMasternodeList.Push(pair.second, pair.first);
+    }
+    queueWeAskedForMasternodeList.Clear();
+    for (const auto& pair : mWeAskedForMasternodeList) {
+        queueWeAskedForMasternodeList.Push(pair.second, pair.first);
+    }
+    queueWeAskedForMasternodeListEntry.Clear();
+    for (const auto& pair : mWeAskedForMasternodeListEntry) {
+        for (const auto& pairAsked : pair.second) {
+            queueWeAskedForMasternodeListEntry.Push(pairAsked.second, std::make_pair(pair.first, pairAsked.first));
+        }
+    }
+    queueMnbRecoveryRequests.Clear();
+    for (const auto& pair : mMnbRecoveryRequests) {
+        queueMnbRecoveryRequests.Push(pair.second.first + MNB_RECOVERY_RETRY_SECONDS, pair.first);
+    }
+    queueWeAskedForVerification.Clear();
+    for (const auto& pair : mWeAskedForVerification) {
+        queueWeAskedForVerification.Push(pair.second.nBlockHeight + MAX_POSE_BLOCKS, pair.first);
+    }
+    queueSeenMasternodeVerification.Clear();
+    for (const auto& pair : mapSeenMasternodeVerification) {
+        queueSeenMasternodeVerification.Push(pair.second.nBlockHeight + MAX_POSE_BLOCKS, pair.first);
+    }
+    queueSeenMasternodePing.Clear();
+    for (const auto& pair : mapSeenMasternodePing) {
+        queueSeenMasternodePing.Push(pair.second.sigTime + MASTERNODE_NEW_START_REQUIRED_SECONDS, pair.first);
     }
 
-    if(fMasternodesRemoved) {
-        NotifyMasternodeUpdates(connman);
+    queueMasternodeChecks.Clear();
+    mapMasternodeNextCheck.clear();
+    int64_t nNow = GetTime();
+    for (const auto& mnpair : mapMasternodes) {
+        ScheduleCheck(mnpair.first, nNow);
     }
 }
 
@@ -415,6 +475,13 @@ void CMasternodeMan::Clear()
     mapSeenMasternodeBroadcast.clear();
     mapSeenMasternodePing.clear();
     nLastSentinelPingTime = 0;
+
+    queueAskedUsForMasternodeList.Clear();
+    queueWeAskedForMasternodeList.Clear();
+    queueWeAskedForMasternodeListEntry.Clear();
+    queueSeenMasternodePing.Clear();
+    queueMasternodeChecks.Clear();
+    mapMasternodeNextCheck.clear();
 }
 
 int CMasternodeMan::CountMasternodes(int nProtocolVersion)
@@ -496,6 +563,7 @@ void CMasternodeMan::DsegUpdate(CNode* pnode, CConnman& connman)
 
     int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
     mWeAskedForMasternodeList[addrSquashed] = askAgain;
+    queueWeAskedForMasternodeList.Push(askAgain, addrSquashed);
 
     LogPrint(MCLog::MN, "CMasternodeMan::DsegUpdate -- asked %s for the list\n", pnode->addr.ToString());
 }
@@ -1008,7 +1076,7 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         LOCK2(cs_main, cs);
 
         if(mapSeenMasternodePing.count(nHash)) return; //seen
-        mapSeenMasternodePing.insert(std::make_pair(nHash, mnp));
+        AddSeenMasternodePing(mnp);
 
         LogPrint(MCLog::MN, "MNPING -- Masternode ping, masternode=%s new\n", mnp.masternodeOutpoint.ToStringShort());
 
@@ -1119,6 +1187,7 @@ void CMasternodeMan::SyncAll(CNode* pnode, CConnman& connman)
         }
         int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
         mAskedUsForMasternodeList[addrSquashed] = askAgain;
+        queueAskedUsForMasternodeList.Push(askAgain, addrSquashed);
     }
 
     int nInvCount = 0;
@@ -1148,7 +1217,7 @@ void CMasternodeMan::PushDsegInvs(CNode* pnode, const CMasternode& mn)
     pnode->PushInventory(CInv(MSG_MASTERNODE_ANNOUNCE, hashMNB));
     pnode->PushInventory(CInv(MSG_MASTERNODE_PING, hashMNP));
     mapSeenMasternodeBroadcast.insert(std::make_pair(hashMNB, std::make_pair(GetTime(), mnb)));
-    mapSeenMasternodePing.insert(std::make_pair(hashMNP, mnp));
+    AddSeenMasternodePing(mnp);
 }
 
 // Verification of masternodes via unique direct requests.
@@ -1327,6 +1396,7 @@ void CMasternodeMan::ProcessPendingMnvRequests(CConnman& connman)
             netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-request");
             // use random nonce, store it and require node to reply with correct one later
             mWeAskedForVerification[pnode->addr] = itPendingMNV->second.second;
+            queueWeAskedForVerification.Push(itPendingMNV->second.second.nBlockHeight + MAX_POSE_BLOCKS, pnode->addr);
             LogPrint(MCLog::MN, "-- verifying node using nonce %d addr=%s\n", itPendingMNV->second.second.nonce, pnode->addr.ToString());
             CNetMsgMaker msgMaker(pnode->GetSendVersion()); // TODO this gives a warning about version not being set (we should wait for VERSION exchange)
             connman.PushMessage(pnode, msgMaker.Make(NetMsgType::MNVERIFY, itPendingMNV->second.second));
@@ -1419,18 +1489,21 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
         return;
     }
 
+    auto itRequested = mWeAskedForVerification.find(pnode->addr);
+    const CMasternodeVerification mnvRequested = itRequested != mWeAskedForVerification.end() ? itRequested->second : CMasternodeVerification();
+
     // Received nonce for a known address must match the one we sent
-    if(mWeAskedForVerification[pnode->addr].nonce != mnv.nonce) {
+    if(mnvRequested.nonce != mnv.nonce) {
         LogPrint(MCLog::MN, "CMasternodeMan::ProcessVerifyReply -- ERROR: wrong nounce: requested=%d, received=%d, peer=%d\n",
-                    mWeAskedForVerification[pnode->addr].nonce, mnv.nonce, pnode->GetId());
+                    mnvRequested.nonce, mnv.nonce, pnode->GetId());
         Misbehaving(pnode->GetId(), 20);
         return;
     }
 
     // Received nBlockHeight for a known address must match the one we sent
-    if(mWeAskedForVerification[pnode->addr].nBlockHeight != mnv.nBlockHeight) {
+    if(mnvRequested.nBlockHeight != mnv.nBlockHeight) {
         LogPrint(MCLog::MN, "CMasternodeMan::ProcessVerifyReply -- ERROR: wrong nBlockHeight: requested=%d, received=%d, peer=%d\n",
-                    mWeAskedForVerification[pnode->addr].nBlockHeight, mnv.nBlockHeight, pnode->GetId());
+                    mnvRequested.nBlockHeight, mnv.nBlockHeight, pnode->GetId());
         Misbehaving(pnode->GetId(), 20);
         return;
     }
@@ -1513,7 +1586,8 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
                     }
 
                     mWeAskedForVerification[pnode->addr] = mnv;
-                    mapSeenMasternodeVerification.insert(std::make_pair(mnv.GetHash(), mnv));
+                    queueWeAskedForVerification.Push(mnv.nBlockHeight + MAX_POSE_BLOCKS, pnode->addr);
+                    AddSeenMasternodeVerification(mnv);
                     mnv.Relay();
 
                 } else {
@@ -1556,7 +1630,7 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
         // we already have one
         return;
     }
-    mapSeenMasternodeVerification[mnv.GetHash()] = mnv;
+    AddSeenMasternodeVerification(mnv);
 
     // we don't care about history
     if(mnv.nBlockHeight < nCachedBlockHeight - MAX_POSE_BLOCKS) {
@@ -1854,6 +1928,24 @@ bool CMasternodeMan::IsMasternodePingedWithin(const COutPoint& outpoint, int nSe
     return pmn ? pmn->IsPingedWithin(nSeconds, nTimeToCheckAt) : false;
 }
 
+void CMasternodeMan::AddSeenMasternodePing(const CMasternodePing& mnp)
+{
+    LOCK(cs);
+    uint256 hash = mnp.GetHash();
+    if (mapSeenMasternodePing.insert(std::make_pair(hash, mnp)).second) {
+        queueSeenMasternodePing.Push(mnp.sigTime + MASTERNODE_NEW_START_REQUIRED_SECONDS, hash);
+    }
+}
+
+void CMasternodeMan::AddSeenMasternodeVerification(const CMasternodeVerification& mnv)
+{
+    AssertLockHeld(cs);
+    uint256 hash = mnv.GetHash();
+    if (mapSeenMasternodeVerification.insert(std::make_pair(hash, mnv)).second) {
+        queueSeenMasternodeVerification.Push(mnv.nBlockHeight + MAX_POSE_BLOCKS, hash);
+    }
+}
+
 void CMasternodeMan::SetMasternodeLastPing(const COutPoint& outpoint, const CMasternodePing& mnp)
 {
     LOCK(cs);
@@ -1867,7 +1959,7 @@ void CMasternodeMan::SetMasternodeLastPing(const COutPoint& outpoint, const CMas
     if(mnp.fSentinelIsCurrent) {
         UpdateLastSentinelPingTime();
     }
-    mapSeenMasternodePing.insert(std::make_pair(mnp.GetHash(), mnp));
+    AddSeenMasternodePing(mnp);
 
     CMasternodeBroadcast mnb(*pmn);
     uint256 hash = mnb.GetHash();
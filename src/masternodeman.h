@@ -9,11 +9,45 @@
 #include <masternode.h>
 #include <sync.h>
 
+#include <functional>
+#include <queue>
+
 class CMasternodeMan;
 class CConnman;
 
 extern CMasternodeMan mnodeman;
 
+/**
+ * Min-heap of the deadlines of the entries of a map, so that expired entries can be
+ * found without walking the whole map. Entries are not removed from the heap when the
+ * map entry is refreshed or erased, so the caller has to check that the entry of a
+ * popped key is still expired before erasing it.
+ */
+template <typename K>
+class CExpiryQueue
+{
+private:
+    typedef std::pair<int64_t, K> entry_t;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t> > queue;
+
+public:
+    void Push(int64_t nDeadline, const K& key) { queue.emplace(nDeadline, key); }
+
+    /// Remove all entries whose deadline is before nTime and call fn(key, nDeadline) for each of them
+    template <typename Callable>
+    void PopExpired(int64_t nTime, Callable fn)
+    {
+        while (!queue.empty() && queue.top().first < nTime) {
+            entry_t entry = queue.top();
+            queue.pop();
+            fn(entry.second, entry.first);
+        }
+    }
+
+    void Clear() { queue = decltype(queue)(); }
+    size_t Size() const { return queue.size(); }
+};
+
 class CMasternodeMan
 {
 public:
@@ -67,6 +101,21 @@ private:
     std::map<CService, std::pair<int64_t, CMasternodeVerification> > mapPendingMNV;
     CCriticalSection cs_mapPendingMNV;
 
+    // deadlines of the entries of the maps above and below, so that CheckAndRemove only
+    // has to visit the entries which expired instead of scanning all of them
+    CExpiryQueue<CService> queueAskedUsForMasternodeList;
+    CExpiryQueue<CService> queueWeAskedForMasternodeList;
+    CExpiryQueue<std::pair<COutPoint, CService> > queueWeAskedForMasternodeListEntry;
+    CExpiryQueue<uint256> queueMnbRecoveryRequests;
+    // block heights after which the verification entries expire
+    CExpiryQueue<CService> queueWeAskedForVerification;
+    CExpiryQueue<uint256> queueSeenMasternodeVerification;
+    CExpiryQueue<uint256> queueSeenMasternodePing;
+
+    // when each masternode is due to be checked next, see Check()
+    CExpiryQueue<COutPoint> queueMasternodeChecks;
+    std::map<COutPoint, int64_t> mapMasternodeNextCheck;
+
     /// Set when masternodes are added, cleared when CGovernanceManager is notified
     bool fMasternodesAdded;
 
@@ -88,6 +137,13 @@ private:
 
     void PushDsegInvs(CNode* pnode, const CMasternode& mn);
 
+    void ScheduleCheck(const COutPoint& outpoint, int64_t nTime);
+    void AddSeenMasternodeVerification(const CMasternodeVerification& mnv);
+    /// Remove the entries of the request and seen maps whose deadlines have passed
+    void RemoveExpiredEntries();
+    /// Rebuild the expiry queues from the maps, whose deadlines are not serialized
+    void RebuildExpiryQueues();
+
 public:
     // Keep track of all broadcasts I've seen
     std::map<uint256, std::pair<int64_t, CMasternodeBroadcast> > mapSeenMasternodeBroadcast;
@@ -123,6 +179,9 @@ public:
         if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
+        if(ser_action.ForRead()) {
+            RebuildExpiryQueues();
+        }
     }
 
     CMasternodeMan();
@@ -135,7 +194,7 @@ public:
 
     bool PoSeBan(const COutPoint &outpoint);
 
-    /// Check all Masternodes
+    /// Check the Masternodes which are due to be checked
     void Check();
 
     /// Check all Masternodes and remove inactive
@@ -233,6 +292,8 @@ public:
 
     bool IsMasternodePingedWithin(const COutPoint& outpoint, int nSeconds, int64_t nTimeToCheckAt = -1);
     void SetMasternodeLastPing(const COutPoint& outpoint, const CMasternodePing& mnp);
+    /// Add a ping to mapSeenMasternodePing, to be removed once it expires
+    void AddSeenMasternodePing(const CMasternodePing& mnp);
 
     void UpdatedBlockTip(const CBlockIndex *pindex);
 
@@ -6,6 +6,7 @@
 #define MACHINECOIN_MEMUSAGE_H
 
 #include <indirectmap.h>
+#include <support/allocators/pool.h>
 
 #include <stdlib.h>
 
@@ -165,6 +166,19 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+/**
+ * The nodes of an unordered_map using a PoolAllocator are stored in the chunks of its PoolResource, so
+ * the memory used is the memory of the chunks, no matter how many of the nodes are in use. The bucket
+ * array is usually too large for the pool and allocated separately.
+ */
+template<typename X, typename Y, typename Z, typename P, size_t MAX_BLOCK_SIZE_BYTES, size_t ALIGN_BYTES>
+static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z, P, PoolAllocator<std::pair<const X, Y>, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> >& m)
+{
+    const auto* resource = m.get_allocator().Resource();
+    return MallocUsage(resource->ChunkSizeBytes()) * resource->NumAllocatedChunks() + DynamicUsage(resource->GetChunks()) +
+           MallocUsage(sizeof(void*) * m.bucket_count());
+}
+
 }
 
 #endif // MACHINECOIN_MEMUSAGE_H
@@ -7,6 +7,14 @@
 
 #include <key.h>
 
+// Size of the cache of successfully verified message/hash signatures in MiB
+static const unsigned int DEFAULT_MAX_MSG_SIG_CACHE_SIZE = 4;
+// Maximum message signature cache size allowed
+static const int64_t MAX_MAX_MSG_SIG_CACHE_SIZE = 1024;
+
+/** To be called once in AppInitMain/BasicTestingSetup to initialize the message signature cache */
+void InitMessageSignatureCache();
+
 /** Helper class for signing messages and checking their signatures
  */
 class CMessageSigner
@@ -170,6 +170,8 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     int nPackagesSelected = 0;
     int nDescendantsUpdated = 0;
     addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+    pblocktemplate->nBlockWeight = nBlockWeight;
+    pblocktemplate->nBlockSigOpsCost = nBlockSigOpsCost;
 
     int64_t nTime1 = GetTimeMicros();
 
@@ -476,12 +478,115 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
         }
 
         ++nPackagesSelected;
+        if (pblocktemplate->nMinPackageSize == 0 ||
+                (double)packageFees * pblocktemplate->nMinPackageSize < (double)pblocktemplate->nMinPackageFees * packageSize) {
+            pblocktemplate->nMinPackageFees = packageFees;
+            pblocktemplate->nMinPackageSize = packageSize;
+        }
 
         // Update transactions that depend on each of these
         nDescendantsUpdated += UpdatePackagesForAdded(ancestors, mapModifiedTx);
     }
 }
 
+bool BlockAssembler::CouldChangeTemplate(const CBlockTemplate& blocktemplate, CTxMemPool::txiter iter) const
+{
+    // The packages of transactions with unconfirmed ancestors change with the ancestors
+    // selected, leave these to a new selection
+    if (iter->GetCountWithAncestors() > 1)
+        return true;
+
+    uint64_t packageSize = iter->GetSizeWithAncestors();
+    CAmount packageFees = iter->GetModFeesWithAncestors();
+    if (packageFees < blockMinFeeRate.GetFee(packageSize))
+        return false;
+
+    // Packages are considered by decreasing fee rate, so a transaction paying less than every
+    // package selected is only considered once the block holds all of them, and then it is
+    // selected if it fits into the space left
+    if (blocktemplate.nMinPackageSize != 0 &&
+            (double)packageFees * blocktemplate.nMinPackageSize >= (double)blocktemplate.nMinPackageFees * packageSize)
+        return true;
+    if (blocktemplate.nBlockWeight + WITNESS_SCALE_FACTOR * packageSize >= nBlockMaxWeight)
+        return false;
+    if (blocktemplate.nBlockSigOpsCost + iter->GetSigOpCostWithAncestors() >= MAX_BLOCK_SIGOPS_COST)
+        return false;
+    return true;
+}
+
+CBlockTemplateTracker::CBlockTemplateTracker(const CChainParams& params) :
+    assembler(params), nTransactionsUpdated(0), nCommitmentsUpdated(0), nNotified(0), fStale(true)
+{
+    connAdded = mempool.NotifyEntryAdded.connect(boost::bind(&CBlockTemplateTracker::TransactionAddedToMempool, this, _1));
+    connRemoved = mempool.NotifyEntryRemoved.connect(boost::bind(&CBlockTemplateTracker::TransactionRemovedFromMempool, this, _1, _2));
+}
+
+void CBlockTemplateTracker::TransactionAddedToMempool(CTransactionRef tx)
+{
+    // Called before the entry is in mapTx, it is looked up in IsUpToDate
+    LOCK(cs);
+    ++nNotified;
+    if (!fStale)
+        vAdded.push_back(tx->GetHash());
+}
+
+void CBlockTemplateTracker::TransactionRemovedFromMempool(CTransactionRef tx, MemPoolRemovalReason reason)
+{
+    LOCK(cs);
+    ++nNotified;
+    if (setTemplateTxids.count(tx->GetHash()))
+        fStale = true;
+}
+
+unsigned int CBlockTemplateTracker::GetCommitmentsUpdated()
+{
+    return llmq::quorumBlockProcessor ? llmq::quorumBlockProcessor->GetMinableCommitmentsUpdated() : 0;
+}
+
+void CBlockTemplateTracker::Reset(std::shared_ptr<const CBlockTemplate> pblocktemplateIn, unsigned int nTransactionsUpdatedIn, unsigned int nCommitmentsUpdatedIn)
+{
+    LOCK(cs);
+    pblocktemplate = std::move(pblocktemplateIn);
+    nTransactionsUpdated = nTransactionsUpdatedIn;
+    nCommitmentsUpdated = nCommitmentsUpdatedIn;
+    nNotified = 0;
+    vAdded.clear();
+    setTemplateTxids.clear();
+    for (const auto& tx : pblocktemplate->block.vtx) {
+        setTemplateTxids.insert(tx->GetHash());
+    }
+    fStale = false;
+}
+
+bool CBlockTemplateTracker::IsUpToDate(unsigned int& nTransactionsUpdatedOut)
+{
+    LOCK2(mempool.cs, cs);
+    nTransactionsUpdatedOut = mempool.GetTransactionsUpdated();
+    if (fStale)
+        return false;
+    if (GetCommitmentsUpdated() != nCommitmentsUpdated) {
+        fStale = true;
+        return false;
+    }
+    // Changes without a notification, like prioritised transactions, can change anything
+    if (nTransactionsUpdatedOut - nTransactionsUpdated != nNotified) {
+        fStale = true;
+        return false;
+    }
+    for (const uint256& hash : vAdded) {
+        // Transactions removed again were notified, and weren't in the template
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it != mempool.mapTx.end() && assembler.CouldChangeTemplate(*pblocktemplate, it)) {
+            fStale = true;
+            return false;
+        }
+    }
+    nTransactionsUpdated = nTransactionsUpdatedOut;
+    nNotified = 0;
+    vAdded.clear();
+    return true;
+}
+
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
 {
     // Update nExtraNonce
@@ -31,6 +31,14 @@ struct CBlockTemplate
     std::vector<unsigned char> vchCoinbaseCommitment;
     std::vector<CTxOut> voutMasternodePayments; // masternode payment
     std::vector<CTxOut> voutSuperblockPayments; // superblock payment
+
+    // Weight and sigop cost of the transactions selected from the mempool, including the
+    // reserved coinbase space, and the lowest fee rate of the packages selected (none if
+    // nMinPackageSize is 0), to tell whether mempool changes can change the selection
+    uint64_t nBlockWeight{0};
+    uint64_t nBlockSigOpsCost{0};
+    CAmount nMinPackageFees{0};
+    uint64_t nMinPackageSize{0};
 };
 
 // Container for tracking updates to ancestor feerate as we include (parent)
@@ -161,6 +169,10 @@ public:
     /** Construct a new block template with coinbase to scriptPubKeyIn */
     std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx=true);
 
+    /** Whether a transaction added to the mempool after a template was assembled could be
+      * selected into it, so that assembling the template again could give another block */
+    bool CouldChangeTemplate(const CBlockTemplate& blocktemplate, CTxMemPool::txiter iter) const EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+
 private:
     // utility functions
     /** Clear the block's state and prepare for assembling a new block */
@@ -195,6 +207,52 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 };
 
+/**
+ * Follows the changes to the mempool after a block template was assembled, to tell
+ * whether assembling it again could give another block. Removing a transaction which
+ * is not in the template doesn't change the selection, and neither does adding one
+ * which cannot be selected (see BlockAssembler::CouldChangeTemplate). Any other
+ * change, such as a prioritised transaction or a new minable LLMQ commitment, makes
+ * the template stale.
+ */
+class CBlockTemplateTracker
+{
+private:
+    mutable CCriticalSection cs;
+    BlockAssembler assembler;
+    boost::signals2::scoped_connection connAdded;
+    boost::signals2::scoped_connection connRemoved;
+
+    // Mempool sequence (CTxMemPool::GetTransactionsUpdated) the template is up to date with
+    unsigned int nTransactionsUpdated GUARDED_BY(cs);
+    // Minable LLMQ commitments sequence (CQuorumBlockProcessor::GetMinableCommitmentsUpdated) the
+    // template was assembled at. The mempool sequence doesn't cover new commitments.
+    unsigned int nCommitmentsUpdated GUARDED_BY(cs);
+    // Additions and removals notified since, which account for as many sequence increments
+    unsigned int nNotified GUARDED_BY(cs);
+    std::vector<uint256> vAdded GUARDED_BY(cs);
+    std::set<uint256> setTemplateTxids GUARDED_BY(cs);
+    bool fStale GUARDED_BY(cs);
+    std::shared_ptr<const CBlockTemplate> pblocktemplate GUARDED_BY(cs);
+
+    void TransactionAddedToMempool(CTransactionRef tx);
+    void TransactionRemovedFromMempool(CTransactionRef tx, MemPoolRemovalReason reason);
+
+public:
+    explicit CBlockTemplateTracker(const CChainParams& params);
+
+    /** Start following the mempool for a template assembled from it at sequence nTransactionsUpdatedIn,
+      * and with the minable LLMQ commitments at sequence nCommitmentsUpdatedIn */
+    void Reset(std::shared_ptr<const CBlockTemplate> pblocktemplateIn, unsigned int nTransactionsUpdatedIn, unsigned int nCommitmentsUpdatedIn);
+
+    /** Current sequence of the minable LLMQ commitments, to pass to Reset */
+    static unsigned int GetCommitmentsUpdated();
+
+    /** Whether the template is still up to date with the mempool, whose current sequence is
+      * returned in nTransactionsUpdatedOut. Once stale, a template stays stale until Reset. */
+    bool IsUpToDate(unsigned int& nTransactionsUpdatedOut);
+};
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
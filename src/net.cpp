@@ -45,6 +45,9 @@
 // We add a random period time (0 to 1 seconds) to feeler connections to prevent synchronization.
 #define FEELER_SLEEP_WINDOW 1
 
+/** Maximum time a socket events wait may block, so that vSend is polled frequently enough */
+static const int SELECT_TIMEOUT_MILLISECONDS = 50;
+
 // MSG_NOSIGNAL is not available on some platforms, if it doesn't exist define it as 0
 #if !defined(MSG_NOSIGNAL)
 #define MSG_NOSIGNAL 0
@@ -1110,7 +1113,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
         return;
     }
 
-    if (!IsSelectableSocket(hSocket))
+    if (socketEventsMode == SOCKETEVENTS_SELECT && !IsSelectableSocket(hSocket))
     {
         LogPrintf("connection from %s dropped: non-selectable socket\n", addr.ToString());
         CloseSocket(hSocket);
@@ -1160,6 +1163,486 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
     }
+    RequestSocketEventsUpdate(pnode);
+}
+
+bool ParseSocketEventsMode(const std::string& str, SocketEventsMode& mode)
+{
+    if (str == "select") {
+        mode = SOCKETEVENTS_SELECT;
+        return true;
+    }
+#ifdef USE_EPOLL
+    if (str == "epoll") {
+        mode = SOCKETEVENTS_EPOLL;
+        return true;
+    }
+#endif
+    return false;
+}
+
+std::string GetSupportedSocketEventsModes()
+{
+    std::string strModes = "select";
+#ifdef USE_EPOLL
+    strModes += ", epoll";
+#endif
+    return strModes;
+}
+
+#ifdef USE_EPOLL
+CSocketEventsEpoll::CSocketEventsEpoll(size_t nMaxEventsPerWait) : vEvents(nMaxEventsPerWait)
+{
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd == -1) {
+        LogPrintf("epoll_create1 failed: %s\n", NetworkErrorString(WSAGetLastError()));
+    }
+}
+
+CSocketEventsEpoll::~CSocketEventsEpoll()
+{
+    if (epollfd != -1) {
+        close(epollfd);
+    }
+}
+
+static uint32_t EpollEventsFromInterest(uint8_t nInterest)
+{
+    uint32_t events = 0;
+    if (nInterest & CSocketEventsEpoll::EVENT_RECV) {
+        events |= EPOLLIN;
+    }
+    if (nInterest & CSocketEventsEpoll::EVENT_SEND) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+bool CSocketEventsEpoll::Add(SOCKET hSocket, uint8_t nInterest, uint64_t nData)
+{
+    struct epoll_event event;
+    event.events = EpollEventsFromInterest(nInterest);
+    event.data.u64 = nData;
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, hSocket, &event) != 0) {
+        LogPrintf("epoll_ctl(EPOLL_CTL_ADD) failed for socket %d: %s\n", hSocket, NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+    return true;
+}
+
+bool CSocketEventsEpoll::Modify(SOCKET hSocket, uint8_t nInterest, uint64_t nData)
+{
+    struct epoll_event event;
+    event.events = EpollEventsFromInterest(nInterest);
+    event.data.u64 = nData;
+    if (epoll_ctl(epollfd, EPOLL_CTL_MOD, hSocket, &event) != 0) {
+        LogPrintf("epoll_ctl(EPOLL_CTL_MOD) failed for socket %d: %s\n", hSocket, NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+    return true;
+}
+
+bool CSocketEventsEpoll::Wait(int nTimeoutMs, std::vector<Event>& events)
+{
+    int nEvents = epoll_wait(epollfd, vEvents.data(), vEvents.size(), nTimeoutMs);
+    if (nEvents < 0) {
+        int nErr = WSAGetLastError();
+        if (nErr == WSAEINTR) {
+            return true;
+        }
+        LogPrintf("epoll_wait error %s\n", NetworkErrorString(nErr));
+        return false;
+    }
+
+    events.reserve(events.size() + nEvents);
+    for (int i = 0; i < nEvents; i++) {
+        const struct epoll_event& event = vEvents[i];
+        uint8_t nReady = EVENT_NONE;
+        if (event.events & EPOLLIN) {
+            nReady |= EVENT_RECV;
+        }
+        if (event.events & EPOLLOUT) {
+            nReady |= EVENT_SEND;
+        }
+        if (event.events & (EPOLLERR | EPOLLHUP)) {
+            nReady |= EVENT_ERROR;
+        }
+        events.push_back(Event{event.data.u64, nReady});
+    }
+    return true;
+}
+#endif // USE_EPOLL
+
+void CConnman::SocketEventsSelect(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set)
+{
+    struct timeval timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = SELECT_TIMEOUT_MILLISECONDS * 1000; // frequency to poll pnode->vSend
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+
+    for (const ListenSocket& hListenSocket : vhListenSocket) {
+        FD_SET(hListenSocket.socket, &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, hListenSocket.socket);
+        have_fds = true;
+    }
+
+    {
+        LOCK(cs_vNodes);
+        for (CNode* pnode : vNodes)
+        {
+            // Implement the following logic:
+            // * If there is data to send, select() for sending data. As this only
+            //   happens when optimistic write failed, we choose to first drain the
+            //   write buffer in this case before receiving more. This avoids
+            //   needlessly queueing received data, if the remote peer is not themselves
+            //   receiving data. This means properly utilizing TCP flow control signalling.
+            // * Otherwise, if there is space left in the receive buffer, select() for
+            //   receiving data.
+            // * Hand off all complete messages to the processor, to be handled without
+            //   blocking here.
+
+            bool select_recv = !pnode->fPauseRecv;
+            bool select_send;
+            {
+                LOCK(pnode->cs_vSend);
+                select_send = !pnode->vSendMsg.empty();
+            }
+
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+
+            FD_SET(pnode->hSocket, &fdsetError);
+            hSocketMax = std::max(hSocketMax, pnode->hSocket);
+            have_fds = true;
+
+            if (select_send) {
+                FD_SET(pnode->hSocket, &fdsetSend);
+                continue;
+            }
+            if (select_recv) {
+                FD_SET(pnode->hSocket, &fdsetRecv);
+            }
+        }
+    }
+
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                         &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    if (interruptNet)
+        return;
+
+    if (nSelect == SOCKET_ERROR)
+    {
+        if (have_fds)
+        {
+            int nErr = WSAGetLastError();
+            LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
+            for (unsigned int i = 0; i <= hSocketMax; i++)
+                FD_SET(i, &fdsetRecv);
+        }
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        if (!interruptNet.sleep_for(std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS)))
+            return;
+    }
+
+    for (SOCKET hSocket = 0; have_fds && hSocket <= hSocketMax; hSocket++) {
+        if (FD_ISSET(hSocket, &fdsetRecv)) {
+            recv_set.insert(hSocket);
+        }
+        if (FD_ISSET(hSocket, &fdsetSend)) {
+            send_set.insert(hSocket);
+        }
+        if (FD_ISSET(hSocket, &fdsetError)) {
+            error_set.insert(hSocket);
+        }
+    }
+}
+
+void CConnman::SocketHandlerSelect()
+{
+    std::set<SOCKET> recv_set, send_set, error_set;
+    SocketEventsSelect(recv_set, send_set, error_set);
+
+    if (interruptNet)
+        return;
+
+    //
+    // Accept new connections
+    //
+    for (const ListenSocket& hListenSocket : vhListenSocket)
+    {
+        if (hListenSocket.socket != INVALID_SOCKET && recv_set.count(hListenSocket.socket) > 0)
+        {
+            AcceptConnection(hListenSocket);
+        }
+    }
+
+    //
+    // Service each socket
+    //
+    std::vector<CNode*> vNodesCopy = CopyNodeVector();
+    for (CNode* pnode : vNodesCopy)
+    {
+        if (interruptNet)
+            break;
+
+        bool recvSet = false;
+        bool sendSet = false;
+        bool errorSet = false;
+        {
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+            recvSet = recv_set.count(pnode->hSocket) > 0;
+            sendSet = send_set.count(pnode->hSocket) > 0;
+            errorSet = error_set.count(pnode->hSocket) > 0;
+        }
+        SocketHandlerNode(pnode, recvSet, sendSet, errorSet);
+        InactivityCheck(pnode);
+    }
+    ReleaseNodeVector(vNodesCopy);
+}
+
+#ifdef USE_EPOLL
+// Event data of listen sockets, the index into vhListenSocket is added. Peers use their id.
+static const uint64_t SOCKET_EVENTS_LISTEN_DATA = uint64_t{1} << 63;
+
+void CConnman::UpdateSocketEventsInterest(CNode* pnode)
+{
+    // Same policy as SocketEventsSelect, but the interest stays registered
+    // with the kernel and is only changed when the send or receive pause
+    // state of the peer changed.
+    bool select_recv = !pnode->fPauseRecv;
+    bool select_send;
+    {
+        LOCK(pnode->cs_vSend);
+        select_send = !pnode->vSendMsg.empty();
+    }
+    uint8_t nInterest = CSocketEventsEpoll::EVENT_NONE;
+    if (select_send) {
+        nInterest = CSocketEventsEpoll::EVENT_SEND;
+    } else if (select_recv) {
+        nInterest = CSocketEventsEpoll::EVENT_RECV;
+    }
+
+    LOCK(pnode->cs_hSocket);
+    if (pnode->hSocket == INVALID_SOCKET)
+        return;
+
+    if (!pnode->fSocketEventsRegistered) {
+        if (socketEventsEpoll->Add(pnode->hSocket, nInterest, pnode->GetId())) {
+            pnode->fSocketEventsRegistered = true;
+            pnode->nSocketEventsInterest = nInterest;
+            mapSocketEventsNodes.emplace(pnode->GetId(), pnode);
+        }
+    } else if (pnode->nSocketEventsInterest != nInterest) {
+        if (socketEventsEpoll->Modify(pnode->hSocket, nInterest, pnode->GetId())) {
+            pnode->nSocketEventsInterest = nInterest;
+        }
+    }
+}
+
+void CConnman::SocketHandlerEpoll()
+{
+    assert(socketEventsEpoll);
+
+    // Only peers whose state changed outside this thread get their interest updated
+    // here, so a wakeup doesn't touch every peer.
+    std::vector<CNode*> vNodesUpdate;
+    {
+        LOCK(cs_vSocketEventsUpdate);
+        vNodesUpdate.swap(vSocketEventsUpdate);
+    }
+    for (CNode* pnode : vNodesUpdate) {
+        pnode->fSocketEventsUpdate = false;
+        UpdateSocketEventsInterest(pnode);
+        pnode->Release();
+    }
+
+    std::vector<CSocketEventsEpoll::Event> events;
+    if (!socketEventsEpoll->Wait(SELECT_TIMEOUT_MILLISECONDS, events)) {
+        interruptNet.sleep_for(std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS));
+    }
+
+    if (interruptNet)
+        return;
+
+    // Map the events back to listen sockets and peers. Events of peers that were
+    // disconnected since are dropped.
+    std::vector<std::pair<CNode*, uint8_t>> vNodesReady;
+    vNodesReady.reserve(events.size());
+    for (const CSocketEventsEpoll::Event& event : events) {
+        if (event.nData & SOCKET_EVENTS_LISTEN_DATA) {
+            const ListenSocket& hListenSocket = vhListenSocket.at(event.nData & ~SOCKET_EVENTS_LISTEN_DATA);
+            if (hListenSocket.socket != INVALID_SOCKET && (event.nEvents & CSocketEventsEpoll::EVENT_RECV)) {
+                AcceptConnection(hListenSocket);
+            }
+            continue;
+        }
+        auto it = mapSocketEventsNodes.find(event.nData);
+        if (it != mapSocketEventsNodes.end()) {
+            it->second->AddRef();
+            vNodesReady.emplace_back(it->second, event.nEvents);
+        }
+    }
+
+    //
+    // Service the ready sockets
+    //
+    for (const auto& ready : vNodesReady)
+    {
+        CNode* pnode = ready.first;
+        if (!interruptNet) {
+            SocketHandlerNode(pnode,
+                              ready.second & CSocketEventsEpoll::EVENT_RECV,
+                              ready.second & CSocketEventsEpoll::EVENT_SEND,
+                              ready.second & CSocketEventsEpoll::EVENT_ERROR);
+            // Receiving may have paused the peer and sending may have drained its queue
+            UpdateSocketEventsInterest(pnode);
+        }
+        pnode->Release();
+    }
+
+    // The timeouts have a resolution of seconds, checking them once per second
+    // rather than on every wakeup is enough.
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime != nLastInactivityCheck) {
+        nLastInactivityCheck = nTime;
+        std::vector<CNode*> vNodesCopy = CopyNodeVector();
+        for (CNode* pnode : vNodesCopy) {
+            InactivityCheck(pnode);
+        }
+        ReleaseNodeVector(vNodesCopy);
+    }
+}
+#endif
+
+void CConnman::RequestSocketEventsUpdate(CNode* pnode)
+{
+#ifdef USE_EPOLL
+    if (socketEventsMode != SOCKETEVENTS_EPOLL)
+        return;
+    if (pnode->fSocketEventsUpdate.exchange(true))
+        return;
+    pnode->AddRef();
+    LOCK(cs_vSocketEventsUpdate);
+    vSocketEventsUpdate.push_back(pnode);
+#endif
+}
+
+void CConnman::SocketHandlerNode(CNode* pnode, bool recvSet, bool sendSet, bool errorSet)
+{
+    //
+    // Receive
+    //
+    if (recvSet || errorSet)
+    {
+        // typical socket buffer is 8K-64K
+        char pchBuf[0x10000];
+        int nBytes = 0;
+        {
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                return;
+            nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+        }
+        if (nBytes > 0)
+        {
+            bool notify = false;
+            if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
+                pnode->CloseSocketDisconnect();
+            RecordBytesRecv(nBytes);
+            if (notify) {
+                size_t nSizeAdded = 0;
+                auto it(pnode->vRecvMsg.begin());
+                for (; it != pnode->vRecvMsg.end(); ++it) {
+                    if (!it->complete())
+                        break;
+                    nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
+                }
+                {
+                    LOCK(pnode->cs_vProcessMsg);
+                    pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
+                    pnode->nProcessQueueSize += nSizeAdded;
+                    pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+                }
+                WakeMessageHandler();
+            }
+        }
+        else if (nBytes == 0)
+        {
+            // socket closed gracefully
+            if (!pnode->fDisconnect) {
+                LogPrint(MCLog::NET, "socket closed\n");
+            }
+            pnode->CloseSocketDisconnect();
+        }
+        else if (nBytes < 0)
+        {
+            // error
+            int nErr = WSAGetLastError();
+            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
+            {
+                if (!pnode->fDisconnect)
+                    LogPrintf("socket recv error %s\n", NetworkErrorString(nErr));
+                pnode->CloseSocketDisconnect();
+            }
+        }
+    }
+
+    //
+    // Send
+    //
+    if (sendSet)
+    {
+        LOCK(pnode->cs_vSend);
+        size_t nBytes = SocketSendData(pnode);
+        if (nBytes) {
+            RecordBytesSent(nBytes);
+        }
+    }
+}
+
+void CConnman::InactivityCheck(CNode* pnode)
+{
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime - pnode->nTimeConnected > 60)
+    {
+        if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
+        {
+            LogPrint(MCLog::NET, "socket no message in first 60 seconds, %d %d from %d\n", pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->GetId());
+            pnode->fDisconnect = true;
+        }
+        else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
+        {
+            LogPrintf("socket sending timeout: %is\n", nTime - pnode->nLastSend);
+            pnode->fDisconnect = true;
+        }
+        else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90*60))
+        {
+            LogPrintf("socket receive timeout: %is\n", nTime - pnode->nLastRecv);
+            pnode->fDisconnect = true;
+        }
+        else if (pnode->nPingNonceSent && pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
+        {
+            LogPrintf("ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
+            pnode->fDisconnect = true;
+        }
+        else if (!pnode->fSuccessfullyConnected)
+        {
+            LogPrintf("version handshake timeout from %d\n", pnode->GetId());
+            pnode->fDisconnect = true;
+        }
+    }
 }
 
 void CConnman::ThreadSocketHandler()
@@ -1198,6 +1681,10 @@ void CConnman::ThreadSocketHandler()
 
                     // close socket and cleanup
                     pnode->CloseSocketDisconnect();
+#ifdef USE_EPOLL
+                    // ignore events still reported for it
+                    mapSocketEventsNodes.erase(pnode->GetId());
+#endif
 
                     // hold in disconnected pool until all refs are released
                     pnode->Release();
@@ -1241,222 +1728,20 @@ void CConnman::ThreadSocketHandler()
         }
 
         //
-        // Find which sockets have data to receive
-        //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
-
-        for (const ListenSocket& hListenSocket : vhListenSocket) {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
-        }
-
-        {
-            LOCK(cs_vNodes);
-            for (CNode* pnode : vNodes)
-            {
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is space left in the receive buffer, select() for
-                //   receiving data.
-                // * Hand off all complete messages to the processor, to be handled without
-                //   blocking here.
-
-                bool select_recv = !pnode->fPauseRecv;
-                bool select_send;
-                {
-                    LOCK(pnode->cs_vSend);
-                    select_send = !pnode->vSendMsg.empty();
-                }
-
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
-
-                if (select_send) {
-                    FD_SET(pnode->hSocket, &fdsetSend);
-                    continue;
-                }
-                if (select_recv) {
-                    FD_SET(pnode->hSocket, &fdsetRecv);
-                }
-            }
-        }
-
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        if (interruptNet)
-            return;
-
-        if (nSelect == SOCKET_ERROR)
-        {
-            if (have_fds)
-            {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
-                return;
-        }
-
-        //
-        // Accept new connections
-        //
-        for (const ListenSocket& hListenSocket : vhListenSocket)
-        {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
-            {
-                AcceptConnection(hListenSocket);
-            }
-        }
-
-        //
-        // Service each socket
+        // Wait for socket events, accept new connections and service the peers
         //
-        std::vector<CNode*> vNodesCopy = CopyNodeVector();
-        for (CNode* pnode : vNodesCopy)
-        {
-            if (interruptNet)
-                return;
-
-            //
-            // Receive
-            //
-            bool recvSet = false;
-            bool sendSet = false;
-            bool errorSet = false;
-            {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
-                sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
-                errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
-            }
-            if (recvSet || errorSet)
-            {
-                // typical socket buffer is 8K-64K
-                char pchBuf[0x10000];
-                int nBytes = 0;
-                {
-                    LOCK(pnode->cs_hSocket);
-                    if (pnode->hSocket == INVALID_SOCKET)
-                        continue;
-                    nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-                }
-                if (nBytes > 0)
-                {
-                    bool notify = false;
-                    if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
-                        pnode->CloseSocketDisconnect();
-                    RecordBytesRecv(nBytes);
-                    if (notify) {
-                        size_t nSizeAdded = 0;
-                        auto it(pnode->vRecvMsg.begin());
-                        for (; it != pnode->vRecvMsg.end(); ++it) {
-                            if (!it->complete())
-                                break;
-                            nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
-                        }
-                        {
-                            LOCK(pnode->cs_vProcessMsg);
-                            pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
-                            pnode->nProcessQueueSize += nSizeAdded;
-                            pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
-                        }
-                        WakeMessageHandler();
-                    }
-                }
-                else if (nBytes == 0)
-                {
-                    // socket closed gracefully
-                    if (!pnode->fDisconnect) {
-                        LogPrint(MCLog::NET, "socket closed\n");
-                    }
-                    pnode->CloseSocketDisconnect();
-                }
-                else if (nBytes < 0)
-                {
-                    // error
-                    int nErr = WSAGetLastError();
-                    if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                    {
-                        if (!pnode->fDisconnect)
-                            LogPrintf("socket recv error %s\n", NetworkErrorString(nErr));
-                        pnode->CloseSocketDisconnect();
-                    }
-                }
-            }
-
-            //
-            // Send
-            //
-            if (sendSet)
-            {
-                LOCK(pnode->cs_vSend);
-                size_t nBytes = SocketSendData(pnode);
-                if (nBytes) {
-                    RecordBytesSent(nBytes);
-                }
-            }
-
-            //
-            // Inactivity checking
-            //
-            int64_t nTime = GetSystemTimeInSeconds();
-            if (nTime - pnode->nTimeConnected > 60)
-            {
-                if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
-                {
-                    LogPrint(MCLog::NET, "socket no message in first 60 seconds, %d %d from %d\n", pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->GetId());
-                    pnode->fDisconnect = true;
-                }
-                else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
-                {
-                    LogPrintf("socket sending timeout: %is\n", nTime - pnode->nLastSend);
-                    pnode->fDisconnect = true;
-                }
-                else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90*60))
-                {
-                    LogPrintf("socket receive timeout: %is\n", nTime - pnode->nLastRecv);
-                    pnode->fDisconnect = true;
-                }
-                else if (pnode->nPingNonceSent && pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
-                {
-                    LogPrintf("ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
-                    pnode->fDisconnect = true;
-                }
-                else if (!pnode->fSuccessfullyConnected)
-                {
-                    LogPrintf("version handshake timeout from %d\n", pnode->GetId());
-                    pnode->fDisconnect = true;
-                }
-            }
+        switch (socketEventsMode) {
+#ifdef USE_EPOLL
+        case SOCKETEVENTS_EPOLL:
+            SocketHandlerEpoll();
+            break;
+#endif
+        case SOCKETEVENTS_SELECT:
+            SocketHandlerSelect();
+            break;
+        default:
+            assert(false);
         }
-        ReleaseNodeVector(vNodesCopy);
     }
 }
 
@@ -2068,6 +2353,7 @@ bool CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
     }
+    RequestSocketEventsUpdate(pnode);
 
     return true;
 }
@@ -2328,6 +2614,26 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         return false;
     }
 
+#ifdef USE_EPOLL
+    if (socketEventsMode == SOCKETEVENTS_EPOLL) {
+        socketEventsEpoll = MakeUnique<CSocketEventsEpoll>();
+        if (!socketEventsEpoll->IsValid()) {
+            if (clientInterface) {
+                clientInterface->ThreadSafeMessageBox(
+                    _("Failed to initialize the epoll socket events backend. Use -socketevents=select if you want to use select() instead."),
+                    "", CClientUIInterface::MSG_ERROR);
+            }
+            return false;
+        }
+        for (size_t i = 0; i < vhListenSocket.size(); i++) {
+            if (!socketEventsEpoll->Add(vhListenSocket[i].socket, CSocketEventsEpoll::EVENT_RECV, SOCKET_EVENTS_LISTEN_DATA | i)) {
+                return false;
+            }
+        }
+        nLastInactivityCheck = 0;
+    }
+#endif
+
     for (const auto& strDest : connOptions.vSeedNodes) {
         AddOneShot(strDest);
     }
@@ -2514,6 +2820,15 @@ void CConnman::Stop()
     vNodes.clear();
     vNodesDisconnected.clear();
     vhListenSocket.clear();
+    {
+        // the nodes are deleted regardless of the references held by the queue
+        LOCK(cs_vSocketEventsUpdate);
+        vSocketEventsUpdate.clear();
+    }
+#ifdef USE_EPOLL
+    mapSocketEventsNodes.clear();
+    socketEventsEpoll.reset();
+#endif
     semOutbound.reset();
     semAddnode.reset();
     semMasternodeOutbound.reset();
@@ -2842,6 +3157,9 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     nextSendTimeFeeFilter = 0;
     fPauseRecv = false;
     fPauseSend = false;
+    fSocketEventsRegistered = false;
+    nSocketEventsInterest = 0;
+    fSocketEventsUpdate = false;
     nProcessQueueSize = 0;
 
     for (const std::string &msg : getAllNetMessageTypes())
@@ -2917,6 +3235,7 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
     CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, serializedHeader, 0, hdr};
 
     size_t nBytesSent = 0;
+    bool fSendQueued = false;
     {
         LOCK(pnode->cs_vSend);
         bool optimisticSend(pnode->vSendMsg.empty());
@@ -2932,11 +3251,16 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
             pnode->vSendMsg.push_back(std::move(msg.data));
 
         // If write queue empty, attempt "optimistic write"
-        if (optimisticSend == true)
+        if (optimisticSend == true) {
             nBytesSent = SocketSendData(pnode);
+            // the socket handler has to wait until the socket is writable now
+            fSendQueued = !pnode->vSendMsg.empty();
+        }
     }
     if (nBytesSent)
         RecordBytesSent(nBytesSent);
+    if (fSendQueued)
+        RequestSocketEventsUpdate(pnode);
 }
 
 bool CConnman::ForNode(const CService& addr, std::function<bool(const CNode* pnode)> cond, std::function<bool(CNode* pnode)> func)
@@ -27,12 +27,18 @@
 #include <stdint.h>
 #include <thread>
 #include <memory>
+#include <unordered_map>
 #include <condition_variable>
 
 #ifndef WIN32
 #include <arpa/inet.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#define USE_EPOLL
+#endif
+
 
 class CScheduler;
 class CNode;
@@ -87,6 +93,19 @@ static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
 // NOTE: When adjusting this, update rpcnet:setban's help ("24h")
 static const unsigned int DEFAULT_MISBEHAVING_BANTIME = 60 * 60 * 24;  // Default 24-hour ban
 
+/** Mechanisms the socket handler thread can use to wait for socket readiness */
+enum SocketEventsMode {
+    SOCKETEVENTS_SELECT = 0,
+    SOCKETEVENTS_EPOLL = 1,
+};
+/** -socketevents default */
+static const char* const DEFAULT_SOCKETEVENTS = "select";
+
+/** Parse a -socketevents value, returns false if the mode is unknown or unsupported on this platform */
+bool ParseSocketEventsMode(const std::string& str, SocketEventsMode& mode);
+/** Modes accepted by -socketevents on this platform, for help and error messages */
+std::string GetSupportedSocketEventsModes();
+
 typedef int64_t NodeId;
 
 struct AddedNodeInfo
@@ -113,6 +132,54 @@ struct CSerializedNetMsg
     std::string command;
 };
 
+#ifdef USE_EPOLL
+/**
+ * Persistent epoll interest set for a group of sockets.
+ *
+ * Unlike select(), which needs every socket handed to the kernel again on
+ * each call, sockets stay registered here between waits and the kernel is
+ * only told when the interest of a socket changes. A wait therefore costs
+ * O(ready sockets) and is not limited by FD_SETSIZE. Each socket carries a
+ * caller chosen value that is handed back with its events, so the caller can
+ * find what the socket belongs to without scanning its own sockets. Sockets
+ * are removed from the set automatically when they are closed.
+ */
+class CSocketEventsEpoll
+{
+public:
+    enum : uint8_t {
+        EVENT_NONE = 0,
+        EVENT_RECV = (1U << 0),
+        EVENT_SEND = (1U << 1),
+        EVENT_ERROR = (1U << 2),
+    };
+
+    struct Event {
+        uint64_t nData;
+        uint8_t nEvents;
+    };
+
+    explicit CSocketEventsEpoll(size_t nMaxEventsPerWait = 1024);
+    ~CSocketEventsEpoll();
+    CSocketEventsEpoll(const CSocketEventsEpoll&) = delete;
+    CSocketEventsEpoll& operator=(const CSocketEventsEpoll&) = delete;
+
+    bool IsValid() const { return epollfd != -1; }
+
+    /** Start watching hSocket, its events are reported with nData. Errors and hangups are always reported, regardless of nInterest. */
+    bool Add(SOCKET hSocket, uint8_t nInterest, uint64_t nData);
+    /** Change the interest of an already added socket */
+    bool Modify(SOCKET hSocket, uint8_t nInterest, uint64_t nData);
+
+    /** Wait up to nTimeoutMs for events and return them in events, one per ready socket */
+    bool Wait(int nTimeoutMs, std::vector<Event>& events);
+
+private:
+    int epollfd;
+    std::vector<struct epoll_event> vEvents;
+};
+#endif // USE_EPOLL
+
 class NetEventsInterface;
 class CConnman
 {
@@ -146,6 +213,7 @@ public:
         bool m_use_addrman_outgoing = true;
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
+        SocketEventsMode socketEventsMode = SOCKETEVENTS_SELECT;
     };
 
     void Init(const Options& connOptions) {
@@ -160,6 +228,7 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        socketEventsMode = connOptions.socketEventsMode;
         {
             LOCK(cs_totalBytesSent);
             nMaxOutboundTimeframe = connOptions.nMaxOutboundTimeframe;
@@ -387,6 +456,12 @@ public:
     unsigned int GetReceiveFloodSize() const;
 
     void WakeMessageHandler();
+
+    /** Make the socket handler recompute which events of the peer's socket it waits for with
+     * -socketevents=epoll. Has to be called after a peer is added to vNodes, and whenever its
+     * send queue may have become non-empty or fPauseRecv may have been cleared outside the
+     * socket handler thread. Does nothing with select(), which recomputes them on every wait. */
+    void RequestSocketEventsUpdate(CNode* pnode);
     
     
     
@@ -450,6 +525,14 @@ private:
     void ThreadOpenMasternodeConnections(std::vector<std::string> connect);
     void ThreadMessageHandler();
     void AcceptConnection(const ListenSocket& hListenSocket);
+    void SocketEventsSelect(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set);
+    void SocketHandlerSelect();
+#ifdef USE_EPOLL
+    void UpdateSocketEventsInterest(CNode* pnode);
+    void SocketHandlerEpoll();
+#endif
+    void SocketHandlerNode(CNode* pnode, bool recvSet, bool sendSet, bool errorSet);
+    void InactivityCheck(CNode* pnode);
     void ThreadSocketHandler();
     void ThreadDNSAddressSeed();
 
@@ -504,6 +587,19 @@ private:
     unsigned int nSendBufferMaxSize;
     unsigned int nReceiveFloodSize;
 
+    SocketEventsMode socketEventsMode;
+#ifdef USE_EPOLL
+    /** Only accessed by the socket handler thread while it runs, and by Start/Stop */
+    std::unique_ptr<CSocketEventsEpoll> socketEventsEpoll;
+    /** Peers registered with socketEventsEpoll by id, only accessed by the socket handler thread */
+    std::unordered_map<NodeId, CNode*> mapSocketEventsNodes;
+    /** Last time all peers were checked for inactivity, only accessed by the socket handler thread */
+    int64_t nLastInactivityCheck;
+#endif
+    /** Peers whose epoll interest may have changed, each holding a reference, see RequestSocketEventsUpdate */
+    CCriticalSection cs_vSocketEventsUpdate;
+    std::vector<CNode*> vSocketEventsUpdate GUARDED_BY(cs_vSocketEventsUpdate);
+
     std::vector<ListenSocket> vhListenSocket;
     std::atomic<bool> fNetworkActive;
     banmap_t setBanned;
@@ -798,6 +894,11 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv;
     std::atomic_bool fPauseSend;
+    // Interest last registered with the epoll backend, only used by the socket handler thread
+    bool fSocketEventsRegistered;
+    uint8_t nSocketEventsInterest;
+    // Whether the node is queued in CConnman::vSocketEventsUpdate
+    std::atomic_bool fSocketEventsUpdate;
 protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
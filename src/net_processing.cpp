@@ -851,8 +851,18 @@ static bool BlockRequestAllowed(const CBlockIndex* pindex, const Consensus::Para
         (GetBlockProofEquivalentTime(*pindexBestHeader, *pindex, *pindexBestHeader, consensusParams) < STALE_RELAY_AGE_LIMIT);
 }
 
-PeerLogicValidation::PeerLogicValidation(CConnman* connmanIn, CScheduler &scheduler, bool enable_bip61)
-    : connman(connmanIn), m_stale_tip_check_time(0), m_enable_bip61(enable_bip61) {
+PeerLogicValidation::PeerLogicValidation(CConnman* connmanIn, CScheduler &scheduler, bool enable_bip61, int nMasternodeMessageThreads)
+    : connman(connmanIn), m_stale_tip_check_time(0), m_enable_bip61(enable_bip61),
+      m_masternode_workers(MAX_MASTERNODE_MESSAGES_PER_PEER, [connmanIn](CPeerTaskQueue::PeerId) {
+          // The message handler may be waiting for room in the peer's queue, or for the peer's
+          // queue to drain before it goes on with the peer's other messages
+          connmanIn->WakeMessageHandler();
+      }),
+      m_masternode_workers_enabled(nMasternodeMessageThreads > 0) {
+
+    if (m_masternode_workers_enabled) {
+        m_masternode_workers.Start(nMasternodeMessageThreads, "machinecoin-mnmsg");
+    }
 
     // Initialize global variables that cannot be constructed at startup.
     recentRejects.reset(new CRollingBloomFilter(120000, 0.000001));
@@ -866,6 +876,16 @@ PeerLogicValidation::PeerLogicValidation(CConnman* connmanIn, CScheduler &schedu
     scheduler.scheduleEvery(std::bind(&PeerLogicValidation::CheckForStaleTipAndEvictPeers, this, consensusParams), EXTRA_PEER_CHECK_INTERVAL * 1000);
 }
 
+PeerLogicValidation::~PeerLogicValidation()
+{
+    StopMasternodeMessageWorkers();
+}
+
+void PeerLogicValidation::StopMasternodeMessageWorkers()
+{
+    m_masternode_workers.Stop();
+}
+
 /**
  * Evict orphan txn pool entries (EraseOrphanTx) based on a newly connected
  * block. Also save the time of the last tip update.
@@ -1078,12 +1098,12 @@ bool static AlreadyHave(const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
     */
 
     case MSG_MASTERNODE_PAYMENT_VOTE:
-        return mnpayments.mapMasternodePaymentVotes.count(inv.hash);
+        return mnpayments.HasPaymentVote(inv.hash);
 
     case MSG_MASTERNODE_PAYMENT_BLOCK:
         {
             BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-            return mi != mapBlockIndex.end() && mnpayments.mapMasternodeBlocks.find(mi->second->nHeight) != mnpayments.mapMasternodeBlocks.end();
+            return mi != mapBlockIndex.end() && mnpayments.HasPaymentBlock(mi->second->nHeight);
         }
 
     case MSG_MASTERNODE_ANNOUNCE:
@@ -1362,8 +1382,9 @@ void static ProcessGetData(CNode* pfrom, const CChainParams& chainparams, CConnm
 
             if (!push && inv.type == MSG_MASTERNODE_PAYMENT_VOTE) {
                 if (!deterministicMNManager->AreDeterministicMNsActive()) {
-                    if (mnpayments.HasVerifiedPaymentVote(inv.hash)) {
-                        connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, mnpayments.mapMasternodePaymentVotes[inv.hash]));
+                    CMasternodePaymentVote vote;
+                    if (mnpayments.GetVerifiedPaymentVote(inv.hash, vote)) {
+                        connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, vote));
                         push = true;
                     }
                 }
@@ -1372,15 +1393,10 @@ void static ProcessGetData(CNode* pfrom, const CChainParams& chainparams, CConnm
             if (!push && inv.type == MSG_MASTERNODE_PAYMENT_BLOCK) {
                 if (!deterministicMNManager->AreDeterministicMNsActive()) {
                     BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-                    LOCK(cs_mapMasternodeBlocks);
-                    if (mi != mapBlockIndex.end() && mnpayments.mapMasternodeBlocks.count(mi->second->nHeight)) {
-                        for (CMasternodePayee& payee : mnpayments.mapMasternodeBlocks[mi->second->nHeight].vecPayees) {
-                            std::vector<uint256> vecVoteHashes = payee.GetVoteHashes();
-                            for (uint256& hash : vecVoteHashes) {
-                                if(mnpayments.HasVerifiedPaymentVote(hash)) {
-                                    connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, mnpayments.mapMasternodePaymentVotes[hash]));
-                                }
-                            }
+                    std::vector<CMasternodePaymentVote> vecVotes;
+                    if (mi != mapBlockIndex.end() && mnpayments.GetVerifiedPaymentVotes(mi->second->nHeight, vecVotes)) {
+                        for (const CMasternodePaymentVote& vote : vecVotes) {
+                            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, vote));
                         }
                         push = true;
                     }
@@ -3244,6 +3260,73 @@ static bool SendRejectsAndCheckIfBanned(CNode* pnode, CConnman* connman, bool en
     return false;
 }
 
+/** Process a single message, logging instead of propagating errors in it */
+static bool ProcessMessageAndCatchErrors(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, unsigned int nMessageSize, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc, bool enable_bip61)
+{
+    bool fRet = false;
+    try
+    {
+        fRet = ProcessMessage(pfrom, strCommand, vRecv, nTimeReceived, chainparams, connman, interruptMsgProc, enable_bip61);
+    }
+    catch (const std::ios_base::failure& e)
+    {
+        if (enable_bip61) {
+            connman->PushMessage(pfrom, CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, std::string("error parsing message")));
+        }
+        if (strstr(e.what(), "end of data"))
+        {
+            // Allow exceptions from under-length message on vRecv
+            LogPrint(MCLog::NET, "%s(%s, %u bytes): Exception '%s' caught, normally caused by a message being shorter than its stated length\n", "ProcessMessages", SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else if (strstr(e.what(), "size too large"))
+        {
+            // Allow exceptions from over-long size
+            LogPrint(MCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", "ProcessMessages", SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else if (strstr(e.what(), "non-canonical ReadCompactSize()"))
+        {
+            // Allow exceptions from non-canonical encoding
+            LogPrint(MCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", "ProcessMessages", SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else
+        {
+            PrintExceptionContinue(&e, "ProcessMessages()");
+        }
+    }
+    catch (const std::exception& e) {
+        PrintExceptionContinue(&e, "ProcessMessages()");
+    } catch (...) {
+        PrintExceptionContinue(nullptr, "ProcessMessages()");
+    }
+
+    if (!fRet) {
+        LogPrint(MCLog::NET, "%s(%s, %u bytes) FAILED peer=%d\n", "ProcessMessages", SanitizeString(strCommand), nMessageSize, pfrom->GetId());
+    }
+
+    return fRet;
+}
+
+/**
+ * Messages processed by the masternode workers instead of the message handler thread. The
+ * sync requests and counts are processed there as well, so that they stay in order with the
+ * objects they request or count.
+ */
+static bool IsMasternodeWorkerMessage(const std::string& strCommand)
+{
+    return strCommand == NetMsgType::DSEG ||
+           strCommand == NetMsgType::SYNCSTATUSCOUNT ||
+           strCommand == NetMsgType::MNGOVERNANCESYNC ||
+           strCommand == NetMsgType::MNANNOUNCE ||
+           strCommand == NetMsgType::MNPING ||
+           strCommand == NetMsgType::MNVERIFY ||
+           strCommand == NetMsgType::MASTERNODEPAYMENTVOTE ||
+           strCommand == NetMsgType::MNGOVERNANCEOBJECT ||
+           strCommand == NetMsgType::MNGOVERNANCEOBJECTVOTE ||
+           strCommand == NetMsgType::QFCOMMITMENT ||
+           strCommand == NetMsgType::QCONTRIB ||
+           strCommand == NetMsgType::QDCOMMITMENT;
+}
+
 bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgProc)
 {
     const CChainParams& chainparams = Params();
@@ -3271,16 +3354,31 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
         return false;
 
     std::list<CNetMessage> msgs;
+    bool fResumeRecv = false;
     {
         LOCK(pfrom->cs_vProcessMsg);
         if (pfrom->vProcessMsg.empty())
             return false;
+        // The messages of a peer are processed one at a time and in order. While the masternode
+        // workers have messages of this peer queued or running, only more masternode messages are
+        // handed to them, as long as there is room. Anything else stays in the process queue, which
+        // pauses receiving from the peer once it grows too large (see fPauseRecv). The workers wake
+        // the message handler again when the peer's queue has room or is empty.
+        if (m_masternode_workers_enabled) {
+            size_t nWorkerQueueSize = m_masternode_workers.GetPeerQueueSize(pfrom->GetId());
+            if (nWorkerQueueSize > 0 &&
+                (nWorkerQueueSize >= MAX_MASTERNODE_MESSAGES_PER_PEER || !IsMasternodeWorkerMessage(pfrom->vProcessMsg.front().hdr.GetCommand())))
+                return false;
+        }
         // Just take one message
         msgs.splice(msgs.begin(), pfrom->vProcessMsg, pfrom->vProcessMsg.begin());
         pfrom->nProcessQueueSize -= msgs.front().vRecv.size() + CMessageHeader::HEADER_SIZE;
+        fResumeRecv = pfrom->fPauseRecv && pfrom->nProcessQueueSize <= connman->GetReceiveFloodSize();
         pfrom->fPauseRecv = pfrom->nProcessQueueSize > connman->GetReceiveFloodSize();
         fMoreWork = !pfrom->vProcessMsg.empty();
     }
+    if (fResumeRecv)
+        connman->RequestSocketEventsUpdate(pfrom);
     CNetMessage& msg(msgs.front());
 
     msg.SetVersion(pfrom->GetRecvVersion());
@@ -3315,50 +3413,42 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
         return fMoreWork;
     }
 
-    // Process message
-    bool fRet = false;
-    try
-    {
-        fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
-        if (interruptMsgProc)
+    if (m_masternode_workers_enabled && IsMasternodeWorkerMessage(strCommand)) {
+        // Hand the message over to the masternode workers. The node reference keeps
+        // it alive until the task ran or was dropped.
+        std::shared_ptr<CNode> pnode(pfrom->AddRef(), [](CNode* p) { p->Release(); });
+        auto pmsgs = std::make_shared<std::list<CNetMessage>>();
+        pmsgs->splice(pmsgs->begin(), msgs);
+        const bool enable_bip61 = m_enable_bip61;
+        CConnman* const connmanPtr = connman;
+        std::atomic<bool>* const pinterruptMsgProc = &interruptMsgProc;
+        bool fQueued = m_masternode_workers.Push(pfrom->GetId(), [pnode, pmsgs, strCommand, nMessageSize, connmanPtr, pinterruptMsgProc, enable_bip61] {
+            if (pnode->fDisconnect || *pinterruptMsgProc)
+                return;
+            CNetMessage& msg = pmsgs->front();
+            ProcessMessageAndCatchErrors(pnode.get(), strCommand, msg.vRecv, nMessageSize, msg.nTime, Params(), connmanPtr, *pinterruptMsgProc, enable_bip61);
+            LOCK(cs_main);
+            SendRejectsAndCheckIfBanned(pnode.get(), connmanPtr, enable_bip61);
+        });
+        if (!fQueued) {
+            // The workers are stopped or the peer's queue is full. Put the message back, it is
+            // retried the next time the peer's messages are processed.
+            LogPrint(MCLog::NET, "%s: masternode workers can't take %s, leaving it queued, peer=%d\n", __func__, SanitizeString(strCommand), pfrom->GetId());
+            LOCK(pfrom->cs_vProcessMsg);
+            pfrom->nProcessQueueSize += pmsgs->front().vRecv.size() + CMessageHeader::HEADER_SIZE;
+            pfrom->fPauseRecv = pfrom->nProcessQueueSize > connman->GetReceiveFloodSize();
+            pfrom->vProcessMsg.splice(pfrom->vProcessMsg.begin(), *pmsgs);
             return false;
-        if (!pfrom->vRecvGetData.empty())
-            fMoreWork = true;
-    }
-    catch (const std::ios_base::failure& e)
-    {
-        if (m_enable_bip61) {
-            connman->PushMessage(pfrom, CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, std::string("error parsing message")));
         }
-        if (strstr(e.what(), "end of data"))
-        {
-            // Allow exceptions from under-length message on vRecv
-            LogPrint(MCLog::NET, "%s(%s, %u bytes): Exception '%s' caught, normally caused by a message being shorter than its stated length\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-        }
-        else if (strstr(e.what(), "size too large"))
-        {
-            // Allow exceptions from over-long size
-            LogPrint(MCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-        }
-        else if (strstr(e.what(), "non-canonical ReadCompactSize()"))
-        {
-            // Allow exceptions from non-canonical encoding
-            LogPrint(MCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-        }
-        else
-        {
-            PrintExceptionContinue(&e, "ProcessMessages()");
-        }
-    }
-    catch (const std::exception& e) {
-        PrintExceptionContinue(&e, "ProcessMessages()");
-    } catch (...) {
-        PrintExceptionContinue(nullptr, "ProcessMessages()");
+        return fMoreWork;
     }
 
-    if (!fRet) {
-        LogPrint(MCLog::NET, "%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), nMessageSize, pfrom->GetId());
-    }
+    // Process message
+    ProcessMessageAndCatchErrors(pfrom, strCommand, vRecv, nMessageSize, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
+    if (interruptMsgProc)
+        return false;
+    if (!pfrom->vRecvGetData.empty())
+        fMoreWork = true;
 
     LOCK(cs_main);
     SendRejectsAndCheckIfBanned(pfrom, connman, m_enable_bip61);
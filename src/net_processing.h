@@ -7,6 +7,7 @@
 #define MACHINECOIN_NET_PROCESSING_H
 
 #include <net.h>
+#include <peertaskqueue.h>
 #include <validationinterface.h>
 #include <consensus/params.h>
 
@@ -16,6 +17,12 @@ static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
 /** Default for BIP61 (sending reject messages) */
 static constexpr bool DEFAULT_ENABLE_BIP61 = true;
+/** Default for -mnmsgthreads, number of threads processing masternode, governance and quorum messages */
+static const int DEFAULT_MASTERNODE_MESSAGE_THREADS = 2;
+/** Maximum for -mnmsgthreads */
+static const int MAX_MASTERNODE_MESSAGE_THREADS = 16;
+/** Maximum number of masternode, governance and quorum messages of a peer waiting for a worker, before we stop reading from it */
+static const size_t MAX_MASTERNODE_MESSAGES_PER_PEER = 100;
 
 /** Increase a node's misbehavior score. */
 void Misbehaving(NodeId nodeid, int howmuch, const std::string& message="");
@@ -25,7 +32,12 @@ private:
     CConnman* const connman;
 
 public:
-    explicit PeerLogicValidation(CConnman* connman, CScheduler &scheduler, bool enable_bip61);
+    /**
+     * @param[in]   nMasternodeMessageThreads   Number of threads processing masternode, governance and quorum
+     *                                          messages, or 0 to process them on the message handler thread
+     */
+    PeerLogicValidation(CConnman* connman, CScheduler &scheduler, bool enable_bip61, int nMasternodeMessageThreads = 0);
+    ~PeerLogicValidation();
 
     /**
      * Overridden from CValidationInterface.
@@ -43,6 +55,10 @@ public:
      * Overridden from CValidationInterface.
      */
     void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override;
+    /**
+     * Overridden from CValidationInterface.
+     */
+    std::string GetSubscriberName() const override { return "peerlogic"; }
 
     /** Initialize a peer by adding it to mapNodeState and pushing a message requesting its version */
     void InitializeNode(CNode* pnode) override;
@@ -70,11 +86,21 @@ public:
     /** If we have extra outbound peers, try to disconnect the one with the oldest block announcement */
     void EvictExtraOutboundPeers(int64_t time_in_seconds);
 
+    /** Stop the masternode message workers. Must be called before the nodes they may reference are deleted. */
+    void StopMasternodeMessageWorkers();
+
 private:
     int64_t m_stale_tip_check_time; //! Next time to check for stale tip
 
     /** Enable BIP61 (sending reject messages) */
     const bool m_enable_bip61;
+
+    /**
+     * Processes masternode, governance and quorum messages off the message handler
+     * thread, so that floods of them don't delay block and transaction relay.
+     */
+    CPeerTaskQueue m_masternode_workers;
+    const bool m_masternode_workers_enabled;
 };
 
 struct CNodeStateStats {
@@ -0,0 +1,135 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockstats.h>
+
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
+#include <primitives/block.h>
+#include <undo.h>
+
+#include <algorithm>
+#include <assert.h>
+
+template<typename T>
+static T CalculateTruncatedMedian(std::vector<T>& scores)
+{
+    size_t size = scores.size();
+    if (size == 0) {
+        return 0;
+    }
+
+    std::sort(scores.begin(), scores.end());
+    if (size % 2 == 0) {
+        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
+    } else {
+        return scores[size / 2];
+    }
+}
+
+void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight)
+{
+    if (scores.empty()) {
+        return;
+    }
+
+    std::sort(scores.begin(), scores.end());
+
+    // 10th, 25th, 50th, 75th, and 90th percentile weight units.
+    const double weights[NUM_GETBLOCKSTATS_PERCENTILES] = {
+        total_weight / 10.0, total_weight / 4.0, total_weight / 2.0, (total_weight * 3.0) / 4.0, (total_weight * 9.0) / 10.0
+    };
+
+    int64_t next_percentile_index = 0;
+    int64_t cumulative_weight = 0;
+    for (const auto& element : scores) {
+        cumulative_weight += element.second;
+        while (next_percentile_index < NUM_GETBLOCKSTATS_PERCENTILES && cumulative_weight >= weights[next_percentile_index]) {
+            result[next_percentile_index] = element.first;
+            ++next_percentile_index;
+        }
+    }
+
+    // Fill any remaining percentiles with the last value.
+    for (int64_t i = next_percentile_index; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
+        result[i] = scores.back().first;
+    }
+}
+
+// outpoint (needed for the utxo index) + nHeight + fCoinBase
+static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+
+void ComputeBlockStats(const CBlock& block, const CBlockUndo& blockUndo, CBlockStats& stats)
+{
+    stats = CBlockStats();
+    stats.nTxs = block.vtx.size();
+
+    CAmount minfee = MAX_MONEY;
+    CAmount minfeerate = MAX_MONEY;
+    int64_t mintxsize = MAX_BLOCK_SERIALIZED_SIZE;
+    std::vector<CAmount> fee_array;
+    std::vector<std::pair<CAmount, int64_t>> feerate_array;
+    std::vector<int64_t> txsize_array;
+
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        stats.nOutputs += tx.vout.size();
+
+        CAmount tx_total_out = 0;
+        for (const CTxOut& out : tx.vout) {
+            tx_total_out += out.nValue;
+            stats.nUTXOSizeIncrease += GetSerializeSize(out, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+        }
+
+        if (tx.IsCoinBase()) {
+            continue;
+        }
+
+        stats.nInputs += tx.vin.size(); // Don't count coinbase's fake input
+        stats.nTotalOut += tx_total_out; // Don't count coinbase reward
+
+        int64_t tx_size = tx.GetTotalSize();
+        txsize_array.push_back(tx_size);
+        stats.nMaxTxSize = std::max(stats.nMaxTxSize, tx_size);
+        mintxsize = std::min(mintxsize, tx_size);
+        stats.nTotalSize += tx_size;
+
+        int64_t weight = GetTransactionWeight(tx);
+        stats.nTotalWeight += weight;
+
+        if (tx.HasWitness()) {
+            ++stats.nSegWitTxs;
+            stats.nSegWitTotalSize += tx_size;
+            stats.nSegWitTotalWeight += weight;
+        }
+
+        // The spent outputs are taken from the undo data, which has an entry for every transaction but the coinbase
+        const CTxUndo& txundo = blockUndo.vtxundo.at(i - 1);
+        CAmount tx_total_in = 0;
+        for (const Coin& prevout : txundo.vprevout) {
+            tx_total_in += prevout.out.nValue;
+            stats.nUTXOSizeIncrease -= GetSerializeSize(prevout.out, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+        }
+
+        CAmount txfee = tx_total_in - tx_total_out;
+        assert(MoneyRange(txfee));
+        fee_array.push_back(txfee);
+        stats.nMaxFee = std::max(stats.nMaxFee, txfee);
+        minfee = std::min(minfee, txfee);
+        stats.nTotalFee += txfee;
+
+        // New feerate uses satoshis per virtual byte instead of per serialized byte
+        CAmount feerate = weight ? (txfee * WITNESS_SCALE_FACTOR) / weight : 0;
+        feerate_array.emplace_back(std::make_pair(feerate, weight));
+        stats.nMaxFeeRate = std::max(stats.nMaxFeeRate, feerate);
+        minfeerate = std::min(minfeerate, feerate);
+    }
+
+    stats.nMinFee = (minfee == MAX_MONEY) ? 0 : minfee;
+    stats.nMinFeeRate = (minfeerate == MAX_MONEY) ? 0 : minfeerate;
+    stats.nMinTxSize = mintxsize == MAX_BLOCK_SERIALIZED_SIZE ? 0 : mintxsize;
+    stats.nMedianFee = CalculateTruncatedMedian(fee_array);
+    stats.nMedianTxSize = CalculateTruncatedMedian(txsize_array);
+    CalculatePercentilesByWeight(stats.vFeeRatePercentiles, feerate_array, stats.nTotalWeight);
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_NODE_BLOCKSTATS_H
+#define MACHINECOIN_NODE_BLOCKSTATS_H
+
+#include <amount.h>
+#include <serialize.h>
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+class CBlock;
+class CBlockUndo;
+
+static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
+
+/** Used by getblockstats to get feerates at different percentiles by weight  */
+void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight);
+
+/** The statistics of the transactions of a block reported by getblockstats. Amounts are in satoshis. */
+struct CBlockStats
+{
+    //! Number of transactions, including the coinbase
+    int64_t nTxs = 0;
+    //! Number of inputs, excluding the coinbase
+    int64_t nInputs = 0;
+    int64_t nOutputs = 0;
+    //! Total amount of the outputs, excluding the coinbase
+    CAmount nTotalOut = 0;
+    CAmount nTotalFee = 0;
+    CAmount nMinFee = 0;
+    CAmount nMaxFee = 0;
+    CAmount nMedianFee = 0;
+    //! Feerates in satoshis per virtual byte
+    CAmount nMinFeeRate = 0;
+    CAmount nMaxFeeRate = 0;
+    CAmount vFeeRatePercentiles[NUM_GETBLOCKSTATS_PERCENTILES] = {};
+    //! Sizes and weights of the transactions, excluding the coinbase
+    int64_t nMinTxSize = 0;
+    int64_t nMaxTxSize = 0;
+    int64_t nMedianTxSize = 0;
+    int64_t nTotalSize = 0;
+    int64_t nTotalWeight = 0;
+    int64_t nSegWitTxs = 0;
+    int64_t nSegWitTotalSize = 0;
+    int64_t nSegWitTotalWeight = 0;
+    int64_t nUTXOSizeIncrease = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nTxs);
+        READWRITE(nInputs);
+        READWRITE(nOutputs);
+        READWRITE(nTotalOut);
+        READWRITE(nTotalFee);
+        READWRITE(nMinFee);
+        READWRITE(nMaxFee);
+        READWRITE(nMedianFee);
+        READWRITE(nMinFeeRate);
+        READWRITE(nMaxFeeRate);
+        for (CAmount& feerate : vFeeRatePercentiles) {
+            READWRITE(feerate);
+        }
+        READWRITE(nMinTxSize);
+        READWRITE(nMaxTxSize);
+        READWRITE(nMedianTxSize);
+        READWRITE(nTotalSize);
+        READWRITE(nTotalWeight);
+        READWRITE(nSegWitTxs);
+        READWRITE(nSegWitTotalSize);
+        READWRITE(nSegWitTotalWeight);
+        READWRITE(nUTXOSizeIncrease);
+    }
+};
+
+/** Compute the statistics of a block from the block and its undo data, which is empty for the genesis block */
+void ComputeBlockStats(const CBlock& block, const CBlockUndo& blockUndo, CBlockStats& stats);
+
+#endif // MACHINECOIN_NODE_BLOCKSTATS_H
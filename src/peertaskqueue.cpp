@@ -0,0 +1,146 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <peertaskqueue.h>
+
+#include <tinyformat.h>
+#include <util.h>
+
+#include <assert.h>
+
+CPeerTaskQueue::CPeerTaskQueue(size_t nMaxTasksPerPeerIn, Notify notifyIn) :
+    nMaxTasksPerPeer(nMaxTasksPerPeerIn),
+    notify(std::move(notifyIn))
+{
+}
+
+CPeerTaskQueue::~CPeerTaskQueue()
+{
+    Stop();
+}
+
+void CPeerTaskQueue::Start(int nThreads, const std::string& strThreadName)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    assert(threads.empty());
+    fStopped = false;
+    for (int i = 0; i < nThreads; i++) {
+        threads.emplace_back(&CPeerTaskQueue::ThreadWorker, this, strprintf("%s.%d", strThreadName, i));
+    }
+}
+
+void CPeerTaskQueue::Stop()
+{
+    std::vector<std::thread> threadsToJoin;
+    // Dropped tasks are destroyed outside of the lock
+    std::map<PeerId, PeerQueue> mapDropped;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fStopped = true;
+        threadsToJoin.swap(threads);
+        for (auto it = mapPeerQueues.begin(); it != mapPeerQueues.end();) {
+            nQueued -= it->second.tasks.size();
+            mapDropped[it->first].tasks.swap(it->second.tasks);
+            // The entries of running tasks are erased by their workers
+            if (it->second.fRunning) {
+                ++it;
+            } else {
+                it = mapPeerQueues.erase(it);
+            }
+        }
+        readyPeers.clear();
+    }
+    cond.notify_all();
+    for (std::thread& t : threadsToJoin) {
+        t.join();
+    }
+}
+
+bool CPeerTaskQueue::Push(PeerId peer, Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (fStopped) {
+            return false;
+        }
+        PeerQueue& q = mapPeerQueues[peer];
+        if (q.tasks.size() + q.fRunning >= nMaxTasksPerPeer) {
+            return false;
+        }
+        q.tasks.emplace_back(std::move(task));
+        nQueued++;
+        if (q.tasks.size() == 1 && !q.fRunning) {
+            readyPeers.push_back(peer);
+        }
+    }
+    cond.notify_one();
+    return true;
+}
+
+bool CPeerTaskQueue::IsPeerFull(PeerId peer) const
+{
+    return GetPeerQueueSize(peer) >= nMaxTasksPerPeer;
+}
+
+size_t CPeerTaskQueue::GetPeerQueueSize(PeerId peer) const
+{
+    std::lock_guard<std::mutex> lock(cs);
+    auto it = mapPeerQueues.find(peer);
+    if (it == mapPeerQueues.end()) {
+        return 0;
+    }
+    return it->second.tasks.size() + it->second.fRunning;
+}
+
+size_t CPeerTaskQueue::GetQueueSize() const
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return nQueued;
+}
+
+void CPeerTaskQueue::ThreadWorker(const std::string& strThreadName)
+{
+    RenameThread(strThreadName.c_str());
+
+    std::unique_lock<std::mutex> lock(cs);
+    while (true) {
+        cond.wait(lock, [this] { return fStopped || !readyPeers.empty(); });
+        if (fStopped) {
+            return;
+        }
+
+        PeerId peer = readyPeers.front();
+        readyPeers.pop_front();
+        PeerQueue& q = mapPeerQueues[peer];
+        assert(!q.fRunning && !q.tasks.empty());
+        Task task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        q.fRunning = true;
+
+        lock.unlock();
+        task();
+        task = nullptr;
+        lock.lock();
+
+        // q stays valid, entries are only erased by the thread running their task
+        bool fWasFull = q.tasks.size() + 1 >= nMaxTasksPerPeer;
+        bool fIdle = q.tasks.empty();
+        q.fRunning = false;
+        nQueued--;
+        if (!fIdle) {
+            if (!fStopped) {
+                readyPeers.push_back(peer);
+                cond.notify_one();
+            }
+        } else {
+            mapPeerQueues.erase(peer);
+        }
+
+        if ((fWasFull || fIdle) && notify) {
+            lock.unlock();
+            notify(peer);
+            lock.lock();
+        }
+    }
+}
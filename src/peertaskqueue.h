@@ -0,0 +1,76 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_PEERTASKQUEUE_H
+#define MACHINECOIN_PEERTASKQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Bounded pool of worker threads executing tasks on behalf of peers.
+ *
+ * Tasks of the same peer are executed in the order they were queued and never
+ * concurrently, while tasks of different peers are executed in parallel and
+ * served round-robin so that one busy peer cannot starve the others. Each peer
+ * can only have a limited number of tasks queued; callers are expected to stop
+ * reading from a peer while IsPeerFull() returns true, which propagates the
+ * back-pressure to the peer's connection. Callers that must not handle other
+ * work of a peer while it has tasks queued wait for GetPeerQueueSize() to
+ * drop to 0.
+ */
+class CPeerTaskQueue
+{
+public:
+    typedef int64_t PeerId;
+    typedef std::function<void()> Task;
+    /** Called without locks held after a task of a peer finished, if the peer was full or has no tasks left */
+    typedef std::function<void(PeerId)> Notify;
+
+    CPeerTaskQueue(size_t nMaxTasksPerPeerIn, Notify notifyIn = nullptr);
+    ~CPeerTaskQueue();
+
+    /** Start nThreads worker threads, whose names are derived from strThreadName */
+    void Start(int nThreads, const std::string& strThreadName);
+    /** Stop accepting tasks, drop the queued ones and wait for running tasks to finish */
+    void Stop();
+
+    /** Queue a task for a peer. Returns false if the queue is stopped or the peer is full. */
+    bool Push(PeerId peer, Task task);
+    /** Returns true if no more tasks can currently be queued for the peer */
+    bool IsPeerFull(PeerId peer) const;
+    /** Number of tasks queued or running for the peer */
+    size_t GetPeerQueueSize(PeerId peer) const;
+    /** Number of tasks queued or running for all peers */
+    size_t GetQueueSize() const;
+
+private:
+    struct PeerQueue {
+        std::deque<Task> tasks;
+        bool fRunning{false};
+    };
+
+    void ThreadWorker(const std::string& strThreadName);
+
+    const size_t nMaxTasksPerPeer;
+    const Notify notify;
+
+    mutable std::mutex cs;
+    std::condition_variable cond;
+    std::map<PeerId, PeerQueue> mapPeerQueues;
+    /** Peers that have tasks queued and no task running, in the order they will be served */
+    std::deque<PeerId> readyPeers;
+    size_t nQueued{0};
+    bool fStopped{true};
+    std::vector<std::thread> threads;
+};
+
+#endif // MACHINECOIN_PEERTASKQUEUE_H
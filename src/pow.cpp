@@ -12,6 +12,74 @@
 #include <util.h>
 #include <validation.h>
 
+#include <mutex>
+
+namespace {
+
+/**
+ * Memo of the last value computed for a block. The memo is keyed by the block
+ * hash, which commits to all ancestors, so it stays valid if block index
+ * entries are freed and others allocated at the same address. Blocks without
+ * a hash, like the ones unit tests build, are not memoized.
+ */
+class CBlockMemo
+{
+private:
+    std::mutex mutex;
+    uint256 hashBlock;
+    const Consensus::Params* pparams = nullptr;
+    unsigned int nValue = 0;
+
+public:
+    bool Get(const CBlockIndex* pindex, const Consensus::Params& params, unsigned int& nValueOut)
+    {
+        if (!pindex->phashBlock) return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pparams != &params || hashBlock != *pindex->phashBlock) return false;
+        nValueOut = nValue;
+        return true;
+    }
+
+    void Set(const CBlockIndex* pindex, const Consensus::Params& params, unsigned int nValueIn)
+    {
+        if (!pindex->phashBlock) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        hashBlock = *pindex->phashBlock;
+        pparams = &params;
+        nValue = nValueIn;
+    }
+};
+
+/** Retarget at the last difficulty adjustment interval boundary, per algorithm */
+CBlockMemo memoRetargetV1;
+CBlockMemo memoRetargetV2;
+/** Last non-special-min-difficulty-rules-block bits, per algorithm */
+CBlockMemo memoMinDifficultyV1;
+CBlockMemo memoMinDifficultyV2;
+
+/**
+ * Return the bits of the last block before or at pindexLast which is not a
+ * special-min-difficulty-rules block, stopping at the start of the interval.
+ * Header sync asks for one block after the other, so the walk usually ends
+ * one block back, at the memoized result for the parent.
+ */
+unsigned int GetLastNonMinDifficultyBits(const CBlockIndex* pindexLast, int64_t nInterval, unsigned int nProofOfWorkLimit, CBlockMemo& memo, const Consensus::Params& params)
+{
+    unsigned int nBits;
+    const CBlockIndex* pindex = pindexLast;
+    while (pindex->pprev && pindex->nHeight % nInterval != 0 && pindex->nBits == nProofOfWorkLimit) {
+        if (memo.Get(pindex, params, nBits)) {
+            memo.Set(pindexLast, params, nBits);
+            return nBits;
+        }
+        pindex = pindex->pprev;
+    }
+    memo.Set(pindexLast, params, pindex->nBits);
+    return pindex->nBits;
+}
+
+} // namespace
+
 // Machinecoin: Select retargeting
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
 {
@@ -60,10 +128,7 @@ unsigned int GetNextWorkRequired_V1(const CBlockIndex* pindexLast, const CBlockH
             else
             {
                 // Return the last non-special-min-difficulty-rules-block
-                const CBlockIndex* pindex = pindexLast;
-                while (pindex->pprev && pindex->nHeight % params.DifficultyAdjustmentInterval() != 0 && pindex->nBits == nProofOfWorkLimit)
-                    pindex = pindex->pprev;
-                return pindex->nBits;
+                return GetLastNonMinDifficultyBits(pindexLast, params.DifficultyAdjustmentInterval(), nProofOfWorkLimit, memoMinDifficultyV1, params);
             }
         }
         return pindexLast->nBits;
@@ -71,17 +136,21 @@ unsigned int GetNextWorkRequired_V1(const CBlockIndex* pindexLast, const CBlockH
 
     // Machinecoin: This fixes an issue where a 51% attack can change difficulty at will.
     // Go back the full period unless it's the first retarget after genesis. Code courtesy of Art Forz
+    unsigned int nBits;
+    if (memoRetargetV1.Get(pindexLast, params, nBits))
+        return nBits;
+
     int blockstogoback = params.DifficultyAdjustmentInterval()-1;
     if ((pindexLast->nHeight+1) != params.DifficultyAdjustmentInterval())
         blockstogoback = params.DifficultyAdjustmentInterval();
 
     // Go back by what we want to be 14 days worth of blocks
-    const CBlockIndex* pindexFirst = pindexLast;
-    for (int i = 0; pindexFirst && i < blockstogoback; i++)
-        pindexFirst = pindexFirst->pprev;
+    const CBlockIndex* pindexFirst = pindexLast->GetAncestor(pindexLast->nHeight - blockstogoback);
     assert(pindexFirst);
 
-    return CalculateNextWorkRequired(pindexLast, pindexFirst->GetBlockTime(), params);
+    nBits = CalculateNextWorkRequired(pindexLast, pindexFirst->GetBlockTime(), params);
+    memoRetargetV1.Set(pindexLast, params, nBits);
+    return nBits;
 }
 
 // DigiShield retargeting
@@ -106,10 +175,7 @@ unsigned int GetNextWorkRequired_V2(const CBlockIndex* pindexLast, const CBlockH
             else
             {
                 // Return the last non-special-min-difficulty-rules-block
-                const CBlockIndex* pindex = pindexLast;
-                while (pindex->pprev && pindex->nHeight % params.DifficultyAdjustmentIntervalV2() != 0 && pindex->nBits == nProofOfWorkLimit)
-                    pindex = pindex->pprev;
-                return pindex->nBits;
+                return GetLastNonMinDifficultyBits(pindexLast, params.DifficultyAdjustmentIntervalV2(), nProofOfWorkLimit, memoMinDifficultyV2, params);
             }
         }
         return pindexLast->nBits;
@@ -117,26 +183,31 @@ unsigned int GetNextWorkRequired_V2(const CBlockIndex* pindexLast, const CBlockH
 
     // Machinecoin: This fixes an issue where a 51% attack can change difficulty at will.
     // Go back the full period unless it's the first retarget after genesis. Code courtesy of Art Forz
+    unsigned int nBits;
+    if (memoRetargetV2.Get(pindexLast, params, nBits))
+        return nBits;
+
     int blockstogoback = params.DifficultyAdjustmentIntervalV2()-1;
     if ((pindexLast->nHeight+1) != params.DifficultyAdjustmentIntervalV2())
         blockstogoback = params.DifficultyAdjustmentIntervalV2();
 
     // Go back by what we want to be 14 days worth of blocks
-    const CBlockIndex* pindexFirst = pindexLast;
-    for (int i = 0; pindexFirst && i < blockstogoback; i++)
-        pindexFirst = pindexFirst->pprev;
+    const CBlockIndex* pindexFirst = pindexLast->GetAncestor(pindexLast->nHeight - blockstogoback);
     assert(pindexFirst);
 
-    return CalculateNextWorkRequired(pindexLast, pindexFirst->GetBlockTime(), params);
+    nBits = CalculateNextWorkRequired(pindexLast, pindexFirst->GetBlockTime(), params);
+    memoRetargetV2.Set(pindexLast, params, nBits);
+    return nBits;
 }
 
 // Retargeting to support the PoW change phase (V3)
 unsigned int GetNextWorkRequired_V3(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
 {
+    const unsigned int nBitsV2 = GetNextWorkRequired_V2(pindexLast, pblock, params);
 
-    if (pblock->GetBlockTime() - pindexLast->GetBlockTime() >= 300 && pblock->nBits != GetNextWorkRequired_V2(pindexLast, pblock, params)){
+    if (pblock->GetBlockTime() - pindexLast->GetBlockTime() >= 300 && pblock->nBits != nBitsV2){
         arith_uint256 bnNew;
-        bnNew.SetCompact(GetNextWorkRequired_V2(pindexLast, pblock, params));
+        bnNew.SetCompact(nBitsV2);
         bool fShift = false;
 
         for (int i=0; i <= (pblock->GetBlockTime() -  pindexLast->GetBlockTime()) / 150; i++)
@@ -163,7 +234,7 @@ unsigned int GetNextWorkRequired_V3(const CBlockIndex* pindexLast, const CBlockH
 
         return bnNew.GetCompact();
     }
-    else return GetNextWorkRequired_V2(pindexLast, pblock, params);
+    else return nBitsV2;
 }
 
 // Machinecoin: Select retargeting
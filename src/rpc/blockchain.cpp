@@ -8,25 +8,35 @@
 #include <amount.h>
 #include <base58.h>
 #include <chain.h>
+#include <blockfilter.h>
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <coins.h>
 #include <consensus/validation.h>
 #include <validation.h>
 #include <core_io.h>
+#include <index/addressindex.h>
+#include <index/blockfilterindex.h>
+#include <index/blockstatsindex.h>
+#include <index/coinstatsindex.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <key_io.h>
+#include <node/blockstats.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
+#include <random.h>
 #include <rpc/server.h>
 #include <script/descriptor.h>
 #include <streams.h>
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <undo.h>
 #include <util.h>
 #include <utilstrencodings.h>
+#include <utxosnapshot.h>
 #include <hash.h>
 #include <validationinterface.h>
 #include <warnings.h>
@@ -43,6 +53,8 @@
 #include <boost/thread/thread.hpp> // boost::thread::interrupt
 
 #include <memory>
+#include <thread>
+#include <unordered_set>
 #include <mutex>
 #include <condition_variable>
 
@@ -350,6 +362,39 @@ static UniValue syncwithvalidationinterfacequeue(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
+static UniValue getvalidationinterfaceinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 0) {
+        throw std::runtime_error(
+            "getvalidationinterfaceinfo\n"
+            "\nReturns the callback queues of the subscribers to validation events.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"name\": \"xxxx\",         (string) The name of the subscriber\n"
+            "    \"pending\": n,            (numeric) The number of callbacks waiting to be delivered\n"
+            "    \"peak_pending\": n,       (numeric) The largest number of callbacks which were waiting at once\n"
+            "    \"delivered\": n           (numeric) The number of callbacks delivered so far\n"
+            "  },\n"
+            "  ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getvalidationinterfaceinfo","")
+            + HelpExampleRpc("getvalidationinterfaceinfo","")
+        );
+    }
+    UniValue ret(UniValue::VARR);
+    for (const ValidationInterfaceQueueInfo& info : GetMainSignals().GetQueueInfo()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("name", info.name);
+        obj.pushKV("pending", (uint64_t)info.pending);
+        obj.pushKV("peak_pending", (uint64_t)info.peak_pending);
+        obj.pushKV("delivered", info.delivered);
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
 static UniValue getdifficulty(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -973,46 +1018,196 @@ static UniValue pruneblockchain(const JSONRPCRequest& request)
 
 static UniValue gettxoutsetinfo(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() != 0)
+    if (request.fHelp || request.params.size() > 2)
         throw std::runtime_error(
-            "gettxoutsetinfo\n"
+            "gettxoutsetinfo ( \"hash_type\" hash_or_height )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "Note this call may take some time, unless the statistics are looked up in the coin stats index (-coinstatsindex).\n"
+            "\nArguments:\n"
+            "1. \"hash_type\"          (string, optional, default=hash_serialized_2) Which UTXO set hash should be calculated.\n"
+            "                          \"hash_serialized_2\" scans the UTXO set, \"muhash\" and \"none\" require -coinstatsindex.\n"
+            "2. hash_or_height       (string or numeric, optional) The block hash or height of the target block, with -coinstatsindex only.\n"
+            "                          Defaults to the last block processed by the index.\n"
             "\nResult:\n"
             "{\n"
-            "  \"height\":n,     (numeric) The current block height (index)\n"
-            "  \"bestblock\": \"hex\",   (string) The hash of the block at the tip of the chain\n"
+            "  \"height\":n,     (numeric) The block height (index)\n"
+            "  \"bestblock\": \"hex\",   (string) The hash of the block\n"
             "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs\n"
             "  \"txouts\": n,            (numeric) The number of unspent transaction outputs\n"
             "  \"bogosize\": n,          (numeric) A meaningless metric for UTXO set size\n"
-            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash\n"
-            "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk\n"
+            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash (only with hash_type hash_serialized_2)\n"
+            "  \"muhash\": \"hash\",      (string) The MuHash3072 of the unspent outputs (only with hash_type muhash)\n"
+            "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk (not for past blocks)\n"
             "  \"total_amount\": x.xxx          (numeric) The total amount\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gettxoutsetinfo", "")
+            + HelpExampleCli("gettxoutsetinfo", "\"muhash\" 1000")
             + HelpExampleRpc("gettxoutsetinfo", "")
         );
 
     UniValue ret(UniValue::VOBJ);
 
-    CCoinsStats stats;
-    FlushStateToDisk();
-    if (GetUTXOStats(pcoinsdbview.get(), stats)) {
-        ret.pushKV("height", (int64_t)stats.nHeight);
-        ret.pushKV("bestblock", stats.hashBlock.GetHex());
-        ret.pushKV("transactions", (int64_t)stats.nTransactions);
-        ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
-        ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
-        ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
-        ret.pushKV("disk_size", stats.nDiskSize);
-        ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
-    } else {
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+    const std::string hash_type = request.params[0].isNull() ? "hash_serialized_2" : request.params[0].get_str();
+    if (hash_type == "hash_serialized_2") {
+        if (!request.params[1].isNull()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "hash_serialized_2 hash type cannot be queried for a specific block");
+        }
+
+        CCoinsStats stats;
+        FlushStateToDisk();
+        if (GetUTXOStats(pcoinsdbview.get(), stats)) {
+            ret.pushKV("height", (int64_t)stats.nHeight);
+            ret.pushKV("bestblock", stats.hashBlock.GetHex());
+            ret.pushKV("transactions", (int64_t)stats.nTransactions);
+            ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
+            ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
+            ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
+            ret.pushKV("disk_size", stats.nDiskSize);
+            ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
+        } else {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+        }
+        return ret;
+    }
+
+    if (hash_type != "muhash" && hash_type != "none") {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s is not a valid hash_type", hash_type));
+    }
+    if (!g_coinstatsindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Querying the UTXO set statistics requires -coinstatsindex");
+    }
+    if (!g_coinstatsindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The coin stats index is still in the process of being built");
+    }
+
+    const CBlockIndex* pindex;
+    {
+        LOCK(cs_main);
+        if (request.params[1].isNull()) {
+            // The index may not have processed the latest blocks yet
+            pindex = g_coinstatsindex->GetBestBlockIndex();
+            if (!pindex) {
+                throw JSONRPCError(RPC_MISC_ERROR, "The coin stats index is still in the process of being built");
+            }
+        } else if (request.params[1].isNum()) {
+            const int height = request.params[1].get_int();
+            if (height < 0 || height > chainActive.Height()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d out of range", height));
+            }
+            pindex = chainActive[height];
+        } else {
+            pindex = LookupBlockIndex(ParseHashV(request.params[1], "hash_or_height"));
+            if (!pindex) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+            }
+        }
     }
+
+    CIndexedCoinsStats stats;
+    if (!g_coinstatsindex->LookupStats(pindex, stats)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Statistics of the block not found. The block was not connected while the index was enabled.");
+    }
+    ret.pushKV("height", (int64_t)pindex->nHeight);
+    ret.pushKV("bestblock", pindex->GetBlockHash().GetHex());
+    ret.pushKV("transactions", (int64_t)stats.nTransactions);
+    ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
+    ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
+    if (hash_type == "muhash") {
+        ret.pushKV("muhash", stats.hashMuHash.GetHex());
+    }
+    if (request.params[1].isNull()) {
+        ret.pushKV("disk_size", (int64_t)pcoinsdbview->EstimateSize());
+    }
+    ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
     return ret;
 }
 
+static UniValue UTXOSnapshotInfoToJSON(const CUTXOSnapshotInfo& info, const fs::path& path)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("base_hash", info.hashBaseBlock.GetHex());
+    ret.pushKV("base_height", info.nBaseHeight);
+    ret.pushKV("coins", (int64_t)info.nCoins);
+    ret.pushKV("mnlists", (int64_t)info.nMNLists);
+    ret.pushKV("quorum_commitments", (int64_t)info.nQuorumCommitments);
+    ret.pushKV("hash", info.hashContents.GetHex());
+    ret.pushKV("path", path.string());
+    return ret;
+}
+
+static UniValue dumptxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "dumptxoutset \"path\"\n"
+            "\nWrites the unspent transaction output set at the chain tip to a snapshot file, together with\n"
+            "the block headers and the deterministic masternode and quorum state. The snapshot can be loaded\n"
+            "into a new node with loadtxoutset. Note this call may take some time.\n"
+            "\nArguments:\n"
+            "1. \"path\"         (string, required) The file to write, relative to the data directory unless absolute. It must not exist.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"base_hash\": \"hash\",   (string) The hash of the block the snapshot is based on\n"
+            "  \"base_height\": n,      (numeric) The height of the base block\n"
+            "  \"coins\": n,            (numeric) The number of unspent transaction outputs written\n"
+            "  \"mnlists\": n,          (numeric) The number of deterministic masternode lists written\n"
+            "  \"quorum_commitments\": n, (numeric) The number of mined quorum commitments written\n"
+            "  \"hash\": \"hash\",        (string) The hash of the snapshot contents, which loadtxoutset accepts once it is pinned\n"
+            "  \"path\": \"path\"         (string) The absolute path of the snapshot\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+
+    const fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    CUTXOSnapshotInfo info;
+    std::string strError;
+    if (!DumpUTXOSnapshot(Params(), path, info, strError)) {
+        throw JSONRPCError(RPC_MISC_ERROR, strError);
+    }
+    return UTXOSnapshotInfoToJSON(info, path);
+}
+
+static UniValue loadtxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "loadtxoutset \"path\"\n"
+            "\nLoads a snapshot written by dumptxoutset and makes its base block the chain tip, without\n"
+            "downloading or validating the blocks before it. The node must not have connected any block\n"
+            "yet, so start it with -connect=0 and restart it normally once the snapshot is loaded.\n"
+            "Blocks before the base block are treated as valid and final, they aren't validated in the\n"
+            "background either. -txindex is not supported.\n"
+            "Only snapshots whose hash is pinned in the chain parameters for the height of their base block\n"
+            "are accepted.\n"
+            "\nArguments:\n"
+            "1. \"path\"         (string, required) The snapshot file, relative to the data directory unless absolute\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"base_hash\": \"hash\",   (string) The hash of the block the snapshot is based on\n"
+            "  \"base_height\": n,      (numeric) The height of the base block\n"
+            "  \"coins\": n,            (numeric) The number of unspent transaction outputs loaded\n"
+            "  \"mnlists\": n,          (numeric) The number of deterministic masternode lists loaded\n"
+            "  \"quorum_commitments\": n, (numeric) The number of mined quorum commitments loaded\n"
+            "  \"hash\": \"hash\",        (string) The hash of the snapshot contents\n"
+            "  \"path\": \"path\"         (string) The absolute path of the snapshot\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("loadtxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("loadtxoutset", "\"utxo.dat\"")
+        );
+
+    const fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    CUTXOSnapshotInfo info;
+    std::string strError;
+    if (!LoadUTXOSnapshot(Params(), path, info, strError)) {
+        throw JSONRPCError(RPC_MISC_ERROR, strError);
+    }
+    return UTXOSnapshotInfoToJSON(info, path);
+}
+
 UniValue gettxout(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 2 || request.params.size() > 3)
@@ -1637,62 +1832,128 @@ static UniValue getchaintxstats(const JSONRPCRequest& request)
     return ret;
 }
 
-template<typename T>
-static T CalculateTruncatedMedian(std::vector<T>& scores)
+//! Maximum number of blocks getblockstats returns the statistics of in one call
+static constexpr int MAX_GETBLOCKSTATS_RANGE = 10000;
+//! Maximum number of threads reading blocks for getblockstats
+static constexpr int MAX_GETBLOCKSTATS_THREADS = 8;
+
+static UniValue BlockStatsToJSON(const CBlockIndex* pindex, const CBlockStats& stats)
 {
-    size_t size = scores.size();
-    if (size == 0) {
-        return 0;
+    UniValue feerates_res(UniValue::VARR);
+    for (int64_t i = 0; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
+        feerates_res.push_back(stats.vFeeRatePercentiles[i]);
     }
 
-    std::sort(scores.begin(), scores.end());
-    if (size % 2 == 0) {
-        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
-    } else {
-        return scores[size / 2];
-    }
+    UniValue ret_all(UniValue::VOBJ);
+    ret_all.pushKV("avgfee", (stats.nTxs > 1) ? stats.nTotalFee / (stats.nTxs - 1) : 0);
+    ret_all.pushKV("avgfeerate", stats.nTotalWeight ? (stats.nTotalFee * WITNESS_SCALE_FACTOR) / stats.nTotalWeight : 0); // Unit: sat/vbyte
+    ret_all.pushKV("avgtxsize", (stats.nTxs > 1) ? stats.nTotalSize / (stats.nTxs - 1) : 0);
+    ret_all.pushKV("blockhash", pindex->GetBlockHash().GetHex());
+    ret_all.pushKV("feerate_percentiles", feerates_res);
+    ret_all.pushKV("height", (int64_t)pindex->nHeight);
+    ret_all.pushKV("ins", stats.nInputs);
+    ret_all.pushKV("maxfee", stats.nMaxFee);
+    ret_all.pushKV("maxfeerate", stats.nMaxFeeRate);
+    ret_all.pushKV("maxtxsize", stats.nMaxTxSize);
+    ret_all.pushKV("medianfee", stats.nMedianFee);
+    ret_all.pushKV("mediantime", pindex->GetMedianTimePast());
+    ret_all.pushKV("mediantxsize", stats.nMedianTxSize);
+    ret_all.pushKV("minfee", stats.nMinFee);
+    ret_all.pushKV("minfeerate", stats.nMinFeeRate);
+    ret_all.pushKV("mintxsize", stats.nMinTxSize);
+    ret_all.pushKV("outs", stats.nOutputs);
+    ret_all.pushKV("subsidy", GetBlockSubsidy(pindex->nHeight, Params().GetConsensus()));
+    ret_all.pushKV("swtotal_size", stats.nSegWitTotalSize);
+    ret_all.pushKV("swtotal_weight", stats.nSegWitTotalWeight);
+    ret_all.pushKV("swtxs", stats.nSegWitTxs);
+    ret_all.pushKV("time", pindex->GetBlockTime());
+    ret_all.pushKV("total_out", stats.nTotalOut);
+    ret_all.pushKV("total_size", stats.nTotalSize);
+    ret_all.pushKV("total_weight", stats.nTotalWeight);
+    ret_all.pushKV("totalfee", stats.nTotalFee);
+    ret_all.pushKV("txs", stats.nTxs);
+    ret_all.pushKV("utxo_increase", stats.nOutputs - stats.nInputs);
+    ret_all.pushKV("utxo_size_inc", stats.nUTXOSizeIncrease);
+    return ret_all;
 }
 
-void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight)
+/** Get the statistics of a block from the block stats index, or compute them from the block and undo data on disk */
+static void GetBlockStats(const CBlockIndex* pindex, CBlockStats& stats)
 {
-    if (scores.empty()) {
+    if (g_blockstatsindex && g_blockstatsindex->LookupStats(pindex, stats)) {
         return;
     }
 
-    std::sort(scores.begin(), scores.end());
+    // Whether the block is pruned is checked holding cs_main before
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+    CBlockUndo blockUndo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(blockUndo, pindex)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Undo data not found on disk");
+    }
+    if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Undo data doesn't match the block");
+    }
+    ComputeBlockStats(block, blockUndo, stats);
+}
 
-    // 10th, 25th, 50th, 75th, and 90th percentile weight units.
-    const double weights[NUM_GETBLOCKSTATS_PERCENTILES] = {
-        total_weight / 10.0, total_weight / 4.0, total_weight / 2.0, (total_weight * 3.0) / 4.0, (total_weight * 9.0) / 10.0
+/** Get the statistics of several blocks, reading the blocks concurrently */
+static void GetBlockStats(const std::vector<const CBlockIndex*>& blocks, std::vector<CBlockStats>& stats)
+{
+    stats.assign(blocks.size(), CBlockStats());
+
+    std::atomic<size_t> next_block{0};
+    std::atomic<bool> failed{false};
+    std::mutex cs_error;
+    UniValue error;
+    auto get_stats = [&] {
+        size_t i;
+        while (!failed && (i = next_block++) < blocks.size()) {
+            try {
+                GetBlockStats(blocks[i], stats[i]);
+            } catch (const UniValue& e) {
+                std::lock_guard<std::mutex> lock(cs_error);
+                if (!failed) error = e;
+                failed = true;
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(cs_error);
+                if (!failed) error = JSONRPCError(RPC_INTERNAL_ERROR, e.what());
+                failed = true;
+            }
+        }
     };
 
-    int64_t next_percentile_index = 0;
-    int64_t cumulative_weight = 0;
-    for (const auto& element : scores) {
-        cumulative_weight += element.second;
-        while (next_percentile_index < NUM_GETBLOCKSTATS_PERCENTILES && cumulative_weight >= weights[next_percentile_index]) {
-            result[next_percentile_index] = element.first;
-            ++next_percentile_index;
-        }
+    // This thread reads blocks as well
+    std::vector<std::thread> threads;
+    const int num_threads = std::max(1, std::min<int>({GetNumCores(), MAX_GETBLOCKSTATS_THREADS, (int)blocks.size()}));
+    for (int i = 1; i < num_threads; ++i) {
+        threads.emplace_back(&TraceThread<std::function<void()>>, "blockstats", get_stats);
+    }
+    get_stats();
+    for (std::thread& thread : threads) {
+        thread.join();
     }
 
-    // Fill any remaining percentiles with the last value.
-    for (int64_t i = next_percentile_index; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
-        result[i] = scores.back().first;
+    if (failed) {
+        throw error;
     }
 }
 
-template<typename T>
-static inline bool SetHasKeys(const std::set<T>& set) {return false;}
-template<typename T, typename Tk, typename... Args>
-static inline bool SetHasKeys(const std::set<T>& set, const Tk& key, const Args&... args)
+static const CBlockIndex* ParseBlockStatsHeight(const UniValue& param)
 {
-    return (set.count(key) != 0) || SetHasKeys(set, args...);
+    const int height = param.get_int();
+    const int current_tip = chainActive.Height();
+    if (height < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
+    }
+    if (height > current_tip) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
+    }
+    return chainActive[height];
 }
 
-// outpoint (needed for the utxo index) + nHeight + fCoinBase
-static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
-
 static UniValue getblockstats(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 4) {
@@ -1700,16 +1961,17 @@ static UniValue getblockstats(const JSONRPCRequest& request)
             "getblockstats hash_or_height ( stats )\n"
             "\nCompute per block statistics for a given window. All amounts are in satoshis.\n"
             "It won't work for some heights with pruning.\n"
-            "It won't work without -txindex for utxo_size_inc, *fee or *feerate stats.\n"
+            "The statistics are looked up in the block stats index if it is enabled (-blockstatsindex).\n"
             "\nArguments:\n"
-            "1. \"hash_or_height\"     (string or numeric, required) The block hash or height of the target block\n"
+            "1. \"hash_or_height\"     (string, numeric or array, required) The block hash or height of the target block,\n"
+            "                        or an array [first_height, last_height] of at most " + std::to_string(MAX_GETBLOCKSTATS_RANGE) + " blocks\n"
             "2. \"stats\"              (array,  optional) Values to plot, by default all values (see result below)\n"
             "    [\n"
             "      \"height\",         (string, optional) Selected statistic\n"
             "      \"time\",           (string, optional) Selected statistic\n"
             "      ,...\n"
             "    ]\n"
-            "\nResult:\n"
+            "\nResult (for a height range, an array of these objects in ascending order of height):\n"
             "{                           (json object)\n"
             "  \"avgfee\": xxxxx,          (numeric) Average fee in the block\n"
             "  \"avgfeerate\": xxxxx,      (numeric) Average feerate (in satoshis per virtual byte)\n"
@@ -1749,213 +2011,89 @@ static UniValue getblockstats(const JSONRPCRequest& request)
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getblockstats", "1000 '[\"minfeerate\",\"avgfeerate\"]'")
+            + HelpExampleCli("getblockstats", "'[1000, 1999]' '[\"totalfee\"]'")
             + HelpExampleRpc("getblockstats", "1000 '[\"minfeerate\",\"avgfeerate\"]'")
         );
     }
 
-    LOCK(cs_main);
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(cs_main);
 
-    CBlockIndex* pindex;
-    if (request.params[0].isNum()) {
-        const int height = request.params[0].get_int();
-        const int current_tip = chainActive.Height();
-        if (height < 0) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
-        }
-        if (height > current_tip) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
+        if (request.params[0].isArray()) {
+            const UniValue& range = request.params[0].get_array();
+            if (range.size() != 2) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Height range must be an array [first_height, last_height]");
+            }
+            const CBlockIndex* pfirst = ParseBlockStatsHeight(range[0]);
+            const CBlockIndex* plast = ParseBlockStatsHeight(range[1]);
+            if (pfirst->nHeight > plast->nHeight) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "First height of the range is after the last height");
+            }
+            if (plast->nHeight - pfirst->nHeight >= MAX_GETBLOCKSTATS_RANGE) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Height range exceeds %d blocks", MAX_GETBLOCKSTATS_RANGE));
+            }
+            for (int height = pfirst->nHeight; height <= plast->nHeight; ++height) {
+                blocks.push_back(chainActive[height]);
+            }
+        } else if (request.params[0].isNum()) {
+            blocks.push_back(ParseBlockStatsHeight(request.params[0]));
+        } else {
+            const std::string strHash = request.params[0].get_str();
+            const uint256 hash(uint256S(strHash));
+            const CBlockIndex* pindex = LookupBlockIndex(hash);
+            if (!pindex) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+            }
+            if (!chainActive.Contains(pindex)) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
+            }
+            blocks.push_back(pindex);
         }
 
-        pindex = chainActive[height];
-    } else {
-        const std::string strHash = request.params[0].get_str();
-        const uint256 hash(uint256S(strHash));
-        pindex = LookupBlockIndex(hash);
-        if (!pindex) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-        }
-        if (!chainActive.Contains(pindex)) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
+        for (const CBlockIndex* pindex : blocks) {
+            if (IsBlockPruned(pindex)) {
+                throw JSONRPCError(RPC_MISC_ERROR, strprintf("Block %d not available (pruned data)", pindex->nHeight));
+            }
         }
     }
 
-    assert(pindex != nullptr);
-
     std::set<std::string> stats;
     if (!request.params[1].isNull()) {
+        // Every block has the same fields, check the names before reading any blocks
+        const UniValue valid_stats = BlockStatsToJSON(blocks.front(), CBlockStats());
         const UniValue stats_univalue = request.params[1].get_array();
         for (unsigned int i = 0; i < stats_univalue.size(); i++) {
             const std::string stat = stats_univalue[i].get_str();
+            if (!valid_stats.exists(stat)) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid selected statistic %s", stat));
+            }
             stats.insert(stat);
         }
     }
 
-    const CBlock block = GetBlockChecked(pindex);
-
-    const bool do_all = stats.size() == 0; // Calculate everything if nothing selected (default)
-    const bool do_mediantxsize = do_all || stats.count("mediantxsize") != 0;
-    const bool do_medianfee = do_all || stats.count("medianfee") != 0;
-    const bool do_feerate_percentiles = do_all || stats.count("feerate_percentiles") != 0;
-    const bool loop_inputs = do_all || do_medianfee || do_feerate_percentiles ||
-        SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee", "avgfeerate", "minfee", "maxfee", "minfeerate", "maxfeerate");
-    const bool loop_outputs = do_all || loop_inputs || stats.count("total_out");
-    const bool do_calculate_size = do_mediantxsize ||
-        SetHasKeys(stats, "total_size", "avgtxsize", "mintxsize", "maxtxsize", "swtotal_size");
-    const bool do_calculate_weight = do_all || SetHasKeys(stats, "total_weight", "avgfeerate", "swtotal_weight", "avgfeerate", "feerate_percentiles", "minfeerate", "maxfeerate");
-    const bool do_calculate_sw = do_all || SetHasKeys(stats, "swtxs", "swtotal_size", "swtotal_weight");
-
-    CAmount maxfee = 0;
-    CAmount maxfeerate = 0;
-    CAmount minfee = MAX_MONEY;
-    CAmount minfeerate = MAX_MONEY;
-    CAmount total_out = 0;
-    CAmount totalfee = 0;
-    int64_t inputs = 0;
-    int64_t maxtxsize = 0;
-    int64_t mintxsize = MAX_BLOCK_SERIALIZED_SIZE;
-    int64_t outputs = 0;
-    int64_t swtotal_size = 0;
-    int64_t swtotal_weight = 0;
-    int64_t swtxs = 0;
-    int64_t total_size = 0;
-    int64_t total_weight = 0;
-    int64_t utxo_size_inc = 0;
-    std::vector<CAmount> fee_array;
-    std::vector<std::pair<CAmount, int64_t>> feerate_array;
-    std::vector<int64_t> txsize_array;
-
-    for (const auto& tx : block.vtx) {
-        outputs += tx->vout.size();
-
-        CAmount tx_total_out = 0;
-        if (loop_outputs) {
-            for (const CTxOut& out : tx->vout) {
-                tx_total_out += out.nValue;
-                utxo_size_inc += GetSerializeSize(out, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
-            }
-        }
+    std::vector<CBlockStats> block_stats;
+    GetBlockStats(blocks, block_stats);
 
-        if (tx->IsCoinBase()) {
+    UniValue results(UniValue::VARR);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        UniValue ret_all = BlockStatsToJSON(blocks[i], block_stats[i]);
+        if (stats.empty()) { // Return everything if nothing selected (default)
+            results.push_back(ret_all);
             continue;
         }
 
-        inputs += tx->vin.size(); // Don't count coinbase's fake input
-        total_out += tx_total_out; // Don't count coinbase reward
-
-        int64_t tx_size = 0;
-        if (do_calculate_size) {
-
-            tx_size = tx->GetTotalSize();
-            if (do_mediantxsize) {
-                txsize_array.push_back(tx_size);
-            }
-            maxtxsize = std::max(maxtxsize, tx_size);
-            mintxsize = std::min(mintxsize, tx_size);
-            total_size += tx_size;
-        }
-
-        int64_t weight = 0;
-        if (do_calculate_weight) {
-            weight = GetTransactionWeight(*tx);
-            total_weight += weight;
-        }
-
-        if (do_calculate_sw && tx->HasWitness()) {
-            ++swtxs;
-            swtotal_size += tx_size;
-            swtotal_weight += weight;
-        }
-
-        if (loop_inputs) {
-
-            if (!g_txindex) {
-                throw JSONRPCError(RPC_INVALID_PARAMETER, "One or more of the selected stats requires -txindex enabled");
-            }
-            CAmount tx_total_in = 0;
-            for (const CTxIn& in : tx->vin) {
-                CTransactionRef tx_in;
-                uint256 hashBlock;
-                if (!GetTransaction(in.prevout.hash, tx_in, Params().GetConsensus(), hashBlock, false)) {
-                    throw JSONRPCError(RPC_INTERNAL_ERROR, std::string("Unexpected internal error (tx index seems corrupt)"));
-                }
-
-                CTxOut prevoutput = tx_in->vout[in.prevout.n];
-
-                tx_total_in += prevoutput.nValue;
-                utxo_size_inc -= GetSerializeSize(prevoutput, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
-            }
-
-            CAmount txfee = tx_total_in - tx_total_out;
-            assert(MoneyRange(txfee));
-            if (do_medianfee) {
-                fee_array.push_back(txfee);
-            }
-            maxfee = std::max(maxfee, txfee);
-            minfee = std::min(minfee, txfee);
-            totalfee += txfee;
-
-            // New feerate uses satoshis per virtual byte instead of per serialized byte
-            CAmount feerate = weight ? (txfee * WITNESS_SCALE_FACTOR) / weight : 0;
-            if (do_feerate_percentiles) {
-                feerate_array.emplace_back(std::make_pair(feerate, weight));
-            }
-            maxfeerate = std::max(maxfeerate, feerate);
-            minfeerate = std::min(minfeerate, feerate);
+        UniValue ret(UniValue::VOBJ);
+        for (const std::string& stat : stats) {
+            ret.pushKV(stat, ret_all[stat]);
         }
+        results.push_back(ret);
     }
 
-    CAmount feerate_percentiles[NUM_GETBLOCKSTATS_PERCENTILES] = { 0 };
-    CalculatePercentilesByWeight(feerate_percentiles, feerate_array, total_weight);
-
-    UniValue feerates_res(UniValue::VARR);
-    for (int64_t i = 0; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
-        feerates_res.push_back(feerate_percentiles[i]);
+    if (request.params[0].isArray()) {
+        return results;
     }
-
-    UniValue ret_all(UniValue::VOBJ);
-    ret_all.pushKV("avgfee", (block.vtx.size() > 1) ? totalfee / (block.vtx.size() - 1) : 0);
-    ret_all.pushKV("avgfeerate", total_weight ? (totalfee * WITNESS_SCALE_FACTOR) / total_weight : 0); // Unit: sat/vbyte
-    ret_all.pushKV("avgtxsize", (block.vtx.size() > 1) ? total_size / (block.vtx.size() - 1) : 0);
-    ret_all.pushKV("blockhash", pindex->GetBlockHash().GetHex());
-    ret_all.pushKV("feerate_percentiles", feerates_res);
-    ret_all.pushKV("height", (int64_t)pindex->nHeight);
-    ret_all.pushKV("ins", inputs);
-    ret_all.pushKV("maxfee", maxfee);
-    ret_all.pushKV("maxfeerate", maxfeerate);
-    ret_all.pushKV("maxtxsize", maxtxsize);
-    ret_all.pushKV("medianfee", CalculateTruncatedMedian(fee_array));
-    ret_all.pushKV("mediantime", pindex->GetMedianTimePast());
-    ret_all.pushKV("mediantxsize", CalculateTruncatedMedian(txsize_array));
-    ret_all.pushKV("minfee", (minfee == MAX_MONEY) ? 0 : minfee);
-    ret_all.pushKV("minfeerate", (minfeerate == MAX_MONEY) ? 0 : minfeerate);
-    ret_all.pushKV("mintxsize", mintxsize == MAX_BLOCK_SERIALIZED_SIZE ? 0 : mintxsize);
-    ret_all.pushKV("outs", outputs);
-    ret_all.pushKV("subsidy", GetBlockSubsidy(pindex->nHeight, Params().GetConsensus()));
-    ret_all.pushKV("swtotal_size", swtotal_size);
-    ret_all.pushKV("swtotal_weight", swtotal_weight);
-    ret_all.pushKV("swtxs", swtxs);
-    ret_all.pushKV("time", pindex->GetBlockTime());
-    ret_all.pushKV("total_out", total_out);
-    ret_all.pushKV("total_size", total_size);
-    ret_all.pushKV("total_weight", total_weight);
-    ret_all.pushKV("totalfee", totalfee);
-    ret_all.pushKV("txs", (int64_t)block.vtx.size());
-    ret_all.pushKV("utxo_increase", outputs - inputs);
-    ret_all.pushKV("utxo_size_inc", utxo_size_inc);
-
-    if (do_all) {
-        return ret_all;
-    }
-
-    UniValue ret(UniValue::VOBJ);
-    for (const std::string& stat : stats) {
-        const UniValue& value = ret_all[stat];
-        if (value.isNull()) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid selected statistic %s", stat));
-        }
-        ret.pushKV(stat, value);
-    }
-    return ret;
+    return results[0];
 }
 
 static UniValue savemempool(const JSONRPCRequest& request)
@@ -1981,14 +2119,38 @@ static UniValue savemempool(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
-//! Search for a given set of pubkey scripts
-bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>& should_abort, int64_t& count, CCoinsViewCursor* cursor, const std::set<CScript>& needles, std::map<COutPoint, Coin>& out_results) {
-    scan_progress = 0;
-    count = 0;
+//! Number of ranges of txids the UTXO set is split into for scanning
+static constexpr int SCAN_RANGES = 64;
+//! Maximum number of threads scanning the UTXO set
+static constexpr int MAX_SCAN_THREADS = 8;
+
+/** Salted hasher for sets of scripts, so that chosen scripts cannot degrade lookups */
+class SaltedScriptHasher
+{
+private:
+    const uint64_t k0, k1;
+
+public:
+    SaltedScriptHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+    size_t operator()(const CScript& script) const {
+        return CSipHasher(k0, k1).Write(script.data(), script.size()).Finalize();
+    }
+};
+
+typedef std::unordered_set<CScript, SaltedScriptHasher> ScriptSet;
+
+//! Search the outputs of transactions whose txid starts with a byte in [begin_byte, end_byte) for a given set of pubkey scripts
+static bool FindScriptPubKeyInRange(std::atomic<int>& scan_progress, std::atomic<uint32_t>& scanned, const std::atomic<bool>& should_abort, int64_t& count, CCoinsViewCursor* cursor, int begin_byte, int end_byte, const ScriptSet& needles, std::map<COutPoint, Coin>& out_results)
+{
+    // position within the range, in units of the first two bytes of the txid
+    uint32_t position = begin_byte << 8;
     while (cursor->Valid()) {
         COutPoint key;
         Coin coin;
-        if (!cursor->GetKey(key) || !cursor->GetValue(coin)) return false;
+        if (!cursor->GetKey(key)) return false;
+        if (*key.hash.begin() >= end_byte) break;
+        if (!cursor->GetValue(coin)) return false;
         if (++count % 8192 == 0) {
             boost::this_thread::interruption_point();
             if (should_abort) {
@@ -1999,13 +2161,69 @@ bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>&
         if (count % 256 == 0) {
             // update progress reference every 256 item
             uint32_t high = 0x100 * *key.hash.begin() + *(key.hash.begin() + 1);
-            scan_progress = (int)(high * 100.0 / 65536.0 + 0.5);
+            scan_progress = (int)((scanned += high - position) * 100.0 / 65536.0 + 0.5);
+            position = high;
         }
         if (needles.count(coin.out.scriptPubKey)) {
             out_results.emplace(key, coin);
         }
         cursor->Next();
     }
+    scan_progress = (int)((scanned += (end_byte << 8) - position) * 100.0 / 65536.0 + 0.5);
+    return true;
+}
+
+/**
+ * Search for a given set of pubkey scripts. Every cursor covers one of an equal
+ * share of the txid ranges, which are scanned concurrently. The cursors must be
+ * created without a write to the database in between.
+ */
+bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>& should_abort, int64_t& count, std::vector<std::unique_ptr<CCoinsViewCursor>>& cursors, const ScriptSet& needles, std::map<COutPoint, Coin>& out_results) {
+    const int num_ranges = cursors.size();
+    scan_progress = 0;
+    count = 0;
+
+    std::atomic<int> next_range{0};
+    std::atomic<uint32_t> scanned{0};
+    std::atomic<bool> failed{false};
+    std::vector<int64_t> range_counts(num_ranges, 0);
+    std::vector<std::map<COutPoint, Coin>> range_results(num_ranges);
+    auto scan_ranges = [&] {
+        int range;
+        while (!failed && (range = next_range++) < num_ranges) {
+            if (!FindScriptPubKeyInRange(scan_progress, scanned, should_abort, range_counts[range], cursors[range].get(),
+                                         range * 256 / num_ranges, (range + 1) * 256 / num_ranges, needles, range_results[range])) {
+                failed = true;
+            }
+            // release the iterator, and with it the database snapshot it holds
+            cursors[range].reset();
+        }
+    };
+
+    // This thread scans ranges as well, and is the only one that can be interrupted
+    std::vector<std::thread> threads;
+    const int num_threads = std::max(1, std::min({GetNumCores(), MAX_SCAN_THREADS, num_ranges}));
+    for (int i = 1; i < num_threads; ++i) {
+        threads.emplace_back(&TraceThread<std::function<void()>>, "scantxoutset", scan_ranges);
+    }
+    try {
+        scan_ranges();
+    } catch (...) {
+        failed = true;
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        throw;
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (int range = 0; range < num_ranges; ++range) {
+        count += range_counts[range];
+        out_results.insert(range_results[range].begin(), range_results[range].end());
+    }
+    if (failed) return false;
     scan_progress = 100;
     return true;
 }
@@ -2113,7 +2331,7 @@ UniValue scantxoutset(const JSONRPCRequest& request)
         if (!reserver.reserve()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Scan already in progress, use action \"abort\" or \"status\"");
         }
-        std::set<CScript> needles;
+        ScriptSet needles;
         CAmount total_in = 0;
 
         // loop through the scan objects
@@ -2157,14 +2375,19 @@ UniValue scantxoutset(const JSONRPCRequest& request)
         g_should_abort_scan = false;
         g_scan_progress = 0;
         int64_t count = 0;
-        std::unique_ptr<CCoinsViewCursor> pcursor;
+        std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
         {
+            // All cursors see the chainstate as of the flush, as it is only written holding cs_main
             LOCK(cs_main);
             FlushStateToDisk();
-            pcursor = std::unique_ptr<CCoinsViewCursor>(pcoinsdbview->Cursor());
-            assert(pcursor);
+            for (int range = 0; range < SCAN_RANGES; ++range) {
+                uint256 start_txid;
+                *start_txid.begin() = range * 256 / SCAN_RANGES;
+                cursors.emplace_back(pcoinsdbview->Cursor(start_txid));
+                assert(cursors.back());
+            }
         }
-        bool res = FindScriptPubKey(g_scan_progress, g_should_abort_scan, count, pcursor.get(), needles, coins);
+        bool res = FindScriptPubKey(g_scan_progress, g_should_abort_scan, count, cursors, needles, coins);
         result.pushKV("success", res);
         result.pushKV("searched_items", count);
 
@@ -2292,15 +2515,265 @@ UniValue getspecialtxes(const JSONRPCRequest& request)
     return result;
 }
 
+static UniValue getblockfilter(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2) {
+        throw std::runtime_error(
+            "getblockfilter \"blockhash\" ( \"filtertype\" )\n"
+            "\nRetrieve a BIP 158 content filter for a particular block. Requires -blockfilterindex.\n"
+            "\nArguments:\n"
+            "1. \"blockhash\"    (string, required) The hash of the block\n"
+            "2. \"filtertype\"   (string, optional, default=basic) The type name of the filter\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"filter\" : (string) the hex-encoded filter data\n"
+            "  \"header\" : (string) the hex-encoded filter header\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\" \"basic\"")
+            + HelpExampleRpc("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\", \"basic\"")
+        );
+    }
+
+    uint256 block_hash = ParseHashV(request.params[0], "blockhash");
+    std::string filtertype_name = "basic";
+    if (!request.params[1].isNull()) {
+        filtertype_name = request.params[1].get_str();
+    }
+
+    BlockFilterType filtertype;
+    if (!BlockFilterTypeByName(filtertype_name, filtertype)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown filtertype");
+    }
+
+    if (!g_blockfilterindex || g_blockfilterindex->GetFilterType() != filtertype) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is not enabled for filtertype " + filtertype_name);
+    }
+
+    const CBlockIndex* block_index;
+    bool block_was_connected;
+    {
+        LOCK(cs_main);
+        block_index = LookupBlockIndex(block_hash);
+        if (!block_index) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        block_was_connected = block_index->IsValid(BLOCK_VALID_SCRIPTS);
+    }
+
+    bool index_ready = g_blockfilterindex->BlockUntilSyncedToCurrentChain();
+
+    BlockFilter filter;
+    uint256 filter_header;
+    if (!g_blockfilterindex->LookupFilter(block_index, filter) ||
+        !g_blockfilterindex->LookupFilterHeader(block_index, filter_header)) {
+        int err_code;
+        std::string errmsg = "Filter not found.";
+
+        if (!block_was_connected) {
+            err_code = RPC_INVALID_ADDRESS_OR_KEY;
+            errmsg += " Block was not connected to active chain.";
+        } else if (!index_ready) {
+            err_code = RPC_MISC_ERROR;
+            errmsg += " Block filters are still in the process of being indexed.";
+        } else {
+            err_code = RPC_INTERNAL_ERROR;
+            errmsg += " This error is unexpected and indicates index corruption.";
+        }
+
+        throw JSONRPCError(err_code, errmsg);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("filter", HexStr(filter.GetEncodedFilter()));
+    ret.pushKV("header", filter_header.GetHex());
+    return ret;
+}
+
+//! Default and maximum number of balance changes returned by getaddressdeltas
+static const int DEFAULT_ADDRESS_DELTAS_COUNT = 1000;
+static const int MAX_ADDRESS_DELTAS_COUNT = 10000;
+
+static uint256 ParseIndexAddress(const UniValue& param)
+{
+    CTxDestination dest = DecodeDestination(param.get_str());
+    if (!IsValidDestination(dest)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+    }
+    return GetIndexScriptHash(GetScriptForDestination(dest));
+}
+
+static AddressIndex& EnsureAddressIndex()
+{
+    if (!g_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled. Use -addressindex to enable it.");
+    }
+    if (!g_addressindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is still being synced with the block chain.");
+    }
+    return *g_addressindex;
+}
+
+static UniValue getaddressdeltas(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 5) {
+        throw std::runtime_error(
+            "getaddressdeltas \"address\" ( start_height end_height skip count )\n"
+            "\nReturns the outputs paying to an address and the inputs spending from it, in order of height.\n"
+            "Requires -addressindex. Long histories can be paged with skip and count.\n"
+            "\nArguments:\n"
+            "1. \"address\"        (string, required) The address\n"
+            "2. start_height       (numeric, optional, default=0) The first height to return changes of\n"
+            "3. end_height         (numeric, optional, default=chain tip) The last height to return changes of\n"
+            "4. skip               (numeric, optional, default=0) The number of changes in the height range to skip\n"
+            "5. count              (numeric, optional, default=" + std::to_string(DEFAULT_ADDRESS_DELTAS_COUNT) + ") The maximum number of changes to return, at most " + std::to_string(MAX_ADDRESS_DELTAS_COUNT) + "\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"height\": n,        (numeric) The height of the block\n"
+            "    \"txid\": \"hash\",     (string) The transaction id\n"
+            "    \"index\": n,         (numeric) The index of the output, or of the input if spending\n"
+            "    \"spending\": b,      (boolean) Whether this is an input spending from the address\n"
+            "    \"amount\": x.xxx     (numeric) The change of the balance of the address in " + CURRENCY_UNIT + ", negative for inputs\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressdeltas", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\" 100000 200000")
+            + HelpExampleRpc("getaddressdeltas", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\", 100000, 200000")
+        );
+    }
+
+    uint256 script_hash = ParseIndexAddress(request.params[0]);
+    int start_height = request.params[1].isNull() ? 0 : request.params[1].get_int();
+    int end_height = request.params[2].isNull() ? std::numeric_limits<int>::max() : request.params[2].get_int();
+    int skip = request.params[3].isNull() ? 0 : request.params[3].get_int();
+    int count = request.params[4].isNull() ? DEFAULT_ADDRESS_DELTAS_COUNT : request.params[4].get_int();
+    if (start_height < 0 || end_height < start_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+    if (skip < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative skip");
+    }
+    if (count < 0 || count > MAX_ADDRESS_DELTAS_COUNT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("count must be between 0 and %d", MAX_ADDRESS_DELTAS_COUNT));
+    }
+
+    std::vector<CAddressDelta> deltas;
+    if (!EnsureAddressIndex().FindAddressDeltas(script_hash, start_height, end_height, skip, count, deltas)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the address index");
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const CAddressDelta& delta : deltas) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("height", delta.nHeight);
+        entry.pushKV("txid", delta.txid.GetHex());
+        entry.pushKV("index", (int64_t)delta.nIndex);
+        entry.pushKV("spending", delta.fSpending);
+        entry.pushKV("amount", ValueFromAmount(delta.nAmount));
+        result.push_back(entry);
+    }
+    return result;
+}
+
+static UniValue getaddressbalance(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        throw std::runtime_error(
+            "getaddressbalance \"address\"\n"
+            "\nReturns the balance of an address in the active chain. Requires -addressindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"        (string, required) The address\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"balance\": x.xxx,   (numeric) The amount of the unspent outputs paying to the address in " + CURRENCY_UNIT + "\n"
+            "  \"received\": x.xxx,  (numeric) The amount of all outputs paying to the address in " + CURRENCY_UNIT + "\n"
+            "  \"txs\": n            (numeric) The number of transactions paying to or spending from the address\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressbalance", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"")
+            + HelpExampleRpc("getaddressbalance", "\"1PSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"")
+        );
+    }
+
+    uint256 script_hash = ParseIndexAddress(request.params[0]);
+    CAmount balance, received;
+    uint64_t tx_count;
+    if (!EnsureAddressIndex().GetAddressBalance(script_hash, balance, received, tx_count)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the address index");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", ValueFromAmount(balance));
+    result.pushKV("received", ValueFromAmount(received));
+    result.pushKV("txs", tx_count);
+    return result;
+}
+
+static UniValue getspentinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 2) {
+        throw std::runtime_error(
+            "getspentinfo \"txid\" n\n"
+            "\nReturns the transaction input spending an output in the active chain. Requires -spentindex.\n"
+            "\nArguments:\n"
+            "1. \"txid\"           (string, required) The transaction id of the output\n"
+            "2. n                (numeric, required) The index of the output\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"txid\": \"hash\",     (string) The id of the spending transaction\n"
+            "  \"index\": n,         (numeric) The index of the spending input\n"
+            "  \"height\": n,        (numeric) The height of the block of the spending transaction\n"
+            "  \"value\": x.xxx,     (numeric) The value of the spent output in " + CURRENCY_UNIT + "\n"
+            "  \"scripthash\": \"hash\" (string) The SHA256 of the scriptPubKey of the spent output\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getspentinfo", "\"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\" 0")
+            + HelpExampleRpc("getspentinfo", "\"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", 0")
+        );
+    }
+
+    uint256 txid = ParseHashV(request.params[0], "txid");
+    int n = request.params[1].get_int();
+    if (n < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid output index");
+    }
+
+    if (!g_spentindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Spent index not enabled. Use -spentindex to enable it.");
+    }
+    if (!g_spentindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Spent index is still being synced with the block chain.");
+    }
+
+    CSpentIndexValue value;
+    if (!g_spentindex->FindSpender(COutPoint(txid, n), value)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No spender of this output in the active chain");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("txid", value.txid.GetHex());
+    result.pushKV("index", (int64_t)value.nInputIndex);
+    result.pushKV("height", value.nHeight);
+    result.pushKV("value", ValueFromAmount(value.nValue));
+    result.pushKV("scripthash", value.scriptHash.GetHex());
+    return result;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
+    { "blockchain",         "dumptxoutset",           &dumptxoutset,           {"path"} },
     { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {} },
     { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"} },
     { "blockchain",         "getblockstats",          &getblockstats,          {"hash_or_height", "stats"} },
+    { "blockchain",         "getaddressbalance",      &getaddressbalance,      {"address"} },
+    { "blockchain",         "getaddressdeltas",       &getaddressdeltas,       {"address", "start_height", "end_height", "skip", "count"} },
     { "blockchain",         "getbestblockhash",       &getbestblockhash,       {} },
     { "blockchain",         "getblockcount",          &getblockcount,          {} },
     { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"} },
     { "blockchain",         "getblockhash",           &getblockhash,           {"height"} },
     { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           {} },
@@ -2311,8 +2784,10 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {} },
     { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         {"blockhash", "type", "count", "skip", "verbosity"} },
+    { "blockchain",         "getspentinfo",           &getspentinfo,           {"txid", "n"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {"hash_type","hash_or_height"} },
+    { "blockchain",         "loadtxoutset",           &loadtxoutset,           {"path"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
@@ -2327,6 +2802,7 @@ static const CRPCCommand commands[] =
     { "hidden",             "waitforblock",           &waitforblock,           {"blockhash","timeout"} },
     { "hidden",             "waitforblockheight",     &waitforblockheight,     {"height","timeout"} },
     { "hidden",             "syncwithvalidationinterfacequeue", &syncwithvalidationinterfacequeue, {} },
+    { "hidden",             "getvalidationinterfaceinfo",       &getvalidationinterfaceinfo,       {} },
 };
 
 void RegisterBlockchainRPCCommands(CRPCTable &t)
@@ -124,6 +124,11 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "finalizepsbt", 1, "extract"},
     { "converttopsbt", 1, "permitsigdata"},
     { "converttopsbt", 2, "iswitness"},
+    { "getaddressdeltas", 1, "start_height" },
+    { "getaddressdeltas", 2, "end_height" },
+    { "getaddressdeltas", 3, "skip" },
+    { "getaddressdeltas", 4, "count" },
+    { "getspentinfo", 1, "n" },
     { "gettxout", 1, "n" },
     { "gettxout", 2, "include_mempool" },
     { "gettxoutproof", 0, "txids" },
@@ -139,6 +144,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "verifychain", 1, "nblocks" },
     { "getblockstats", 0, "hash_or_height" },
     { "getblockstats", 1, "stats" },
+    { "gettxoutsetinfo", 1, "hash_or_height" },
     { "pruneblockchain", 0, "height" },
     { "keypoolrefill", 0, "newsize" },
     { "getrawmempool", 0, "verbose" },
@@ -16,6 +16,7 @@
 #include <net.h>
 #include <policy/fees.h>
 #include <pow.h>
+#include <reverselock.h>
 #include <rpc/blockchain.h>
 #include <rpc/mining.h>
 #include <rpc/server.h>
@@ -291,6 +292,88 @@ static std::string gbt_vb_name(const Consensus::DeploymentPos pos) {
     return s;
 }
 
+/** A long poll ends early when the fees of the block template rise by at least this percentage */
+static const int GBT_LONGPOLL_MIN_FEE_INCREASE = 1;
+
+/** The block template last assembled by getblocktemplate, and what it was assembled for */
+struct CachedBlockTemplate
+{
+    CBlockIndex* pindexPrev = nullptr;
+    // Mempool sequence the template is up to date with
+    unsigned int nTransactionsUpdated = 0;
+    int64_t nStart = 0;
+    // Whether it was assembled with segwit support, to avoid returning a segwit-block to a
+    // non-segwit caller
+    bool fSupportsSegwit = true;
+    std::shared_ptr<CBlockTemplate> pblocktemplate;
+    std::unique_ptr<CBlockTemplateTracker> tracker;
+};
+static CachedBlockTemplate cachedTemplate;
+
+/**
+ * Bring the cached block template up to date with the tip and the mempool. A template is
+ * reused for as long as the changes to the mempool cannot change the transactions selected,
+ * and is otherwise assembled again at most every 5 seconds.
+ */
+static void UpdateBlockTemplate(bool fSupportsSegwit) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    CachedBlockTemplate& cached = cachedTemplate;
+    if (!cached.tracker)
+        cached.tracker = MakeUnique<CBlockTemplateTracker>(Params());
+
+    if (cached.pindexPrev == chainActive.Tip() && cached.fSupportsSegwit == fSupportsSegwit) {
+        unsigned int nTransactionsUpdated;
+        if (cached.tracker->IsUpToDate(nTransactionsUpdated)) {
+            cached.nTransactionsUpdated = nTransactionsUpdated;
+            return;
+        }
+        if (GetTime() - cached.nStart <= 5)
+            return;
+    }
+
+    // Clear pindexPrev so future calls make a new block, despite any failures from here on
+    cached.pindexPrev = nullptr;
+
+    // Store the pindexBest used before CreateNewBlock, to avoid races
+    unsigned int nTransactionsUpdated = mempool.GetTransactionsUpdated();
+    unsigned int nCommitmentsUpdated = CBlockTemplateTracker::GetCommitmentsUpdated();
+    CBlockIndex* pindexPrevNew = chainActive.Tip();
+    cached.nStart = GetTime();
+    cached.fSupportsSegwit = fSupportsSegwit;
+
+    // Create new block
+    CScript scriptDummy = CScript() << OP_TRUE;
+    cached.pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy, fSupportsSegwit);
+    if (!cached.pblocktemplate)
+        throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
+    cached.tracker->Reset(cached.pblocktemplate, nTransactionsUpdated, nCommitmentsUpdated);
+
+    // Need to update only after we know CreateNewBlock succeeded
+    cached.nTransactionsUpdated = nTransactionsUpdated;
+    cached.pindexPrev = pindexPrevNew;
+}
+
+/**
+ * Whether the fees of the block template for the current mempool rose materially above those
+ * of the template a long poll waits on. Called with the lock on g_best_block_mutex held, which
+ * is released meanwhile.
+ */
+static bool BlockTemplateFeesIncreased(WaitableLock& lock, CAmount nFeesLP, bool fSupportsSegwit)
+{
+    reverse_lock<WaitableLock> unlock(lock);
+    LOCK(cs_main);
+    try {
+        UpdateBlockTemplate(fSupportsSegwit);
+    } catch (const std::exception&) {
+        // Let the caller assemble the template again and report the failure
+        return true;
+    }
+    if (!cachedTemplate.pindexPrev)
+        return true;
+    CAmount nFees = -cachedTemplate.pblocktemplate->vTxFees[0];
+    return nFees > nFeesLP && nFees * 100 >= nFeesLP * (100 + GBT_LONGPOLL_MIN_FEE_INCREASE);
+}
+
 static UniValue getblocktemplate(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 1)
@@ -476,7 +559,11 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
         && CSuperblock::IsValidBlockHeight(chainActive.Height() + 1))
             throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, "Machinecoin is syncing with network...");
 
-    static unsigned int nTransactionsUpdatedLast;
+    const struct VBDeploymentInfo& segwit_info = VersionBitsDeploymentInfo[Consensus::DEPLOYMENT_SEGWIT];
+    // If the caller is indicating segwit support, then allow CreateNewBlock()
+    // to select witness transactions, after segwit activates (otherwise
+    // don't).
+    bool fSupportsSegwit = setClientRules.find(segwit_info.name) != setClientRules.end();
 
     if (!lpval.isNull())
     {
@@ -497,7 +584,15 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
         {
             // NOTE: Spec does not specify behaviour for non-string longpollid, but this makes testing easier
             hashWatchedChain = chainActive.Tip()->GetBlockHash();
-            nTransactionsUpdatedLastLP = nTransactionsUpdatedLast;
+            nTransactionsUpdatedLastLP = cachedTemplate.nTransactionsUpdated;
+        }
+
+        // If the caller works on the cached template, changes to the mempool only end the
+        // long poll when they raise its fees materially
+        CAmount nFeesLP = -1;
+        if (cachedTemplate.pindexPrev && cachedTemplate.pindexPrev->GetBlockHash() == hashWatchedChain &&
+                cachedTemplate.nTransactionsUpdated == nTransactionsUpdatedLastLP) {
+            nFeesLP = -cachedTemplate.pblocktemplate->vTxFees[0];
         }
 
         // Release the wallet and main lock while waiting
@@ -511,7 +606,8 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
                 if (g_best_block_cv.wait_until(lock, checktxtime) == std::cv_status::timeout)
                 {
                     // Timeout: Check transactions for update
-                    if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLastLP)
+                    if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLastLP &&
+                            (nFeesLP < 0 || BlockTemplateFeesIncreased(lock, nFeesLP, fSupportsSegwit)))
                         break;
                     checktxtime += std::chrono::seconds(10);
                 }
@@ -524,41 +620,10 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
         // TODO: Maybe recheck connections/IBD and (if something wrong) send an expires-immediately template to stop miners?
     }
 
-    const struct VBDeploymentInfo& segwit_info = VersionBitsDeploymentInfo[Consensus::DEPLOYMENT_SEGWIT];
-    // If the caller is indicating segwit support, then allow CreateNewBlock()
-    // to select witness transactions, after segwit activates (otherwise
-    // don't).
-    bool fSupportsSegwit = setClientRules.find(segwit_info.name) != setClientRules.end();
-
     // Update block
-    static CBlockIndex* pindexPrev;
-    static int64_t nStart;
-    static std::unique_ptr<CBlockTemplate> pblocktemplate;
-    // Cache whether the last invocation was with segwit support, to avoid returning
-    // a segwit-block to a non-segwit caller.
-    static bool fLastTemplateSupportsSegwit = true;
-    if (pindexPrev != chainActive.Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5) ||
-        fLastTemplateSupportsSegwit != fSupportsSegwit)
-    {
-        // Clear pindexPrev so future calls make a new block, despite any failures from here on
-        pindexPrev = nullptr;
-
-        // Store the pindexBest used before CreateNewBlock, to avoid races
-        nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
-        CBlockIndex* pindexPrevNew = chainActive.Tip();
-        nStart = GetTime();
-        fLastTemplateSupportsSegwit = fSupportsSegwit;
-
-        // Create new block
-        CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy, fSupportsSegwit);
-        if (!pblocktemplate)
-            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-
-        // Need to update only after we know CreateNewBlock succeeded
-        pindexPrev = pindexPrevNew;
-    }
+    UpdateBlockTemplate(fSupportsSegwit);
+    CBlockIndex* const pindexPrev = cachedTemplate.pindexPrev;
+    const std::shared_ptr<CBlockTemplate>& pblocktemplate = cachedTemplate.pblocktemplate;
     assert(pindexPrev);
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
     const Consensus::Params& consensusParams = Params().GetConsensus();
@@ -686,7 +751,7 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
     result.pushKV("transactions", transactions);
     result.pushKV("coinbaseaux", aux);
     result.pushKV("coinbasevalue", (int64_t)pblock->vtx[0]->vout[0].nValue);
-    result.pushKV("longpollid", chainActive.Tip()->GetBlockHash().GetHex() + i64tostr(nTransactionsUpdatedLast));
+    result.pushKV("longpollid", chainActive.Tip()->GetBlockHash().GetHex() + i64tostr(cachedTemplate.nTransactionsUpdated));
     result.pushKV("target", hashTarget.GetHex());
     result.pushKV("mintime", (int64_t)pindexPrev->GetMedianTimePast()+1);
     result.pushKV("mutable", aMutable);
@@ -0,0 +1,209 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_SUPPORT_ALLOCATORS_POOL_H
+#define MACHINECOIN_SUPPORT_ALLOCATORS_POOL_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+ * A memory resource for many small allocations of a few different sizes, like the nodes of
+ * node based containers.
+ *
+ * Memory is taken from large chunks, which are only returned to the system when the resource
+ * is destroyed. Deallocated blocks are put on a free list for their size, so they can be reused
+ * by the next allocation of the same size. Sizes are rounded up to a multiple of ELEM_ALIGN_BYTES.
+ * Allocations larger than MAX_BLOCK_SIZE_BYTES, or with a larger alignment than ELEM_ALIGN_BYTES,
+ * use operator new.
+ *
+ * Compared to allocating every node separately, this saves the malloc overhead of each node,
+ * makes the memory used known exactly, and frees everything at once instead of node by node.
+ *
+ * The resource is not thread safe.
+ */
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+class PoolResource
+{
+    static_assert(ALIGN_BYTES > 0, "ALIGN_BYTES must be nonzero");
+    static_assert((ALIGN_BYTES & (ALIGN_BYTES - 1)) == 0, "ALIGN_BYTES must be a power of two");
+
+    /** Entry of the free lists, stored in the free blocks themselves */
+    struct ListNode
+    {
+        ListNode* next;
+
+        explicit ListNode(ListNode* nextIn) : next(nextIn) {}
+    };
+
+public:
+    /** Alignment and size granularity of the blocks, large enough to hold a ListNode */
+    static constexpr std::size_t ELEM_ALIGN_BYTES = std::max(alignof(ListNode), ALIGN_BYTES);
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE_BYTES = 256 * 1024;
+
+private:
+    static_assert(ELEM_ALIGN_BYTES % alignof(ListNode) == 0, "ELEM_ALIGN_BYTES must be a multiple of alignof(ListNode)");
+    static_assert(ELEM_ALIGN_BYTES >= sizeof(ListNode), "ELEM_ALIGN_BYTES must be at least sizeof(ListNode)");
+    static_assert(ELEM_ALIGN_BYTES <= alignof(std::max_align_t), "operator new doesn't align chunks to ELEM_ALIGN_BYTES");
+
+    const std::size_t nChunkSizeBytes;
+    std::vector<void*> vChunks;
+    /** Free lists, indexed by the block size in multiples of ELEM_ALIGN_BYTES */
+    std::array<ListNode*, (MAX_BLOCK_SIZE_BYTES + ELEM_ALIGN_BYTES - 1) / ELEM_ALIGN_BYTES + 1> freeLists;
+    /** Memory of the last chunk which hasn't been handed out yet */
+    char* pAvailableBegin;
+    char* pAvailableEnd;
+
+    static std::size_t NumElemAlignBytes(std::size_t bytes)
+    {
+        return (bytes + ELEM_ALIGN_BYTES - 1) / ELEM_ALIGN_BYTES + (bytes == 0);
+    }
+
+    static bool IsFreeListUsable(std::size_t bytes, std::size_t alignment)
+    {
+        return alignment <= ELEM_ALIGN_BYTES && bytes <= MAX_BLOCK_SIZE_BYTES;
+    }
+
+    void AddToFreeList(void* p, std::size_t nNumAlignments)
+    {
+        freeLists[nNumAlignments] = new (p) ListNode(freeLists[nNumAlignments]);
+    }
+
+    void AllocateChunk()
+    {
+        // The rest of the current chunk is a multiple of ELEM_ALIGN_BYTES, so it can be reused as one block
+        if (pAvailableBegin != pAvailableEnd) {
+            AddToFreeList(pAvailableBegin, (pAvailableEnd - pAvailableBegin) / ELEM_ALIGN_BYTES);
+        }
+        void* pChunk = ::operator new(nChunkSizeBytes);
+        try {
+            vChunks.push_back(pChunk);
+        } catch (...) {
+            ::operator delete(pChunk);
+            throw;
+        }
+        pAvailableBegin = static_cast<char*>(pChunk);
+        pAvailableEnd = pAvailableBegin + nChunkSizeBytes;
+    }
+
+public:
+    explicit PoolResource(std::size_t nChunkSizeBytesIn) :
+        nChunkSizeBytes(nChunkSizeBytesIn / ELEM_ALIGN_BYTES * ELEM_ALIGN_BYTES),
+        pAvailableBegin(nullptr),
+        pAvailableEnd(nullptr)
+    {
+        assert(nChunkSizeBytes >= MAX_BLOCK_SIZE_BYTES);
+        freeLists.fill(nullptr);
+    }
+
+    PoolResource() : PoolResource(DEFAULT_CHUNK_SIZE_BYTES) {}
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    ~PoolResource()
+    {
+        for (void* pChunk : vChunks) {
+            ::operator delete(pChunk);
+        }
+    }
+
+    void* Allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!IsFreeListUsable(bytes, alignment)) {
+            return ::operator new(bytes);
+        }
+        const std::size_t nNumAlignments = NumElemAlignBytes(bytes);
+        if (freeLists[nNumAlignments] != nullptr) {
+            ListNode* node = freeLists[nNumAlignments];
+            freeLists[nNumAlignments] = node->next;
+            node->~ListNode();
+            return node;
+        }
+        const std::size_t nRoundBytes = nNumAlignments * ELEM_ALIGN_BYTES;
+        if (nRoundBytes > static_cast<std::size_t>(pAvailableEnd - pAvailableBegin)) {
+            AllocateChunk();
+        }
+        void* p = pAvailableBegin;
+        pAvailableBegin += nRoundBytes;
+        return p;
+    }
+
+    void Deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (!IsFreeListUsable(bytes, alignment)) {
+            ::operator delete(p);
+            return;
+        }
+        AddToFreeList(p, NumElemAlignBytes(bytes));
+    }
+
+    std::size_t NumAllocatedChunks() const { return vChunks.size(); }
+    std::size_t ChunkSizeBytes() const { return nChunkSizeBytes; }
+    const std::vector<void*>& GetChunks() const { return vChunks; }
+};
+
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+constexpr std::size_t PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>::ELEM_ALIGN_BYTES;
+
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+constexpr std::size_t PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>::DEFAULT_CHUNK_SIZE_BYTES;
+
+/**
+ * Allocator taking its memory from a PoolResource. The resource must outlive all containers
+ * using it. Copies of an allocator share the same resource.
+ */
+template <typename T, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES = alignof(T)>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> ResourceType;
+
+    template <typename U>
+    struct rebind {
+        typedef PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> other;
+    };
+
+private:
+    ResourceType* pResource;
+
+public:
+    PoolAllocator(ResourceType* pResourceIn) noexcept : pResource(pResourceIn) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& other) noexcept : pResource(other.Resource()) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(pResource->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        pResource->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    ResourceType* Resource() const noexcept { return pResource; }
+};
+
+template <typename T1, typename T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator==(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a,
+                const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return a.Resource() == b.Resource();
+}
+
+template <typename T1, typename T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator!=(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a,
+                const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return !(a == b);
+}
+
+#endif // MACHINECOIN_SUPPORT_ALLOCATORS_POOL_H
@@ -0,0 +1,225 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/validation.h>
+#include <index/addressindex.h>
+#include <index/spentindex.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <test/test_machinecoin.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+static void WaitForSync(BaseIndex& index)
+{
+    constexpr int64_t timeout_ms = 60 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_spentindex_sync_and_reorg, TestChain100Setup)
+{
+    AddressIndex addressindex(1 << 20, true);
+    SpentIndex spentindex(1 << 20, true);
+
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const uint256 coinbase_script_hash = GetIndexScriptHash(coinbase_script);
+    const CScript other_script = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+
+    CAmount balance, received;
+    uint64_t tx_count;
+    BOOST_CHECK(addressindex.GetAddressBalance(coinbase_script_hash, balance, received, tx_count));
+    BOOST_CHECK_EQUAL(tx_count, 0U);
+
+    addressindex.Start();
+    spentindex.Start();
+    WaitForSync(addressindex);
+    WaitForSync(spentindex);
+
+    // All outputs of the initial chain paying to the coinbase script are indexed
+    CAmount expected = 0;
+    uint64_t expected_count = 0;
+    for (const auto& txn : m_coinbase_txns) {
+        for (const CTxOut& out : txn->vout) {
+            if (out.scriptPubKey == coinbase_script) {
+                expected += out.nValue;
+                expected_count++;
+            }
+        }
+    }
+    BOOST_CHECK(addressindex.GetAddressBalance(coinbase_script_hash, balance, received, tx_count));
+    BOOST_CHECK_EQUAL(balance, expected);
+    BOOST_CHECK_EQUAL(received, expected);
+    BOOST_CHECK_EQUAL(tx_count, expected_count);
+
+    // Deltas are ordered by height and can be paged
+    std::vector<CAddressDelta> deltas;
+    BOOST_CHECK(addressindex.FindAddressDeltas(coinbase_script_hash, 0, 1000, 0, 1000, deltas));
+    BOOST_CHECK_EQUAL(deltas.size(), expected_count);
+    for (size_t i = 1; i < deltas.size(); i++) {
+        BOOST_CHECK(deltas[i - 1].nHeight <= deltas[i].nHeight);
+    }
+    std::vector<CAddressDelta> page;
+    BOOST_CHECK(addressindex.FindAddressDeltas(coinbase_script_hash, 0, 1000, 10, 5, page));
+    BOOST_REQUIRE_EQUAL(page.size(), 5U);
+    for (size_t i = 0; i < page.size(); i++) {
+        BOOST_CHECK_EQUAL(page[i].txid, deltas[10 + i].txid);
+    }
+    page.clear();
+    BOOST_CHECK(addressindex.FindAddressDeltas(coinbase_script_hash, 50, 59, 0, 1000, page));
+    BOOST_CHECK_EQUAL(page.size(), 10U);
+    for (const CAddressDelta& delta : page) {
+        BOOST_CHECK(delta.nHeight >= 50 && delta.nHeight <= 59);
+        BOOST_CHECK(!delta.fSpending);
+    }
+
+    // Spend the first coinbase output, with change to the coinbase script
+    const CAmount change = COIN;
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    spend.vout.resize(2);
+    spend.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue - change - 1000;
+    spend.vout[0].scriptPubKey = other_script;
+    spend.vout[1].nValue = change;
+    spend.vout[1].scriptPubKey = coinbase_script;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    const CBlock block = CreateAndProcessBlock({spend}, other_script);
+    BOOST_REQUIRE_EQUAL(chainActive.Tip()->GetBlockHash(), block.GetHash());
+    const int spend_height = chainActive.Height();
+    BOOST_CHECK(addressindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(spentindex.BlockUntilSyncedToCurrentChain());
+
+    CSpentIndexValue value;
+    BOOST_REQUIRE(spentindex.FindSpender(spend.vin[0].prevout, value));
+    BOOST_CHECK_EQUAL(value.txid, spend.GetHash());
+    BOOST_CHECK_EQUAL(value.nInputIndex, 0U);
+    BOOST_CHECK_EQUAL(value.nHeight, spend_height);
+    BOOST_CHECK_EQUAL(value.nValue, m_coinbase_txns[0]->vout[0].nValue);
+    BOOST_CHECK_EQUAL(value.scriptHash, coinbase_script_hash);
+
+    deltas.clear();
+    BOOST_CHECK(addressindex.FindAddressDeltas(coinbase_script_hash, spend_height, spend_height, 0, 1000, deltas));
+    BOOST_REQUIRE_EQUAL(deltas.size(), 2U);
+    BOOST_CHECK(deltas[0].fSpending);
+    BOOST_CHECK_EQUAL(deltas[0].txid, spend.GetHash());
+    BOOST_CHECK_EQUAL(deltas[0].nAmount, -m_coinbase_txns[0]->vout[0].nValue);
+    BOOST_CHECK(!deltas[1].fSpending);
+    BOOST_CHECK_EQUAL(deltas[1].txid, spend.GetHash());
+    BOOST_CHECK_EQUAL(deltas[1].nAmount, change);
+    BOOST_CHECK(addressindex.GetAddressBalance(coinbase_script_hash, balance, received, tx_count));
+    BOOST_CHECK_EQUAL(balance, expected - m_coinbase_txns[0]->vout[0].nValue + change);
+    BOOST_CHECK_EQUAL(received, expected + change);
+    // The spend and its change are one transaction
+    BOOST_CHECK_EQUAL(tx_count, expected_count + 1);
+
+    // Replace the block with one not spending anything, which rewinds both indexes
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(InvalidateBlock(state, Params(), chainActive.Tip()));
+    }
+    CValidationState state;
+    BOOST_CHECK(ActivateBestChain(state, Params()));
+    mempool.clear();
+    const CBlock block2 = CreateAndProcessBlock({}, other_script);
+    BOOST_REQUIRE_EQUAL(chainActive.Tip()->GetBlockHash(), block2.GetHash());
+    BOOST_CHECK(addressindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(spentindex.BlockUntilSyncedToCurrentChain());
+
+    BOOST_CHECK(!spentindex.FindSpender(spend.vin[0].prevout, value));
+    deltas.clear();
+    BOOST_CHECK(addressindex.FindAddressDeltas(coinbase_script_hash, spend_height, spend_height, 0, 1000, deltas));
+    BOOST_CHECK(deltas.empty());
+    BOOST_CHECK(addressindex.GetAddressBalance(coinbase_script_hash, balance, received, tx_count));
+    BOOST_CHECK_EQUAL(balance, expected);
+    BOOST_CHECK_EQUAL(received, expected);
+    BOOST_CHECK_EQUAL(tx_count, expected_count);
+
+    addressindex.Stop(); // Stop threads before calling destructors
+    spentindex.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_spentindex_parallel_sync, TestChain100Setup)
+{
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const CScript other_script = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+
+    // Spend the first coinbase output, then extend the chain far enough for the sync to be
+    // split into ranges of blocks
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue - 1000;
+    spend.vout[0].scriptPubKey = other_script;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    CreateAndProcessBlock({spend}, other_script);
+    const int spend_height = chainActive.Height();
+    for (int i = 0; i < 1100; i++) {
+        CreateAndProcessBlock({}, other_script);
+    }
+
+    CAmount expected = 0;
+    uint64_t expected_count = 0;
+    {
+        LOCK(cs_main);
+        for (int height = spend_height; height <= chainActive.Height(); height++) {
+            CBlock block;
+            BOOST_REQUIRE(ReadBlockFromDisk(block, chainActive[height], Params().GetConsensus()));
+            for (const CTransactionRef& tx : block.vtx) {
+                for (const CTxOut& out : tx->vout) {
+                    if (out.scriptPubKey == other_script) {
+                        expected += out.nValue;
+                        expected_count++;
+                    }
+                }
+            }
+        }
+    }
+
+    AddressIndex addressindex(1 << 20, true);
+    SpentIndex spentindex(1 << 20, true);
+    addressindex.Start(4);
+    spentindex.Start(4);
+    WaitForSync(addressindex);
+    WaitForSync(spentindex);
+
+    CAmount balance, received;
+    uint64_t tx_count;
+    BOOST_CHECK(addressindex.GetAddressBalance(GetIndexScriptHash(other_script), balance, received, tx_count));
+    BOOST_CHECK_EQUAL(balance, expected);
+    BOOST_CHECK_EQUAL(received, expected);
+    BOOST_CHECK_EQUAL(tx_count, expected_count);
+
+    CSpentIndexValue value;
+    BOOST_REQUIRE(spentindex.FindSpender(spend.vin[0].prevout, value));
+    BOOST_CHECK_EQUAL(value.txid, spend.GetHash());
+    BOOST_CHECK_EQUAL(value.nHeight, spend_height);
+
+    addressindex.Stop(); // Stop threads before calling destructors
+    spentindex.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
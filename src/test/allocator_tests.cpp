@@ -4,10 +4,12 @@
 
 #include <util.h>
 
+#include <support/allocators/pool.h>
 #include <support/allocators/secure.h>
 #include <test/test_machinecoin.h>
 
 #include <memory>
+#include <unordered_map>
 
 #include <boost/test/unit_test.hpp>
 
@@ -233,4 +235,69 @@ BOOST_AUTO_TEST_CASE(lockedpool_tests_live)
     BOOST_CHECK(pool.stats().used == initial.used);
 }
 
+BOOST_AUTO_TEST_CASE(poolresource_tests)
+{
+    PoolResource<64, 8> resource(1024);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 0U);
+
+    // Blocks are handed out from the chunk, rounded up to the alignment
+    void* a = resource.Allocate(8, 8);
+    void* b = resource.Allocate(5, 4);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+    BOOST_CHECK_EQUAL(static_cast<char*>(b) - static_cast<char*>(a), 8);
+
+    // Freed blocks are reused by allocations of the same rounded size
+    resource.Deallocate(a, 8, 8);
+    void* c = resource.Allocate(7, 8);
+    BOOST_CHECK(c == a);
+    void* d = resource.Allocate(16, 8);
+    BOOST_CHECK(d != a);
+
+    // Blocks larger than the maximum block size don't use the chunks
+    void* big = resource.Allocate(1000, 8);
+    BOOST_CHECK(big != nullptr);
+    resource.Deallocate(big, 1000, 8);
+
+    // New chunks are allocated once the current one is used up
+    std::vector<void*> blocks;
+    for (int i = 0; i < 1024 / 64; i++) {
+        blocks.push_back(resource.Allocate(64, 8));
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+    for (void* p : blocks) {
+        resource.Deallocate(p, 64, 8);
+    }
+    resource.Deallocate(b, 5, 4);
+    resource.Deallocate(c, 7, 8);
+    resource.Deallocate(d, 16, 8);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(poolallocator_tests)
+{
+    typedef std::pair<const int, int> Value;
+    typedef PoolAllocator<Value, sizeof(Value) + sizeof(void*) * 4, alignof(void*)> Allocator;
+    Allocator::ResourceType resource;
+    {
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, Allocator> map(0, std::hash<int>(), std::equal_to<int>(), Allocator(&resource));
+        for (int i = 0; i < 10000; i++) {
+            map[i] = i;
+        }
+        size_t nChunks = resource.NumAllocatedChunks();
+        BOOST_CHECK(nChunks > 0);
+
+        // Erased nodes are reused without allocating more chunks
+        for (int i = 0; i < 10000; i++) {
+            map.erase(i);
+        }
+        for (int i = 0; i < 10000; i++) {
+            map[i] = i;
+        }
+        BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), nChunks);
+        BOOST_CHECK_EQUAL(map.size(), 10000U);
+        BOOST_CHECK_EQUAL(map.at(1234), 1234);
+        BOOST_CHECK(map.get_allocator() == Allocator(&resource));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
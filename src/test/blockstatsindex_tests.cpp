@@ -0,0 +1,79 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockstatsindex.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/test_machinecoin.h>
+#include <undo.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(blockstatsindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(blockstatsindex_initial_sync, TestChain100Setup)
+{
+    // Spend a mature coinbase output, paying a fee
+    CScript coinbase_script_pub_key = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue - 1000;
+    spend.vout[0].scriptPubKey = coinbase_script_pub_key;
+    std::vector<unsigned char> sig;
+    uint256 hash = SignatureHash(coinbase_script_pub_key, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign(hash, sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+    CreateAndProcessBlock({spend}, coinbase_script_pub_key);
+
+    BlockStatsIndex index(1 << 20, true);
+
+    CBlockStats stats;
+    BOOST_CHECK(!index.LookupStats(chainActive.Tip(), stats));
+
+    index.Start();
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // The indexed statistics match the ones computed from the blocks on disk
+    for (int height = 0; height <= chainActive.Height(); height++) {
+        const CBlockIndex* pindex = chainActive[height];
+        CBlock block;
+        CBlockUndo block_undo;
+        BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+        BOOST_REQUIRE(height == 0 || UndoReadFromDisk(block_undo, pindex));
+        CBlockStats expected;
+        ComputeBlockStats(block, block_undo, expected);
+
+        BOOST_REQUIRE(index.LookupStats(pindex, stats));
+        BOOST_CHECK_EQUAL(stats.nTxs, expected.nTxs);
+        BOOST_CHECK_EQUAL(stats.nInputs, expected.nInputs);
+        BOOST_CHECK_EQUAL(stats.nOutputs, expected.nOutputs);
+        BOOST_CHECK_EQUAL(stats.nTotalFee, expected.nTotalFee);
+        BOOST_CHECK_EQUAL(stats.nTotalSize, expected.nTotalSize);
+        BOOST_CHECK_EQUAL(stats.nUTXOSizeIncrease, expected.nUTXOSizeIncrease);
+    }
+
+    BOOST_REQUIRE(index.LookupStats(chainActive.Tip(), stats));
+    BOOST_CHECK_EQUAL(stats.nTxs, 2);
+    BOOST_CHECK_EQUAL(stats.nInputs, 1);
+    BOOST_CHECK_EQUAL(stats.nTotalFee, 1000);
+    BOOST_CHECK_EQUAL(stats.nMinFee, 1000);
+    BOOST_CHECK_EQUAL(stats.nMaxFee, 1000);
+    BOOST_CHECK_EQUAL(stats.nMedianFee, 1000);
+    BOOST_CHECK_EQUAL(stats.nTotalSize, (int64_t)CTransaction(spend).GetTotalSize());
+
+    index.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -586,7 +586,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map(0, SaltedOutpointHasher(), std::equal_to<COutPoint>(), CCoinsMapAllocator(&resource));
     InsertCoinsMapEntry(map, value, flags);
     view.BatchWrite(map, {});
 }
@@ -855,4 +856,37 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_prefetch)
+{
+    CCoinsViewTest base;
+    COutPoint outpoint1(InsecureRand256(), 0);
+    COutPoint outpoint2(InsecureRand256(), 1);
+    Coin coin(CTxOut(1000, CScript() << OP_TRUE), 1, false);
+    {
+        CCoinsViewCacheTest cache(&base);
+        cache.AddCoin(outpoint1, Coin(coin), false);
+        cache.AddCoin(outpoint2, Coin(coin), false);
+        BOOST_CHECK(cache.Flush());
+    }
+
+    CCoinsViewCacheTest cache(&base);
+    BOOST_CHECK(cache.SpendCoin(outpoint1));
+
+    // A prefetched coin must not replace the more recent entry in the cache
+    Coin prefetched1;
+    BOOST_CHECK(base.GetCoin(outpoint1, prefetched1));
+    cache.AddPrefetchedCoin(outpoint1, std::move(prefetched1));
+    BOOST_CHECK(!cache.HaveCoin(outpoint1));
+    BOOST_CHECK_EQUAL(cache.map().at(outpoint1).flags, CCoinsCacheEntry::DIRTY);
+
+    // Coins missing from the cache are added unmodified, as if fetched from the base
+    Coin prefetched2;
+    BOOST_CHECK(base.GetCoin(outpoint2, prefetched2));
+    cache.AddPrefetchedCoin(outpoint2, std::move(prefetched2));
+    BOOST_CHECK(cache.HaveCoinInCache(outpoint2));
+    BOOST_CHECK_EQUAL(cache.map().at(outpoint2).flags, 0);
+    BOOST_CHECK(cache.AccessCoin(outpoint2).out == coin.out);
+    cache.SelfTest();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
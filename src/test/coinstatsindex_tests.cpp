@@ -0,0 +1,165 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/validation.h>
+#include <crypto/muhash.h>
+#include <index/coinstatsindex.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/test_machinecoin.h>
+#include <txdb.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(coinstatsindex_tests)
+
+/** Compute the statistics of the UTXO set by scanning the coins database */
+static CIndexedCoinsStats ScanUTXOSet()
+{
+    FlushStateToDisk();
+
+    CIndexedCoinsStats stats;
+    MuHash3072 muhash;
+    std::set<uint256> txids;
+    std::unique_ptr<CCoinsViewCursor> cursor(pcoinsdbview->Cursor());
+    for (; cursor->Valid(); cursor->Next()) {
+        COutPoint key;
+        Coin coin;
+        BOOST_REQUIRE(cursor->GetKey(key) && cursor->GetValue(coin));
+
+        CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+        ss << key << (uint32_t)(coin.nHeight * 2 + coin.fCoinBase) << coin.out;
+        muhash.Insert((const unsigned char*)ss.data(), ss.size());
+        txids.insert(key.hash);
+        stats.nTransactionOutputs++;
+        stats.nBogoSize += 50 + coin.out.scriptPubKey.size();
+        stats.nTotalAmount += coin.out.nValue;
+    }
+    stats.nTransactions = txids.size();
+    muhash.Finalize(stats.hashMuHash);
+    return stats;
+}
+
+static void CheckStats(const CoinStatsIndex& index)
+{
+    const CIndexedCoinsStats expected = ScanUTXOSet();
+    CIndexedCoinsStats stats;
+    BOOST_REQUIRE(index.LookupStats(chainActive.Tip(), stats));
+    BOOST_CHECK(stats.hashMuHash == expected.hashMuHash);
+    BOOST_CHECK_EQUAL(stats.nTransactions, expected.nTransactions);
+    BOOST_CHECK_EQUAL(stats.nTransactionOutputs, expected.nTransactionOutputs);
+    BOOST_CHECK_EQUAL(stats.nBogoSize, expected.nBogoSize);
+    BOOST_CHECK_EQUAL(stats.nTotalAmount, expected.nTotalAmount);
+}
+
+BOOST_FIXTURE_TEST_CASE(coinstatsindex_initial_sync, TestChain100Setup)
+{
+    CoinStatsIndex index(1 << 20, true);
+
+    CIndexedCoinsStats stats;
+    BOOST_CHECK(!index.LookupStats(chainActive.Tip(), stats));
+
+    index.Start();
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // Every block of the chain has its statistics
+    for (int height = 0; height <= chainActive.Height(); height++) {
+        BOOST_CHECK(index.LookupStats(chainActive[height], stats));
+    }
+    CheckStats(index);
+
+    // Blocks spending outputs are indexed as they are connected
+    CScript coinbase_script_pub_key = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    for (int i = 0; i < 5; i++) {
+        CMutableTransaction spend;
+        spend.vin.resize(1);
+        spend.vin[0].prevout = COutPoint(m_coinbase_txns[i]->GetHash(), 0);
+        spend.vout.resize(2);
+        spend.vout[0].nValue = m_coinbase_txns[i]->vout[0].nValue / 2;
+        spend.vout[0].scriptPubKey = coinbase_script_pub_key;
+        spend.vout[1].nValue = m_coinbase_txns[i]->vout[0].nValue / 4;
+        spend.vout[1].scriptPubKey = coinbase_script_pub_key;
+
+        std::vector<unsigned char> sig;
+        uint256 hash = SignatureHash(coinbase_script_pub_key, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_REQUIRE(coinbaseKey.Sign(hash, sig));
+        sig.push_back((unsigned char)SIGHASH_ALL);
+        spend.vin[0].scriptSig << sig;
+
+        CreateAndProcessBlock({spend}, coinbase_script_pub_key);
+        BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+        CheckStats(index);
+    }
+
+    index.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_FIXTURE_TEST_CASE(coinstatsindex_reorg, TestChain100Setup)
+{
+    CoinStatsIndex index(1 << 20, true);
+    index.Start();
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    CIndexedCoinsStats stats_before;
+    BOOST_REQUIRE(index.LookupStats(chainActive.Tip(), stats_before));
+
+    // Connect a block spending a coinbase output
+    CScript coinbase_script_pub_key = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue / 2;
+    spend.vout[0].scriptPubKey = coinbase_script_pub_key;
+    std::vector<unsigned char> sig;
+    uint256 hash = SignatureHash(coinbase_script_pub_key, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign(hash, sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+
+    CreateAndProcessBlock({spend}, coinbase_script_pub_key);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    CheckStats(index);
+    CIndexedCoinsStats stats_spend;
+    BOOST_REQUIRE(index.LookupStats(chainActive.Tip(), stats_spend));
+    BOOST_CHECK(stats_spend.hashMuHash != stats_before.hashMuHash);
+
+    // Disconnect it and connect a block with no spends instead, which has the index undo the
+    // spend before applying the new block
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(InvalidateBlock(state, Params(), chainActive.Tip()));
+    }
+    CValidationState state;
+    BOOST_CHECK(ActivateBestChain(state, Params()));
+    mempool.clear();
+    CreateAndProcessBlock({}, coinbase_script_pub_key);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    CheckStats(index);
+
+    // The spend was undone, only the new coinbase transaction was added
+    CIndexedCoinsStats stats_replaced;
+    BOOST_REQUIRE(index.LookupStats(chainActive.Tip(), stats_replaced));
+    BOOST_CHECK(stats_replaced.hashMuHash != stats_spend.hashMuHash);
+    BOOST_CHECK_EQUAL(stats_replaced.nTransactions, stats_before.nTransactions + 1);
+
+    index.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_AUTO_TEST_SUITE_END()
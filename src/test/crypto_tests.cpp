@@ -10,7 +10,9 @@
 #include <crypto/sha512.h>
 #include <crypto/hmac_sha256.h>
 #include <crypto/hmac_sha512.h>
+#include <crypto/muhash.h>
 #include <random.h>
+#include <streams.h>
 #include <utilstrencodings.h>
 #include <test/test_machinecoin.h>
 
@@ -562,4 +564,43 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+static MuHash3072 FromInt(unsigned char i)
+{
+    unsigned char tmp[32] = {i, 0};
+    return MuHash3072().Insert(tmp, sizeof(tmp));
+}
+
+BOOST_AUTO_TEST_CASE(muhash_tests)
+{
+    uint256 out;
+
+    MuHash3072 acc = FromInt(0);
+    acc *= FromInt(1);
+    acc /= FromInt(2);
+    acc.Finalize(out);
+    BOOST_CHECK_EQUAL(out.GetHex(), "10d312b100cbd32ada024a6646e40d3482fcff103668d2625f10002a607d5863");
+
+    // The hash doesn't depend on the order of insertions and removals
+    unsigned char data[4][32];
+    for (int i = 0; i < 4; i++) {
+        GetRandBytes(data[i], sizeof(data[i]));
+    }
+    MuHash3072 acc1, acc2;
+    acc1.Insert(data[0], 32).Insert(data[1], 32).Insert(data[2], 32).Remove(data[1], 32);
+    acc2.Remove(data[3], 32).Insert(data[2], 32).Insert(data[3], 32).Insert(data[0], 32);
+    uint256 out1, out2;
+    acc1.Finalize(out1);
+    acc2.Finalize(out2);
+    BOOST_CHECK(out1 == out2);
+
+    // Removing every element gives the hash of the empty set, also after serialization
+    CDataStream ss(SER_DISK, 0);
+    ss << acc1;
+    MuHash3072 acc3;
+    ss >> acc3;
+    acc3.Remove(data[0], 32).Remove(data[2], 32).Finalize(out1);
+    MuHash3072().Finalize(out2);
+    BOOST_CHECK(out1 == out2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
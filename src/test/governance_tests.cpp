@@ -0,0 +1,139 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <ctpl.h>
+#include <evo/deterministicmns.h>
+#include <evo/evodb.h>
+#include <governance.h>
+#include <governance-vote.h>
+#include <key.h>
+#include <masternode.h>
+#include <masternodeman.h>
+#include <test/test_machinecoin.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+struct GovernanceVoteSetup : public BasicTestingSetup
+{
+    // Looking up masternodes needs to know whether the deterministic list is active
+    const bool fOwnEvo;
+
+    GovernanceVoteSetup() : fOwnEvo(deterministicMNManager == nullptr)
+    {
+        if (fOwnEvo) {
+            evoDb = new CEvoDB(1 << 20, true, true);
+            deterministicMNManager = new CDeterministicMNManager(*evoDb);
+        }
+    }
+
+    ~GovernanceVoteSetup()
+    {
+        mnodeman.Clear();
+        if (fOwnEvo) {
+            delete deterministicMNManager;
+            deterministicMNManager = nullptr;
+            delete evoDb;
+            evoDb = nullptr;
+        }
+    }
+
+    /** Add a legacy masternode whose operator and voting key is key */
+    void AddMasternode(const COutPoint& outpoint, const CKey& key)
+    {
+        CKey keyCollateral;
+        keyCollateral.MakeNewKey(true);
+        CMasternode mn(CService(), outpoint, keyCollateral.GetPubKey(), key.GetPubKey(), PROTOCOL_VERSION);
+        BOOST_REQUIRE(mnodeman.Add(mn));
+    }
+};
+
+CKey MakeKey()
+{
+    CKey key;
+    key.MakeNewKey(true);
+    return key;
+}
+
+CGovernanceVote MakeVote(const COutPoint& outpoint, const CKey& key)
+{
+    CGovernanceVote vote(outpoint, InsecureRand256(), VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+    BOOST_REQUIRE(vote.Sign(key, key.GetPubKey().GetID()));
+    return vote;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(governance_tests, GovernanceVoteSetup)
+
+BOOST_AUTO_TEST_CASE(check_vote_signatures)
+{
+    CKey key = MakeKey();
+    COutPoint outpoint(InsecureRand256(), 0);
+    AddMasternode(outpoint, key);
+
+    CGovernanceVote validVote = MakeVote(outpoint, key);
+    CGovernanceVote badSigVote = MakeVote(outpoint, MakeKey());
+    CGovernanceVote unknownMnVote = MakeVote(COutPoint(InsecureRand256(), 0), key);
+
+    std::vector<vote_sig_check_t> vecSigChecks = CGovernanceManager::CheckVoteSignatures({validVote, badSigVote, unknownMnVote}, {true, false, true});
+    BOOST_REQUIRE_EQUAL(vecSigChecks.size(), 3U);
+
+    BOOST_CHECK_EQUAL(vecSigChecks[0].eStatus, VOTE_SIG_VALID);
+    BOOST_CHECK(vecSigChecks[0].keyID == key.GetPubKey().GetID());
+    BOOST_CHECK(validVote.IsValid(true, vecSigChecks[0]));
+
+    // Checked with the operator key, which is the same key for legacy masternodes
+    BOOST_CHECK_EQUAL(vecSigChecks[1].eStatus, VOTE_SIG_INVALID);
+    BOOST_CHECK(vecSigChecks[1].keyID == key.GetPubKey().GetID());
+    BOOST_CHECK(!badSigVote.IsValid(false, vecSigChecks[1]));
+
+    // Unknown masternodes are left to ProcessVote
+    BOOST_CHECK_EQUAL(vecSigChecks[2].eStatus, VOTE_SIG_UNCHECKED);
+}
+
+BOOST_AUTO_TEST_CASE(check_vote_signatures_key_changed)
+{
+    CKey keyOld = MakeKey();
+    CKey keyNew = MakeKey();
+    COutPoint outpoint(InsecureRand256(), 0);
+    AddMasternode(outpoint, keyOld);
+
+    CGovernanceVote voteOld = MakeVote(outpoint, keyOld);
+    CGovernanceVote voteNew = MakeVote(outpoint, keyNew);
+    std::vector<vote_sig_check_t> vecSigChecks = CGovernanceManager::CheckVoteSignatures({voteOld, voteNew}, {true, true});
+    BOOST_CHECK_EQUAL(vecSigChecks[0].eStatus, VOTE_SIG_VALID);
+    BOOST_CHECK_EQUAL(vecSigChecks[1].eStatus, VOTE_SIG_INVALID);
+
+    // The masternode list changes before the votes are processed. The results of the earlier
+    // checks don't apply to the new key, the signatures are checked again.
+    mnodeman.Clear();
+    AddMasternode(outpoint, keyNew);
+    BOOST_CHECK(!voteOld.IsValid(true, vecSigChecks[0]));
+    BOOST_CHECK(voteNew.IsValid(true, vecSigChecks[1]));
+}
+
+BOOST_AUTO_TEST_CASE(check_vote_signatures_batches)
+{
+    CKey key = MakeKey();
+    COutPoint outpoint(InsecureRand256(), 0);
+    AddMasternode(outpoint, key);
+
+    // Several batches verified in parallel, every third vote has a bad signature
+    std::vector<CGovernanceVote> vecVotes;
+    for (size_t i = 0; i < 3 * GOVERNANCE_VOTE_VERIFY_BATCH_SIZE + 1; i++) {
+        vecVotes.emplace_back(MakeVote(outpoint, i % 3 == 0 ? MakeKey() : key));
+    }
+    ctpl::thread_pool pool(2);
+    std::vector<vote_sig_check_t> vecSigChecks = CGovernanceManager::CheckVoteSignatures(vecVotes, std::vector<bool>(vecVotes.size(), true), &pool);
+    pool.stop(true);
+
+    BOOST_REQUIRE_EQUAL(vecSigChecks.size(), vecVotes.size());
+    for (size_t i = 0; i < vecVotes.size(); i++) {
+        BOOST_CHECK_EQUAL(vecSigChecks[i].eStatus, i % 3 == 0 ? VOTE_SIG_INVALID : VOTE_SIG_VALID);
+        BOOST_CHECK_EQUAL(vecVotes[i].IsValid(true, vecSigChecks[i]), i % 3 != 0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
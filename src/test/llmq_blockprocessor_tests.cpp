@@ -0,0 +1,235 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bls/bls.h>
+#include <bls/bls_worker.h>
+#include <chainparams.h>
+#include <evo/deterministicmns.h>
+#include <evo/evodb.h>
+#include <llmq/quorums_blockprocessor.h>
+#include <llmq/quorums_commitment.h>
+#include <llmq/quorums_utils.h>
+#include <test/test_machinecoin.h>
+#include <utiltime.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace llmq {
+struct CQuorumBlockProcessorTest {
+    typedef std::shared_ptr<CQuorumBlockProcessor::PendingCommitment> PendingCommitmentPtr;
+
+    static void PreVerifyCommitmentSigs(CQuorumBlockProcessor& processor, const uint256& blockHash, const CFinalCommitment& qc, const std::vector<CDeterministicMNCPtr>& members)
+    {
+        processor.PreVerifyCommitmentSigs(blockHash, qc, members);
+    }
+    static std::map<uint256, std::shared_future<bool> > TakeBlockCommitmentSigs(CQuorumBlockProcessor& processor, const uint256& blockHash)
+    {
+        return processor.TakeBlockCommitmentSigs(blockHash);
+    }
+    static std::shared_future<bool> GetBlockCommitmentSig(CQuorumBlockProcessor& processor, const uint256& blockHash, const uint256& commitmentHash)
+    {
+        LOCK(processor.blockCommitmentSigsCs);
+        return processor.blockCommitmentSigs.at(blockHash).at(commitmentHash);
+    }
+    static size_t CountBlockCommitmentSigs(CQuorumBlockProcessor& processor)
+    {
+        LOCK(processor.blockCommitmentSigsCs);
+        size_t nCount = 0;
+        for (const auto& p : processor.blockCommitmentSigs) {
+            nCount += p.second.size();
+        }
+        return nCount;
+    }
+    static PendingCommitmentPtr AddPendingCommitment(CQuorumBlockProcessor& processor, const CFinalCommitment& qc, NodeId nodeId)
+    {
+        return processor.AddPendingCommitment(qc, nodeId);
+    }
+    static void VerifyPendingCommitment(CQuorumBlockProcessor& processor, const PendingCommitmentPtr& pending, const std::vector<CDeterministicMNCPtr>& members)
+    {
+        processor.VerifyPendingCommitment(pending, members);
+    }
+    static bool HasPendingCommitments(CQuorumBlockProcessor& processor)
+    {
+        LOCK(processor.pendingCommitmentsCs);
+        return !processor.pendingCommitments.empty();
+    }
+    static std::vector<NodeId> GetPendingPunishments(CQuorumBlockProcessor& processor)
+    {
+        LOCK(processor.pendingCommitmentsCs);
+        return processor.pendingPunishments;
+    }
+};
+} // namespace llmq
+
+using namespace llmq;
+
+namespace {
+const Consensus::LLMQType LLMQ_TYPE = Consensus::LLMQ_50_60;
+
+struct QuorumBlockProcessorSetup : public TestingSetup
+{
+    CEvoDB evoDb;
+    CBLSWorker blsWorker;
+    CQuorumBlockProcessor processor;
+
+    std::vector<CBLSSecretKey> memberKeys;
+    std::vector<CDeterministicMNCPtr> members;
+    CBLSSecretKey quorumKey;
+    const uint256 quorumHash;
+
+    QuorumBlockProcessorSetup() : evoDb(1 << 20, true, true), processor(evoDb, blsWorker), quorumHash(InsecureRand256())
+    {
+        const auto& params = Params().GetConsensus().llmqs.at(LLMQ_TYPE);
+        for (int i = 0; i < params.size; i++) {
+            CBLSSecretKey sk;
+            sk.MakeNewKey();
+            auto state = std::make_shared<CDeterministicMNState>();
+            state->pubKeyOperator = sk.GetPublicKey();
+            auto dmn = std::make_shared<CDeterministicMN>();
+            dmn->proTxHash = InsecureRand256();
+            dmn->pdmnState = state;
+            memberKeys.emplace_back(sk);
+            members.emplace_back(dmn);
+        }
+        quorumKey.MakeNewKey();
+    }
+
+    ~QuorumBlockProcessorSetup()
+    {
+        // the callbacks of network commitments reference the processor
+        blsWorker.Stop();
+    }
+
+    /** A commitment signed by the first nSigners members, with a quorum signature made by another key if !fValid */
+    CFinalCommitment MakeCommitment(int nSigners, bool fValid = true)
+    {
+        const auto& params = Params().GetConsensus().llmqs.at(LLMQ_TYPE);
+        CFinalCommitment qc(params, quorumHash);
+        qc.quorumPublicKey = quorumKey.GetPublicKey();
+        qc.quorumVvecHash = InsecureRand256();
+        for (int i = 0; i < params.size; i++) {
+            qc.validMembers[i] = true;
+        }
+
+        uint256 commitmentHash = CLLMQUtils::BuildCommitmentHash(qc.llmqType, qc.quorumHash, qc.validMembers, qc.quorumPublicKey, qc.quorumVvecHash);
+        std::vector<CBLSSignature> sigs;
+        std::vector<CBLSPublicKey> pubKeys;
+        for (int i = 0; i < nSigners; i++) {
+            qc.signers[i] = true;
+            sigs.emplace_back(memberKeys[i].Sign(commitmentHash));
+            pubKeys.emplace_back(memberKeys[i].GetPublicKey());
+        }
+        qc.membersSig = CBLSSignature::AggregateSecure(sigs, pubKeys, commitmentHash);
+
+        CBLSSecretKey otherKey;
+        otherKey.MakeNewKey();
+        qc.quorumSig = (fValid ? quorumKey : otherKey).Sign(commitmentHash);
+
+        BOOST_REQUIRE(qc.Verify(members, false));
+        return qc;
+    }
+
+    template <typename Predicate>
+    static bool WaitFor(Predicate pred)
+    {
+        for (int i = 0; i < 1000 && !pred(); i++) {
+            MilliSleep(10);
+        }
+        return pred();
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(llmq_blockprocessor_tests, QuorumBlockProcessorSetup)
+
+BOOST_AUTO_TEST_CASE(pre_verified_block_commitment)
+{
+    CFinalCommitment qcGood = MakeCommitment(45);
+    CFinalCommitment qcBad = MakeCommitment(45, false);
+    uint256 blockGood = InsecureRand256();
+    uint256 blockBad = InsecureRand256();
+
+    CQuorumBlockProcessorTest::PreVerifyCommitmentSigs(processor, blockGood, qcGood, members);
+    CQuorumBlockProcessorTest::PreVerifyCommitmentSigs(processor, blockBad, qcBad, members);
+    // already pending for this block
+    CQuorumBlockProcessorTest::PreVerifyCommitmentSigs(processor, blockGood, qcGood, members);
+    BOOST_CHECK_EQUAL(CQuorumBlockProcessorTest::CountBlockCommitmentSigs(processor), 2U);
+
+    // Processing a block only takes its own verifications, the other block's one is still pending
+    auto sigs = CQuorumBlockProcessorTest::TakeBlockCommitmentSigs(processor, blockGood);
+    BOOST_REQUIRE_EQUAL(sigs.size(), 1U);
+    BOOST_REQUIRE(sigs.count(::SerializeHash(qcGood)));
+    BOOST_CHECK(sigs.at(::SerializeHash(qcGood)).get());
+    BOOST_CHECK_EQUAL(CQuorumBlockProcessorTest::CountBlockCommitmentSigs(processor), 1U);
+    BOOST_CHECK(CQuorumBlockProcessorTest::TakeBlockCommitmentSigs(processor, blockGood).empty());
+
+    sigs = CQuorumBlockProcessorTest::TakeBlockCommitmentSigs(processor, blockBad);
+    BOOST_REQUIRE_EQUAL(sigs.size(), 1U);
+    BOOST_CHECK(!sigs.begin()->second.get());
+    BOOST_CHECK_EQUAL(CQuorumBlockProcessorTest::CountBlockCommitmentSigs(processor), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(pre_verified_block_commitments_limit)
+{
+    CFinalCommitment qc = MakeCommitment(45);
+    uint256 commitmentHash = ::SerializeHash(qc);
+
+    std::vector<std::shared_future<bool> > futures;
+    for (int i = 0; i < 32; i++) {
+        uint256 blockHash = InsecureRand256();
+        CQuorumBlockProcessorTest::PreVerifyCommitmentSigs(processor, blockHash, qc, members);
+        futures.emplace_back(CQuorumBlockProcessorTest::GetBlockCommitmentSig(processor, blockHash, commitmentHash));
+    }
+    BOOST_CHECK_EQUAL(CQuorumBlockProcessorTest::CountBlockCommitmentSigs(processor), 32U);
+    for (auto& f : futures) {
+        BOOST_CHECK(f.get());
+    }
+
+    // The finished verifications of blocks which were never connected make room for new ones
+    uint256 blockHash = InsecureRand256();
+    CQuorumBlockProcessorTest::PreVerifyCommitmentSigs(processor, blockHash, qc, members);
+    BOOST_CHECK_EQUAL(CQuorumBlockProcessorTest::CountBlockCommitmentSigs(processor), 1U);
+    BOOST_CHECK_EQUAL(CQuorumBlockProcessorTest::TakeBlockCommitmentSigs(processor, blockHash).size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(network_commitment_bad_sig)
+{
+    CFinalCommitment qc = MakeCommitment(45, false);
+    auto pending = CQuorumBlockProcessorTest::AddPendingCommitment(processor, qc, 7);
+    BOOST_REQUIRE(pending);
+    CQuorumBlockProcessorTest::VerifyPendingCommitment(processor, pending, members);
+
+    BOOST_CHECK(WaitFor([&]() { return !CQuorumBlockProcessorTest::GetPendingPunishments(processor).empty(); }));
+    BOOST_CHECK(CQuorumBlockProcessorTest::GetPendingPunishments(processor) == std::vector<NodeId>{7});
+    BOOST_CHECK(!CQuorumBlockProcessorTest::HasPendingCommitments(processor));
+    BOOST_CHECK(!processor.HasMinableCommitment(::SerializeHash(qc)));
+}
+
+BOOST_AUTO_TEST_CASE(network_commitment_better_cancels)
+{
+    CFinalCommitment qcWorse = MakeCommitment(45);
+    CFinalCommitment qcBetter = MakeCommitment(50);
+
+    auto pendingWorse = CQuorumBlockProcessorTest::AddPendingCommitment(processor, qcWorse, 1);
+    BOOST_REQUIRE(pendingWorse);
+    auto pendingBetter = CQuorumBlockProcessorTest::AddPendingCommitment(processor, qcBetter, 2);
+    BOOST_REQUIRE(pendingBetter);
+    BOOST_CHECK(pendingWorse->cancelled);
+    BOOST_CHECK(!pendingBetter->cancelled);
+
+    // an at least as good commitment is already being verified
+    BOOST_CHECK(!CQuorumBlockProcessorTest::AddPendingCommitment(processor, qcWorse, 3));
+    BOOST_CHECK(!CQuorumBlockProcessorTest::AddPendingCommitment(processor, qcBetter, 3));
+
+    // The cancelled verification doesn't report a result, only the better commitment becomes minable
+    CQuorumBlockProcessorTest::VerifyPendingCommitment(processor, pendingWorse, members);
+    CQuorumBlockProcessorTest::VerifyPendingCommitment(processor, pendingBetter, members);
+    BOOST_CHECK(WaitFor([&]() { return processor.HasMinableCommitment(::SerializeHash(qcBetter)); }));
+    blsWorker.Stop();
+    BOOST_CHECK(!processor.HasMinableCommitment(::SerializeHash(qcWorse)));
+    BOOST_CHECK(!CQuorumBlockProcessorTest::HasPendingCommitments(processor));
+    BOOST_CHECK(CQuorumBlockProcessorTest::GetPendingPunishments(processor).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,102 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <logging.h>
+
+#include <test/test_machinecoin.h>
+
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(logging_tests, BasicTestingSetup)
+
+static std::vector<std::string> ReadLogLines(const fs::path& path)
+{
+    std::vector<std::string> lines;
+    std::ifstream file(path.string());
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+BOOST_AUTO_TEST_CASE(logging_async)
+{
+    const fs::path path = SetDataDir("logging_async") / "debug.log";
+    {
+        MCLog::Logger logger;
+        logger.m_print_to_file = true;
+        logger.m_log_timestamps = false;
+        logger.m_file_path = path;
+        logger.LogPrintStr("before open\n");
+        BOOST_CHECK(logger.OpenDebugLog());
+
+        logger.StartAsync(1 << 20);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&logger, t] {
+                for (int i = 0; i < 1000; i++) {
+                    logger.LogPrintStr(strprintf("thread %d line %d\n", t, i));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        logger.StopAsync();
+        BOOST_CHECK_EQUAL(logger.GetAsyncDroppedCount(), 0U);
+
+        // back to writing synchronously
+        logger.LogPrintStr("after async\n");
+    }
+
+    std::vector<std::string> lines = ReadLogLines(path);
+    BOOST_REQUIRE_EQUAL(lines.size(), 4002U);
+    BOOST_CHECK_EQUAL(lines.front(), "before open");
+    BOOST_CHECK_EQUAL(lines.back(), "after async");
+
+    // lines of each thread are written in the order they were logged
+    std::vector<int> next(4, 0);
+    for (size_t i = 1; i < lines.size() - 1; i++) {
+        int t, n;
+        BOOST_REQUIRE(sscanf(lines[i].c_str(), "thread %d line %d", &t, &n) == 2);
+        BOOST_REQUIRE(t >= 0 && t < 4);
+        BOOST_CHECK_EQUAL(n, next[t]++);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(logging_async_drop)
+{
+    const fs::path path = SetDataDir("logging_async_drop") / "debug.log";
+    {
+        MCLog::Logger logger;
+        logger.m_print_to_file = true;
+        logger.m_log_timestamps = false;
+        logger.m_file_path = path;
+        BOOST_CHECK(logger.OpenDebugLog());
+
+        // no line fits into the buffer
+        logger.StartAsync(0);
+        for (int i = 0; i < 10; i++) {
+            logger.LogPrintStr("dropped\n");
+        }
+        logger.StopAsync();
+        BOOST_CHECK_EQUAL(logger.GetAsyncDroppedCount(), 10U);
+    }
+
+    // the writer may have reported the drops in several parts
+    int nDropped = 0;
+    for (const std::string& line : ReadLogLines(path)) {
+        int n;
+        BOOST_REQUIRE(sscanf(line.c_str(), "%d log messages dropped", &n) == 1);
+        nDropped += n;
+    }
+    BOOST_CHECK_EQUAL(nDropped, 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
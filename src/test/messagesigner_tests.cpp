@@ -0,0 +1,49 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <messagesigner.h>
+
+#include <hash.h>
+#include <key.h>
+#include <test/test_machinecoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(messagesigner_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(messagesigner_verify_cached)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CKey keyOther;
+    keyOther.MakeNewKey(true);
+    CKeyID keyID = key.GetPubKey().GetID();
+    CKeyID keyIDOther = keyOther.GetPubKey().GetID();
+
+    uint256 hash = Hash(keyID.begin(), keyID.end());
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(CHashSigner::SignHash(hash, key, vchSig));
+
+    std::string strError;
+    // The second verification is answered by the cache and must give the same result
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(CHashSigner::VerifyHash(hash, keyID, vchSig, strError));
+        // A cached signature must not be valid for another key or hash
+        BOOST_CHECK(!CHashSigner::VerifyHash(hash, keyIDOther, vchSig, strError));
+        BOOST_CHECK(!CHashSigner::VerifyHash(Hash(hash.begin(), hash.end()), keyID, vchSig, strError));
+    }
+
+    std::vector<unsigned char> vchSigBad(vchSig);
+    vchSigBad[10] ^= 1;
+    BOOST_CHECK(!CHashSigner::VerifyHash(hash, keyID, vchSigBad, strError));
+
+    const std::string strMessage = "machinecoin";
+    BOOST_CHECK(CMessageSigner::SignMessage(strMessage, vchSig, key));
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(CMessageSigner::VerifyMessage(keyID, vchSig, strMessage, strError));
+        BOOST_CHECK(!CMessageSigner::VerifyMessage(keyID, vchSig, strMessage + "!", strError));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
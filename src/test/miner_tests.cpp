@@ -12,6 +12,7 @@
 #include <miner.h>
 #include <policy/policy.h>
 #include <pubkey.h>
+#include <script/interpreter.h>
 #include <script/standard.h>
 #include <txmempool.h>
 #include <uint256.h>
@@ -521,4 +522,88 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+BOOST_FIXTURE_TEST_CASE(BlockTemplateTracker_staleness, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    const CScript coinbaseScriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    TestMemPoolEntryHelper entry;
+    CBlockTemplateTracker tracker(chainparams);
+
+    // Add a transaction spending the first output of the i-th coinbase transaction to the mempool
+    auto addSpend = [&](int i, CAmount nFee) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(m_coinbase_txns[i]->GetHash(), 0);
+        tx.vout.resize(1);
+        tx.vout[0].nValue = m_coinbase_txns[i]->vout[0].nValue - nFee;
+        tx.vout[0].scriptPubKey = coinbaseScriptPubKey;
+        std::vector<unsigned char> vchSig;
+        uint256 hash = SignatureHash(coinbaseScriptPubKey, tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_REQUIRE(coinbaseKey.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[0].scriptSig << vchSig;
+        LOCK(mempool.cs);
+        mempool.addUnchecked(tx.GetHash(), entry.Fee(nFee).Time(GetTime()).SpendsCoinbase(true).FromTx(tx));
+        return MakeTransactionRef(tx);
+    };
+    // Assemble a template and have the tracker follow the mempool from there
+    auto assemble = [&]() {
+        unsigned int nTransactionsUpdated = mempool.GetTransactionsUpdated();
+        std::shared_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(chainparams).CreateNewBlock(scriptPubKey);
+        BOOST_REQUIRE(pblocktemplate);
+        tracker.Reset(pblocktemplate, nTransactionsUpdated, CBlockTemplateTracker::GetCommitmentsUpdated());
+        return pblocktemplate;
+    };
+    unsigned int nTransactionsUpdated;
+
+    // An addition paying less than the template's transactions which fits into the block could be selected
+    CTransactionRef txHigh = addSpend(0, 100000);
+    BOOST_CHECK_EQUAL(assemble()->block.vtx.size(), 2U);
+    BOOST_CHECK(tracker.IsUpToDate(nTransactionsUpdated));
+    CTransactionRef txLow = addSpend(1, 10000);
+    BOOST_CHECK(!tracker.IsUpToDate(nTransactionsUpdated));
+    // Once stale, a template stays stale
+    BOOST_CHECK(!tracker.IsUpToDate(nTransactionsUpdated));
+
+    // Removing a transaction not in the template, or adding one below -blockmintxfee, changes nothing
+    mempool.removeRecursive(*txLow);
+    BOOST_CHECK_EQUAL(assemble()->block.vtx.size(), 2U);
+    CTransactionRef txFree = addSpend(2, 0);
+    BOOST_CHECK(tracker.IsUpToDate(nTransactionsUpdated));
+    mempool.removeRecursive(*txFree);
+    BOOST_CHECK(tracker.IsUpToDate(nTransactionsUpdated));
+    BOOST_CHECK_EQUAL(nTransactionsUpdated, mempool.GetTransactionsUpdated());
+
+    // Removing a transaction of the template makes it stale
+    mempool.removeRecursive(*txHigh);
+    BOOST_CHECK(!tracker.IsUpToDate(nTransactionsUpdated));
+
+    // So does prioritising a transaction, which changes the mempool without a notification
+    txHigh = addSpend(0, 100000);
+    BOOST_CHECK_EQUAL(assemble()->block.vtx.size(), 2U);
+    mempool.PrioritiseTransaction(txHigh->GetHash(), 1000);
+    BOOST_CHECK(!tracker.IsUpToDate(nTransactionsUpdated));
+
+    // With the block full, an addition paying less than the template's transactions can't be selected,
+    // but one paying more can replace them
+    const size_t nTxSize = ::GetSerializeSize(*txHigh, SER_NETWORK, PROTOCOL_VERSION);
+    gArgs.ForceSetArg("-blockmaxweight", std::to_string(4000 + WITNESS_SCALE_FACTOR * (nTxSize + nTxSize / 2)));
+    CBlockTemplateTracker trackerFull(chainparams);
+    {
+        unsigned int nTransactionsUpdatedFull = mempool.GetTransactionsUpdated();
+        std::shared_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(chainparams).CreateNewBlock(scriptPubKey);
+        BOOST_REQUIRE(pblocktemplate);
+        BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 2U);
+        trackerFull.Reset(pblocktemplate, nTransactionsUpdatedFull, CBlockTemplateTracker::GetCommitmentsUpdated());
+    }
+    addSpend(1, 10000);
+    BOOST_CHECK(trackerFull.IsUpToDate(nTransactionsUpdated));
+    addSpend(2, 1000000);
+    BOOST_CHECK(!trackerFull.IsUpToDate(nTransactionsUpdated));
+    gArgs.ForceSetArg("-blockmaxweight", std::to_string(DEFAULT_BLOCK_MAX_WEIGHT));
+
+    mempool.clear();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
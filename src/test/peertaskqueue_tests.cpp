@@ -0,0 +1,155 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <peertaskqueue.h>
+#include <test/test_machinecoin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(peertaskqueue_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(peertaskqueue_per_peer_order)
+{
+    static const int PEERS = 10;
+    static const int TASKS = 200;
+
+    std::mutex cs;
+    std::vector<std::vector<int>> vResults(PEERS);
+    std::atomic<int> nRunningForPeer[PEERS];
+    std::atomic<bool> fConcurrentPeer{false};
+    for (auto& n : nRunningForPeer) n = 0;
+
+    CPeerTaskQueue queue(TASKS);
+    queue.Start(4, "test");
+    for (int i = 0; i < TASKS; i++) {
+        for (int peer = 0; peer < PEERS; peer++) {
+            BOOST_CHECK(queue.Push(peer, [&, peer, i] {
+                if (nRunningForPeer[peer]++ != 0) fConcurrentPeer = true;
+                {
+                    std::lock_guard<std::mutex> lock(cs);
+                    vResults[peer].push_back(i);
+                }
+                nRunningForPeer[peer]--;
+            }));
+        }
+    }
+    while (queue.GetQueueSize() != 0) {
+        MilliSleep(1);
+    }
+    queue.Stop();
+
+    BOOST_CHECK(!fConcurrentPeer);
+    for (int peer = 0; peer < PEERS; peer++) {
+        BOOST_CHECK_EQUAL(vResults[peer].size(), (size_t)TASKS);
+        for (int i = 0; i < (int)vResults[peer].size(); i++) {
+            BOOST_CHECK_EQUAL(vResults[peer][i], i);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(peertaskqueue_backpressure)
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    bool fRelease = false;
+    std::vector<CPeerTaskQueue::PeerId> vNotified;
+    auto notified = [&](CPeerTaskQueue::PeerId peer) {
+        std::lock_guard<std::mutex> lock(cs);
+        return std::count(vNotified.begin(), vNotified.end(), peer);
+    };
+
+    CPeerTaskQueue queue(2, [&](CPeerTaskQueue::PeerId peer) {
+        std::lock_guard<std::mutex> lock(cs);
+        vNotified.push_back(peer);
+    });
+    queue.Start(2, "test");
+
+    auto blocking = [&] {
+        std::unique_lock<std::mutex> lock(cs);
+        cond.wait(lock, [&] { return fRelease; });
+    };
+    BOOST_CHECK(queue.Push(1, blocking));
+    BOOST_CHECK(queue.Push(1, blocking));
+    BOOST_CHECK(queue.IsPeerFull(1));
+    BOOST_CHECK(!queue.Push(1, [] {}));
+    BOOST_CHECK_EQUAL(queue.GetPeerQueueSize(1), 2U);
+
+    // Other peers are not affected by a full peer
+    BOOST_CHECK(!queue.IsPeerFull(2));
+    std::atomic<bool> fOtherRan{false};
+    BOOST_CHECK(queue.Push(2, [&] { fOtherRan = true; }));
+    while (!fOtherRan) {
+        MilliSleep(1);
+    }
+    // A peer whose queue drained is notified as well
+    while (notified(2) == 0) {
+        MilliSleep(1);
+    }
+    BOOST_CHECK_EQUAL(notified(1), 0);
+
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fRelease = true;
+    }
+    cond.notify_all();
+    // The first task of the full peer finishing makes room, the second one drains its queue
+    while (queue.GetQueueSize() != 0) {
+        MilliSleep(1);
+    }
+    BOOST_CHECK(!queue.IsPeerFull(1));
+    while (notified(1) != 2) {
+        MilliSleep(1);
+    }
+    BOOST_CHECK_EQUAL(notified(2), 1);
+
+    queue.Stop();
+    BOOST_CHECK(!queue.Push(1, [] {}));
+}
+
+BOOST_AUTO_TEST_CASE(peertaskqueue_stop_drops_queued)
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    bool fRelease = false;
+    std::atomic<bool> fStarted{false};
+    std::atomic<int> nRan{0};
+
+    CPeerTaskQueue queue(10);
+    queue.Start(1, "test");
+    BOOST_CHECK(queue.Push(1, [&] {
+        fStarted = true;
+        std::unique_lock<std::mutex> lock(cs);
+        cond.wait(lock, [&] { return fRelease; });
+    }));
+    BOOST_CHECK(queue.Push(1, [&] { nRan++; }));
+    BOOST_CHECK(queue.Push(2, [&] { nRan++; }));
+    while (!fStarted) {
+        MilliSleep(1);
+    }
+
+    // Release the running task only once Stop() dropped the queued ones
+    std::thread release([&] {
+        while (queue.GetQueueSize() != 1) {
+            MilliSleep(1);
+        }
+        std::lock_guard<std::mutex> lock(cs);
+        fRelease = true;
+        cond.notify_all();
+    });
+    queue.Stop();
+    release.join();
+
+    BOOST_CHECK_EQUAL(nRan, 0);
+    BOOST_CHECK_EQUAL(queue.GetQueueSize(), 0U);
+    BOOST_CHECK_EQUAL(queue.GetPeerQueueSize(1), 0U);
+    BOOST_CHECK_EQUAL(queue.GetPeerQueueSize(2), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
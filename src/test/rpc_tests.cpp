@@ -8,6 +8,7 @@
 #include <core_io.h>
 #include <key_io.h>
 #include <netbase.h>
+#include <node/blockstats.h>
 
 #include <test/test_machinecoin.h>
 
@@ -9,6 +9,7 @@
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
 #include <validation.h>
+#include <messagesigner.h>
 #include <miner.h>
 #include <net_processing.h>
 #include <pow.h>
@@ -54,6 +55,7 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
     SetupEnvironment();
     SetupNetworking();
     InitSignatureCache();
+    InitMessageSignatureCache();
     InitScriptExecutionCache();
     fCheckBlockIndex = true;
     SelectParams(chainName);
@@ -65,4 +65,42 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Stop(); // Stop thread before calling destructor
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_parallel_sync, TestChain100Setup)
+{
+    // Extend the chain far enough for the sync to be split into ranges of blocks
+    CScript coinbase_script_pub_key = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+    std::vector<std::pair<uint256, uint256>> coinbase_txns;
+    for (int i = 0; i < 1100; i++) {
+        std::vector<CMutableTransaction> no_txns;
+        const CBlock& block = CreateAndProcessBlock(no_txns, coinbase_script_pub_key);
+        coinbase_txns.emplace_back(block.vtx[0]->GetHash(), block.GetHash());
+    }
+
+    TxIndex txindex(1 << 20, true);
+    txindex.Start(4);
+
+    constexpr int64_t timeout_ms = 60 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!txindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+    for (const auto& txn : coinbase_txns) {
+        if (!txindex.FindTx(txn.first, block_hash, tx_disk)) {
+            BOOST_ERROR("FindTx failed");
+        } else {
+            BOOST_CHECK(tx_disk->GetHash() == txn.first);
+            BOOST_CHECK(block_hash == txn.second);
+        }
+    }
+
+    txindex.Stop(); // Stop thread before calling destructor
+}
+
 BOOST_AUTO_TEST_SUITE_END()
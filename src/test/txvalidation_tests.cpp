@@ -8,6 +8,7 @@
 #include <consensus/validation.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
+#include <script/interpreter.h>
 #include <test/test_machinecoin.h>
 
 #include <boost/test/unit_test.hpp>
@@ -58,4 +59,54 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup)
     BOOST_CHECK_EQUAL(nDoS, 100);
 }
 
+/**
+ * Ensure that transactions, including chains of unconfirmed ones, survive a
+ * round trip through mempool.dat.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_dump_load, TestChain100Setup)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // A transaction spending a coinbase and a child spending it
+    std::vector<CMutableTransaction> txs(2);
+    for (size_t i = 0; i < txs.size(); i++) {
+        const CTransaction& txPrev = i == 0 ? *m_coinbase_txns[0] : CTransaction(txs[i - 1]);
+        txs[i].nVersion = 1;
+        txs[i].vin.resize(1);
+        txs[i].vin[0].prevout = COutPoint(txPrev.GetHash(), 0);
+        txs[i].vout.resize(1);
+        txs[i].vout[0].nValue = txPrev.vout[0].nValue - CENT;
+        txs[i].vout[0].scriptPubKey = scriptPubKey;
+
+        std::vector<unsigned char> vchSig;
+        uint256 hash = SignatureHash(scriptPubKey, txs[i], 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        txs[i].vin[0].scriptSig << vchSig;
+    }
+
+    {
+        LOCK(cs_main);
+        for (const CMutableTransaction& tx : txs) {
+            CValidationState state;
+            BOOST_CHECK(AcceptToMemoryPool(mempool, state, MakeTransactionRef(tx),
+                nullptr /* pfMissingInputs */,
+                nullptr /* plTxnReplaced */,
+                false /* bypass_limits */,
+                0 /* nAbsurdFee */));
+        }
+    }
+    BOOST_CHECK_EQUAL(mempool.size(), 2U);
+
+    BOOST_CHECK(DumpMempool());
+    mempool.clear();
+    BOOST_CHECK_EQUAL(mempool.size(), 0U);
+
+    BOOST_CHECK(LoadMempool());
+    BOOST_CHECK_EQUAL(mempool.size(), 2U);
+    for (const CMutableTransaction& tx : txs) {
+        BOOST_CHECK(mempool.exists(tx.GetHash()));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -181,4 +181,51 @@ BOOST_AUTO_TEST_CASE(processnewblock_signals_ordering)
     BOOST_CHECK_EQUAL(sub.m_expected_tip, chainActive.Tip()->GetBlockHash());
 }
 
+// Write a block like in the blk?????.dat files, only its first nTruncatedSize bytes if not 0
+static void WriteBlockFrame(CDataStream& stream, const CBlock& block, size_t nTruncatedSize = 0)
+{
+    CDataStream ssBlock(SER_DISK, CLIENT_VERSION);
+    ssBlock << block;
+    stream << Params().MessageStart() << (unsigned int)ssBlock.size();
+    stream.write(ssBlock.data(), nTruncatedSize ? nTruncatedSize : ssBlock.size());
+}
+
+BOOST_AUTO_TEST_CASE(loadexternalblockfile_corrupt)
+{
+    auto pblock1 = GoodBlock(Params().GenesisBlock().GetHash());
+    auto pblock2 = GoodBlock(pblock1->GetHash());
+    auto pblock3 = GoodBlock(pblock2->GetHash());
+    auto pblock4 = GoodBlock(pblock3->GetHash());
+    const unsigned int nSize2 = ::GetSerializeSize(*pblock2, SER_DISK, CLIENT_VERSION);
+
+    CDataStream stream(SER_DISK, CLIENT_VERSION);
+    WriteBlockFrame(stream, *pblock1);
+    // a corrupt block
+    stream << Params().MessageStart() << nSize2;
+    stream.write(std::vector<char>(nSize2, 0).data(), nSize2);
+    WriteBlockFrame(stream, *pblock2);
+    // a partially written block, its size covers the start of the next, complete, block
+    WriteBlockFrame(stream, *pblock3, 80);
+    WriteBlockFrame(stream, *pblock3);
+    WriteBlockFrame(stream, *pblock4);
+
+    fs::path path = GetDataDir() / "import.dat";
+    FILE* file = fsbridge::fopen(path, "wb+");
+    BOOST_REQUIRE(file);
+    BOOST_REQUIRE_EQUAL(fwrite(stream.data(), 1, stream.size(), file), stream.size());
+    rewind(file);
+    BOOST_CHECK(LoadExternalBlockFile(Params(), file));
+
+    // The file is scanned again after the blocks which couldn't be decoded, none of the complete blocks is missed
+    for (const auto& pblock : {pblock1, pblock2, pblock3, pblock4}) {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = LookupBlockIndex(pblock->GetHash());
+        BOOST_REQUIRE(pindex);
+        BOOST_CHECK(pindex->nStatus & BLOCK_HAVE_DATA);
+    }
+    CValidationState state;
+    BOOST_CHECK(ActivateBestChain(state, Params()));
+    BOOST_CHECK_EQUAL(chainActive.Tip()->GetBlockHash(), pblock4->GetHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/transaction.h>
+#include <scheduler.h>
+#include <test/test_machinecoin.h>
+#include <utiltime.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, TestingSetup)
+
+namespace {
+
+/** Counts the transactions added to the mempool, each once a gate is open */
+class TxCounter : public CValidationInterface
+{
+public:
+    std::atomic<int> m_started{0};
+    std::atomic<int> m_count{0};
+
+    TxCounter(std::string name, std::shared_future<void> gate) : m_name(std::move(name)), m_gate(gate) {}
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef& tx) override
+    {
+        m_started++;
+        m_gate.wait();
+        m_count++;
+    }
+
+    std::string GetSubscriberName() const override { return m_name; }
+
+private:
+    const std::string m_name;
+    std::shared_future<void> m_gate;
+};
+
+ValidationInterfaceQueueInfo GetQueueInfo(const std::string& name)
+{
+    for (const ValidationInterfaceQueueInfo& info : GetMainSignals().GetQueueInfo()) {
+        if (info.name == name) return info;
+    }
+    BOOST_FAIL("no queue for subscriber " + name);
+    return {};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(slow_subscriber_does_not_delay_others)
+{
+    // A second scheduler thread, so that both subscribers can be notified at once
+    threadGroup.create_thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+
+    std::promise<void> slow_gate;
+    std::promise<void> fast_gate;
+    fast_gate.set_value();
+    TxCounter slow("slow", slow_gate.get_future().share());
+    TxCounter fast("fast", fast_gate.get_future().share());
+    RegisterValidationInterface(&slow);
+    RegisterValidationInterface(&fast);
+
+    const CTransactionRef tx = MakeTransactionRef(CMutableTransaction());
+    for (int i = 0; i < 3; i++) {
+        GetMainSignals().TransactionAddedToMempool(tx);
+    }
+
+    // The fast subscriber gets all of its callbacks while the slow one is stuck in its first
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (GetQueueInfo("fast").delivered < 3) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(10);
+    }
+    BOOST_CHECK_EQUAL(fast.m_count, 3);
+    BOOST_CHECK_EQUAL(slow.m_count, 0);
+
+    ValidationInterfaceQueueInfo slow_info = GetQueueInfo("slow");
+    BOOST_CHECK(slow_info.pending >= 2);
+    BOOST_CHECK(slow_info.peak_pending >= 2);
+    BOOST_CHECK_EQUAL(slow_info.delivered, 0U);
+    ValidationInterfaceQueueInfo fast_info = GetQueueInfo("fast");
+    BOOST_CHECK_EQUAL(fast_info.pending, 0U);
+
+    // Syncing with the queue still waits for every subscriber
+    slow_gate.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(slow.m_count, 3);
+
+    UnregisterValidationInterface(&slow);
+    UnregisterValidationInterface(&fast);
+    for (const ValidationInterfaceQueueInfo& info : GetMainSignals().GetQueueInfo()) {
+        BOOST_CHECK(info.name != "slow" && info.name != "fast");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(unregister_waits_for_running_callback)
+{
+    std::promise<void> gate;
+    std::unique_ptr<TxCounter> counter = MakeUnique<TxCounter>("slow", gate.get_future().share());
+    RegisterValidationInterface(counter.get());
+
+    const CTransactionRef tx = MakeTransactionRef(CMutableTransaction());
+    GetMainSignals().TransactionAddedToMempool(tx);
+    GetMainSignals().TransactionAddedToMempool(tx);
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (counter->m_started < 1) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(10);
+    }
+
+    // Unregistering blocks while the first callback runs
+    std::atomic<bool> unregistered{false};
+    std::thread unregister_thread([&] {
+        UnregisterValidationInterface(counter.get());
+        unregistered = true;
+    });
+    MilliSleep(100);
+    BOOST_CHECK(!unregistered);
+
+    gate.set_value();
+    unregister_thread.join();
+    BOOST_CHECK(unregistered);
+
+    // The running callback finished, the pending one is dropped and never sees the deleted subscriber
+    BOOST_CHECK_EQUAL(counter->m_started, 1);
+    BOOST_CHECK_EQUAL(counter->m_count, 1);
+    counter.reset();
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -37,6 +37,16 @@ static const int64_t nMaxBlockDBCache = 2;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/machinecoin/machinecoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxTxIndexCache = 1024;
+//! Max memory allocated to block filter index DB specific cache, if -blockfilterindex (MiB)
+static const int64_t nMaxBlockFilterIndexCache = 1024;
+//! Max memory allocated to address index DB specific cache, if -addressindex (MiB)
+static const int64_t nMaxAddressIndexCache = 1024;
+//! Max memory allocated to spent index DB specific cache, if -spentindex (MiB)
+static const int64_t nMaxSpentIndexCache = 1024;
+//! Max memory allocated to coin stats index DB specific cache, if -coinstatsindex (MiB)
+static const int64_t nMaxCoinStatsIndexCache = 1024;
+//! Max memory allocated to block stats index DB specific cache, if -blockstatsindex (MiB)
+static const int64_t nMaxBlockStatsIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -54,9 +64,24 @@ public:
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
+    //! Cursor starting at the first coin of the transaction with the lowest txid not below start_txid.
+    //! Cursors created without a write in between see the same state of the database.
+    CCoinsViewCursor *Cursor(const uint256 &start_txid) const;
 
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
+
+    //! Mark the database as being loaded from a snapshot based on hashBlock. It is
+    //! inconsistent until FinishSnapshotLoad is called.
+    bool BeginSnapshotLoad(const uint256 &hashBlock);
+    //! Write coins of a snapshot. They are expected in database order, which the
+    //! database writes fastest.
+    bool WriteSnapshotCoins(const std::vector<std::pair<COutPoint, Coin> > &vCoins);
+    //! Mark the database as consistent with hashBlock after loading a snapshot.
+    bool FinishSnapshotLoad(const uint256 &hashBlock);
+    //! Erase all coins written while loading a snapshot into an empty database, and
+    //! make hashBlock the best block again.
+    bool AbortSnapshotLoad(const uint256 &hashBlock);
     size_t EstimateSize() const override;
 };
 
@@ -95,6 +120,8 @@ public:
     void ReadReindexing(bool &fReindexing);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    bool WriteSnapshotBase(const uint256 &hash, uint64_t nChainTx);
+    bool ReadSnapshotBase(uint256 &hash, uint64_t &nChainTx);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
 };
 
@@ -422,26 +422,26 @@ void CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
         bool ok = GetTxPayload(tx, proTx);
         assert(ok);
         if (!proTx.collateralOutpoint.hash.IsNull()) {
-            mapProTxRefs.emplace(tx.GetHash(), proTx.collateralOutpoint.hash);
+            addProTxConflictKey(ProTxConflictKey::Ref(tx.GetHash()), proTx.collateralOutpoint.hash);
         }
-        mapProTxAddresses.emplace(proTx.addr, tx.GetHash());
-        mapProTxPubKeyIDs.emplace(proTx.keyIDOwner, tx.GetHash());
-        mapProTxBlsPubKeyHashes.emplace(proTx.pubKeyOperator.GetHash(), tx.GetHash());
+        addProTxConflictKey(ProTxConflictKey::Address(proTx.addr), tx.GetHash());
+        addProTxConflictKey(ProTxConflictKey::OwnerKey(proTx.keyIDOwner), tx.GetHash());
+        addProTxConflictKey(ProTxConflictKey::OperatorKey(proTx.pubKeyOperator), tx.GetHash());
         if (!proTx.collateralOutpoint.hash.IsNull()) {
-            mapProTxCollaterals.emplace(proTx.collateralOutpoint, tx.GetHash());
+            addProTxConflictKey(ProTxConflictKey::Collateral(proTx.collateralOutpoint), tx.GetHash());
         }
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_SERVICE) {
         CProUpServTx proTx;
         bool ok = GetTxPayload(tx, proTx);
         assert(ok);
-        mapProTxRefs.emplace(proTx.proTxHash, tx.GetHash());
-        mapProTxAddresses.emplace(proTx.addr, tx.GetHash());
+        addProTxConflictKey(ProTxConflictKey::Ref(proTx.proTxHash), tx.GetHash());
+        addProTxConflictKey(ProTxConflictKey::Address(proTx.addr), tx.GetHash());
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
         CProUpRegTx proTx;
         bool ok = GetTxPayload(tx, proTx);
         assert(ok);
-        mapProTxRefs.emplace(proTx.proTxHash, tx.GetHash());
-        mapProTxBlsPubKeyHashes.emplace(proTx.pubKeyOperator.GetHash(), tx.GetHash());
+        addProTxConflictKey(ProTxConflictKey::Ref(proTx.proTxHash), tx.GetHash());
+        addProTxConflictKey(ProTxConflictKey::OperatorKey(proTx.pubKeyOperator), tx.GetHash());
         auto dmn = deterministicMNManager->GetListAtChainTip().GetMN(proTx.proTxHash);
         assert(dmn);
         newit->validForProTxKey = ::SerializeHash(dmn->pdmnState->pubKeyOperator);
@@ -452,7 +452,7 @@ void CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
         CProUpRevTx proTx;
         bool ok = GetTxPayload(tx, proTx);
         assert(ok);
-        mapProTxRefs.emplace(proTx.proTxHash, tx.GetHash());
+        addProTxConflictKey(ProTxConflictKey::Ref(proTx.proTxHash), tx.GetHash());
         auto dmn = deterministicMNManager->GetListAtChainTip().GetMN(proTx.proTxHash);
         assert(dmn);
         newit->validForProTxKey = ::SerializeHash(dmn->pdmnState->pubKeyOperator);
@@ -478,17 +478,6 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     } else
         vTxHashes.clear();
 
-    auto eraseProTxRef = [&](const uint256& proTxHash, const uint256& txHash) {
-        auto its = mapProTxRefs.equal_range(proTxHash);
-        for (auto it = its.first; it != its.second;) {
-            if (it->second == txHash) {
-                it = mapProTxRefs.erase(it);
-            } else {
-                ++it;
-            }
-        }
-    };
-
     if (it->GetTx().nType == TRANSACTION_PROVIDER_REGISTER) {
         CProRegTx proTx;
         if (!GetTxPayload(it->GetTx(), proTx)) {
@@ -497,24 +486,24 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
         if (!proTx.collateralOutpoint.IsNull()) {
             eraseProTxRef(it->GetTx().GetHash(), proTx.collateralOutpoint.hash);
         }
-        mapProTxAddresses.erase(proTx.addr);
-        mapProTxPubKeyIDs.erase(proTx.keyIDOwner);
-        mapProTxBlsPubKeyHashes.erase(proTx.pubKeyOperator.GetHash());
-        mapProTxCollaterals.erase(proTx.collateralOutpoint);
+        mapProTxConflicts.erase(ProTxConflictKey::Address(proTx.addr));
+        mapProTxConflicts.erase(ProTxConflictKey::OwnerKey(proTx.keyIDOwner));
+        mapProTxConflicts.erase(ProTxConflictKey::OperatorKey(proTx.pubKeyOperator));
+        mapProTxConflicts.erase(ProTxConflictKey::Collateral(proTx.collateralOutpoint));
     } else if (it->GetTx().nType == TRANSACTION_PROVIDER_UPDATE_SERVICE) {
         CProUpServTx proTx;
         if (!GetTxPayload(it->GetTx(), proTx)) {
             assert(false);
         }
         eraseProTxRef(proTx.proTxHash, it->GetTx().GetHash());
-        mapProTxAddresses.erase(proTx.addr);
+        mapProTxConflicts.erase(ProTxConflictKey::Address(proTx.addr));
     } else if (it->GetTx().nType == TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
         CProUpRegTx proTx;
         if (!GetTxPayload(it->GetTx(), proTx)) {
             assert(false);
         }
         eraseProTxRef(proTx.proTxHash, it->GetTx().GetHash());
-        mapProTxBlsPubKeyHashes.erase(proTx.pubKeyOperator.GetHash());
+        mapProTxConflicts.erase(ProTxConflictKey::OperatorKey(proTx.pubKeyOperator));
     } else if (it->GetTx().nType == TRANSACTION_PROVIDER_UPDATE_REVOKE) {
         CProUpRevTx proTx;
         if (!GetTxPayload(it->GetTx(), proTx)) {
@@ -647,30 +636,46 @@ void CTxMemPool::removeConflicts(const CTransaction &tx)
     }
 }
 
-void CTxMemPool::removeProTxPubKeyConflicts(const CTransaction &tx, const CKeyID &keyId)
+ProTxConflictKey ProTxConflictKey::Address(const CService& addr)
 {
-    if (mapProTxPubKeyIDs.count(keyId)) {
-        uint256 conflictHash = mapProTxPubKeyIDs[keyId];
-        if (conflictHash != tx.GetHash() && mapTx.count(conflictHash)) {
-            removeRecursive(mapTx.find(conflictHash)->GetTx(), MemPoolRemovalReason::CONFLICT);
-        }
+    // CService compares the IPv6 address and the port only
+    uint256 hash;
+    std::vector<unsigned char> vKey = addr.GetKey();
+    memcpy(hash.begin(), vKey.data(), 16);
+    return ProTxConflictKey(ADDRESS, hash, addr.GetPort());
+}
+
+ProTxConflictKey ProTxConflictKey::OwnerKey(const CKeyID& keyID)
+{
+    uint256 hash;
+    memcpy(hash.begin(), keyID.begin(), keyID.size());
+    return ProTxConflictKey(OWNER_KEY, hash);
+}
+
+void CTxMemPool::addProTxConflictKey(const ProTxConflictKey& key, const uint256& txHash)
+{
+    if (key.type == ProTxConflictKey::REF || !mapProTxConflicts.count(key)) {
+        mapProTxConflicts.emplace(key, txHash);
     }
 }
 
-void CTxMemPool::removeProTxPubKeyConflicts(const CTransaction &tx, const CBLSPublicKey &pubKey)
+void CTxMemPool::eraseProTxRef(const uint256& proTxHash, const uint256& txHash)
 {
-    if (mapProTxBlsPubKeyHashes.count(pubKey.GetHash())) {
-        uint256 conflictHash = mapProTxBlsPubKeyHashes[pubKey.GetHash()];
-        if (conflictHash != tx.GetHash() && mapTx.count(conflictHash)) {
-            removeRecursive(mapTx.find(conflictHash)->GetTx(), MemPoolRemovalReason::CONFLICT);
+    auto its = mapProTxConflicts.equal_range(ProTxConflictKey::Ref(proTxHash));
+    for (auto it = its.first; it != its.second;) {
+        if (it->second == txHash) {
+            it = mapProTxConflicts.erase(it);
+        } else {
+            ++it;
         }
     }
 }
 
-void CTxMemPool::removeProTxCollateralConflicts(const CTransaction &tx, const COutPoint &collateralOutpoint)
+void CTxMemPool::removeProTxKeyConflicts(const CTransaction &tx, const ProTxConflictKey &key)
 {
-    if (mapProTxCollaterals.count(collateralOutpoint)) {
-        uint256 conflictHash = mapProTxCollaterals[collateralOutpoint];
+    auto it = mapProTxConflicts.find(key);
+    if (it != mapProTxConflicts.end()) {
+        uint256 conflictHash = it->second;
         if (conflictHash != tx.GetHash() && mapTx.count(conflictHash)) {
             removeRecursive(mapTx.find(conflictHash)->GetTx(), MemPoolRemovalReason::CONFLICT);
         }
@@ -683,8 +688,8 @@ void CTxMemPool::removeProTxSpentCollateralConflicts(const CTransaction &tx)
     auto removeSpentCollateralConflict = [&](const uint256& proTxHash) {
         // Can't use equal_range here as every call to removeRecursive might invalidate iterators
         while (true) {
-            auto it = mapProTxRefs.find(proTxHash);
-            if (it == mapProTxRefs.end()) {
+            auto it = mapProTxConflicts.find(ProTxConflictKey::Ref(proTxHash));
+            if (it == mapProTxConflicts.end()) {
                 break;
             }
             auto conflictIt = mapTx.find(it->second);
@@ -693,17 +698,18 @@ void CTxMemPool::removeProTxSpentCollateralConflicts(const CTransaction &tx)
             } else {
                 // Should not happen as we track referencing TXs in addUnchecked/removeUnchecked.
                 // But lets be on the safe side and not run into an endless loop...
-                LogPrintf("%s: ERROR: found invalid TX ref in mapProTxRefs, proTxHash=%s, txHash=%s", __func__, proTxHash.ToString(), it->second.ToString());
-                mapProTxRefs.erase(it);
+                LogPrintf("%s: ERROR: found invalid TX ref in mapProTxConflicts, proTxHash=%s, txHash=%s", __func__, proTxHash.ToString(), it->second.ToString());
+                mapProTxConflicts.erase(it);
             }
         }
     };
     auto mnList = deterministicMNManager->GetListAtChainTip();
     for (const auto& in : tx.vin) {
-        auto collateralIt = mapProTxCollaterals.find(in.prevout);
-        if (collateralIt != mapProTxCollaterals.end()) {
-            // These are not yet mined ProRegTxs
-            removeSpentCollateralConflict(collateralIt->second);
+        auto collateralIt = mapProTxConflicts.find(ProTxConflictKey::Collateral(in.prevout));
+        if (collateralIt != mapProTxConflicts.end()) {
+            // These are not yet mined ProRegTxs. Copy the hash, the entry is erased with them
+            uint256 proTxHash = collateralIt->second;
+            removeSpentCollateralConflict(proTxHash);
         }
         auto dmn = mnList.GetMNByCollateral(in.prevout);
         if (dmn) {
@@ -716,7 +722,7 @@ void CTxMemPool::removeProTxSpentCollateralConflicts(const CTransaction &tx)
 void CTxMemPool::removeProTxKeyChangedConflicts(const CTransaction &tx, const uint256& proTxHash, const uint256& newKeyHash)
 {
     std::set<uint256> conflictingTxs;
-    for (auto its = mapProTxRefs.equal_range(proTxHash); its.first != its.second; ++its.first) {
+    for (auto its = mapProTxConflicts.equal_range(ProTxConflictKey::Ref(proTxHash)); its.first != its.second; ++its.first) {
         auto txit = mapTx.find(its.first->second);
         if (txit == mapTx.end()) {
             continue;
@@ -733,6 +739,12 @@ void CTxMemPool::removeProTxKeyChangedConflicts(const CTransaction &tx, const ui
 
 void CTxMemPool::removeProTxConflicts(const CTransaction &tx)
 {
+    // Only transactions in the conflict index are removed, and most blocks are connected
+    // without any ProTx in the mempool
+    if (mapProTxConflicts.empty()) {
+        return;
+    }
+
     removeProTxSpentCollateralConflicts(tx);
 
     if (tx.nType == TRANSACTION_PROVIDER_REGISTER) {
@@ -742,16 +754,11 @@ void CTxMemPool::removeProTxConflicts(const CTransaction &tx)
             return;
         }
 
-        if (mapProTxAddresses.count(proTx.addr)) {
-            uint256 conflictHash = mapProTxAddresses[proTx.addr];
-            if (conflictHash != tx.GetHash() && mapTx.count(conflictHash)) {
-                removeRecursive(mapTx.find(conflictHash)->GetTx(), MemPoolRemovalReason::CONFLICT);
-            }
-        }
-        removeProTxPubKeyConflicts(tx, proTx.keyIDOwner);
-        removeProTxPubKeyConflicts(tx, proTx.pubKeyOperator);
+        removeProTxKeyConflicts(tx, ProTxConflictKey::Address(proTx.addr));
+        removeProTxKeyConflicts(tx, ProTxConflictKey::OwnerKey(proTx.keyIDOwner));
+        removeProTxKeyConflicts(tx, ProTxConflictKey::OperatorKey(proTx.pubKeyOperator));
         if (!proTx.collateralOutpoint.hash.IsNull()) {
-            removeProTxCollateralConflicts(tx, proTx.collateralOutpoint);
+            removeProTxKeyConflicts(tx, ProTxConflictKey::Collateral(proTx.collateralOutpoint));
         }
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_SERVICE) {
         CProUpServTx proTx;
@@ -760,12 +767,7 @@ void CTxMemPool::removeProTxConflicts(const CTransaction &tx)
             return;
         }
 
-        if (mapProTxAddresses.count(proTx.addr)) {
-            uint256 conflictHash = mapProTxAddresses[proTx.addr];
-            if (conflictHash != tx.GetHash() && mapTx.count(conflictHash)) {
-                removeRecursive(mapTx.find(conflictHash)->GetTx(), MemPoolRemovalReason::CONFLICT);
-            }
-        }
+        removeProTxKeyConflicts(tx, ProTxConflictKey::Address(proTx.addr));
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
         CProUpRegTx proTx;
         if (!GetTxPayload(tx, proTx)) {
@@ -773,7 +775,7 @@ void CTxMemPool::removeProTxConflicts(const CTransaction &tx)
             return;
         }
 
-        removeProTxPubKeyConflicts(tx, proTx.pubKeyOperator);
+        removeProTxKeyConflicts(tx, ProTxConflictKey::OperatorKey(proTx.pubKeyOperator));
         removeProTxKeyChangedConflicts(tx, proTx.proTxHash, ::SerializeHash(proTx.pubKeyOperator));
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REVOKE) {
         CProUpRevTx proTx;
@@ -824,8 +826,7 @@ void CTxMemPool::_clear()
     mapLinks.clear();
     mapTx.clear();
     mapNextTx.clear();
-    mapProTxAddresses.clear();
-    mapProTxPubKeyIDs.clear();
+    mapProTxConflicts.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
     lastRollingFeeUpdate = GetTime();
@@ -1068,7 +1069,7 @@ bool CTxMemPool::existsProviderTxConflict(const CTransaction &tx) const {
     LOCK(cs);
 
     auto hasKeyChangeInMempool = [&](const uint256& proTxHash) {
-        for (auto its = mapProTxRefs.equal_range(proTxHash); its.first != its.second; ++its.first) {
+        for (auto its = mapProTxConflicts.equal_range(ProTxConflictKey::Ref(proTxHash)); its.first != its.second; ++its.first) {
             auto txit = mapTx.find(its.first->second);
             if (txit == mapTx.end()) {
                 continue;
@@ -1086,10 +1087,12 @@ bool CTxMemPool::existsProviderTxConflict(const CTransaction &tx) const {
             LogPrintf("%s: ERROR: Invalid transaction payload, tx: %s", __func__, tx.ToString());
             return true; // i.e. can't decode payload == conflict
         }
-        if (mapProTxAddresses.count(proTx.addr) || mapProTxPubKeyIDs.count(proTx.keyIDOwner) || mapProTxBlsPubKeyHashes.count(proTx.pubKeyOperator.GetHash()))
+        if (mapProTxConflicts.count(ProTxConflictKey::Address(proTx.addr)) ||
+            mapProTxConflicts.count(ProTxConflictKey::OwnerKey(proTx.keyIDOwner)) ||
+            mapProTxConflicts.count(ProTxConflictKey::OperatorKey(proTx.pubKeyOperator)))
             return true;
         if (!proTx.collateralOutpoint.hash.IsNull()) {
-            if (mapProTxCollaterals.count(proTx.collateralOutpoint)) {
+            if (mapProTxConflicts.count(ProTxConflictKey::Collateral(proTx.collateralOutpoint))) {
                 // there is another ProRegTx that refers to the same collateral
                 return true;
             }
@@ -1105,8 +1108,8 @@ bool CTxMemPool::existsProviderTxConflict(const CTransaction &tx) const {
             LogPrintf("%s: ERROR: Invalid transaction payload, tx: %s", __func__, tx.ToString());
             return true; // i.e. can't decode payload == conflict
         }
-        auto it = mapProTxAddresses.find(proTx.addr);
-        return it != mapProTxAddresses.end() && it->second != proTx.proTxHash;
+        auto it = mapProTxConflicts.find(ProTxConflictKey::Address(proTx.addr));
+        return it != mapProTxConflicts.end() && it->second != proTx.proTxHash;
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
         CProUpRegTx proTx;
         if (!GetTxPayload(tx, proTx)) {
@@ -1127,8 +1130,8 @@ bool CTxMemPool::existsProviderTxConflict(const CTransaction &tx) const {
             }
         }
 
-        auto it = mapProTxBlsPubKeyHashes.find(proTx.pubKeyOperator.GetHash());
-        return it != mapProTxBlsPubKeyHashes.end() && it->second != proTx.proTxHash;
+        auto it = mapProTxConflicts.find(ProTxConflictKey::OperatorKey(proTx.pubKeyOperator));
+        return it != mapProTxConflicts.end() && it->second != proTx.proTxHash;
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REVOKE) {
         CProUpRevTx proTx;
         if (!GetTxPayload(tx, proTx)) {
@@ -1407,3 +1410,5 @@ void CTxMemPool::GetTransactionAncestry(const uint256& txid, size_t& ancestors,
 }
 
 SaltedTxidHasher::SaltedTxidHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+SaltedProTxConflictKeyHasher::SaltedProTxConflictKeyHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
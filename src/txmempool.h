@@ -9,6 +9,7 @@
 #include <memory>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <string>
@@ -371,6 +372,53 @@ public:
     }
 };
 
+/**
+ * A key ProTxs in the mempool can conflict on, reduced to a hash and a number: the
+ * referred proTxHash, the IPv6 address and port of a service, the owner key id, the
+ * hash of the operator key or the collateral outpoint.
+ */
+struct ProTxConflictKey
+{
+    enum Type : uint8_t {
+        REF,        //!< proTxHash referred to, shared by all TXs that refer to an existing proTx
+        ADDRESS,
+        OWNER_KEY,
+        OPERATOR_KEY,
+        COLLATERAL,
+    };
+
+    uint256 hash;
+    uint32_t n;
+    Type type;
+
+    ProTxConflictKey(Type typeIn, const uint256& hashIn, uint32_t nIn = 0) : hash(hashIn), n(nIn), type(typeIn) {}
+
+    static ProTxConflictKey Ref(const uint256& proTxHash) { return ProTxConflictKey(REF, proTxHash); }
+    static ProTxConflictKey Address(const CService& addr);
+    static ProTxConflictKey OwnerKey(const CKeyID& keyID);
+    static ProTxConflictKey OperatorKey(const CBLSPublicKey& pubKey) { return ProTxConflictKey(OPERATOR_KEY, pubKey.GetHash()); }
+    static ProTxConflictKey Collateral(const COutPoint& outpoint) { return ProTxConflictKey(COLLATERAL, outpoint.hash, outpoint.n); }
+
+    friend bool operator==(const ProTxConflictKey& a, const ProTxConflictKey& b)
+    {
+        return a.type == b.type && a.n == b.n && a.hash == b.hash;
+    }
+};
+
+class SaltedProTxConflictKeyHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedProTxConflictKeyHasher();
+
+    size_t operator()(const ProTxConflictKey& key) const {
+        return SipHashUint256Extra(k0, k1, key.hash, key.n) + key.type;
+    }
+};
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain transactions
  * that may be included in the next block.
@@ -515,11 +563,12 @@ private:
     typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
     txlinksMap mapLinks;
 
-    std::multimap<uint256, uint256> mapProTxRefs; // proTxHash -> transaction (all TXs that refer to an existing proTx)
-    std::map<CService, uint256> mapProTxAddresses;
-    std::map<CKeyID, uint256> mapProTxPubKeyIDs;
-    std::map<uint256, uint256> mapProTxBlsPubKeyHashes;
-    std::map<COutPoint, uint256> mapProTxCollaterals;
+    // conflict key -> transaction. REF keys can map to several transactions, every other key
+    // maps to the first transaction indexed under it
+    std::unordered_multimap<ProTxConflictKey, uint256, SaltedProTxConflictKeyHasher> mapProTxConflicts;
+
+    void addProTxConflictKey(const ProTxConflictKey& key, const uint256& txHash);
+    void eraseProTxRef(const uint256& proTxHash, const uint256& txHash);
 
     void UpdateParent(txiter entry, txiter parent, bool add);
     void UpdateChild(txiter entry, txiter child, bool add);
@@ -556,9 +605,7 @@ public:
     void removeRecursive(const CTransaction &tx, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN);
     void removeForReorg(const CCoinsViewCache *pcoins, unsigned int nMemPoolHeight, int flags);
     void removeConflicts(const CTransaction &tx) EXCLUSIVE_LOCKS_REQUIRED(cs);
-    void removeProTxPubKeyConflicts(const CTransaction &tx, const CKeyID &keyId);
-    void removeProTxPubKeyConflicts(const CTransaction &tx, const CBLSPublicKey &pubKey);
-    void removeProTxCollateralConflicts(const CTransaction &tx, const COutPoint &collateralOutpoint);
+    void removeProTxKeyConflicts(const CTransaction &tx, const ProTxConflictKey &key);
     void removeProTxSpentCollateralConflicts(const CTransaction &tx);
     void removeProTxKeyChangedConflicts(const CTransaction &tx, const uint256& proTxHash, const uint256& newKeyHash);
     void removeProTxConflicts(const CTransaction &tx);
@@ -6,10 +6,12 @@
 #ifndef MACHINECOIN_UNDO_H
 #define MACHINECOIN_UNDO_H
 
+#include <coins.h>
 #include <compressor.h>
 #include <consensus/consensus.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
+#include <version.h>
 
 /** Undo information for a CTxIn
  *
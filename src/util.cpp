@@ -716,6 +716,8 @@ void PrintExceptionContinue(const std::exception* pex, const char* pszThread)
 {
     std::string message = FormatException(pex, pszThread);
     LogPrintf("\n\n************************\n%s\n", message);
+    // the thread is likely about to terminate the process, don't lose the line in the async log queue
+    g_logger->Flush();
     fprintf(stderr, "\n\n************************\n%s\n", message.c_str());
 }
 
@@ -1157,6 +1159,13 @@ void AllocateFileRange(FILE *file, unsigned int offset, unsigned int length) {
 #endif
 }
 
+void ReadAheadFile(FILE *file)
+{
+#if defined(__linux__)
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_WILLNEED);
+#endif
+}
+
 #ifdef WIN32
 fs::path GetSpecialFolderPath(int nFolder, bool fCreate)
 {
@@ -0,0 +1,600 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <utxosnapshot.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <coins.h>
+#include <consensus/validation.h>
+#include <hash.h>
+#include <index/addressindex.h>
+#include <index/blockfilterindex.h>
+#include <index/spentindex.h>
+#include <index/txindex.h>
+#include <streams.h>
+#include <txdb.h>
+#include <util.h>
+#include <validation.h>
+
+#include <evo/deterministicmns.h>
+#include <evo/evodb.h>
+#include <llmq/quorums_blockprocessor.h>
+
+#include <string.h>
+
+namespace {
+
+const unsigned char SNAPSHOT_MAGIC[5] = {'u', 't', 'x', 'o', 0xff};
+
+/** Types of the entries following the block headers of a snapshot */
+enum SnapshotEntryType : uint8_t
+{
+    SNAPSHOT_ENTRY_END = 0,
+    SNAPSHOT_ENTRY_COIN = 1,
+    SNAPSHOT_ENTRY_MNLIST_DIFF = 2,
+    SNAPSHOT_ENTRY_QUORUM_COMMITMENT = 3,
+};
+
+/** Number of coins passed to the coins database at a time when loading a snapshot */
+const size_t SNAPSHOT_LOAD_COINS_BATCH = 100000;
+
+struct CSnapshotHeader
+{
+    unsigned char pchMagic[sizeof(SNAPSHOT_MAGIC)];
+    uint16_t nVersion;
+    CMessageHeader::MessageStartChars pchMessageStart;
+    uint256 hashBaseBlock;
+    int32_t nBaseHeight;
+    uint64_t nChainTx;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(FLATDATA(pchMagic));
+        READWRITE(nVersion);
+        READWRITE(FLATDATA(pchMessageStart));
+        READWRITE(hashBaseBlock);
+        READWRITE(nBaseHeight);
+        READWRITE(nChainTx);
+    }
+};
+
+/** Key or value of a database entry, (de)serialized as its raw bytes */
+class CRawDBData
+{
+public:
+    std::vector<unsigned char> vch;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s.write((const char*)vch.data(), vch.size());
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        vch.resize(s.size());
+        s.read((char*)vch.data(), vch.size());
+    }
+};
+
+/** Writes to a file and hashes everything written, the counterpart of CHashVerifier */
+class CHashedFileWriter : public CHashWriter
+{
+private:
+    CAutoFile& file;
+
+public:
+    explicit CHashedFileWriter(CAutoFile& fileIn) : CHashWriter(fileIn.GetType(), fileIn.GetVersion()), file(fileIn) {}
+
+    void write(const char* pch, size_t nSize)
+    {
+        file.write(pch, nSize);
+        CHashWriter::write(pch, nSize);
+    }
+
+    template <typename T>
+    CHashedFileWriter& operator<<(const T& obj)
+    {
+        ::Serialize(*this, obj);
+        return *this;
+    }
+};
+
+/**
+ * Collect the evo data needed to connect the blocks after a snapshot base block: the masternode
+ * lists of the blocks since the quorum block of the previous DKG interval of every LLMQ type, as
+ * diffs of which the first one is from an empty list, and the quorum commitments mined up to the
+ * base block. The evo database itself holds the lists as hash maps, serialized in an order which
+ * depends on how they were built, and it isn't written to snapshots for that reason.
+ */
+void GetSnapshotEvoData(const Consensus::Params& consensusParams, const CBlockIndex* pindexBase,
+                        std::vector<CDeterministicMNListDiff>& vMNListDiffs, std::vector<llmq::CFinalCommitment>& vCommitments)
+{
+    AssertLockHeld(cs_main);
+
+    int nStartHeight = pindexBase->nHeight;
+    for (const auto& p : consensusParams.llmqs) {
+        const int nInterval = p.second.dkgInterval;
+        nStartHeight = std::min(nStartHeight, pindexBase->nHeight - (pindexBase->nHeight % nInterval) - nInterval);
+    }
+    CDeterministicMNList prevList;
+    for (int nHeight = std::max(nStartHeight, 1); nHeight <= pindexBase->nHeight; nHeight++) {
+        CDeterministicMNList list = deterministicMNManager->GetListForBlock(pindexBase->GetAncestor(nHeight)->GetBlockHash());
+        if (list.GetHeight() == -1) {
+            // deterministic masternodes weren't active yet
+            continue;
+        }
+        vMNListDiffs.emplace_back(prevList.BuildDiff(list));
+        prevList = list;
+    }
+
+    for (const auto& p : consensusParams.llmqs) {
+        for (int nHeight = 0; nHeight <= pindexBase->nHeight; nHeight += p.second.dkgInterval) {
+            llmq::CFinalCommitment qc;
+            if (llmq::quorumBlockProcessor->GetMinedCommitment(p.first, pindexBase->GetAncestor(nHeight)->GetBlockHash(), qc)) {
+                vCommitments.emplace_back(std::move(qc));
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool DumpUTXOSnapshot(const CChainParams& chainparams, const fs::path& path, CUTXOSnapshotInfo& info, std::string& strError)
+{
+    if (fs::exists(path)) {
+        strError = strprintf("%s already exists", path.string());
+        return false;
+    }
+
+    // Leveldb iterators see the databases as they were when the iterators were created. The evo
+    // data is much smaller than the UTXO set, it is collected while holding cs_main.
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::vector<CDeterministicMNListDiff> vMNListDiffs;
+    std::vector<llmq::CFinalCommitment> vCommitments;
+    const CBlockIndex* pindexBase;
+    {
+        LOCK(cs_main);
+        FlushStateToDisk();
+        pcursor.reset(pcoinsdbview->Cursor());
+        pindexBase = LookupBlockIndex(pcursor->GetBestBlock());
+        if (pindexBase == nullptr || pindexBase != chainActive.Tip() || pindexBase->nHeight == 0) {
+            strError = "The chainstate isn't at a block after the genesis block";
+            return false;
+        }
+        if (!evoDb->VerifyBestBlock(pindexBase->GetBlockHash())) {
+            strError = "The evo database isn't at the chain tip";
+            return false;
+        }
+        info.hashBaseBlock = pindexBase->GetBlockHash();
+        info.nBaseHeight = pindexBase->nHeight;
+        info.nChainTx = pindexBase->nChainTx;
+        GetSnapshotEvoData(chainparams.GetConsensus(), pindexBase, vMNListDiffs, vCommitments);
+    }
+
+    fs::path pathTmp = path;
+    pathTmp += ".incomplete";
+    FILE* file = fsbridge::fopen(pathTmp, "wb");
+    CAutoFile afile(file, SER_DISK, CLIENT_VERSION);
+    if (afile.IsNull()) {
+        strError = strprintf("Unable to open %s for writing", pathTmp.string());
+        return false;
+    }
+
+    try {
+        CHashedFileWriter writer(afile);
+
+        CSnapshotHeader header;
+        memcpy(header.pchMagic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.nVersion = UTXO_SNAPSHOT_VERSION;
+        memcpy(header.pchMessageStart, chainparams.MessageStart(), sizeof(header.pchMessageStart));
+        header.hashBaseBlock = info.hashBaseBlock;
+        header.nBaseHeight = info.nBaseHeight;
+        header.nChainTx = info.nChainTx;
+        writer << header;
+
+        // The headers of the blocks after the genesis block up to the base block
+        std::vector<CBlockHeader> vHeaders;
+        for (int nHeight = 1; nHeight <= info.nBaseHeight; nHeight += vHeaders.size()) {
+            vHeaders.clear();
+            {
+                LOCK(cs_main);
+                int nEnd = std::min<int>(nHeight + MAX_HEADERS_RESULTS, info.nBaseHeight + 1);
+                for (const CBlockIndex* pindex = pindexBase->GetAncestor(nEnd - 1); pindex->nHeight >= nHeight; pindex = pindex->pprev) {
+                    vHeaders.push_back(pindex->GetBlockHeader());
+                }
+            }
+            for (auto it = vHeaders.rbegin(); it != vHeaders.rend(); ++it) {
+                writer << *it;
+            }
+        }
+
+        // The coins, in database order
+        for (; pcursor->Valid(); pcursor->Next()) {
+            COutPoint outpoint;
+            Coin coin;
+            if (!pcursor->GetKey(outpoint) || !pcursor->GetValue(coin)) {
+                throw std::runtime_error("unable to read the coins database");
+            }
+            writer << (uint8_t)SNAPSHOT_ENTRY_COIN << outpoint << coin;
+            info.nCoins++;
+        }
+
+        // The masternode lists and quorums of the blocks before the base block can't be rebuilt
+        // without the blocks
+        for (const auto& diff : vMNListDiffs) {
+            writer << (uint8_t)SNAPSHOT_ENTRY_MNLIST_DIFF << diff;
+            info.nMNLists++;
+        }
+        for (const auto& qc : vCommitments) {
+            writer << (uint8_t)SNAPSHOT_ENTRY_QUORUM_COMMITMENT << qc;
+            info.nQuorumCommitments++;
+        }
+
+        writer << (uint8_t)SNAPSHOT_ENTRY_END;
+        info.hashContents = writer.GetHash();
+        afile << info.nCoins << info.nMNLists << info.nQuorumCommitments << info.hashContents;
+
+        if (!FileCommit(afile.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        afile.fclose();
+    } catch (const std::exception& e) {
+        afile.fclose();
+        fs::remove(pathTmp);
+        strError = strprintf("Unable to write the snapshot: %s", e.what());
+        return false;
+    }
+
+    if (!RenameOver(pathTmp, path)) {
+        fs::remove(pathTmp);
+        strError = strprintf("Unable to rename %s to %s", pathTmp.string(), path.string());
+        return false;
+    }
+
+    LogPrintf("Wrote UTXO snapshot at block %s (height %d) with %u coins, %u masternode lists and %u quorum commitments to %s\n",
+        info.hashBaseBlock.ToString(), info.nBaseHeight, info.nCoins, info.nMNLists, info.nQuorumCommitments, path.string());
+    return true;
+}
+
+/** Read the header and the block headers of a snapshot. With fApply, the block headers are processed. */
+static bool ReadSnapshotHeaders(const CChainParams& chainparams, CHashVerifier<CAutoFile>& verifier, bool fApply, CUTXOSnapshotInfo& info, std::string& strError)
+{
+    CSnapshotHeader header;
+    verifier >> header;
+    if (memcmp(header.pchMagic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        strError = "Not a UTXO snapshot";
+        return false;
+    }
+    if (header.nVersion != UTXO_SNAPSHOT_VERSION) {
+        strError = strprintf("Unsupported snapshot version %d", header.nVersion);
+        return false;
+    }
+    if (memcmp(header.pchMessageStart, chainparams.MessageStart(), sizeof(header.pchMessageStart)) != 0) {
+        strError = "The snapshot is for a different network";
+        return false;
+    }
+    if (header.nBaseHeight <= 0 || header.nChainTx == 0) {
+        strError = "Invalid snapshot base block";
+        return false;
+    }
+    info.hashBaseBlock = header.hashBaseBlock;
+    info.nBaseHeight = header.nBaseHeight;
+    info.nChainTx = header.nChainTx;
+
+    uint256 hashPrev = chainparams.GenesisBlock().GetHash();
+    std::vector<CBlockHeader> vHeaders;
+    for (int nHeight = 1; nHeight <= header.nBaseHeight; nHeight++) {
+        CBlockHeader blockHeader;
+        verifier >> blockHeader;
+        if (blockHeader.hashPrevBlock != hashPrev) {
+            strError = strprintf("The block header at height %d doesn't connect to the previous one", nHeight);
+            return false;
+        }
+        hashPrev = blockHeader.GetHash();
+        if (fApply) {
+            vHeaders.push_back(blockHeader);
+            if (vHeaders.size() == MAX_HEADERS_RESULTS || nHeight == header.nBaseHeight) {
+                CValidationState state;
+                if (!ProcessNewBlockHeaders(vHeaders, state, chainparams)) {
+                    strError = strprintf("Invalid block header: %s", FormatStateMessage(state));
+                    return false;
+                }
+                vHeaders.clear();
+            }
+        }
+    }
+    if (hashPrev != header.hashBaseBlock) {
+        strError = "The last block header isn't the snapshot base block";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Read the coins, masternode lists and quorum commitments of a snapshot and check them against the
+ * hash at the end of the file. With fApply, they are written to the databases as they are read.
+ */
+static bool ReadSnapshotEntries(CAutoFile& afile, CHashVerifier<CAutoFile>& verifier, bool fApply, CUTXOSnapshotInfo& info, std::string& strError)
+{
+    info.nCoins = 0;
+    info.nMNLists = 0;
+    info.nQuorumCommitments = 0;
+    std::vector<std::pair<COutPoint, Coin> > vCoins;
+    CDBBatch evoBatch(evoDb->GetRawDB());
+    auto writeEvoBatch = [&](bool fFinal) {
+        if (!fFinal && evoBatch.SizeEstimate() <= (size_t)nDefaultDbBatchSize) {
+            return true;
+        }
+        bool ret = evoDb->GetRawDB().WriteBatch(evoBatch, fFinal);
+        evoBatch.Clear();
+        return ret;
+    };
+    uint256 hashLastList;
+    int nLastListHeight = -1;
+
+    while (true) {
+        uint8_t nType;
+        verifier >> nType;
+        if (nType == SNAPSHOT_ENTRY_END) {
+            break;
+        } else if (nType == SNAPSHOT_ENTRY_COIN) {
+            COutPoint outpoint;
+            Coin coin;
+            verifier >> outpoint >> coin;
+            if (coin.IsSpent()) {
+                strError = "The snapshot contains a spent coin";
+                return false;
+            }
+            info.nCoins++;
+            if (fApply) {
+                vCoins.emplace_back(outpoint, std::move(coin));
+                if (vCoins.size() >= SNAPSHOT_LOAD_COINS_BATCH) {
+                    if (!pcoinsdbview->WriteSnapshotCoins(vCoins)) {
+                        strError = "Failed to write to the coins database";
+                        return false;
+                    }
+                    vCoins.clear();
+                }
+            }
+        } else if (nType == SNAPSHOT_ENTRY_MNLIST_DIFF) {
+            CDeterministicMNListDiff diff;
+            verifier >> diff;
+            // Every list follows the previous one, the first one is a diff from an empty list
+            if (diff.prevBlockHash != hashLastList || (nLastListHeight != -1 && diff.nHeight != nLastListHeight + 1)) {
+                strError = "The masternode lists of the snapshot don't follow each other";
+                return false;
+            }
+            hashLastList = diff.blockHash;
+            nLastListHeight = diff.nHeight;
+            info.nMNLists++;
+            if (fApply) {
+                if (diff.prevBlockHash.IsNull()) {
+                    CDeterministicMNList list(diff.blockHash, diff.nHeight);
+                    for (const auto& p : diff.addedMNs) {
+                        list.AddMN(p.second);
+                    }
+                    list.ClearChangedMNs();
+                    deterministicMNManager->WriteListToBatch(evoBatch, list);
+                } else {
+                    deterministicMNManager->WriteListDiffToBatch(evoBatch, diff);
+                }
+                if (!writeEvoBatch(false)) {
+                    strError = "Failed to write to the evo database";
+                    return false;
+                }
+            }
+        } else if (nType == SNAPSHOT_ENTRY_QUORUM_COMMITMENT) {
+            llmq::CFinalCommitment qc;
+            verifier >> qc;
+            info.nQuorumCommitments++;
+            if (fApply) {
+                llmq::quorumBlockProcessor->WriteMinedCommitmentToBatch(evoBatch, qc);
+                if (!writeEvoBatch(false)) {
+                    strError = "Failed to write to the evo database";
+                    return false;
+                }
+            }
+        } else {
+            strError = strprintf("Unknown snapshot entry type %d", nType);
+            return false;
+        }
+    }
+
+    uint64_t nCoins;
+    uint64_t nMNLists;
+    uint64_t nQuorumCommitments;
+    uint256 hashContents;
+    afile >> nCoins >> nMNLists >> nQuorumCommitments >> hashContents;
+    if (verifier.GetHash() != hashContents || nCoins != info.nCoins || nMNLists != info.nMNLists ||
+        nQuorumCommitments != info.nQuorumCommitments) {
+        strError = "The snapshot doesn't match its hash";
+        return false;
+    }
+    info.hashContents = hashContents;
+    if (info.nMNLists > 0 && hashLastList != info.hashBaseBlock) {
+        strError = "The masternode lists of the snapshot don't end at the base block";
+        return false;
+    }
+
+    if (fApply) {
+        evoBatch.Write(EVODB_BEST_BLOCK, info.hashBaseBlock);
+        if (!pcoinsdbview->WriteSnapshotCoins(vCoins) || !writeEvoBatch(true)) {
+            strError = "Failed to write the snapshot to the databases";
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef std::vector<std::pair<CRawDBData, CRawDBData> > RawDBEntries;
+
+static RawDBEntries ReadEvoDB()
+{
+    RawDBEntries vEntries;
+    std::unique_ptr<CDBIterator> pIter(evoDb->GetRawDB().NewIterator());
+    for (pIter->SeekToFirst(); pIter->Valid(); pIter->Next()) {
+        vEntries.emplace_back();
+        if (!pIter->GetKey(vEntries.back().first) || !pIter->GetValue(vEntries.back().second)) {
+            throw std::runtime_error("unable to read the evo database");
+        }
+    }
+    return vEntries;
+}
+
+/** Undo a partially loaded snapshot, restoring the coins database at hashBestBlock and the evo database entries */
+static void RollbackSnapshotLoad(const uint256& hashBestBlock, const RawDBEntries& vEvoEntries)
+{
+    LogPrintf("Rolling back the partially loaded UTXO snapshot\n");
+    if (!pcoinsdbview->AbortSnapshotLoad(hashBestBlock)) {
+        throw std::runtime_error("failed to roll back the coins database");
+    }
+    CDBWrapper& evoRawDB = evoDb->GetRawDB();
+    CDBBatch batch(evoRawDB);
+    std::unique_ptr<CDBIterator> pIter(evoRawDB.NewIterator());
+    for (pIter->SeekToFirst(); pIter->Valid(); pIter->Next()) {
+        CRawDBData key;
+        if (!pIter->GetKey(key)) {
+            throw std::runtime_error("unable to read the evo database");
+        }
+        batch.Erase(key);
+    }
+    for (const auto& entry : vEvoEntries) {
+        batch.Write(entry.first, entry.second);
+    }
+    if (!evoRawDB.WriteBatch(batch, true)) {
+        throw std::runtime_error("failed to roll back the evo database");
+    }
+}
+
+/** Check that the chainstate is still at the genesis block, so a snapshot can be written to it */
+static bool CheckSnapshotLoadable(std::string& strError) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+    if (chainActive.Height() != 0 || pcoinsTip->GetCacheSize() != 0) {
+        strError = "A snapshot can only be loaded by a node that hasn't connected any blocks yet";
+        return false;
+    }
+    if (g_txindex || g_blockfilterindex || g_addressindex || g_spentindex) {
+        strError = "The transaction, block filter, address and spent indexes need all blocks, which aren't available with a snapshot";
+        return false;
+    }
+    return true;
+}
+
+bool LoadUTXOSnapshot(const CChainParams& chainparams, const fs::path& path, CUTXOSnapshotInfo& info, std::string& strError)
+{
+    {
+        LOCK(cs_main);
+        if (!CheckSnapshotLoadable(strError)) {
+            return false;
+        }
+    }
+
+    // Check the whole snapshot before writing anything
+    try {
+        CAutoFile afile(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        if (afile.IsNull()) {
+            strError = strprintf("Unable to open %s", path.string());
+            return false;
+        }
+        CHashVerifier<CAutoFile> verifier(&afile);
+        if (!ReadSnapshotHeaders(chainparams, verifier, false, info, strError)) {
+            return false;
+        }
+        if (!chainparams.SnapshotHashes().count(info.nBaseHeight)) {
+            strError = strprintf("No UTXO snapshot is accepted at height %d", info.nBaseHeight);
+            return false;
+        }
+        if (!ReadSnapshotEntries(afile, verifier, false, info, strError)) {
+            return false;
+        }
+    } catch (const std::exception& e) {
+        strError = strprintf("Unable to read the snapshot: %s", e.what());
+        return false;
+    }
+    // The hash is computed over the contents read, it only proves anything if it is the one pinned in the chain parameters
+    if (info.hashContents != chainparams.SnapshotHashes().at(info.nBaseHeight)) {
+        strError = strprintf("The snapshot hash %s isn't the hash accepted at height %d", info.hashContents.ToString(), info.nBaseHeight);
+        return false;
+    }
+    const uint256 hashVerified = info.hashContents;
+
+    try {
+        CAutoFile afile(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        if (afile.IsNull()) {
+            strError = strprintf("Unable to open %s", path.string());
+            return false;
+        }
+        CHashVerifier<CAutoFile> verifier(&afile);
+        if (!ReadSnapshotHeaders(chainparams, verifier, true, info, strError)) {
+            return false;
+        }
+
+        // Nothing may connect blocks while the databases are written
+        LOCK(cs_main);
+        if (!CheckSnapshotLoadable(strError)) {
+            return false;
+        }
+        CBlockIndex* pindexBase = LookupBlockIndex(info.hashBaseBlock);
+        if (pindexBase == nullptr || (pindexBase->nStatus & BLOCK_FAILED_MASK)) {
+            strError = "The snapshot base block is invalid";
+            return false;
+        }
+
+        LogPrintf("Loading UTXO snapshot at block %s (height %d)\n", info.hashBaseBlock.ToString(), info.nBaseHeight);
+        FlushStateToDisk();
+        const uint256 hashBestBlock = pcoinsdbview->GetBestBlock();
+        const RawDBEntries vEvoEntries = ReadEvoDB();
+
+        // Until the snapshot is written completely, the coins database is marked as inconsistent
+        if (!pcoinsdbview->BeginSnapshotLoad(info.hashBaseBlock)) {
+            strError = "Failed to write to the coins database";
+            return false;
+        }
+        bool fLoaded = false;
+        try {
+            if (!ReadSnapshotEntries(afile, verifier, true, info, strError)) {
+                // strError is set
+            } else if (info.hashContents != hashVerified) {
+                strError = "The snapshot changed while it was loaded";
+            } else if (!evoDb->VerifyBestBlock(info.hashBaseBlock)) {
+                strError = "The evo database of the snapshot isn't at the base block";
+            } else if (!pcoinsdbview->FinishSnapshotLoad(info.hashBaseBlock)) {
+                strError = "Failed to write to the coins database";
+            } else {
+                fLoaded = true;
+            }
+        } catch (const std::exception& e) {
+            strError = strprintf("Unable to load the snapshot: %s", e.what());
+        }
+        if (!fLoaded) {
+            RollbackSnapshotLoad(hashBestBlock, vEvoEntries);
+            return false;
+        }
+
+        if (!ActivateSnapshotChainstate(chainparams, pindexBase, info.nChainTx)) {
+            strError = "Failed to activate the snapshot chainstate";
+            return false;
+        }
+    } catch (const std::exception& e) {
+        strError = strprintf("Unable to load the snapshot: %s", e.what());
+        return false;
+    }
+
+    LogPrintf("Loaded UTXO snapshot at block %s (height %d) with %u coins, %u masternode lists and %u quorum commitments\n",
+        info.hashBaseBlock.ToString(), info.nBaseHeight, info.nCoins, info.nMNLists, info.nQuorumCommitments);
+
+    CValidationState state;
+    if (!ActivateBestChain(state, chainparams)) {
+        strError = strprintf("Failed to connect blocks after the snapshot: %s", FormatStateMessage(state));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2018 The Machinecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MACHINECOIN_UTXOSNAPSHOT_H
+#define MACHINECOIN_UTXOSNAPSHOT_H
+
+#include <fs.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <string>
+
+class CChainParams;
+
+/** Version of the UTXO snapshot file format */
+static const uint16_t UTXO_SNAPSHOT_VERSION = 2;
+
+/** Description of a UTXO snapshot */
+struct CUTXOSnapshotInfo
+{
+    //! The block the snapshot is based on
+    uint256 hashBaseBlock;
+    int nBaseHeight = 0;
+    //! Number of transactions up to and including the base block
+    uint64_t nChainTx = 0;
+    uint64_t nCoins = 0;
+    //! Number of deterministic masternode lists, of the last blocks up to the base block
+    uint64_t nMNLists = 0;
+    //! Number of quorum commitments mined up to the base block
+    uint64_t nQuorumCommitments = 0;
+    //! Hash committing to the whole contents of the snapshot
+    uint256 hashContents;
+};
+
+/**
+ * Write the block headers up to the chain tip, the UTXO set and the masternode lists and quorum
+ * commitments needed to connect the blocks after the tip to a snapshot file. The coins database is
+ * read from a consistent view without holding cs_main. Everything is written in a serialization
+ * which doesn't depend on the history of the node, so all nodes write the same snapshot at a block.
+ */
+bool DumpUTXOSnapshot(const CChainParams& chainparams, const fs::path& path, CUTXOSnapshotInfo& info, std::string& strError);
+
+/**
+ * Load a snapshot written by DumpUTXOSnapshot into an empty chainstate, and make its base block
+ * the chain tip. The snapshot is verified before anything is written, its hash must be the one
+ * pinned for the height of its base block in the chain parameters. Blocks before the base block
+ * are never downloaded or connected, not even in the background: validating them and comparing
+ * the resulting UTXO set with the snapshot is left for a follow-up, until then the pinned hashes
+ * are all the snapshot is checked against.
+ */
+bool LoadUTXOSnapshot(const CChainParams& chainparams, const fs::path& path, CUTXOSnapshotInfo& info, std::string& strError);
+
+#endif // MACHINECOIN_UTXOSNAPSHOT_H
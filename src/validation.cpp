@@ -49,8 +49,11 @@
 #include <evo/deterministicmns.h>
 #include <evo/cbtx.h>
 
+#include <llmq/quorums_blockprocessor.h>
+
 #include <future>
 #include <sstream>
+#include <unordered_map>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/thread.hpp>
@@ -172,7 +175,7 @@ public:
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to mapBlockIndex.
      */
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Block (dis)connection on a given view:
@@ -191,6 +194,7 @@ public:
     bool ReplayBlocks(const CChainParams& params, CCoinsView* view);
     bool RewindBlockIndex(const CChainParams& params);
     bool LoadGenesisBlock(const CChainParams& chainparams);
+    bool ActivateSnapshotChainstate(const CChainParams& chainparams, CBlockIndex* pindexBase, uint64_t nChainTx) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     void PruneBlockIndexCandidates();
 
@@ -233,6 +237,8 @@ std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fHavePruned = false;
 bool fPruneMode = false;
+/** Base block of the UTXO snapshot the chainstate was loaded from, if any. Its ancestors are never connected. */
+static CBlockIndex* pindexSnapshotBase = nullptr;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
@@ -1591,7 +1597,27 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+/** Abort with a message */
+static bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
+{
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+        userMessage.empty() ? _("Error: A fatal internal error occurred, see debug.log for details") : userMessage,
+        "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+    return false;
+}
+
+static bool AbortNode(CValidationState& state, const std::string& strMessage, const std::string& userMessage="")
+{
+    AbortNode(strMessage, userMessage);
+    return state.Error(strMessage);
+}
+
+} // namespace
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
 {
     CDiskBlockPos pos = pindex->GetUndoPos();
     if (pos.IsNull()) {
@@ -1622,26 +1648,6 @@ static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
     return true;
 }
 
-/** Abort with a message */
-static bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
-{
-    SetMiscWarning(strMessage);
-    LogPrintf("*** %s\n", strMessage);
-    uiInterface.ThreadSafeMessageBox(
-        userMessage.empty() ? _("Error: A fatal internal error occurred, see debug.log for details") : userMessage,
-        "", CClientUIInterface::MSG_ERROR);
-    StartShutdown();
-    return false;
-}
-
-static bool AbortNode(CValidationState& state, const std::string& strMessage, const std::string& userMessage="")
-{
-    AbortNode(strMessage, userMessage);
-    return state.Error(strMessage);
-}
-
-} // namespace
-
 /**
  * Restore the UTXO in a Coin at a given COutPoint
  * @param undo The Coin to be restored.
@@ -1805,6 +1811,200 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+namespace {
+
+/** A block read from a block file, which is decoded and checked by the block decode threads */
+struct CImportBlock
+{
+    CDiskBlockPos pos;
+    std::vector<char> vData;
+    // Where the block's data ends, according to the size in the file and once decoded. If they differ, the
+    // file is scanned again from nRescanPos: one byte after the message start if the block couldn't be
+    // decoded, as blocks which were only partially written may contain complete ones
+    uint64_t nEndPos = 0;
+    uint64_t nDecodedEndPos = 0;
+    uint64_t nRescanPos = 0;
+    std::shared_ptr<CBlock> pblock;
+    uint256 hash;
+    bool fDecoded = false;
+};
+
+/**
+ * Closure representing the decoding of one block read by LoadExternalBlockFile, together with
+ * the context-free checks of CheckBlock. These include the expensive proof of work hash, whose
+ * result is remembered by CBlock::fChecked.
+ */
+class CBlockDecodeCheck
+{
+private:
+    CImportBlock* pimport;
+    const Consensus::Params* pconsensusParams;
+
+public:
+    CBlockDecodeCheck() : pimport(nullptr), pconsensusParams(nullptr) {}
+    CBlockDecodeCheck(CImportBlock& import, const Consensus::Params& consensusParams) : pimport(&import), pconsensusParams(&consensusParams) {}
+
+    bool operator()()
+    {
+        try {
+            CDataStream ss(pimport->vData, SER_DISK, CLIENT_VERSION);
+            pimport->pblock = std::make_shared<CBlock>();
+            ss >> *pimport->pblock;
+            pimport->nDecodedEndPos = pimport->nEndPos - ss.size();
+        } catch (const std::exception& e) {
+            LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            return true;
+        }
+        pimport->hash = pimport->pblock->GetHash();
+        pimport->fDecoded = true;
+        // Failures are reported again when the block is accepted
+        CValidationState state;
+        CheckBlock(*pimport->pblock, state, *pconsensusParams);
+        // The raw data isn't needed anymore
+        std::vector<char>().swap(pimport->vData);
+        return true;
+    }
+
+    void swap(CBlockDecodeCheck& check)
+    {
+        std::swap(pimport, check.pimport);
+        std::swap(pconsensusParams, check.pconsensusParams);
+    }
+};
+
+} // namespace
+
+static CCheckQueue<CBlockDecodeCheck> blockdecodequeue(1);
+static std::atomic<int> nBlockDecodeThreads{0};
+
+void ThreadBlockDecode() {
+    RenameThread("machinecoin-blkdecode");
+    nBlockDecodeThreads++;
+    blockdecodequeue.Thread();
+}
+
+namespace {
+
+/** An input of a block which is looked up in the coins database ahead of ConnectBlock */
+struct CPrefetchCoin
+{
+    COutPoint outpoint;
+    Coin coin;
+    bool fFound = false;
+};
+
+/**
+ * Closure representing the lookup of a range of block inputs in the coins database. The
+ * lookups only read the database, the coins found are added to pcoinsTip by the thread
+ * holding cs_main once all lookups are done.
+ */
+class CCoinsPrefetchCheck
+{
+private:
+    const CCoinsView* pview;
+    CPrefetchCoin* pbegin;
+    CPrefetchCoin* pend;
+
+public:
+    CCoinsPrefetchCheck() : pview(nullptr), pbegin(nullptr), pend(nullptr) {}
+    CCoinsPrefetchCheck(const CCoinsView& view, CPrefetchCoin* begin, CPrefetchCoin* end) : pview(&view), pbegin(begin), pend(end) {}
+
+    bool operator()()
+    {
+        for (CPrefetchCoin* p = pbegin; p != pend; ++p) {
+            try {
+                p->fFound = pview->GetCoin(p->outpoint, p->coin) && !p->coin.IsSpent();
+            } catch (const std::exception&) {
+                // ConnectBlock reads the input again and handles the error
+                p->fFound = false;
+            }
+        }
+        return true;
+    }
+
+    void swap(CCoinsPrefetchCheck& check)
+    {
+        std::swap(pview, check.pview);
+        std::swap(pbegin, check.pbegin);
+        std::swap(pend, check.pend);
+    }
+};
+
+} // namespace
+
+static CCheckQueue<CCoinsPrefetchCheck> coinsprefetchqueue(1);
+static std::atomic<int> nCoinsPrefetchThreads{0};
+
+void ThreadCoinsPrefetch() {
+    RenameThread("machinecoin-prefetch");
+    nCoinsPrefetchThreads++;
+    coinsprefetchqueue.Thread();
+}
+
+/**
+ * Look up the inputs of a block which aren't in pcoinsTip yet in the coins database, using
+ * the prefetch threads, and add them to pcoinsTip. ConnectBlock then finds them in the cache
+ * instead of reading them one after the other. Inputs spending outputs of the same block
+ * are skipped. ProcessNewBlock calls this without cs_main when a block is received, so the
+ * lookups don't hold up other threads, and ConnectTip for blocks connected from disk.
+ */
+static void PrefetchBlockCoins(const CBlock& block)
+{
+    if (nCoinsPrefetchThreads == 0) {
+        return;
+    }
+
+    std::vector<CPrefetchCoin> vCoins;
+    uint256 hashBestBlock;
+    {
+        LOCK(cs_main);
+        if (!pcoinsTip) {
+            return;
+        }
+        std::set<uint256> setBlockTxids;
+        for (const auto& tx : block.vtx) {
+            if (!tx->IsCoinBase()) {
+                for (const CTxIn& txin : tx->vin) {
+                    if (!setBlockTxids.count(txin.prevout.hash) && !pcoinsTip->HaveCoinInCache(txin.prevout)) {
+                        vCoins.emplace_back();
+                        vCoins.back().outpoint = txin.prevout;
+                    }
+                }
+            }
+            setBlockTxids.insert(tx->GetHash());
+        }
+        if (vCoins.size() < COINS_PREFETCH_MIN_INPUTS) {
+            return;
+        }
+        hashBestBlock = pcoinsdbview->GetBestBlock();
+    }
+
+    {
+        CCheckQueueControl<CCoinsPrefetchCheck> control(&coinsprefetchqueue);
+        std::vector<CCoinsPrefetchCheck> vChecks;
+        vChecks.reserve((vCoins.size() + COINS_PREFETCH_BATCH_SIZE - 1) / COINS_PREFETCH_BATCH_SIZE);
+        for (size_t i = 0; i < vCoins.size(); i += COINS_PREFETCH_BATCH_SIZE) {
+            size_t nEnd = std::min(vCoins.size(), i + COINS_PREFETCH_BATCH_SIZE);
+            vChecks.emplace_back(*pcoinsdbview, vCoins.data() + i, vCoins.data() + nEnd);
+        }
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    LOCK(cs_main);
+    // The coins database is only written by flushing pcoinsTip. Coins which were spent in
+    // pcoinsTip since the lookups are still in its cache and aren't replaced below, unless
+    // the cache was flushed meanwhile, in which case the coins found may be stale.
+    if (!pcoinsTip || hashBestBlock.IsNull() || pcoinsdbview->GetBestBlock() != hashBestBlock) {
+        return;
+    }
+    for (CPrefetchCoin& p : vCoins) {
+        if (p.fFound) {
+            pcoinsTip->AddPrefetchedCoin(p.outpoint, std::move(p.coin));
+        }
+    }
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2493,6 +2693,7 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
 }
 
 static int64_t nTimeReadFromDisk = 0;
+static int64_t nTimePrefetch = 0;
 static int64_t nTimeConnectTotal = 0;
 static int64_t nTimeFlush = 0;
 static int64_t nTimeChainState = 0;
@@ -2588,6 +2789,9 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
     int64_t nTime3;
     LogPrint(MCLog::BENCHMARK, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
+    PrefetchBlockCoins(blockConnecting);
+    int64_t nTimePrefetched = GetTimeMicros(); nTimePrefetch += nTimePrefetched - nTime2;
+    LogPrint(MCLog::BENCHMARK, "  - Prefetch inputs: %.2fms [%.2fs]\n", (nTimePrefetched - nTime2) * MILLI, nTimePrefetch * MICRO);
     {
         auto dbTx = evoDb->BeginTransaction();
 
@@ -2599,8 +2803,8 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
                 InvalidBlockFound(pindexNew, state);
             return error("ConnectTip(): ConnectBlock %s failed", pindexNew->GetBlockHash().ToString());
         }
-        nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
-        LogPrint(MCLog::BENCHMARK, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
+        nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTimePrefetched;
+        LogPrint(MCLog::BENCHMARK, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTimePrefetched) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
@@ -3096,7 +3300,10 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block)
 void CChainState::ReceivedBlockTransactions(const CBlock& block, CBlockIndex* pindexNew, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
 {
     pindexNew->nTx = block.vtx.size();
-    pindexNew->nChainTx = 0;
+    // The base block of a UTXO snapshot stays linked without its ancestors
+    if (pindexNew != pindexSnapshotBase) {
+        pindexNew->nChainTx = 0;
+    }
     pindexNew->nFile = pos.nFile;
     pindexNew->nDataPos = pos.nPos;
     pindexNew->nUndoPos = 0;
@@ -3107,6 +3314,10 @@ void CChainState::ReceivedBlockTransactions(const CBlock& block, CBlockIndex* pi
     pindexNew->RaiseValidity(BLOCK_VALID_TRANSACTIONS);
     setDirtyBlockIndex.insert(pindexNew);
 
+    if (pindexNew == pindexSnapshotBase) {
+        return;
+    }
+
     if (pindexNew->pprev == nullptr || pindexNew->pprev->nChainTx) {
         // If pindexNew is the genesis block or all parents are BLOCK_VALID_TRANSACTIONS.
         std::deque<CBlockIndex*> queue;
@@ -3515,7 +3726,7 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3533,7 +3744,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), fCheckPOW))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3630,7 +3841,9 @@ bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CVali
     CBlockIndex *pindexDummy = nullptr;
     CBlockIndex *&pindex = ppindex ? *ppindex : pindexDummy;
 
-    if (!AcceptBlockHeader(block, state, chainparams, &pindex))
+    // If CheckBlock already succeeded for this block (e.g. in the block decode threads during a reindex), the
+    // proof of work was verified and doesn't have to be hashed again
+    if (!AcceptBlockHeader(block, state, chainparams, &pindex, !block.fChecked))
         return false;
 
     // Try to process all requested blocks that we don't have, but only
@@ -3711,6 +3924,16 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
         // belt-and-suspenders.
         bool ret = CheckBlock(*pblock, state, chainparams.GetConsensus());
 
+        if (ret) {
+            PrefetchBlockCoins(*pblock);
+        }
+
+        // Verify the commitment signatures on the BLS worker while the block is stored and the chain is
+        // activated, rather than when ConnectBlock needs them while holding cs_main
+        if (ret && llmq::quorumBlockProcessor) {
+            llmq::quorumBlockProcessor->PreVerifyBlockCommitments(*pblock);
+        }
+
         LOCK(cs_main);
 
         if (ret) {
@@ -3999,6 +4222,11 @@ bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlo
 
     boost::this_thread::interruption_point();
 
+    // The base block of a UTXO snapshot has no data, but its descendants can be linked
+    uint256 hashSnapshotBase;
+    uint64_t nSnapshotChainTx = 0;
+    blocktree.ReadSnapshotBase(hashSnapshotBase, nSnapshotChainTx);
+
     // Calculate nChainWork
     std::vector<std::pair<int, CBlockIndex*> > vSortedByHeight;
     vSortedByHeight.reserve(mapBlockIndex.size());
@@ -4015,7 +4243,10 @@ bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlo
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
         // We can link the chain of blocks for which we've received transactions at some point.
         // Pruned nodes may have deleted the block.
-        if (pindex->nTx > 0) {
+        if (!hashSnapshotBase.IsNull() && pindex->GetBlockHash() == hashSnapshotBase) {
+            pindex->nChainTx = nSnapshotChainTx;
+            pindexSnapshotBase = pindex;
+        } else if (pindex->nTx > 0) {
             if (pindex->pprev) {
                 if (pindex->pprev->nChainTx) {
                     pindex->nChainTx = pindex->pprev->nChainTx + pindex->nTx;
@@ -4031,7 +4262,7 @@ bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlo
             pindex->nStatus |= BLOCK_FAILED_CHILD;
             setDirtyBlockIndex.insert(pindex);
         }
-        if (pindex->IsValid(BLOCK_VALID_TRANSACTIONS) && (pindex->nChainTx || pindex->pprev == nullptr))
+        if ((pindex->IsValid(BLOCK_VALID_TRANSACTIONS) || pindex == pindexSnapshotBase) && (pindex->nChainTx || pindex->pprev == nullptr))
             setBlockIndexCandidates.insert(pindex);
         if (pindex->nStatus & BLOCK_FAILED_MASK && (!pindexBestInvalid || pindex->nChainWork > pindexBestInvalid->nChainWork))
             pindexBestInvalid = pindex;
@@ -4177,6 +4408,11 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
             LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
             break;
         }
+        if (pindexSnapshotBase && pindex->nHeight <= pindexSnapshotBase->nHeight) {
+            // The chainstate was loaded from a snapshot at this block, there is no undo data
+            LogPrintf("VerifyDB(): block verification stopping at height %d (UTXO snapshot base)\n", pindex->nHeight);
+            break;
+        }
         CBlock block;
         // check level 0: read from disk
         if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
@@ -4327,6 +4563,36 @@ bool ReplayBlocks(const CChainParams& params, CCoinsView* view) {
     return g_chainstate.ReplayBlocks(params, view);
 }
 
+bool CChainState::ActivateSnapshotChainstate(const CChainParams& chainparams, CBlockIndex* pindexBase, uint64_t nChainTx)
+{
+    AssertLockHeld(cs_main);
+    assert(pcoinsdbview->GetBestBlock() == pindexBase->GetBlockHash());
+
+    // The base block is the first block whose successors can be connected. It and its
+    // ancestors are assumed to be valid, but keep the validity of their headers, as their
+    // transactions and scripts were never checked
+    pindexBase->nChainTx = nChainTx;
+    setDirtyBlockIndex.insert(pindexBase);
+    if (!pblocktree->WriteSnapshotBase(pindexBase->GetBlockHash(), nChainTx)) {
+        return error("%s: failed to write snapshot base", __func__);
+    }
+    pindexSnapshotBase = pindexBase;
+
+    setBlockIndexCandidates.insert(pindexBase);
+    pcoinsTip->SetBestBlock(pindexBase->GetBlockHash());
+    deterministicMNManager->UpdatedBlockTip(pindexBase);
+    if (!LoadChainTip(chainparams)) {
+        return error("%s: failed to load the snapshot base as the chain tip", __func__);
+    }
+    FlushStateToDisk();
+    return true;
+}
+
+bool ActivateSnapshotChainstate(const CChainParams& chainparams, CBlockIndex* pindexBase, uint64_t nChainTx)
+{
+    return g_chainstate.ActivateSnapshotChainstate(chainparams, pindexBase, nChainTx);
+}
+
 bool CChainState::RewindBlockIndex(const CChainParams& params)
 {
     LOCK(cs_main);
@@ -4468,6 +4734,7 @@ void UnloadBlockIndex()
     }
     mapBlockIndex.clear();
     fHavePruned = false;
+    pindexSnapshotBase = nullptr;
 
     g_chainstate.UnloadBlockIndex();
 }
@@ -4524,6 +4791,141 @@ bool LoadGenesisBlock(const CChainParams& chainparams)
     return g_chainstate.LoadGenesisBlock(chainparams);
 }
 
+/**
+ * Read the next batch of raw blocks from a block file, up to IMPORT_BATCH_MAX_BLOCKS blocks or
+ * IMPORT_BATCH_MAX_BYTES bytes. Returns false once the end of the file was reached.
+ */
+static bool ReadImportBlocks(CBufferedFile& blkdat, uint64_t& nRewind, const CChainParams& chainparams, const CDiskBlockPos* dbp,
+                             std::vector<CImportBlock>& vBlocks)
+{
+    vBlocks.clear();
+    size_t nBytes = 0;
+    while (!blkdat.eof() && vBlocks.size() < IMPORT_BATCH_MAX_BLOCKS && nBytes < IMPORT_BATCH_MAX_BYTES) {
+        boost::this_thread::interruption_point();
+
+        blkdat.SetPos(nRewind);
+        nRewind++; // start one byte further next time, in case of failure
+        blkdat.SetLimit(); // remove former limit
+        unsigned int nSize = 0;
+        try {
+            // locate a header
+            unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
+            blkdat.FindByte(chainparams.MessageStart()[0]);
+            nRewind = blkdat.GetPos()+1;
+            blkdat >> buf;
+            if (memcmp(buf, chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE))
+                continue;
+            // read size
+            blkdat >> nSize;
+            if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                continue;
+        } catch (const std::exception&) {
+            // no valid block header found; don't complain
+            return false;
+        }
+        try {
+            // read block, it is decoded by the block decode threads
+            uint64_t nBlockPos = blkdat.GetPos();
+            blkdat.SetLimit(nBlockPos + nSize);
+            blkdat.SetPos(nBlockPos);
+            CImportBlock import;
+            if (dbp) {
+                import.pos = *dbp;
+                import.pos.nPos = nBlockPos;
+            }
+            import.nEndPos = nBlockPos + nSize;
+            import.nRescanPos = nRewind;
+            import.vData.resize(nSize);
+            blkdat.read(import.vData.data(), nSize);
+            nRewind = blkdat.GetPos();
+            nBytes += nSize;
+            vBlocks.emplace_back(std::move(import));
+        } catch (const std::exception& e) {
+            LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+        }
+    }
+    return !blkdat.eof();
+}
+
+/**
+ * Accept a decoded block read from a block file, and the earlier read blocks that were waiting
+ * for it as their parent. Returns false if importing the file should be aborted.
+ */
+static bool AcceptImportBlock(const CChainParams& chainparams, const CImportBlock& import, CDiskBlockPos* dbp,
+                              std::multimap<uint256, CDiskBlockPos>& mapBlocksUnknownParent, int& nLoaded)
+{
+    const std::shared_ptr<CBlock>& pblock = import.pblock;
+    const CBlock& block = *pblock;
+    const uint256& hash = import.hash;
+    if (dbp)
+        dbp->nPos = import.pos.nPos;
+
+    {
+        LOCK(cs_main);
+        // detect out of order blocks, and store them for later
+        if (hash != chainparams.GetConsensus().hashGenesisBlock && !LookupBlockIndex(block.hashPrevBlock)) {
+            LogPrint(MCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                    block.hashPrevBlock.ToString());
+            if (dbp)
+                mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+            return true;
+        }
+
+        // process in case the block isn't known yet
+        CBlockIndex* pindex = LookupBlockIndex(hash);
+        if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
+          CValidationState state;
+          if (g_chainstate.AcceptBlock(pblock, state, chainparams, nullptr, true, dbp, nullptr)) {
+              nLoaded++;
+          }
+          if (state.IsError()) {
+              return false;
+          }
+        } else if (hash != chainparams.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
+          LogPrint(MCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
+        }
+    }
+
+    // Activate the genesis block so normal node progress can continue
+    if (hash == chainparams.GetConsensus().hashGenesisBlock) {
+        CValidationState state;
+        if (!ActivateBestChain(state, chainparams)) {
+            return false;
+        }
+    }
+
+    NotifyHeaderTip();
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+            if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
+            {
+                LogPrint(MCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                        head.ToString());
+                LOCK(cs_main);
+                CValidationState dummy;
+                if (g_chainstate.AcceptBlock(pblockrecursive, dummy, chainparams, nullptr, true, &it->second, nullptr))
+                {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            mapBlocksUnknownParent.erase(it);
+            NotifyHeaderTip();
+        }
+    }
+    return true;
+}
+
 bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
 {
     // Map of disk positions for blocks with unknown parent (only used for reindex)
@@ -4535,107 +4937,75 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
         // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
         CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
         uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
-            boost::this_thread::interruption_point();
 
-            blkdat.SetPos(nRewind);
-            nRewind++; // start one byte further next time, in case of failure
-            blkdat.SetLimit(); // remove former limit
-            unsigned int nSize = 0;
-            try {
-                // locate a header
-                unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
-                blkdat.FindByte(chainparams.MessageStart()[0]);
-                nRewind = blkdat.GetPos()+1;
-                blkdat >> buf;
-                if (memcmp(buf, chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE))
-                    continue;
-                // read size
-                blkdat >> nSize;
-                if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+        // Blocks are imported in a pipeline: while the blocks of one batch are accepted in file order by this
+        // thread, the next batch is read and decoded and checked by the block decode threads.
+        const bool fParallel = nBlockDecodeThreads > 0;
+        std::vector<CImportBlock> vBatch, vNextBatch;
+        std::unique_ptr<CCheckQueueControl<CBlockDecodeCheck> > control;
+        auto startDecoding = [&]() {
+            std::vector<CBlockDecodeCheck> vChecks;
+            vChecks.reserve(vNextBatch.size());
+            for (CImportBlock& import : vNextBatch) {
+                vChecks.emplace_back(import, chainparams.GetConsensus());
+            }
+            if (fParallel) {
+                control.reset(new CCheckQueueControl<CBlockDecodeCheck>(&blockdecodequeue));
+                control->Add(vChecks);
+            } else {
+                for (CBlockDecodeCheck& check : vChecks) {
+                    check();
+                }
+            }
+        };
+
+        bool fMore = ReadImportBlocks(blkdat, nRewind, chainparams, dbp, vNextBatch);
+        startDecoding();
+        bool fAbort = false;
+        while (!vNextBatch.empty() && !fAbort) {
+            if (control) {
+                control->Wait();
+                control.reset();
+            }
+            vBatch.swap(vNextBatch);
+            vNextBatch.clear();
+            // The blocks were read ahead assuming the sizes in the file are right. Where a block couldn't be
+            // decoded, or is shorter, the file is scanned again from where the serial import would have
+            // continued, and the blocks read after it are dropped from the batch.
+            for (size_t i = 0; i < vBatch.size(); i++) {
+                const CImportBlock& import = vBatch[i];
+                uint64_t nNextPos = import.fDecoded ? import.nDecodedEndPos : import.nRescanPos;
+                if (nNextPos == import.nEndPos) {
                     continue;
-            } catch (const std::exception&) {
-                // no valid block header found; don't complain
+                }
+                vBatch.resize(i + 1);
+                nRewind = nNextPos;
+                // the block may be further back than the buffer can rewind, the files are read from the start
+                // so their positions are the same as the buffer's
+                if (!blkdat.SetPos(nRewind) && !blkdat.Seek(nRewind)) {
+                    throw std::runtime_error("LoadExternalBlockFile: seek failed");
+                }
+                fMore = true;
                 break;
             }
-            try {
-                // read block
-                uint64_t nBlockPos = blkdat.GetPos();
-                if (dbp)
-                    dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                blkdat.SetPos(nBlockPos);
-                std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
-                nRewind = blkdat.GetPos();
-
-                uint256 hash = block.GetHash();
-                {
-                    LOCK(cs_main);
-                    // detect out of order blocks, and store them for later
-                    if (hash != chainparams.GetConsensus().hashGenesisBlock && !LookupBlockIndex(block.hashPrevBlock)) {
-                        LogPrint(MCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                                block.hashPrevBlock.ToString());
-                        if (dbp)
-                            mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                        continue;
-                    }
+            if (fMore) {
+                fMore = ReadImportBlocks(blkdat, nRewind, chainparams, dbp, vNextBatch);
+                startDecoding();
+            }
 
-                    // process in case the block isn't known yet
-                    CBlockIndex* pindex = LookupBlockIndex(hash);
-                    if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
-                      CValidationState state;
-                      if (g_chainstate.AcceptBlock(pblock, state, chainparams, nullptr, true, dbp, nullptr)) {
-                          nLoaded++;
-                      }
-                      if (state.IsError()) {
-                          break;
-                      }
-                    } else if (hash != chainparams.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
-                      LogPrint(MCLog::REINDEX, "Block Import: already had block %s at height %d\n", hash.ToString(), pindex->nHeight);
-                    }
+            for (const CImportBlock& import : vBatch) {
+                boost::this_thread::interruption_point();
+                if (!import.fDecoded) {
+                    continue;
                 }
-
-                // Activate the genesis block so normal node progress can continue
-                if (hash == chainparams.GetConsensus().hashGenesisBlock) {
-                    CValidationState state;
-                    if (!ActivateBestChain(state, chainparams)) {
+                try {
+                    if (!AcceptImportBlock(chainparams, import, dbp, mapBlocksUnknownParent, nLoaded)) {
+                        fAbort = true;
                         break;
                     }
+                } catch (const std::exception& e) {
+                    LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
                 }
-
-                NotifyHeaderTip();
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
-                        {
-                            LogPrint(MCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            CValidationState dummy;
-                            if (g_chainstate.AcceptBlock(pblockrecursive, dummy, chainparams, nullptr, true, &it->second, nullptr))
-                            {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        NotifyHeaderTip();
-                    }
-                }
-            } catch (const std::exception& e) {
-                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
             }
         }
     } catch (const std::runtime_error& e) {
@@ -4689,13 +5059,17 @@ void CChainState::CheckBlockIndex(const Consensus::Params& consensusParams)
     CBlockIndex* pindexFirstNotScriptsValid = nullptr; // Oldest ancestor of pindex which does not have BLOCK_VALID_SCRIPTS (regardless of being valid or not).
     while (pindex != nullptr) {
         nNodes++;
+        // The blocks after the genesis block up to the base block of a UTXO snapshot were never
+        // processed. They are assumed to be valid, so they don't count as missing or not valid for
+        // their descendants.
+        bool fSnapshotAssumed = pindexSnapshotBase && pindex->pprev != nullptr && pindexSnapshotBase->GetAncestor(pindex->nHeight) == pindex;
         if (pindexFirstInvalid == nullptr && pindex->nStatus & BLOCK_FAILED_VALID) pindexFirstInvalid = pindex;
-        if (pindexFirstMissing == nullptr && !(pindex->nStatus & BLOCK_HAVE_DATA)) pindexFirstMissing = pindex;
-        if (pindexFirstNeverProcessed == nullptr && pindex->nTx == 0) pindexFirstNeverProcessed = pindex;
+        if (!fSnapshotAssumed && pindexFirstMissing == nullptr && !(pindex->nStatus & BLOCK_HAVE_DATA)) pindexFirstMissing = pindex;
+        if (!fSnapshotAssumed && pindexFirstNeverProcessed == nullptr && pindex->nTx == 0) pindexFirstNeverProcessed = pindex;
         if (pindex->pprev != nullptr && pindexFirstNotTreeValid == nullptr && (pindex->nStatus & BLOCK_VALID_MASK) < BLOCK_VALID_TREE) pindexFirstNotTreeValid = pindex;
-        if (pindex->pprev != nullptr && pindexFirstNotTransactionsValid == nullptr && (pindex->nStatus & BLOCK_VALID_MASK) < BLOCK_VALID_TRANSACTIONS) pindexFirstNotTransactionsValid = pindex;
-        if (pindex->pprev != nullptr && pindexFirstNotChainValid == nullptr && (pindex->nStatus & BLOCK_VALID_MASK) < BLOCK_VALID_CHAIN) pindexFirstNotChainValid = pindex;
-        if (pindex->pprev != nullptr && pindexFirstNotScriptsValid == nullptr && (pindex->nStatus & BLOCK_VALID_MASK) < BLOCK_VALID_SCRIPTS) pindexFirstNotScriptsValid = pindex;
+        if (!fSnapshotAssumed && pindex->pprev != nullptr && pindexFirstNotTransactionsValid == nullptr && (pindex->nStatus & BLOCK_VALID_MASK) < BLOCK_VALID_TRANSACTIONS) pindexFirstNotTransactionsValid = pindex;
+        if (!fSnapshotAssumed && pindex->pprev != nullptr && pindexFirstNotChainValid == nullptr && (pindex->nStatus & BLOCK_VALID_MASK) < BLOCK_VALID_CHAIN) pindexFirstNotChainValid = pindex;
+        if (!fSnapshotAssumed && pindex->pprev != nullptr && pindexFirstNotScriptsValid == nullptr && (pindex->nStatus & BLOCK_VALID_MASK) < BLOCK_VALID_SCRIPTS) pindexFirstNotScriptsValid = pindex;
 
         // Begin: actual consistency checks.
         if (pindex->pprev == nullptr) {
@@ -4717,8 +5091,11 @@ void CChainState::CheckBlockIndex(const Consensus::Params& consensusParams)
         if (pindex->nStatus & BLOCK_HAVE_UNDO) assert(pindex->nStatus & BLOCK_HAVE_DATA);
         assert(((pindex->nStatus & BLOCK_VALID_MASK) >= BLOCK_VALID_TRANSACTIONS) == (pindex->nTx > 0)); // This is pruning-independent.
         // All parents having had data (at some point) is equivalent to all parents being VALID_TRANSACTIONS, which is equivalent to nChainTx being set.
-        assert((pindexFirstNeverProcessed != nullptr) == (pindex->nChainTx == 0)); // nChainTx != 0 is used to signal that all parent blocks have been processed (but may have been pruned).
-        assert((pindexFirstNotTransactionsValid != nullptr) == (pindex->nChainTx == 0));
+        if (!fSnapshotAssumed || pindex == pindexSnapshotBase) {
+            // Only the base block of a UTXO snapshot has nChainTx set, its ancestors aren't linked.
+            assert((pindexFirstNeverProcessed != nullptr) == (pindex->nChainTx == 0)); // nChainTx != 0 is used to signal that all parent blocks have been processed (but may have been pruned).
+            assert((pindexFirstNotTransactionsValid != nullptr) == (pindex->nChainTx == 0));
+        }
         assert(pindex->nHeight == nHeight); // nHeight must be consistent.
         assert(pindex->pprev == nullptr || pindex->nChainWork >= pindex->pprev->nChainWork); // For every block except the genesis block, the chainwork must be larger than the parent's.
         assert(nHeight < 2 || (pindex->pskip && (pindex->pskip->nHeight < nHeight))); // The pskip pointer must point back for all but the first 2 blocks.
@@ -4860,7 +5237,118 @@ int VersionBitsTipStateSinceHeight(const Consensus::Params& params, Consensus::D
     return VersionBitsStateSinceHeight(chainActive.Tip(), params, pos, versionbitscache);
 }
 
-static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+/** Version of mempool.dat storing the entries only */
+static const uint64_t MEMPOOL_DUMP_VERSION_NO_PARENTS = 1;
+/** Version of mempool.dat also storing, for every input, which entry it spends an output of */
+static const uint64_t MEMPOOL_DUMP_VERSION = 2;
+
+/** Number of transactions whose scripts LoadMempool verifies in one batch of the script check queue */
+static const size_t MEMPOOL_LOAD_VERIFY_BATCH_SIZE = 128;
+
+namespace {
+
+/** A transaction of mempool.dat */
+struct CMempoolDumpEntry
+{
+    CTransactionRef tx;
+    int64_t nTime;
+    int64_t nFeeDelta;
+    //! For every input, one plus the position of the entry it spends an output of, or 0 if it
+    //! spends an output of the block chain. Parents come before their children.
+    std::vector<uint32_t> vInputParents;
+    //! Whether the entry is too old to be loaded
+    bool fExpired = false;
+};
+
+/** Fill in the parents of entries read from a mempool.dat without them */
+void FindMempoolDumpParents(std::vector<CMempoolDumpEntry>& vEntries)
+{
+    std::unordered_map<uint256, uint32_t, SaltedTxidHasher> mapPositions;
+    for (size_t i = 0; i < vEntries.size(); i++) {
+        const CTransaction& tx = *vEntries[i].tx;
+        vEntries[i].vInputParents.clear();
+        for (const CTxIn& txin : tx.vin) {
+            auto it = mapPositions.find(txin.prevout.hash);
+            vEntries[i].vInputParents.push_back(it == mapPositions.end() ? 0 : it->second + 1);
+        }
+        mapPositions.emplace(tx.GetHash(), i);
+    }
+}
+
+/**
+ * Verify the scripts of the entries of mempool.dat in parallel on the script check queue, with the
+ * script verification flags of AcceptToMemoryPool. The signatures are stored in the signature
+ * cache, and the transactions of batches which verify in the script execution cache, so
+ * AcceptToMemoryPool mostly finds the results in the caches. The result of the verification itself
+ * is not used: AcceptToMemoryPool still decides which transactions are accepted.
+ */
+void PreVerifyMempoolDumpScripts(const std::vector<CMempoolDumpEntry>& vEntries)
+{
+    constexpr unsigned int flags = STANDARD_SCRIPT_VERIFY_FLAGS;
+
+    for (size_t nBatchStart = 0; nBatchStart < vEntries.size() && !ShutdownRequested(); nBatchStart += MEMPOOL_LOAD_VERIFY_BATCH_SIZE) {
+        const size_t nBatchEnd = std::min(nBatchStart + MEMPOOL_LOAD_VERIFY_BATCH_SIZE, vEntries.size());
+
+        // The checks keep pointers to the precomputed data, which must not move
+        std::vector<PrecomputedTransactionData> vTxData;
+        vTxData.reserve(nBatchEnd - nBatchStart);
+        std::vector<CScriptCheck> vChecks;
+        std::vector<uint256> vCacheEntries;
+        {
+            LOCK(cs_main);
+            for (size_t i = nBatchStart; i < nBatchEnd; i++) {
+                const CMempoolDumpEntry& entry = vEntries[i];
+                const CTransaction& tx = *entry.tx;
+                if (entry.fExpired || tx.IsCoinBase() || entry.vInputParents.size() != tx.vin.size()) continue;
+
+                // Find the outputs spent by the transaction, skip it if some are missing
+                std::vector<CTxOut> vSpent;
+                vSpent.reserve(tx.vin.size());
+                for (size_t j = 0; j < tx.vin.size(); j++) {
+                    const COutPoint& prevout = tx.vin[j].prevout;
+                    const uint32_t nParent = entry.vInputParents[j];
+                    if (nParent == 0) {
+                        const Coin& coin = pcoinsTip->AccessCoin(prevout);
+                        if (coin.IsSpent()) break;
+                        vSpent.push_back(coin.out);
+                    } else {
+                        if (nParent > i) break;
+                        const CTransaction& txParent = *vEntries[nParent - 1].tx;
+                        if (txParent.GetHash() != prevout.hash || prevout.n >= txParent.vout.size()) break;
+                        vSpent.push_back(txParent.vout[prevout.n]);
+                    }
+                }
+                if (vSpent.size() != tx.vin.size()) continue;
+
+                vTxData.emplace_back(tx);
+                for (size_t j = 0; j < tx.vin.size(); j++) {
+                    vChecks.emplace_back(vSpent[j], tx, j, flags, true /* cacheStore */, &vTxData.back());
+                }
+
+                // Same key as in CheckInputs
+                uint256 hashCacheEntry;
+                CSHA256().Write(scriptExecutionCacheNonce.begin(), 55 - sizeof(flags) - 32).Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+                vCacheEntries.push_back(hashCacheEntry);
+            }
+        }
+
+        // Release the script check queue before taking cs_main, ConnectBlock locks them the other way round
+        bool fValid;
+        {
+            CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+            control.Add(vChecks);
+            fValid = control.Wait();
+        }
+        if (fValid) {
+            LOCK(cs_main);
+            for (const uint256& hashCacheEntry : vCacheEntries) {
+                scriptExecutionCache.insert(hashCacheEntry);
+            }
+        }
+    }
+}
+
+} // namespace
 
 bool LoadMempool(void)
 {
@@ -4879,62 +5367,86 @@ bool LoadMempool(void)
     int64_t already_there = 0;
     int64_t nNow = GetTime();
 
+    std::vector<CMempoolDumpEntry> vEntries;
+    std::map<uint256, CAmount> mapDeltas;
     try {
         uint64_t version;
         file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
+        if (version != MEMPOOL_DUMP_VERSION && version != MEMPOOL_DUMP_VERSION_NO_PARENTS) {
             return false;
         }
         uint64_t num;
         file >> num;
         while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                mempool.PrioritiseTransaction(tx->GetHash(), amountdelta);
-            }
-            CValidationState state;
-            if (nTime + nExpiryTimeout > nNow) {
-                LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(chainparams, mempool, state, tx, nullptr /* pfMissingInputs */, nTime,
-                                           nullptr /* plTxnReplaced */, false /* bypass_limits */, 0 /* nAbsurdFee */,
-                                           false /* test_accept */);
-                if (state.IsValid()) {
-                    ++count;
-                } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (mempool.exists(tx->GetHash())) {
-                        ++already_there;
-                    } else {
-                        ++failed;
-                    }
+            vEntries.emplace_back();
+            CMempoolDumpEntry& entry = vEntries.back();
+            file >> entry.tx;
+            file >> entry.nTime;
+            file >> entry.nFeeDelta;
+            if (version == MEMPOOL_DUMP_VERSION) {
+                entry.vInputParents.resize(entry.tx->vin.size());
+                for (uint32_t& nParent : entry.vInputParents) {
+                    file >> VARINT(nParent);
                 }
-            } else {
-                ++expired;
             }
             if (ShutdownRequested())
                 return false;
         }
-        std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
 
-        for (const auto& i : mapDeltas) {
-            mempool.PrioritiseTransaction(i.first, i.second);
+        if (version == MEMPOOL_DUMP_VERSION_NO_PARENTS) {
+            FindMempoolDumpParents(vEntries);
         }
     } catch (const std::exception& e) {
         LogPrintf("Failed to deserialize mempool data on disk: %s. Continuing anyway.\n", e.what());
         return false;
     }
 
+    for (CMempoolDumpEntry& entry : vEntries) {
+        entry.fExpired = entry.nTime + nExpiryTimeout <= nNow;
+    }
+    if (nScriptCheckThreads) {
+        int64_t nTimeStart = GetTimeMicros();
+        PreVerifyMempoolDumpScripts(vEntries);
+        LogPrint(MCLog::BENCHMARK, "Verified scripts of mempool transactions from disk: %.2fms\n", (GetTimeMicros() - nTimeStart) * MILLI);
+    }
+
+    for (const CMempoolDumpEntry& entry : vEntries) {
+        const CTransactionRef& tx = entry.tx;
+        CAmount amountdelta = entry.nFeeDelta;
+        if (amountdelta) {
+            mempool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+        }
+        CValidationState state;
+        if (!entry.fExpired) {
+            LOCK(cs_main);
+            AcceptToMemoryPoolWithTime(chainparams, mempool, state, tx, nullptr /* pfMissingInputs */, entry.nTime,
+                                       nullptr /* plTxnReplaced */, false /* bypass_limits */, 0 /* nAbsurdFee */,
+                                       false /* test_accept */);
+            if (state.IsValid()) {
+                ++count;
+            } else {
+                // mempool may contain the transaction already, e.g. from
+                // wallet(s) having loaded it while we were processing
+                // mempool transactions; consider these as valid, instead of
+                // failed, but mark them as 'already there'
+                if (mempool.exists(tx->GetHash())) {
+                    ++already_there;
+                } else {
+                    ++failed;
+                }
+            }
+        } else {
+            ++expired;
+        }
+        if (ShutdownRequested())
+            return false;
+    }
+
+    for (const auto& i : mapDeltas) {
+        mempool.PrioritiseTransaction(i.first, i.second);
+    }
+
     LogPrintf("Imported mempool transactions from disk: %i succeeded, %i failed, %i expired, %i already there\n", count, failed, expired, already_there);
     return true;
 }
@@ -4967,12 +5479,22 @@ bool DumpMempool(void)
         uint64_t version = MEMPOOL_DUMP_VERSION;
         file << version;
 
+        // infoAll sorts the transactions by their number of ancestors, so parents come first
+        std::vector<CMempoolDumpEntry> vEntries(vinfo.size());
+        for (size_t i = 0; i < vinfo.size(); i++) {
+            vEntries[i].tx = vinfo[i].tx;
+        }
+        FindMempoolDumpParents(vEntries);
+
         file << (uint64_t)vinfo.size();
-        for (const auto& i : vinfo) {
-            file << *(i.tx);
-            file << (int64_t)i.nTime;
-            file << (int64_t)i.nFeeDelta;
-            mapDeltas.erase(i.tx->GetHash());
+        for (size_t i = 0; i < vinfo.size(); i++) {
+            file << *(vinfo[i].tx);
+            file << (int64_t)vinfo[i].nTime;
+            file << (int64_t)vinfo[i].nFeeDelta;
+            for (uint32_t nParent : vEntries[i].vInputParents) {
+                file << VARINT(nParent);
+            }
+            mapDeltas.erase(vinfo[i].tx->GetHash());
         }
 
         file << mapDeltas;
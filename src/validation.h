@@ -33,6 +33,7 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CChainParams;
 class CCoinsViewDB;
 class CInv;
@@ -81,6 +82,18 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Maximum number of blocks read and decoded ahead of the block being accepted when importing block files */
+static const size_t IMPORT_BATCH_MAX_BLOCKS = 128;
+/** Maximum size of the blocks read and decoded ahead of the block being accepted when importing block files */
+static const size_t IMPORT_BATCH_MAX_BYTES = 32 * 1000 * 1000;
+/** Maximum number of threads looking up block inputs in the coins database ahead of ConnectBlock */
+static const int MAX_COINS_PREFETCH_THREADS = 16;
+/** -prefetchthreads default (number of threads looking up block inputs, 0 = disabled) */
+static const int DEFAULT_COINS_PREFETCH_THREADS = 4;
+/** Minimum number of block inputs missing from the coins cache for them to be prefetched */
+static const size_t COINS_PREFETCH_MIN_INPUTS = 32;
+/** Number of block inputs looked up by a prefetch thread at a time */
+static const size_t COINS_PREFETCH_BATCH_SIZE = 16;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -117,6 +130,11 @@ static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = true;
+static const bool DEFAULT_BLOCKFILTERINDEX = false;
+static const bool DEFAULT_ADDRESSINDEX = false;
+static const bool DEFAULT_SPENTINDEX = false;
+static const bool DEFAULT_COINSTATSINDEX = false;
+static const bool DEFAULT_BLOCKSTATSINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
@@ -258,10 +276,20 @@ bool LoadGenesisBlock(const CChainParams& chainparams);
 bool LoadBlockIndex(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 /** Update the chain tip based on database information. */
 bool LoadChainTip(const CChainParams& chainparams);
+/**
+ * Make the base block of a UTXO snapshot, which was just written to the coins and evo
+ * databases, the chain tip. The block and its ancestors are assumed to be valid, blocks
+ * are connected from there on.
+ */
+bool ActivateSnapshotChainstate(const CChainParams& chainparams, CBlockIndex* pindexBase, uint64_t nChainTx) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 /** Unload database information */
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the thread decoding and checking blocks imported by LoadExternalBlockFile */
+void ThreadBlockDecode();
+/** Run an instance of the thread looking up block inputs in the coins database ahead of ConnectBlock */
+void ThreadCoinsPrefetch();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -399,6 +427,7 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& message_start);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& message_start);
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
 
 /** Functions for validating blocks and updating the block tree */
 
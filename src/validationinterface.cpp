@@ -13,40 +13,158 @@
 #include <validation.h>
 
 #include <list>
+#include <memory>
 #include <atomic>
 #include <future>
 
 #include <boost/signals2/signal.hpp>
 
+/**
+ * The callback queue of a registered CValidationInterface. Every subscriber has its own
+ * queue, drained by the callback pool, so a slow subscriber only delays its own callbacks
+ * while the callbacks of each subscriber still happen in order, one at a time.
+ *
+ * The tasks draining the queue hold a reference to the subscriber, so that it can be
+ * deleted from MainSignalsInstance::m_subscribers when it is unregistered.
+ */
+struct ValidationInterfaceSubscriber : public std::enable_shared_from_this<ValidationInterfaceSubscriber> {
+    CValidationInterface* const m_callbacks;
+    const std::string m_name;
+    CScheduler* const m_pscheduler;
+    //! Cleared when the subscriber is unregistered, after which its pending callbacks are dropped
+    std::atomic<bool> m_active{true};
+    //! Held while a callback runs, so that unregistering can wait for it to finish
+    CCriticalSection m_cs_running;
+    std::atomic<size_t> m_peak_pending{0};
+    std::atomic<uint64_t> m_delivered{0};
+
+    CCriticalSection m_cs_callbacks_pending;
+    std::list<std::function<void ()>> m_callbacks_pending GUARDED_BY(m_cs_callbacks_pending);
+    //! Whether a task draining the queue is scheduled or running
+    bool m_are_callbacks_scheduled GUARDED_BY(m_cs_callbacks_pending) = false;
+
+    ValidationInterfaceSubscriber(CValidationInterface* callbacks, std::string name, CScheduler* pscheduler)
+        : m_callbacks(callbacks), m_name(std::move(name)), m_pscheduler(pscheduler) {}
+
+    /** Queue a callback, which is skipped if the subscriber is unregistered meanwhile */
+    void Enqueue(std::function<void (CValidationInterface&)> func) {
+        AddToProcessQueue([this, func] {
+            LOCK(m_cs_running);
+            if (!m_active) return;
+            func(*m_callbacks);
+            m_delivered++;
+        });
+    }
+
+    void AddToProcessQueue(std::function<void ()> func) {
+        {
+            LOCK(m_cs_callbacks_pending);
+            m_callbacks_pending.emplace_back(std::move(func));
+            size_t pending = m_callbacks_pending.size();
+            size_t peak = m_peak_pending;
+            while (pending > peak && !m_peak_pending.compare_exchange_weak(peak, pending)) {}
+            if (m_are_callbacks_scheduled) return;
+            m_are_callbacks_scheduled = true;
+        }
+        std::shared_ptr<ValidationInterfaceSubscriber> self = shared_from_this();
+        m_pscheduler->schedule([self] { self->ProcessQueue(); });
+    }
+
+    /** Deliver one callback, and schedule delivering the next one if there is any */
+    void ProcessQueue() {
+        std::function<void ()> callback;
+        {
+            LOCK(m_cs_callbacks_pending);
+            if (m_callbacks_pending.empty()) {
+                m_are_callbacks_scheduled = false;
+                return;
+            }
+            callback = std::move(m_callbacks_pending.front());
+            m_callbacks_pending.pop_front();
+        }
+
+        // Reschedule even if callback() throws. Other subscribers get their turn in between.
+        struct RAIIReschedule {
+            std::shared_ptr<ValidationInterfaceSubscriber> self;
+            ~RAIIReschedule() {
+                {
+                    LOCK(self->m_cs_callbacks_pending);
+                    if (self->m_callbacks_pending.empty()) {
+                        self->m_are_callbacks_scheduled = false;
+                        return;
+                    }
+                }
+                self->m_pscheduler->schedule([self = self] { self->ProcessQueue(); });
+            }
+        } reschedule{shared_from_this()};
+
+        callback();
+    }
+
+    /** Deliver all pending callbacks on the calling thread. Only when no thread services the scheduler. */
+    void EmptyQueue() {
+        assert(!m_pscheduler->AreThreadsServicingQueue());
+        while (true) {
+            std::function<void ()> callback;
+            {
+                LOCK(m_cs_callbacks_pending);
+                if (m_callbacks_pending.empty()) return;
+                callback = std::move(m_callbacks_pending.front());
+                m_callbacks_pending.pop_front();
+            }
+            callback();
+        }
+    }
+
+    /** Drop the pending callbacks and wait for the running one to finish */
+    void Deactivate() {
+        m_active = false;
+        LOCK(m_cs_running);
+    }
+
+    size_t CallbacksPending() {
+        LOCK(m_cs_callbacks_pending);
+        return m_callbacks_pending.size();
+    }
+};
+
 struct MainSignalsInstance {
-    boost::signals2::signal<void (const CBlockIndex *pindexNew)> AcceptedBlockHeader;
-    boost::signals2::signal<void (const CBlockIndex *pindexNew, bool fInitialDownload)> NotifyHeaderTip;
-    boost::signals2::signal<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> UpdatedBlockTip;
-    boost::signals2::signal<void (const CTransaction &tx)> NotifyTransactionLock;
-    boost::signals2::signal<void (const CGovernanceVote &vote)> NotifyGovernanceVote;
-    boost::signals2::signal<void (const CGovernanceObject &object)> NotifyGovernanceObject;
-    boost::signals2::signal<void (const CTransactionRef &)> TransactionAddedToMempool;
-    boost::signals2::signal<void (const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex, const std::vector<CTransactionRef>&)> BlockConnected;
-    boost::signals2::signal<void (const std::shared_ptr<const CBlock> &)> BlockDisconnected;
-    boost::signals2::signal<void (const CTransactionRef &)> TransactionRemovedFromMempool;
-    boost::signals2::signal<void (const CBlockLocator &)> ChainStateFlushed;
+    // Signals which are delivered synchronously, on the thread generating them
     boost::signals2::signal<void (int64_t nBestBlockTime, CConnman* connman)> Broadcast;
     boost::signals2::signal<void (const CBlock&, const CValidationState&)> BlockChecked;
     boost::signals2::signal<void (const CBlockIndex *, const std::shared_ptr<const CBlock>&)> NewPoWValidBlock;
 
+    CScheduler* const m_pscheduler;
+    //! Scheduler whose threads drain the subscriber queues, the single threaded m_pscheduler if none
+    CScheduler* const m_pcallback_pool;
+
     // We are not allowed to assume the scheduler only runs in one thread,
     // but must ensure all callbacks happen in-order, so we end up creating
-    // our own queue here :(
+    // our own queues here :(
+    // Callbacks which are not addressed to a subscriber, e.g. the ones of
+    // CallFunctionInValidationInterfaceQueue, go to this queue.
     SingleThreadedSchedulerClient m_schedulerClient;
 
-    explicit MainSignalsInstance(CScheduler *pscheduler) : m_schedulerClient(pscheduler) {}
+    CCriticalSection m_cs_subscribers;
+    std::vector<std::shared_ptr<ValidationInterfaceSubscriber>> m_subscribers GUARDED_BY(m_cs_subscribers);
+
+    MainSignalsInstance(CScheduler *pscheduler, CScheduler *pcallback_pool)
+        : m_pscheduler(pscheduler), m_pcallback_pool(pcallback_pool ? pcallback_pool : pscheduler), m_schedulerClient(pscheduler) {}
+
+    /** Queue a callback for every active subscriber */
+    void Enqueue(std::function<void (CValidationInterface&)> func) {
+        LOCK(m_cs_subscribers);
+        for (const auto& subscriber : m_subscribers) {
+            subscriber->Enqueue(func);
+        }
+    }
 };
 
 static CMainSignals g_signals;
 
-void CMainSignals::RegisterBackgroundSignalScheduler(CScheduler& scheduler) {
+void CMainSignals::RegisterBackgroundSignalScheduler(CScheduler& scheduler, CScheduler* pcallback_pool) {
     assert(!m_internals);
-    m_internals.reset(new MainSignalsInstance(&scheduler));
+    m_internals.reset(new MainSignalsInstance(&scheduler, pcallback_pool));
 }
 
 void CMainSignals::UnregisterBackgroundSignalScheduler() {
@@ -56,12 +174,41 @@ void CMainSignals::UnregisterBackgroundSignalScheduler() {
 void CMainSignals::FlushBackgroundCallbacks() {
     if (m_internals) {
         m_internals->m_schedulerClient.EmptyQueue();
+        std::vector<std::shared_ptr<ValidationInterfaceSubscriber>> subscribers;
+        {
+            LOCK(m_internals->m_cs_subscribers);
+            subscribers = m_internals->m_subscribers;
+        }
+        for (const auto& subscriber : subscribers) {
+            subscriber->EmptyQueue();
+        }
     }
 }
 
 size_t CMainSignals::CallbacksPending() {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    // The deepest queue tells how far the slowest subscriber lags behind validation
+    size_t pending = m_internals->m_schedulerClient.CallbacksPending();
+    LOCK(m_internals->m_cs_subscribers);
+    for (const auto& subscriber : m_internals->m_subscribers) {
+        pending = std::max(pending, subscriber->CallbacksPending());
+    }
+    return pending;
+}
+
+std::vector<ValidationInterfaceQueueInfo> CMainSignals::GetQueueInfo() {
+    std::vector<ValidationInterfaceQueueInfo> infos;
+    if (!m_internals) return infos;
+    LOCK(m_internals->m_cs_subscribers);
+    for (const auto& subscriber : m_internals->m_subscribers) {
+        ValidationInterfaceQueueInfo info;
+        info.name = subscriber->m_name;
+        info.pending = subscriber->CallbacksPending();
+        info.peak_pending = subscriber->m_peak_pending;
+        info.delivered = subscriber->m_delivered;
+        infos.push_back(std::move(info));
+    }
+    return infos;
 }
 
 void CMainSignals::RegisterWithMempoolSignals(CTxMemPool& pool) {
@@ -78,36 +225,37 @@ CMainSignals& GetMainSignals()
 }
 
 void RegisterValidationInterface(CValidationInterface* pwalletIn) {
-    g_signals.m_internals->AcceptedBlockHeader.connect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
-    g_signals.m_internals->NotifyHeaderTip.connect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
-    g_signals.m_internals->UpdatedBlockTip.connect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->NotifyTransactionLock.connect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1));
-    g_signals.m_internals->NotifyGovernanceVote.connect(boost::bind(&CValidationInterface::NotifyGovernanceVote, pwalletIn, _1));
-    g_signals.m_internals->NotifyGovernanceObject.connect(boost::bind(&CValidationInterface::NotifyGovernanceObject, pwalletIn, _1));
-    g_signals.m_internals->TransactionAddedToMempool.connect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
-    g_signals.m_internals->BlockConnected.connect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->BlockDisconnected.connect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1));
-    g_signals.m_internals->TransactionRemovedFromMempool.connect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1));
-    g_signals.m_internals->ChainStateFlushed.connect(boost::bind(&CValidationInterface::ChainStateFlushed, pwalletIn, _1));
+    {
+        LOCK(g_signals.m_internals->m_cs_subscribers);
+        CScheduler* pscheduler = pwalletIn->UseSchedulerThread() ? g_signals.m_internals->m_pscheduler : g_signals.m_internals->m_pcallback_pool;
+        g_signals.m_internals->m_subscribers.push_back(std::make_shared<ValidationInterfaceSubscriber>(pwalletIn, pwalletIn->GetSubscriberName(), pscheduler));
+    }
     g_signals.m_internals->Broadcast.connect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
     g_signals.m_internals->BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
     g_signals.m_internals->NewPoWValidBlock.connect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
 }
 
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
+    std::vector<std::shared_ptr<ValidationInterfaceSubscriber>> removed;
+    {
+        // Tasks still draining the queue of the subscriber keep it alive until they are done
+        LOCK(g_signals.m_internals->m_cs_subscribers);
+        auto& subscribers = g_signals.m_internals->m_subscribers;
+        for (auto it = subscribers.begin(); it != subscribers.end();) {
+            if ((*it)->m_callbacks == pwalletIn) {
+                removed.push_back(std::move(*it));
+                it = subscribers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // pwalletIn may be deleted once this returns, none of its callbacks may run anymore
+    for (const auto& subscriber : removed) {
+        subscriber->Deactivate();
+    }
     g_signals.m_internals->BlockChecked.disconnect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
     g_signals.m_internals->Broadcast.disconnect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.m_internals->ChainStateFlushed.disconnect(boost::bind(&CValidationInterface::ChainStateFlushed, pwalletIn, _1));
-    g_signals.m_internals->TransactionAddedToMempool.disconnect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
-    g_signals.m_internals->BlockConnected.disconnect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->BlockDisconnected.disconnect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1));
-    g_signals.m_internals->TransactionRemovedFromMempool.disconnect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1));
-    g_signals.m_internals->AcceptedBlockHeader.disconnect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
-    g_signals.m_internals->NotifyHeaderTip.disconnect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
-    g_signals.m_internals->UpdatedBlockTip.disconnect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->NotifyTransactionLock.disconnect(boost::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, _1));
-    g_signals.m_internals->NotifyGovernanceVote.disconnect(boost::bind(&CValidationInterface::NotifyGovernanceVote, pwalletIn, _1));
-    g_signals.m_internals->NotifyGovernanceObject.disconnect(boost::bind(&CValidationInterface::NotifyGovernanceObject, pwalletIn, _1));
     g_signals.m_internals->NewPoWValidBlock.disconnect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
 }
 
@@ -115,24 +263,35 @@ void UnregisterAllValidationInterfaces() {
     if (!g_signals.m_internals) {
         return;
     }
+    std::vector<std::shared_ptr<ValidationInterfaceSubscriber>> removed;
+    {
+        LOCK(g_signals.m_internals->m_cs_subscribers);
+        removed.swap(g_signals.m_internals->m_subscribers);
+    }
+    for (const auto& subscriber : removed) {
+        subscriber->Deactivate();
+    }
     g_signals.m_internals->BlockChecked.disconnect_all_slots();
     g_signals.m_internals->Broadcast.disconnect_all_slots();
-    g_signals.m_internals->ChainStateFlushed.disconnect_all_slots();
-    g_signals.m_internals->TransactionAddedToMempool.disconnect_all_slots();
-    g_signals.m_internals->BlockConnected.disconnect_all_slots();
-    g_signals.m_internals->BlockDisconnected.disconnect_all_slots();
-    g_signals.m_internals->TransactionRemovedFromMempool.disconnect_all_slots();
-    g_signals.m_internals->AcceptedBlockHeader.disconnect_all_slots();
-    g_signals.m_internals->NotifyHeaderTip.disconnect_all_slots();
-    g_signals.m_internals->UpdatedBlockTip.disconnect_all_slots();
-    g_signals.m_internals->NotifyTransactionLock.disconnect_all_slots();
-    g_signals.m_internals->NotifyGovernanceVote.disconnect_all_slots();
-    g_signals.m_internals->NotifyGovernanceObject.disconnect_all_slots();
     g_signals.m_internals->NewPoWValidBlock.disconnect_all_slots();
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void ()> func) {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    // Put a marker into every queue and call func when the last queue reaches its marker.
+    // The queues keep draining independently meanwhile, none of them waits for the others.
+    LOCK(g_signals.m_internals->m_cs_subscribers);
+    const auto& subscribers = g_signals.m_internals->m_subscribers;
+    auto remaining = std::make_shared<std::atomic<size_t>>(subscribers.size() + 1);
+    auto shared_func = std::make_shared<std::function<void ()>>(std::move(func));
+    auto marker = [remaining, shared_func] {
+        if (--*remaining == 0) {
+            (*shared_func)();
+        }
+    };
+    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(marker);
+    for (const auto& subscriber : subscribers) {
+        subscriber->AddToProcessQueue(marker);
+    }
 }
 
 void SyncWithValidationInterfaceQueue() {
@@ -147,69 +306,75 @@ void SyncWithValidationInterfaceQueue() {
 
 void CMainSignals::MempoolEntryRemoved(CTransactionRef ptx, MemPoolRemovalReason reason) {
     if (reason != MemPoolRemovalReason::BLOCK && reason != MemPoolRemovalReason::CONFLICT) {
-        m_internals->m_schedulerClient.AddToProcessQueue([ptx, this] {
-            m_internals->TransactionRemovedFromMempool(ptx);
+        m_internals->Enqueue([ptx](CValidationInterface& callbacks) {
+            callbacks.TransactionRemovedFromMempool(ptx);
         });
     }
 }
 
 void CMainSignals::AcceptedBlockHeader(const CBlockIndex *pindexNew) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pindexNew, this] {
-        m_internals->AcceptedBlockHeader(pindexNew);
+    m_internals->Enqueue([pindexNew](CValidationInterface& callbacks) {
+        callbacks.AcceptedBlockHeader(pindexNew);
     });
 }
 
 void CMainSignals::NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDownload) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pindexNew, fInitialDownload, this] {
-        m_internals->NotifyHeaderTip(pindexNew, fInitialDownload);
+    m_internals->Enqueue([pindexNew, fInitialDownload](CValidationInterface& callbacks) {
+        callbacks.NotifyHeaderTip(pindexNew, fInitialDownload);
     });
 }
 
 void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    m_internals->Enqueue([pindexNew, pindexFork, fInitialDownload](CValidationInterface& callbacks) {
+        callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     });
 }
 
 void CMainSignals::NotifyTransactionLock(const CTransaction &tx) {
-    m_internals->m_schedulerClient.AddToProcessQueue([tx, this] {
-        m_internals->NotifyTransactionLock(tx);
+    // Share a single copy between the queues of all subscribers
+    auto ptx = std::make_shared<const CTransaction>(tx);
+    m_internals->Enqueue([ptx](CValidationInterface& callbacks) {
+        callbacks.NotifyTransactionLock(*ptx);
     });
 }
 
 void CMainSignals::NotifyGovernanceVote(const CGovernanceVote &vote) {
-    m_internals->m_schedulerClient.AddToProcessQueue([vote, this] {
-        m_internals->NotifyGovernanceVote(vote);
+    // Share a single copy between the queues of all subscribers
+    auto pvote = std::make_shared<const CGovernanceVote>(vote);
+    m_internals->Enqueue([pvote](CValidationInterface& callbacks) {
+        callbacks.NotifyGovernanceVote(*pvote);
     });
 }
 
 void CMainSignals::NotifyGovernanceObject(const CGovernanceObject &object) {
-    m_internals->m_schedulerClient.AddToProcessQueue([object, this] {
-        m_internals->NotifyGovernanceObject(object);
+    // Share a single copy between the queues of all subscribers
+    auto pobject = std::make_shared<const CGovernanceObject>(object);
+    m_internals->Enqueue([pobject](CValidationInterface& callbacks) {
+        callbacks.NotifyGovernanceObject(*pobject);
     });
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef &ptx) {
-    m_internals->m_schedulerClient.AddToProcessQueue([ptx, this] {
-        m_internals->TransactionAddedToMempool(ptx);
+    m_internals->Enqueue([ptx](CValidationInterface& callbacks) {
+        callbacks.TransactionAddedToMempool(ptx);
     });
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CTransactionRef>>& pvtxConflicted) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, pindex, pvtxConflicted, this] {
-        m_internals->BlockConnected(pblock, pindex, *pvtxConflicted);
+    m_internals->Enqueue([pblock, pindex, pvtxConflicted](CValidationInterface& callbacks) {
+        callbacks.BlockConnected(pblock, pindex, *pvtxConflicted);
     });
 }
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock> &pblock) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, this] {
-        m_internals->BlockDisconnected(pblock);
+    m_internals->Enqueue([pblock](CValidationInterface& callbacks) {
+        callbacks.BlockDisconnected(pblock);
     });
 }
 
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
-    m_internals->m_schedulerClient.AddToProcessQueue([locator, this] {
-        m_internals->ChainStateFlushed(locator);
+    m_internals->Enqueue([locator](CValidationInterface& callbacks) {
+        callbacks.ChainStateFlushed(locator);
     });
 }
 
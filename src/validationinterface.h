@@ -11,6 +11,12 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
+
+//! Default and maximum number of threads delivering background callbacks to the subscribers (-schedulerthreads)
+static const int DEFAULT_SCHEDULER_THREADS = 4;
+static const int MAX_SCHEDULER_THREADS = 16;
 
 class CBlock;
 class CBlockIndex;
@@ -29,9 +35,13 @@ enum class MemPoolRemovalReason;
 
 /** Register a wallet to receive updates from core */
 void RegisterValidationInterface(CValidationInterface* pwalletIn);
-/** Unregister a wallet from core */
+/**
+ * Unregister a wallet from core. Drops its pending callbacks and waits for a running one to
+ * finish, so it can be deleted afterwards. Must not be called while holding a lock its
+ * callbacks take.
+ */
 void UnregisterValidationInterface(CValidationInterface* pwalletIn);
-/** Unregister all wallets from core */
+/** Unregister all wallets from core, like UnregisterValidationInterface */
 void UnregisterAllValidationInterfaces();
 /**
  * Pushes a function to callback onto the notification queue, guaranteeing any
@@ -54,6 +64,17 @@ void CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
  */
 void SyncWithValidationInterfaceQueue();
 
+/** Callback queue statistics of a validation interface subscriber */
+struct ValidationInterfaceQueueInfo {
+    std::string name;
+    //! Number of callbacks waiting to be delivered
+    size_t pending;
+    //! Largest number of callbacks which were waiting at once
+    size_t peak_pending;
+    //! Number of callbacks delivered so far
+    uint64_t delivered;
+};
+
 /**
  * Implement this to subscribe to events generated in validation
  *
@@ -67,7 +88,9 @@ void SyncWithValidationInterfaceQueue();
  * UpdatedBlockTip() callback may depend on an operation performed in
  * the BlockConnected() callback without worrying about explicit
  * synchronization. No ordering should be assumed across
- * ValidationInterface() subscribers.
+ * ValidationInterface() subscribers: every subscriber has its own queue
+ * of background callbacks, and the queues are drained concurrently by
+ * the callback pool.
  */
 class CValidationInterface {
 protected:
@@ -151,6 +174,15 @@ protected:
      * Notifies listeners that a block which builds directly on our current tip
      * has been received and connected to the headers tree, though not validated yet */
     virtual void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) {};
+    /** Name of the subscriber in the statistics of CMainSignals::GetQueueInfo */
+    virtual std::string GetSubscriberName() const { return "unnamed"; }
+    /**
+     * Whether the background callbacks must be delivered on the scheduler thread, serialized
+     * with the tasks scheduled there, rather than on the callback pool. For subscribers sharing
+     * unsynchronized state with scheduled maintenance tasks.
+     */
+    virtual bool UseSchedulerThread() const { return false; }
+    friend class CMainSignals;
     friend void ::RegisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
@@ -169,14 +201,20 @@ private:
     void MempoolEntryRemoved(CTransactionRef tx, MemPoolRemovalReason reason);
 
 public:
-    /** Register a CScheduler to give callbacks which should run in the background (may only be called once) */
-    void RegisterBackgroundSignalScheduler(CScheduler& scheduler);
+    /**
+     * Register a CScheduler to give callbacks which should run in the background (may only be called once).
+     * The queues of the subscribers are drained by the threads of pcallback_pool if given.
+     */
+    void RegisterBackgroundSignalScheduler(CScheduler& scheduler, CScheduler* pcallback_pool = nullptr);
     /** Unregister a CScheduler to give callbacks which should run in the background - these callbacks will now be dropped! */
     void UnregisterBackgroundSignalScheduler();
     /** Call any remaining callbacks on the calling thread */
     void FlushBackgroundCallbacks();
 
+    /** Number of callbacks waiting in the deepest subscriber queue */
     size_t CallbacksPending();
+    /** Queue statistics of the registered subscribers */
+    std::vector<ValidationInterfaceQueueInfo> GetQueueInfo();
 
     /** Register with mempool to call TransactionRemovedFromMempool callbacks */
     void RegisterWithMempoolSignals(CTxMemPool& pool);
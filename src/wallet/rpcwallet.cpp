@@ -3938,6 +3938,7 @@ UniValue rescanblockchain(const JSONRPCRequest& request)
         throw std::runtime_error(
             "rescanblockchain (\"start_height\") (\"stop_height\")\n"
             "\nRescan the local blockchain for wallet related transactions.\n"
+            "With -blockfilterindex, blocks whose compact block filters don't match any script of the wallet are skipped.\n"
             "\nArguments:\n"
             "1. \"start_height\"    (numeric, optional) block height where the rescan should start\n"
             "2. \"stop_height\"     (numeric, optional) the last block height that should be scanned\n"
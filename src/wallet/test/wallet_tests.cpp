@@ -366,6 +366,47 @@ BOOST_FIXTURE_TEST_CASE(ListCoins, ListCoinsTestingSetup)
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+// Check that coins and balances follow the unspent outputs of the wallet when
+// a spend of them is added, leaves the mempool and is abandoned.
+BOOST_FIXTURE_TEST_CASE(wallet_utxo_set, ListCoinsTestingSetup)
+{
+    auto available_count = [&]() {
+        LOCK2(cs_main, wallet->cs_wallet);
+        std::vector<COutput> available;
+        wallet->AvailableCoins(available);
+        return available.size();
+    };
+
+    BOOST_CHECK_EQUAL(available_count(), 1U);
+    BOOST_CHECK_EQUAL(wallet->GetBalance(), 50 * COIN);
+
+    // Spend the coin without getting the spend into a block.
+    CTransactionRef tx;
+    CReserveKey reservekey(wallet.get());
+    CAmount fee;
+    int changePos = -1;
+    std::string error;
+    CCoinControl dummy;
+    BOOST_CHECK(wallet->CreateTransaction({CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */}}, tx, reservekey, fee, changePos, error, dummy));
+    CValidationState state;
+    BOOST_CHECK(wallet->CommitTransaction(tx, {}, {}, {}, reservekey, nullptr, state));
+
+    // Only the change is left while the spend is in the mempool.
+    BOOST_CHECK_EQUAL(available_count(), 1U);
+    BOOST_CHECK_EQUAL(wallet->GetBalance(), 49 * COIN - fee);
+
+    // Nothing is left once the spend drops out of the mempool.
+    mempool.clear();
+    wallet->TransactionRemovedFromMempool(tx);
+    BOOST_CHECK_EQUAL(available_count(), 0U);
+    BOOST_CHECK_EQUAL(wallet->GetBalance(), 0);
+
+    // Abandoning the spend makes the coin available again.
+    BOOST_CHECK(wallet->AbandonTransaction(tx->GetHash()));
+    BOOST_CHECK_EQUAL(available_count(), 1U);
+    BOOST_CHECK_EQUAL(wallet->GetBalance(), 50 * COIN);
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
 {
     std::shared_ptr<CWallet> wallet = std::make_shared<CWallet>(WalletLocation(), WalletDatabase::CreateDummy());
@@ -11,6 +11,8 @@
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <fs.h>
+#include <blockfilter.h>
+#include <index/blockfilterindex.h>
 #include <key.h>
 #include <key_io.h>
 #include <keystore.h>
@@ -679,6 +681,59 @@ void CWallet::AddToSpends(const uint256& wtxid)
         AddToSpends(txin.prevout, wtxid);
 }
 
+void CWallet::UpdateWalletUTXO(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs_wallet);
+    auto it = mapWallet.find(outpoint.hash);
+    if (it != mapWallet.end() && outpoint.n < it->second.tx->vout.size() &&
+        IsMine(it->second.tx->vout[outpoint.n]) && !IsSpent(outpoint.hash, outpoint.n)) {
+        setWalletUTXO.insert(outpoint);
+    } else {
+        setWalletUTXO.erase(outpoint);
+    }
+}
+
+void CWallet::UpdateWalletUTXO(const uint256& hash)
+{
+    AssertLockHeld(cs_wallet);
+    auto it = mapWallet.find(hash);
+    if (it == mapWallet.end()) {
+        return;
+    }
+    for (unsigned int i = 0; i < it->second.tx->vout.size(); i++) {
+        UpdateWalletUTXO(COutPoint(hash, i));
+    }
+}
+
+void CWallet::RebuildWalletUTXO()
+{
+    AssertLockHeld(cs_wallet);
+    setWalletUTXO.clear();
+    for (const auto& entry : mapWallet) {
+        for (unsigned int i = 0; i < entry.second.tx->vout.size(); i++) {
+            if (IsMine(entry.second.tx->vout[i]) && !IsSpent(entry.first, i)) {
+                setWalletUTXO.emplace_hint(setWalletUTXO.end(), entry.first, i);
+            }
+        }
+    }
+    ClearBalanceCache();
+}
+
+std::vector<const CWalletTx*> CWallet::GetWalletUTXOTxs() const
+{
+    AssertLockHeld(cs_wallet);
+    std::vector<const CWalletTx*> vTxs;
+    for (const COutPoint& outpoint : setWalletUTXO) {
+        // The outputs of a transaction are next to each other in the set
+        if (!vTxs.empty() && vTxs.back()->GetHash() == outpoint.hash) continue;
+        auto it = mapWallet.find(outpoint.hash);
+        if (it != mapWallet.end()) {
+            vTxs.push_back(&it->second);
+        }
+    }
+    return vTxs;
+}
+
 bool CWallet::EncryptWallet(const SecureString& strWalletPassphrase)
 {
     if (IsCrypted())
@@ -939,9 +994,11 @@ bool CWallet::GetLabelDestination(CTxDestination &dest, const std::string& label
 void CWallet::MarkDirty()
 {
     {
-        LOCK(cs_wallet);
+        LOCK2(cs_main, cs_wallet);
         for (std::pair<const uint256, CWalletTx>& item : mapWallet)
             item.second.MarkDirty();
+        // Outputs may have become ours
+        RebuildWalletUTXO();
     }
 }
 
@@ -996,7 +1053,6 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 
         for(unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
             if (IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
-                setWalletUTXO.insert(COutPoint(hash, i));
                 if (deterministicMNManager->IsProTxWithCollateral(wtx.tx, i) || deterministicMNManager->HasMNCollateralAtChainTip(COutPoint(hash, i))) {
                     LockCoin(COutPoint(hash, i));
                 }
@@ -1050,6 +1106,8 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    UpdateWalletUTXO(hash);
+    ClearBalanceCache();
 
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1160,8 +1218,10 @@ void CWallet::MarkInputsDirty(const CTransactionRef& tx)
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            UpdateWalletUTXO(txin.prevout);
         }
     }
+    ClearBalanceCache();
 }
 
 bool CWallet::AbandonTransaction(const uint256& hashTx)
@@ -1291,6 +1351,7 @@ void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx) {
     if (it != mapWallet.end()) {
         it->second.fInMempool = true;
     }
+    ClearBalanceCache();
 }
 
 void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx) {
@@ -1299,6 +1360,7 @@ void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx) {
     if (it != mapWallet.end()) {
         it->second.fInMempool = false;
     }
+    ClearBalanceCache();
 }
 
 void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex *pindex, const std::vector<CTransactionRef>& vtxConflicted) {
@@ -1321,6 +1383,8 @@ void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const
     }
 
     m_last_block_processed = pindex;
+    // The depth of all transactions changed
+    ClearBalanceCache();
 }
 
 void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) {
@@ -1329,6 +1393,7 @@ void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) {
     for (const CTransactionRef& ptx : pblock->vtx) {
         SyncTransaction(ptx);
     }
+    ClearBalanceCache();
 }
 
 
@@ -1752,6 +1817,76 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+/** Add the scripts paying to a key to a set of scriptPubKeys, the witness ones also nested in P2SH */
+static void InsertScriptPubKeysForKey(std::set<CScript>& setScripts, const CKeyID& keyid, const CPubKey* pubkey)
+{
+    if (pubkey) {
+        setScripts.insert(GetScriptForRawPubKey(*pubkey));
+    }
+    setScripts.insert(GetScriptForDestination(keyid));
+    CScript witnessScript = GetScriptForDestination(WitnessV0KeyHash(keyid));
+    setScripts.insert(GetScriptForDestination(CScriptID(witnessScript)));
+    setScripts.insert(witnessScript);
+}
+
+std::set<CScript> CWallet::GetScriptPubKeysForFilter() const
+{
+    AssertLockHeld(cs_wallet);
+    std::set<CScript> setScripts;
+    LOCK(cs_KeyStore);
+    for (const CKeyID& keyid : GetKeys()) {
+        CPubKey pubkey;
+        InsertScriptPubKeysForKey(setScripts, keyid, GetPubKey(keyid, pubkey) ? &pubkey : nullptr);
+    }
+    for (const auto& entry : mapWatchKeys) {
+        InsertScriptPubKeysForKey(setScripts, entry.first, &entry.second);
+    }
+    for (const auto& entry : mapScripts) {
+        // Redeem scripts may be paid to directly, through P2SH, P2WSH or P2SH-P2WSH
+        const CScript& script = entry.second;
+        CScript witnessScript = GetScriptForDestination(WitnessV0ScriptHash(script));
+        setScripts.insert(script);
+        setScripts.insert(GetScriptForDestination(CScriptID(script)));
+        setScripts.insert(witnessScript);
+        setScripts.insert(GetScriptForDestination(CScriptID(witnessScript)));
+    }
+    setScripts.insert(setWatchOnly.begin(), setWatchOnly.end());
+    return setScripts;
+}
+
+size_t CWallet::CountScriptPubKeySources() const
+{
+    AssertLockHeld(cs_wallet);
+    LOCK(cs_KeyStore);
+    return mapKeys.size() + mapCryptedKeys.size() + mapWatchKeys.size() + mapScripts.size() + setWatchOnly.size();
+}
+
+/**
+ * Whether a block may contain transactions of the wallet according to its compact filter. Blocks
+ * without a filter may. The filter elements are rebuilt when the wallet learned new keys or
+ * scripts, like the keys added to the keypool while the rescan finds used ones.
+ */
+static bool BlockFilterMatchesWallet(const CWallet& wallet, const BlockFilterIndex& filterIndex, const CBlockIndex* pindex,
+                                     GCSFilter::ElementSet& elements, size_t& nSources)
+{
+    BlockFilter filter;
+    if (!filterIndex.LookupFilter(pindex, filter)) {
+        return true;
+    }
+    {
+        LOCK(wallet.cs_wallet);
+        size_t nCurrentSources = wallet.CountScriptPubKeySources();
+        if (nCurrentSources != nSources) {
+            elements.clear();
+            for (const CScript& script : wallet.GetScriptPubKeysForFilter()) {
+                elements.emplace(script.begin(), script.end());
+            }
+            nSources = nCurrentSources;
+        }
+    }
+    return filter.GetFilter().MatchAny(elements);
+}
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -1800,6 +1935,9 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
             }
         }
         double progress_current = progress_begin;
+        GCSFilter::ElementSet filterElements;
+        size_t nFilterSources = std::numeric_limits<size_t>::max();
+        int nSkippedBlocks = 0;
         while (pindex && !fAbortRescan && !ShutdownRequested())
         {
             if (pindex->nHeight % 100 == 0 && progress_end - progress_begin > 0.0) {
@@ -1811,7 +1949,10 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
             }
 
             CBlock block;
-            if (ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            if (g_blockfilterindex && !BlockFilterMatchesWallet(*this, *g_blockfilterindex, pindex, filterElements, nFilterSources)) {
+                // The block has no transactions of the wallet, so it doesn't need to be read
+                nSkippedBlocks++;
+            } else if (ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
                 LOCK2(cs_main, cs_wallet);
                 if (pindex && !chainActive.Contains(pindex)) {
                     // Abort scan if current block is no longer active, to prevent
@@ -1839,6 +1980,9 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
                 }
             }
         }
+        if (nSkippedBlocks > 0) {
+            WalletLogPrintf("Rescan skipped %d blocks not matching their compact block filters\n", nSkippedBlocks);
+        }
         if (pindex && fAbortRescan) {
             WalletLogPrintf("Rescan aborted at block %d. Progress=%f\n", pindex->nHeight, progress_current);
         } else if (pindex && ShutdownRequested()) {
@@ -2168,13 +2312,18 @@ CAmount CWallet::GetBalance(const isminefilter& filter, const int min_depth) con
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (const auto& entry : mapWallet)
+        auto it = mapBalanceCache.find(std::make_pair(filter, min_depth));
+        if (it != mapBalanceCache.end()) {
+            return it->second;
+        }
+        // Transactions without unspent outputs of ours have no available credit
+        for (const CWalletTx* pcoin : GetWalletUTXOTxs())
         {
-            const CWalletTx* pcoin = &entry.second;
             if (pcoin->IsTrusted() && pcoin->GetDepthInMainChain() >= min_depth) {
                 nTotal += pcoin->GetAvailableCredit(true, filter);
             }
         }
+        mapBalanceCache.emplace(std::make_pair(filter, min_depth), nTotal);
     }
 
     return nTotal;
@@ -2185,9 +2334,8 @@ CAmount CWallet::GetUnconfirmedBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (const auto& entry : mapWallet)
+        for (const CWalletTx* pcoin : GetWalletUTXOTxs())
         {
-            const CWalletTx* pcoin = &entry.second;
             if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
                 nTotal += pcoin->GetAvailableCredit();
         }
@@ -2200,9 +2348,8 @@ CAmount CWallet::GetImmatureBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (const auto& entry : mapWallet)
+        for (const CWalletTx* pcoin : GetWalletUTXOTxs())
         {
-            const CWalletTx* pcoin = &entry.second;
             nTotal += pcoin->GetImmatureCredit();
         }
     }
@@ -2214,9 +2361,8 @@ CAmount CWallet::GetUnconfirmedWatchOnlyBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (const auto& entry : mapWallet)
+        for (const CWalletTx* pcoin : GetWalletUTXOTxs())
         {
-            const CWalletTx* pcoin = &entry.second;
             if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
                 nTotal += pcoin->GetAvailableCredit(true, ISMINE_WATCH_ONLY);
         }
@@ -2229,9 +2375,8 @@ CAmount CWallet::GetImmatureWatchOnlyBalance() const
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
-        for (const auto& entry : mapWallet)
+        for (const CWalletTx* pcoin : GetWalletUTXOTxs())
         {
-            const CWalletTx* pcoin = &entry.second;
             nTotal += pcoin->GetImmatureWatchOnlyCredit();
         }
     }
@@ -2304,10 +2449,10 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
     vCoins.clear();
     CAmount nTotal = 0;
 
-    for (const auto& entry : mapWallet)
+    // Only transactions with unspent outputs of ours can have coins
+    for (const CWalletTx* pcoin : GetWalletUTXOTxs())
     {
-        const uint256& wtxid = entry.first;
-        const CWalletTx* pcoin = &entry.second;
+        const uint256& wtxid = pcoin->GetHash();
 
         if (!CheckFinalTx(*pcoin->tx))
             continue;
@@ -2364,14 +2509,15 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
         if (nDepth < nMinDepth || nDepth > nMaxDepth)
             continue;
 
-        for (unsigned int i = 0; i < pcoin->tx->vout.size(); i++) {
+        for (auto it = setWalletUTXO.lower_bound(COutPoint(wtxid, 0)); it != setWalletUTXO.end() && it->hash == wtxid; ++it) {
+            const unsigned int i = it->n;
             if (pcoin->tx->vout[i].nValue < nMinimumAmount || pcoin->tx->vout[i].nValue > nMaximumAmount)
                 continue;
 
-            if (coinControl && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(COutPoint(entry.first, i)))
+            if (coinControl && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(*it))
                 continue;
 
-            if (IsLockedCoin(entry.first, i))
+            if (IsLockedCoin(wtxid, i))
                 continue;
 
             if (IsSpent(wtxid, i))
@@ -3326,13 +3472,7 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
 
 	{
         LOCK2(cs_main, cs_wallet);
-        for (auto& pair : mapWallet) {
-            for(unsigned int i = 0; i < pair.second.tx->vout.size(); ++i) {
-                if (IsMine(pair.second.tx->vout[i]) && !IsSpent(pair.first, i)) {
-                    setWalletUTXO.insert(COutPoint(pair.first, i));
-                }
-            }
-        }
+        RebuildWalletUTXO();
     }
 
     {
@@ -4634,6 +4774,9 @@ bool CWalletTx::AcceptToMemoryPool(const CAmount& nAbsurdFee, CValidationState&
     bool ret = ::AcceptToMemoryPool(mempool, state, tx, nullptr /* pfMissingInputs */,
                                 nullptr /* plTxnReplaced */, false /* bypass_limits */, nAbsurdFee);
     fInMempool |= ret;
+    if (ret && pwallet) {
+        pwallet->ClearBalanceCache();
+    }
     return ret;
 }
 
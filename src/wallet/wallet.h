@@ -718,8 +718,29 @@ private:
     bool AddToWalletIfInvolvingMe(const CTransactionRef& tx, const CBlockIndex* pIndex, int posInBlock, bool fUpdate) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
 
+    /**
+     * Outputs of wallet transactions which are ours and weren't spent when last checked. Outputs
+     * are removed when a spend of them is added, and checked again when a spender changes
+     * conflicted or abandoned state, so every unspent output of ours is in the set. It may also
+     * hold some outputs which are spent meanwhile, so users still check IsSpent. AvailableCoins
+     * and the balance functions only look at the transactions of these outputs instead of all of
+     * mapWallet.
+     */
     std::set<COutPoint> setWalletUTXO;
 
+    /** Balances computed by GetBalance since the last change of the wallet or chain, by filter and minimum depth */
+    mutable std::map<std::pair<isminefilter, int>, CAmount> mapBalanceCache;
+
+    /** Add or remove the outputs of a wallet transaction to or from setWalletUTXO */
+    void UpdateWalletUTXO(const uint256& hash);
+    void UpdateWalletUTXO(const COutPoint& outpoint);
+
+    /** Rebuild setWalletUTXO from all of mapWallet, e.g. after keys or scripts were added */
+    void RebuildWalletUTXO();
+
+    /** The transactions with outputs in setWalletUTXO */
+    std::vector<const CWalletTx*> GetWalletUTXOTxs() const;
+
     /* Mark a transaction (and its in-wallet descendants) as conflicting with a particular block. */
     void MarkConflicted(const uint256& hashBlock, const uint256& hashTx);
 
@@ -960,6 +981,8 @@ public:
     bool GetLabelDestination(CTxDestination &dest, const std::string& label, bool bForceNew = false);
 
     void MarkDirty();
+    /** Forget the balances cached by GetBalance, on every change which may affect them */
+    void ClearBalanceCache() const { mapBalanceCache.clear(); }
     bool AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose=true);
     void LoadToWallet(const CWalletTx& wtxIn);
     void TransactionAddedToMempool(const CTransactionRef& tx) override;
@@ -967,6 +990,15 @@ public:
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) override;
     int64_t RescanFromTime(int64_t startTime, const WalletRescanReserver& reserver, bool update);
     CBlockIndex* ScanForWalletTransactions(CBlockIndex* pindexStart, CBlockIndex* pindexStop, const WalletRescanReserver& reserver, bool fUpdate = false);
+    /**
+     * Return every scriptPubKey IsMine may recognize: the P2PK, P2PKH, P2WPKH and P2SH-P2WPKH scripts
+     * of all keys and watch-only keys, all scripts themselves and their P2SH, P2WSH and P2SH-P2WSH
+     * scripts, and the watch-only scripts. Used to test blocks against their compact filters during
+     * rescans.
+     */
+    std::set<CScript> GetScriptPubKeysForFilter() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Number of keys, scripts and watch-only scripts GetScriptPubKeysForFilter is derived from */
+    size_t CountScriptPubKeySources() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void TransactionRemovedFromMempool(const CTransactionRef &ptx) override;
     void ReacceptWalletTransactions();
     void ResendWalletTransactions(int64_t nBestBlockTime, CConnman* connman) override;
@@ -1080,6 +1112,7 @@ public:
     CAmount GetCredit(const CTransaction& tx, const isminefilter& filter) const;
     CAmount GetChange(const CTransaction& tx) const;
     void ChainStateFlushed(const CBlockLocator& loc) override;
+    std::string GetSubscriberName() const override { return "wallet " + GetName(); }
 
     DBErrors LoadWallet(bool& fFirstRunRet);
     DBErrors ZapWalletTx(std::vector<CWalletTx>& vWtx);
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+# Copyright (c) 2018 The Machinecoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test dumptxoutset and loadtxoutset.
+
+- node0 mines a chain and dumps its UTXO set twice, the snapshots must be identical.
+- node1 loads the snapshot with its hash pinned, continues the chain from the base block
+  and keeps it over a restart.
+- node2 refuses the snapshot without a pinned hash, with another hash pinned and once the
+  file doesn't match its hash anymore.
+"""
+
+import os
+import shutil
+
+from test_framework.test_framework import MachinecoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+    connect_nodes,
+    sync_blocks,
+)
+
+SNAPSHOT_HEIGHT = 110
+
+class UTXOSnapshotTest(MachinecoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 3
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def setup_network(self):
+        # A snapshot can only be loaded by a node which hasn't connected any block yet
+        self.setup_nodes()
+
+    def run_test(self):
+        node0 = self.nodes[0]
+        node0.generate(SNAPSHOT_HEIGHT)
+
+        self.log.info("Dump the UTXO set")
+        path = os.path.join(node0.datadir, "utxo.dat")
+        dump = node0.dumptxoutset(path)
+        assert_equal(dump['base_hash'], node0.getbestblockhash())
+        assert_equal(dump['base_height'], SNAPSHOT_HEIGHT)
+        assert_equal(dump['coins'], node0.gettxoutsetinfo()['txouts'])
+        assert_equal(dump['path'], path)
+        assert_raises_rpc_error(-1, "already exists", node0.dumptxoutset, path)
+
+        # The snapshot only depends on the chain, dumping it again gives the same file
+        dump2 = node0.dumptxoutset("utxo2.dat")
+        assert_equal(dump2['hash'], dump['hash'])
+        with open(path, 'rb') as f1, open(os.path.join(node0.datadir, "utxo2.dat"), 'rb') as f2:
+            assert f1.read() == f2.read()
+
+        self.log.info("Refuse a snapshot whose hash isn't pinned")
+        assert_raises_rpc_error(-1, "No UTXO snapshot is accepted at height {}".format(SNAPSHOT_HEIGHT), self.nodes[2].loadtxoutset, path)
+        self.restart_node(2, ["-snapshothash={}:{}".format(SNAPSHOT_HEIGHT, "00" * 32)])
+        assert_raises_rpc_error(-1, "isn't the hash accepted at height {}".format(SNAPSHOT_HEIGHT), self.nodes[2].loadtxoutset, path)
+
+        self.log.info("Refuse a snapshot which doesn't match its hash")
+        self.restart_node(2, ["-snapshothash={}:{}".format(SNAPSHOT_HEIGHT, dump['hash'])])
+        bad_path = os.path.join(self.nodes[2].datadir, "utxo_bad.dat")
+        shutil.copyfile(path, bad_path)
+        with open(bad_path, 'r+b') as f:
+            f.seek(-1, os.SEEK_END)
+            last = f.read(1)
+            f.seek(-1, os.SEEK_END)
+            f.write(bytes([last[0] ^ 0xff]))
+        assert_raises_rpc_error(-1, "The snapshot doesn't match its hash", self.nodes[2].loadtxoutset, bad_path)
+        assert_equal(self.nodes[2].getblockcount(), 0)
+
+        self.log.info("Load the snapshot with its hash pinned")
+        self.restart_node(1, ["-snapshothash={}:{}".format(SNAPSHOT_HEIGHT, dump['hash'])])
+        node1 = self.nodes[1]
+        load = node1.loadtxoutset(path)
+        assert_equal(load['hash'], dump['hash'])
+        assert_equal(load['coins'], dump['coins'])
+        assert_equal(load['mnlists'], dump['mnlists'])
+        assert_equal(load['quorum_commitments'], dump['quorum_commitments'])
+        assert_equal(node1.getbestblockhash(), dump['base_hash'])
+        assert_equal(node1.gettxoutsetinfo()['hash_serialized_2'], node0.gettxoutsetinfo()['hash_serialized_2'])
+        assert_raises_rpc_error(-1, "hasn't connected any blocks yet", node1.loadtxoutset, path)
+
+        self.log.info("Sync the blocks after the base block")
+        self.restart_node(1)
+        assert_equal(node1.getbestblockhash(), dump['base_hash'])
+        connect_nodes(node1, 0)
+        node0.generate(5)
+        sync_blocks([node0, node1])
+        assert_equal(node1.getblockcount(), SNAPSHOT_HEIGHT + 5)
+        assert_equal(node1.gettxoutsetinfo()['hash_serialized_2'], node0.gettxoutsetinfo()['hash_serialized_2'])
+
+if __name__ == '__main__':
+    UTXOSnapshotTest().main()
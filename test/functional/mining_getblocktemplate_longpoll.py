@@ -32,7 +32,7 @@ class GetBlockTemplateLPTest(MachinecoinTestFramework):
         self.skip_if_no_wallet()
 
     def run_test(self):
-        self.log.info("Warning: this test will take about 70 seconds in the best case. Be patient.")
+        self.log.info("Warning: this test will take about 160 seconds in the best case. Be patient.")
         self.nodes[0].generate(10)
         templat = self.nodes[0].getblocktemplate()
         longpollid = templat['longpollid']
@@ -71,5 +71,19 @@ class GetBlockTemplateLPTest(MachinecoinTestFramework):
         thr.join(60 + 20)
         assert(not thr.is_alive())
 
+        # Test 5: test that a new transaction only terminates the longpoll if it raises the fees of the template by 1%
+        self.nodes[0].settxfee(Decimal("0.1"))
+        self.nodes[0].sendtoaddress(self.nodes[1].getnewaddress(), Decimal("1"))
+        thr = LongpollThread(self.nodes[0])
+        thr.start()
+        self.nodes[0].settxfee(min_relay_fee)
+        self.nodes[0].sendtoaddress(self.nodes[1].getnewaddress(), Decimal("1"))
+        thr.join(60 + 20)
+        assert(thr.is_alive())
+        self.nodes[0].settxfee(Decimal("0.1"))
+        self.nodes[0].sendtoaddress(self.nodes[1].getnewaddress(), Decimal("1"))
+        thr.join(10 + 10)
+        assert(not thr.is_alive())
+
 if __name__ == '__main__':
     GetBlockTemplateLPTest().main()
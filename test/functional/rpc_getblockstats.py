@@ -21,18 +21,6 @@ class GetblockstatsTest(MachinecoinTestFramework):
 
     start_height = 101
     max_stat_pos = 2
-    STATS_NEED_TXINDEX = [
-        'avgfee',
-        'avgfeerate',
-        'maxfee',
-        'maxfeerate',
-        'medianfee',
-        'feerate_percentiles',
-        'minfee',
-        'minfeerate',
-        'totalfee',
-        'utxo_size_inc',
-    ]
 
     def add_options(self, parser):
         parser.add_argument('--gen-test-data', dest='gen_test_data',
@@ -45,7 +33,7 @@ class GetblockstatsTest(MachinecoinTestFramework):
 
     def set_test_params(self):
         self.num_nodes = 2
-        self.extra_args = [['-txindex'], ['-paytxfee=0.003']]
+        self.extra_args = [['-blockstatsindex'], ['-paytxfee=0.003']]
         self.setup_clean_chain = True
 
     def get_stats(self):
@@ -107,9 +95,6 @@ class GetblockstatsTest(MachinecoinTestFramework):
 
         self.sync_all()
         stats = self.get_stats()
-        expected_stats_noindex = []
-        for stat_row in stats:
-            expected_stats_noindex.append({k: v for k, v in stat_row.items() if k not in self.STATS_NEED_TXINDEX})
 
         # Make sure all valid statistics are included but nothing else is
         expected_keys = self.expected_stats[0].keys()
@@ -127,9 +112,13 @@ class GetblockstatsTest(MachinecoinTestFramework):
             stats_by_hash = self.nodes[0].getblockstats(hash_or_height=blockhash)
             assert_equal(stats_by_hash, self.expected_stats[i])
 
-            # Check with the node that has no txindex
-            stats_no_txindex = self.nodes[1].getblockstats(hash_or_height=blockhash, stats=list(expected_stats_noindex[i].keys()))
-            assert_equal(stats_no_txindex, expected_stats_noindex[i])
+            # Check with the node that has no block stats index
+            stats_no_index = self.nodes[1].getblockstats(hash_or_height=blockhash)
+            assert_equal(stats_no_index, self.expected_stats[i])
+
+        # Check querying a range of heights
+        range_stats = self.nodes[1].getblockstats(hash_or_height=[self.start_height, self.start_height + self.max_stat_pos])
+        assert_equal(range_stats, self.expected_stats[:self.max_stat_pos + 1])
 
         # Make sure each stat can be queried on its own
         for stat in expected_keys:
@@ -168,9 +157,11 @@ class GetblockstatsTest(MachinecoinTestFramework):
         # Make sure we aren't always returning inv_sel_stat as the culprit stat
         assert_raises_rpc_error(-8, 'Invalid selected statistic aaa%s' % inv_sel_stat,
                                 self.nodes[0].getblockstats, hash_or_height=1, stats=['minfee' , 'aaa%s' % inv_sel_stat])
+        assert_raises_rpc_error(-8, 'Invalid selected statistic %s' % inv_sel_stat,
+                                self.nodes[0].getblockstats, hash_or_height=[1, 2], stats=['minfee', inv_sel_stat])
 
-        assert_raises_rpc_error(-8, 'One or more of the selected stats requires -txindex enabled',
-                                self.nodes[1].getblockstats, hash_or_height=self.start_height + self.max_stat_pos)
+        assert_raises_rpc_error(-8, 'First height of the range is after the last height',
+                                self.nodes[0].getblockstats, hash_or_height=[2, 1])
 
         # Mainchain's genesis block shouldn't be found on regtest
         assert_raises_rpc_error(-5, 'Block not found', self.nodes[0].getblockstats,
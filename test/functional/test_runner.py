@@ -149,6 +149,7 @@ BASE_SCRIPTS = [
     'p2p_unrequested_blocks.py',
     'feature_includeconf.py',
     'rpc_scantxoutset.py',
+    'feature_utxo_snapshot.py',
     'feature_logging.py',
     'p2p_node_network_limited.py',
     'feature_blocksdir.py',